@@ -27,6 +27,7 @@
 #include "memory/memory.h"
 #include "r4300/r4300_core.h"
 #include "ri/ri_controller.h"
+#include "rsp/rsp_core.h"
 #include "vi/vi_controller.h"
 
 enum
@@ -70,6 +71,10 @@ static unsigned int get_dma_duration(struct ai_controller* ai)
 
 static void do_dma(struct ai_controller* ai, const struct ai_dma* dma)
 {
+    /* the samples may come from an audio task still running on a worker,
+     * which may also be calling into the audio plugin */
+    rsp_wait_task(ai->sp);
+
     /* lazy initialization of sample format */
     if (ai->samples_format_changed)
     {
@@ -148,10 +153,12 @@ void push_audio_samples(struct ai_controller* ai, const void* buffer, size_t siz
 void connect_ai(struct ai_controller* ai,
                 struct r4300_core* r4300,
                 struct ri_controller* ri,
+                struct rsp_core* sp,
                 struct vi_controller* vi)
 {
     ai->r4300 = r4300;
     ai->ri = ri;
+    ai->sp = sp;
     ai->vi = vi;
 }
 
@@ -27,6 +27,7 @@
 
 struct r4300_core;
 struct ri_controller;
+struct rsp_core;
 struct vi_controller;
 
 enum ai_registers
@@ -60,6 +61,7 @@ struct ai_controller
 
     struct r4300_core* r4300;
     struct ri_controller* ri;
+    struct rsp_core* sp;
     struct vi_controller* vi;
 };
 
@@ -74,6 +76,7 @@ void push_audio_samples(struct ai_controller* ai, const void* buffer, size_t siz
 void connect_ai(struct ai_controller* ai,
                 struct r4300_core* r4300,
                 struct ri_controller* ri,
+                struct rsp_core* sp,
                 struct vi_controller* vi);
 
 void init_ai(struct ai_controller* ai);
@@ -46,6 +46,7 @@
 #include "main/workqueue.h"
 #include "osd/screenshot.h"
 #include "plugin/plugin.h"
+#include "r4300/code_cache.h"
 #include "vidext.h"
 
 /* some local state variables */
@@ -79,6 +80,7 @@ EXPORT m64p_error CALL CoreStartup(int APIVersion, const char *ConfigPath, const
     plugin_connect(M64PLUGIN_CORE, NULL);
 
     savestates_init();
+    main_init();
 
     /* next, start up the configuration handling code by loading and parsing the config file */
     if (ConfigInit(ConfigPath, DataPath) != M64ERR_SUCCESS)
@@ -94,7 +96,7 @@ EXPORT m64p_error CALL CoreStartup(int APIVersion, const char *ConfigPath, const
     /* The ROM database contains MD5 hashes, goodnames, and some game-specific parameters */
     romdatabase_open();
 
-    workqueue_init();
+    workqueue_init(ConfigGetParamInt(g_CoreConfig, "WorkerThreads"));
 
     l_CoreInit = 1;
     return M64ERR_SUCCESS;
@@ -110,6 +112,7 @@ EXPORT m64p_error CALL CoreShutdown(void)
     ConfigShutdown();
     workqueue_shutdown();
     savestates_deinit();
+    main_deinit();
 
     /* tell SDL to shut down */
     SDL_Quit();
@@ -152,6 +155,7 @@ EXPORT m64p_error CALL CoreDoCommand(m64p_command Command, int ParamInt, void *P
 {
     m64p_error rval;
     int keysym, keymod;
+    m64p_code_cache_stats cache_stats;
 
     if (!l_CoreInit)
         return M64ERR_NOT_INIT;
@@ -246,6 +250,46 @@ EXPORT m64p_error CALL CoreDoCommand(m64p_command Command, int ParamInt, void *P
                 return M64ERR_INPUT_INVALID;
             main_state_save(ParamInt, (char *) ParamPtr);
             return M64ERR_SUCCESS;
+        case M64CMD_STATE_LOAD_BUFFER:
+            if (!g_EmulatorRunning)
+                return M64ERR_INVALID_STATE;
+            if (ParamPtr == NULL)
+                return M64ERR_INPUT_ASSERT;
+            if (ParamInt <= 0)
+                return M64ERR_INPUT_INVALID;
+            main_state_load_buffer(ParamPtr, ParamInt);
+            return M64ERR_SUCCESS;
+        case M64CMD_STATE_SAVE_BUFFER:
+            if (!g_EmulatorRunning)
+                return M64ERR_INVALID_STATE;
+            if (ParamPtr == NULL)
+                return M64ERR_INPUT_ASSERT;
+            if (ParamInt <= 0)
+                return M64ERR_INPUT_INVALID;
+            main_state_save_buffer(ParamPtr, ParamInt);
+            return M64ERR_SUCCESS;
+        case M64CMD_STATE_SET_DELTA_BASE:
+            if (ParamPtr != NULL && ParamInt <= 0)
+                return M64ERR_INPUT_INVALID;
+            if (!savestates_set_delta_base(ParamPtr, (ParamPtr != NULL) ? ParamInt : 0))
+                return M64ERR_INPUT_INVALID;
+            return M64ERR_SUCCESS;
+        case M64CMD_STATE_REWIND:
+            if (!g_EmulatorRunning)
+                return M64ERR_INVALID_STATE;
+            if (ParamInt <= 0)
+                return M64ERR_INPUT_INVALID;
+            return main_state_rewind(ParamInt);
+        case M64CMD_CODE_CACHE_STATS:
+            if (ParamPtr == NULL)
+                return M64ERR_INPUT_ASSERT;
+            if (ParamInt <= 0)
+                return M64ERR_INPUT_INVALID;
+            code_cache_get_stats(&cache_stats);
+            if (sizeof(m64p_code_cache_stats) < ParamInt)
+                ParamInt = sizeof(m64p_code_cache_stats);
+            memcpy(ParamPtr, &cache_stats, ParamInt);
+            return M64ERR_SUCCESS;
         case M64CMD_STATE_SET_SLOT:
             if (ParamInt < 0 || ParamInt > 9)
                 return M64ERR_INPUT_INVALID;
@@ -291,6 +335,19 @@ EXPORT m64p_error CALL CoreDoCommand(m64p_command Command, int ParamInt, void *P
                 return M64ERR_INVALID_STATE;
             main_advance_one();
             return M64ERR_SUCCESS;
+        case M64CMD_RENDER_NEXT_FRAME:
+            if (!g_EmulatorRunning)
+                return M64ERR_INVALID_STATE;
+            main_render_next_frame();
+            return M64ERR_SUCCESS;
+        case M64CMD_ADVANCE_BATCH:
+            if (!g_EmulatorRunning)
+                return M64ERR_INVALID_STATE;
+            if (ParamPtr == NULL)
+                return M64ERR_INPUT_ASSERT;
+            if (ParamInt != M64BATCH_FRAMES && ParamInt != M64BATCH_VIS)
+                return M64ERR_INPUT_INVALID;
+            return main_advance_batch((m64p_batch_unit) ParamInt, (int *) ParamPtr);
         default:
             return M64ERR_INPUT_INVALID;
     }
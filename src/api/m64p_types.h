@@ -132,7 +132,9 @@ typedef enum {
   M64CORE_AUDIO_MUTE,
   M64CORE_INPUT_GAMESHARK,
   M64CORE_STATE_LOADCOMPLETE,
-  M64CORE_STATE_SAVECOMPLETE
+  M64CORE_STATE_SAVECOMPLETE,
+  M64CORE_STATE_BUFFER_SIZE,
+  M64CORE_RENDER_SKIP
 } m64p_core_param;
 
 typedef enum {
@@ -156,14 +158,36 @@ typedef enum {
   M64CMD_CORE_STATE_SET,
   M64CMD_READ_SCREEN,
   M64CMD_RESET,
-  M64CMD_ADVANCE_FRAME
+  M64CMD_ADVANCE_FRAME,
+  M64CMD_ADVANCE_BATCH,
+  M64CMD_STATE_LOAD_BUFFER,
+  M64CMD_STATE_SAVE_BUFFER,
+  M64CMD_STATE_SET_DELTA_BASE,
+  M64CMD_STATE_REWIND,
+  M64CMD_CODE_CACHE_STATS,
+  M64CMD_RENDER_NEXT_FRAME
 } m64p_command;
 
+typedef enum {
+  M64BATCH_FRAMES = 1,
+  M64BATCH_VIS
+} m64p_batch_unit;
+
 typedef struct {
   uint32_t address;
   int      value;
 } m64p_cheat_code;
 
+/* Dynamic recompiler code cache counters, for M64CMD_CODE_CACHE_STATS.
+ * They are reset when the emulation starts. */
+typedef struct {
+  uint64_t bytes_used;      /* executable memory currently allocated to blocks */
+  uint64_t bytes_limit;     /* size of the code cache (CodeCacheSize) */
+  uint64_t blocks_compiled; /* number of times a block was (re)compiled */
+  uint64_t evictions;       /* blocks evicted to make room for new code */
+  uint64_t recompile_nsec;  /* time spent initializing and compiling blocks */
+} m64p_code_cache_stats;
+
 /* ----------------------------------------- */
 /* Structures to hold ROM image information  */
 /* ----------------------------------------- */
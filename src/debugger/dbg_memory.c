@@ -28,6 +28,7 @@
 #include "dbg_breakpoints.h"
 #include "dbg_memory.h"
 #include "dbg_types.h"
+#include "device/device.h"
 #include "main/main.h"
 #include "main/rom.h"
 #include "memory/memory.h"
@@ -121,11 +122,11 @@ static void decode_recompiled(uint32 addr)
 
     lines_recompiled=0;
 
-    if(blocks[addr>>12] == NULL)
+    if(get_block(addr>>12) == NULL)
         return;
 
-    if(blocks[addr>>12]->block[(addr&0xFFF)/4].ops == current_instruction_table.NOTCOMPILED)
-    //      recompile_block((int *) g_sp_mem, blocks[addr>>12], addr);
+    if(get_block(addr>>12)->block[(addr&0xFFF)/4].ops == current_instruction_table.NOTCOMPILED)
+    //      recompile_block((int *) g_sp_mem, get_block(addr>>12), addr);
       {
     strcpy(opcode_recompiled[0],"INVLD");
     strcpy(args_recompiled[0],"NOTCOMPILED");
@@ -135,15 +136,15 @@ static void decode_recompiled(uint32 addr)
     return;
       }
 
-    assemb = (blocks[addr>>12]->code) + 
-      (blocks[addr>>12]->block[(addr&0xFFF)/4].local_addr);
+    assemb = (get_block(addr>>12)->code) + 
+      (get_block(addr>>12)->info[(addr&0xFFF)/4].local_addr);
 
-    end_addr = blocks[addr>>12]->code;
+    end_addr = get_block(addr>>12)->code;
 
     if( (addr & 0xFFF) >= 0xFFC)
-        end_addr += blocks[addr>>12]->code_length;
+        end_addr += get_block(addr>>12)->code_length;
     else
-        end_addr += blocks[addr>>12]->block[(addr&0xFFF)/4+1].local_addr;
+        end_addr += get_block(addr>>12)->info[(addr&0xFFF)/4+1].local_addr;
 
     while(assemb < end_addr)
       {
@@ -203,18 +204,18 @@ int get_has_recompiled(uint32 addr)
 {
     unsigned char *assemb, *end_addr;
 
-    if(r4300emu != CORE_DYNAREC || blocks[addr>>12] == NULL)
+    if(r4300emu != CORE_DYNAREC || get_block(addr>>12) == NULL)
         return FALSE;
 
-    assemb = (blocks[addr>>12]->code) + 
-      (blocks[addr>>12]->block[(addr&0xFFF)/4].local_addr);
+    assemb = (get_block(addr>>12)->code) + 
+      (get_block(addr>>12)->info[(addr&0xFFF)/4].local_addr);
 
-    end_addr = blocks[addr>>12]->code;
+    end_addr = get_block(addr>>12)->code;
 
     if( (addr & 0xFFF) >= 0xFFC)
-        end_addr += blocks[addr>>12]->code_length;
+        end_addr += get_block(addr>>12)->code_length;
     else
-        end_addr += blocks[addr>>12]->block[(addr&0xFFF)/4+1].local_addr;
+        end_addr += get_block(addr>>12)->info[(addr&0xFFF)/4+1].local_addr;
     if(assemb==end_addr)
       return FALSE;
 
@@ -297,68 +298,68 @@ uint32 read_memory_32(uint32 addr){
     case M64P_MEM_RDRAM:
       return g_rdram[rdram_dram_address(addr)];
     case M64P_MEM_RSPMEM:
-      return g_sp.mem[rsp_mem_address(addr)];
+      return g_dev.sp.mem[rsp_mem_address(addr)];
     case M64P_MEM_ROM:
       return *((uint32 *)(g_rom + rom_address(addr)));
     case M64P_MEM_RDRAMREG:
       offset = rdram_reg(addr);
       if (offset < RDRAM_REGS_COUNT)
-          return g_ri.rdram.regs[offset];
+          return g_dev.ri.rdram.regs[offset];
       break;
     case M64P_MEM_RSPREG:
       offset = rsp_reg(addr);
       if (offset < SP_REGS_COUNT)
-        return g_sp.regs[offset];
+        return g_dev.sp.regs[offset];
       break;
     case M64P_MEM_RSP:
       offset = rsp_reg2(addr);
       if (offset < SP_REGS2_COUNT)
-        return g_sp.regs2[offset];
+        return g_dev.sp.regs2[offset];
       break;
     case M64P_MEM_DP:
       offset = dpc_reg(addr);
       if (offset < DPC_REGS_COUNT)
-        return g_dp.dpc_regs[offset];
+        return g_dev.dp.dpc_regs[offset];
       break;
     case M64P_MEM_DPS:
       offset = dps_reg(addr);
       if (offset < DPS_REGS_COUNT)
-        return g_dp.dps_regs[offset];
+        return g_dev.dp.dps_regs[offset];
       break;
     case M64P_MEM_VI:
       offset = vi_reg(addr);
       if (offset < VI_REGS_COUNT)
-        return g_vi.regs[offset];
+        return g_dev.vi.regs[offset];
       break;
     case M64P_MEM_AI:
       offset = ai_reg(addr);
       if (offset < AI_REGS_COUNT)
-        return g_ai.regs[offset];
+        return g_dev.ai.regs[offset];
       break;
     case M64P_MEM_PI:
       offset = pi_reg(addr);
       if (offset < PI_REGS_COUNT)
-        return g_pi.regs[offset];
+        return g_dev.pi.regs[offset];
       break;
     case M64P_MEM_RI:
       offset = ri_reg(addr);
       if (offset < RI_REGS_COUNT)
-        return g_ri.regs[offset];
+        return g_dev.ri.regs[offset];
       break;
     case M64P_MEM_SI:
       offset = si_reg(addr);
       if (offset < SI_REGS_COUNT)
-        return g_si.regs[offset];
+        return g_dev.si.regs[offset];
       break;
     case M64P_MEM_PIF:
       offset = pif_ram_address(addr);
       if (offset < PIF_RAM_SIZE)
-        return sl((*((uint32_t*)&g_si.pif.ram[offset])));
+        return sl((*((uint32_t*)&g_dev.si.pif.ram[offset])));
       break;
     case M64P_MEM_MI:
       offset = mi_reg(addr);
       if (offset < MI_REGS_COUNT)
-        return g_r4300.mi.regs[offset];
+        return g_dev.r4300.mi.regs[offset];
       break;
     default:
       break;
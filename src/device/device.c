@@ -0,0 +1,47 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - device.c                                                *
+ *   Mupen64Plus homepage: http://code.google.com/p/mupen64plus/           *
+ *   Copyright (C) 2015 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "device.h"
+
+void connect_device(struct device* dev,
+                    uint32_t* dram, size_t dram_size,
+                    uint8_t* rom, size_t rom_size)
+{
+    connect_rdp(&dev->dp, &dev->r4300, &dev->sp, &dev->ri);
+    connect_rsp(&dev->sp, &dev->r4300, &dev->dp, &dev->ri);
+    connect_ai(&dev->ai, &dev->r4300, &dev->ri, &dev->sp, &dev->vi);
+    connect_pi(&dev->pi, &dev->r4300, &dev->ri, rom, rom_size);
+    connect_ri(&dev->ri, dram, dram_size);
+    connect_si(&dev->si, &dev->r4300, &dev->ri);
+    connect_vi(&dev->vi, &dev->r4300);
+}
+
+void init_device(struct device* dev)
+{
+    init_r4300(&dev->r4300);
+    init_rdp(&dev->dp);
+    init_rsp(&dev->sp);
+    init_ai(&dev->ai);
+    init_pi(&dev->pi);
+    init_ri(&dev->ri);
+    init_si(&dev->si);
+    init_vi(&dev->vi);
+}
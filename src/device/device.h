@@ -0,0 +1,68 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - device.h                                                *
+ *   Mupen64Plus homepage: http://code.google.com/p/mupen64plus/           *
+ *   Copyright (C) 2015 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_DEVICE_DEVICE_H
+#define M64P_DEVICE_DEVICE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ai/ai_controller.h"
+#include "pi/pi_controller.h"
+#include "r4300/r4300_core.h"
+#include "rdp/rdp_core.h"
+#include "ri/ri_controller.h"
+#include "rsp/rsp_core.h"
+#include "si/si_controller.h"
+#include "vi/vi_controller.h"
+
+/* Device structure is a container for the n64 components.
+ * It owns the state of every controller so that a whole machine
+ * can be referred to as a single object.
+ *
+ * It is not a reentrant instance: the r4300 register file, the
+ * recompilers, the memory handler and TLB tables, g_rdram/g_rom and the
+ * plugin interfaces are process-wide, so g_dev is the only device and
+ * the core runs one machine per process.
+ */
+struct device
+{
+    struct r4300_core r4300;
+    struct rdp_core dp;
+    struct rsp_core sp;
+    struct ai_controller ai;
+    struct pi_controller pi;
+    struct ri_controller ri;
+    struct si_controller si;
+    struct vi_controller vi;
+};
+
+/* Wire the components of the device together and attach
+ * the external RDRAM and cartridge ROM buffers.
+ */
+void connect_device(struct device* dev,
+                    uint32_t* dram, size_t dram_size,
+                    uint8_t* rom, size_t rom_size);
+
+/* Reset all components of the device to their power-on state. */
+void init_device(struct device* dev);
+
+#endif
@@ -47,10 +47,13 @@ void open_eep_file(struct eep_file* eep, const char* filename)
     default:
         break;
     }
+
+    open_write_behind(&eep->wb, eep->filename, "eeprom", eep->eeprom, EEPROM_MAX_SIZE);
 }
 
 void close_eep_file(struct eep_file* eep)
 {
+    close_write_behind(&eep->wb);
     free((void*)eep->filename);
 }
 
@@ -61,19 +64,8 @@ uint8_t* eep_file_ptr(struct eep_file* eep)
 
 void save_eep_file(void* opaque)
 {
-    /* flush eeprom to disk */
+    /* queue eeprom flush to disk */
     struct eep_file* eep = (struct eep_file*)opaque;
 
-    switch(write_to_file(eep->filename, eep->eeprom, EEPROM_MAX_SIZE))
-    {
-    case file_open_error:
-        DebugMessage(M64MSG_WARNING, "couldn't open eeprom file '%s' for writing", eep->filename);
-        break;
-    case file_write_error:
-        DebugMessage(M64MSG_WARNING, "failed to write eeprom file '%s'", eep->filename);
-        break;
-    default:
-        break;
-    }
+    write_behind_mark_dirty(&eep->wb);
 }
-
@@ -24,6 +24,8 @@
 
 #include <stdint.h>
 
+#include "write_behind.h"
+
 /* Note: EEP files are all EEPROM_MAX_SIZE bytes long,
  * whatever the real EEPROM size is.
  */
@@ -34,6 +36,7 @@ struct eep_file
 {
     uint8_t eeprom[EEPROM_MAX_SIZE];
     const char* filename;
+    struct write_behind wb;
 };
 
 void open_eep_file(struct eep_file* eep, const char* filename);
@@ -47,10 +47,13 @@ void open_fla_file(struct fla_file* fla, const char* filename)
     default:
         break;
     }
+
+    open_write_behind(&fla->wb, fla->filename, "flashram", fla->flashram, FLASHRAM_SIZE);
 }
 
 void close_fla_file(struct fla_file* fla)
 {
+    close_write_behind(&fla->wb);
     free((void*)fla->filename);
 }
 
@@ -61,20 +64,8 @@ uint8_t* fla_file_ptr(struct fla_file* fla)
 
 void save_fla_file(void* opaque)
 {
-    /* flush flashram to disk */
+    /* queue flashram flush to disk */
     struct fla_file* fla = (struct fla_file*)opaque;
 
-    switch(write_to_file(fla->filename, fla->flashram, FLASHRAM_SIZE))
-    {
-    case file_open_error:
-        DebugMessage(M64MSG_WARNING, "couldn't open flashram file '%s' for writing", fla->filename);
-        break;
-    case file_write_error:
-        DebugMessage(M64MSG_WARNING, "failed to write flashram file '%s'", fla->filename);
-        break;
-    default:
-        break;
-    }
-
+    write_behind_mark_dirty(&fla->wb);
 }
-
@@ -25,11 +25,13 @@
 #include <stdint.h>
 
 #include "pi/flashram.h"
+#include "write_behind.h"
 
 struct fla_file
 {
     uint8_t flashram[FLASHRAM_SIZE];
     const char* filename;
+    struct write_behind wb;
 };
 
 void open_fla_file(struct fla_file* fla, const char* filename);
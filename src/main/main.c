@@ -45,6 +45,7 @@
 #include "api/m64p_vidext.h"
 #include "api/vidext.h"
 #include "cheat.h"
+#include "device/device.h"
 #include "eep_file.h"
 #include "eventloop.h"
 #include "fla_file.h"
@@ -62,10 +63,12 @@
 #include "plugin/plugin.h"
 #include "plugin/rumble_via_input_plugin.h"
 #include "profile.h"
+#include "r4300/code_cache.h"
 #include "r4300/r4300.h"
 #include "r4300/r4300_core.h"
 #include "r4300/reset.h"
 #include "rdp/rdp_core.h"
+#include "rewind.h"
 #include "ri/ri_controller.h"
 #include "rom.h"
 #include "rsp/rsp_core.h"
@@ -95,15 +98,8 @@ m64p_frame_callback g_FrameCallback = NULL;
 int         g_MemHasBeenBSwapped = 0;   // store byte-swapped flag so we don't swap twice when re-playing game
 int         g_EmulatorRunning = 0;      // need separate boolean to tell if emulator is running, since --nogui doesn't use a thread
 
-ALIGN(16, uint32_t g_rdram[RDRAM_MAX_SIZE/4]);
-struct ai_controller g_ai;
-struct pi_controller g_pi;
-struct ri_controller g_ri;
-struct si_controller g_si;
-struct vi_controller g_vi;
-struct r4300_core g_r4300;
-struct rdp_core g_dp;
-struct rsp_core g_sp;
+ALIGN(4096, uint32_t g_rdram[RDRAM_MAX_SIZE/4]);
+struct device g_dev;
 
 int g_delay_si = 0;
 
@@ -115,6 +111,15 @@ static int   l_TakeScreenshot = 0;       // Tell OSD Rendering callback to take
 static int   l_SpeedFactor = 100;        // percentage of nominal game speed at which emulator is running
 static int   l_FrameAdvance = 0;         // variable to check if we pause on next frame
 static int   l_MainSpeedLimit = 1;       // insert delay during vi_interrupt to keep speed at real-time
+static int   l_BatchUnit = 0;            // unit of the batch being run by main_advance_batch(), 0 if none
+static int   l_BatchRemaining = 0;       // number of frames or VIs left to run in the current batch
+static int   l_RenderSkip = 0;           // frames skipped between two rendered frames, -1 to render only requested frames
+static int   l_RenderNextFrame = 0;      // render the next frame whatever l_RenderSkip is
+static int   l_RenderFrame = 1;          // the current frame is rendered
+
+static SDL_sem *l_PauseWake = NULL;      // wakes up the emulation thread while it is paused
+static SDL_sem *l_BatchDone = NULL;      // signalled by the emulation thread when a batch is over
+static SDL_mutex *l_RequestLock = NULL;  // protects the batch state and l_RenderNextFrame, shared with the frontend thread
 
 static osd_message_t *l_msgVol = NULL;
 static osd_message_t *l_msgFF = NULL;
@@ -208,6 +213,23 @@ void main_check_inputs(void)
 * global functions, for adjusting the core emulator behavior
 */
 
+void main_init(void)
+{
+    l_PauseWake = SDL_CreateSemaphore(0);
+    l_BatchDone = SDL_CreateSemaphore(0);
+    l_RequestLock = SDL_CreateMutex();
+}
+
+void main_deinit(void)
+{
+    SDL_DestroySemaphore(l_PauseWake);
+    SDL_DestroySemaphore(l_BatchDone);
+    SDL_DestroyMutex(l_RequestLock);
+    l_PauseWake = NULL;
+    l_BatchDone = NULL;
+    l_RequestLock = NULL;
+}
+
 int main_set_core_defaults(void)
 {
     float fConfigParamsVersion;
@@ -245,6 +267,8 @@ int main_set_core_defaults(void)
     ConfigSetDefaultInt(g_CoreConfig, "R4300Emulator", 1, "Use Pure Interpreter if 0, Cached Interpreter if 1, or Dynamic Recompiler if 2 or more");
 #endif
     ConfigSetDefaultBool(g_CoreConfig, "NoCompiledJump", 0, "Disable compiled jump commands in dynamic recompiler (should be set to False) ");
+    ConfigSetDefaultBool(g_CoreConfig, "FastMem", 0, "Map RDRAM into a reserved host address window so the x86_64 dynamic recompiler accesses it directly");
+    ConfigSetDefaultInt(g_CoreConfig, "CodeCacheSize", 128, "Size (in MB) of the dynamic recompiler code cache. Least recently used blocks are recompiled when it is full");
     ConfigSetDefaultBool(g_CoreConfig, "DisableExtraMem", 0, "Disable 4MB expansion RAM pack. May be necessary for some games");
     ConfigSetDefaultBool(g_CoreConfig, "AutoStateSlotIncrement", 0, "Increment the save state slot after each save operation");
     ConfigSetDefaultBool(g_CoreConfig, "EnableDebugger", 0, "Activate the R4300 debugger when ROM execution begins, if core was built with Debugger support");
@@ -255,6 +279,13 @@ int main_set_core_defaults(void)
     ConfigSetDefaultString(g_CoreConfig, "SharedDataPath", "", "Path to a directory to search when looking for shared data files");
     ConfigSetDefaultBool(g_CoreConfig, "DelaySI", 1, "Delay interrupt after DMA SI read/write");
     ConfigSetDefaultInt(g_CoreConfig, "CountPerOp", 0, "Force number of cycles per emulated instruction");
+    ConfigSetDefaultInt(g_CoreConfig, "RewindBufferSize", 0, "Memory budget (in MB, at most 2048) of the rewind buffer of compressed snapshots. Rewinding is disabled if 0");
+    ConfigSetDefaultInt(g_CoreConfig, "RewindInterval", 1, "Number of frames between two rewind snapshots");
+    ConfigSetDefaultBool(g_CoreConfig, "SharedRomCache", 0, "Map ROMs read-only from a byte-swapped copy in the user cache directory, shared by all processes running the same ROM");
+    ConfigSetDefaultInt(g_CoreConfig, "RenderSkip", 0, "Number of frames whose display lists aren't rendered between two rendered frames. If -1, only the frames requested by the front-end are rendered");
+    ConfigSetDefaultBool(g_CoreConfig, "SkipRspAudio", 0, "Don't run RSP audio tasks when no audio plugin is attached, only signal their completion");
+    ConfigSetDefaultBool(g_CoreConfig, "AsyncRspAudio", 0, "Run RSP audio tasks on a worker thread, concurrently with the R4300. The recompiler then accesses RDRAM through the memory handlers. Not available with the new dynamic recompiler");
+    ConfigSetDefaultInt(g_CoreConfig, "WorkerThreads", 0, "Number of threads running background jobs such as savestate compression. If 0, it is chosen from the number of CPUs");
 
     /* handle upgrades */
     if (bUpgrade)
@@ -381,15 +412,91 @@ void main_toggle_pause(void)
 
     rompause = !rompause;
     l_FrameAdvance = 0;
+
+    if (!rompause)
+        SDL_SemPost(l_PauseWake);
+}
+
+void main_render_next_frame(void)
+{
+    SDL_LockMutex(l_RequestLock);
+    l_RenderNextFrame = 1;
+    SDL_UnlockMutex(l_RequestLock);
+}
+
+int main_frame_rendered(void)
+{
+    return l_RenderFrame;
 }
 
 void main_advance_one(void)
 {
     l_FrameAdvance = 1;
     rompause = 0;
+    SDL_SemPost(l_PauseWake);
     StateChanged(M64CORE_EMU_STATE, M64EMU_RUNNING);
 }
 
+/* Run *count frames or VIs without speed limiting or input polling, and
+ * return once the emulator is paused again. *count is updated with the number
+ * of frames or VIs actually run, which is less than requested if the emulator
+ * was paused or stopped by other means. Must be called from a thread other
+ * than the emulation thread, with the emulator paused. */
+m64p_error main_advance_batch(m64p_batch_unit unit, int *count)
+{
+    int requested = *count;
+    int remaining;
+
+    if (requested <= 0)
+        return M64ERR_INPUT_INVALID;
+
+    SDL_LockMutex(l_RequestLock);
+    if (!main_is_paused() || l_BatchUnit != 0)
+    {
+        SDL_UnlockMutex(l_RequestLock);
+        return M64ERR_INVALID_STATE;
+    }
+    l_BatchRemaining = requested;
+    l_BatchUnit = unit;
+    SDL_UnlockMutex(l_RequestLock);
+
+    rompause = 0;
+    SDL_SemPost(l_PauseWake);
+
+    SDL_SemWait(l_BatchDone);
+
+    SDL_LockMutex(l_RequestLock);
+    remaining = l_BatchRemaining;
+    l_BatchRemaining = 0;
+    SDL_UnlockMutex(l_RequestLock);
+
+    *count = requested - remaining;
+    return (remaining == 0) ? M64ERR_SUCCESS : M64ERR_INVALID_STATE;
+}
+
+/* must be called with l_RequestLock held */
+static void batch_step(void)
+{
+    if (l_BatchRemaining > 0 && --l_BatchRemaining == 0)
+        rompause = 1;
+}
+
+/* give control back to the main_advance_batch() caller, if any */
+static int batch_end(void)
+{
+    int unit;
+
+    SDL_LockMutex(l_RequestLock);
+    unit = l_BatchUnit;
+    l_BatchUnit = 0;
+    SDL_UnlockMutex(l_RequestLock);
+
+    if (unit != 0)
+        SDL_SemPost(l_BatchDone);
+
+    return unit != 0;
+}
+
 static void main_draw_volume_osd(void)
 {
     char msgString[64];
@@ -441,10 +548,10 @@ void main_state_inc_slot(void)
 
 void main_state_load(const char *filename)
 {
-    rumblepak_rumble(&g_si.pif.controllers[0].rumblepak, RUMBLE_STOP);
-    rumblepak_rumble(&g_si.pif.controllers[1].rumblepak, RUMBLE_STOP);
-    rumblepak_rumble(&g_si.pif.controllers[2].rumblepak, RUMBLE_STOP);
-    rumblepak_rumble(&g_si.pif.controllers[3].rumblepak, RUMBLE_STOP);
+    rumblepak_rumble(&g_dev.si.pif.controllers[0].rumblepak, RUMBLE_STOP);
+    rumblepak_rumble(&g_dev.si.pif.controllers[1].rumblepak, RUMBLE_STOP);
+    rumblepak_rumble(&g_dev.si.pif.controllers[2].rumblepak, RUMBLE_STOP);
+    rumblepak_rumble(&g_dev.si.pif.controllers[3].rumblepak, RUMBLE_STOP);
 
     if (filename == NULL) // Save to slot
         savestates_set_job(savestates_job_load, savestates_type_m64p, NULL);
@@ -460,6 +567,34 @@ void main_state_save(int format, const char *filename)
         savestates_set_job(savestates_job_save, (savestates_type)format, filename);
 }
 
+void main_state_load_buffer(void *buffer, size_t size)
+{
+    rumblepak_rumble(&g_dev.si.pif.controllers[0].rumblepak, RUMBLE_STOP);
+    rumblepak_rumble(&g_dev.si.pif.controllers[1].rumblepak, RUMBLE_STOP);
+    rumblepak_rumble(&g_dev.si.pif.controllers[2].rumblepak, RUMBLE_STOP);
+    rumblepak_rumble(&g_dev.si.pif.controllers[3].rumblepak, RUMBLE_STOP);
+
+    savestates_set_mem_job(savestates_job_load, buffer, size);
+}
+
+void main_state_save_buffer(void *buffer, size_t size)
+{
+    savestates_set_mem_job(savestates_job_save, buffer, size);
+}
+
+m64p_error main_state_rewind(int frames)
+{
+    if (!rewind_request(frames))
+        return M64ERR_INVALID_STATE;
+
+    rumblepak_rumble(&g_dev.si.pif.controllers[0].rumblepak, RUMBLE_STOP);
+    rumblepak_rumble(&g_dev.si.pif.controllers[1].rumblepak, RUMBLE_STOP);
+    rumblepak_rumble(&g_dev.si.pif.controllers[2].rumblepak, RUMBLE_STOP);
+    rumblepak_rumble(&g_dev.si.pif.controllers[3].rumblepak, RUMBLE_STOP);
+
+    return M64ERR_SUCCESS;
+}
+
 m64p_error main_core_state_query(m64p_core_param param, int *rval)
 {
     switch (param)
@@ -510,6 +645,12 @@ m64p_error main_core_state_query(m64p_core_param param, int *rval)
         case M64CORE_INPUT_GAMESHARK:
             *rval = event_gameshark_active();
             break;
+        case M64CORE_STATE_BUFFER_SIZE:
+            *rval = (int) savestates_get_mem_size();
+            break;
+        case M64CORE_RENDER_SKIP:
+            *rval = l_RenderSkip;
+            break;
         // these are only used for callbacks; they cannot be queried or set
         case M64CORE_STATE_LOADCOMPLETE:
         case M64CORE_STATE_SAVECOMPLETE:
@@ -609,6 +750,14 @@ m64p_error main_core_state_set(m64p_core_param param, int val)
         case M64CORE_STATE_LOADCOMPLETE:
         case M64CORE_STATE_SAVECOMPLETE:
             return M64ERR_INPUT_INVALID;
+        // read-only
+        case M64CORE_STATE_BUFFER_SIZE:
+            return M64ERR_INPUT_INVALID;
+        case M64CORE_RENDER_SKIP:
+            if (val < -1)
+                return M64ERR_INPUT_INVALID;
+            l_RenderSkip = val;
+            return M64ERR_SUCCESS;
         default:
             return M64ERR_INPUT_INVALID;
     }
@@ -725,11 +874,25 @@ void new_frame(void)
     /* advance the current frame */
     l_CurrentFrame++;
 
+    /* decide whether the display lists of this frame are rendered */
+    SDL_LockMutex(l_RequestLock);
+    l_RenderFrame = l_RenderNextFrame || l_RenderSkip == 0
+                 || (l_RenderSkip > 0 && l_CurrentFrame % (l_RenderSkip + 1) == 0);
+    l_RenderNextFrame = 0;
+    SDL_UnlockMutex(l_RequestLock);
+
+    rewind_new_frame();
+
     if (l_FrameAdvance) {
         rompause = 1;
         l_FrameAdvance = 0;
         StateChanged(M64CORE_EMU_STATE, M64EMU_PAUSED);
     }
+
+    SDL_LockMutex(l_RequestLock);
+    if (l_BatchUnit == M64BATCH_FRAMES)
+        batch_step();
+    SDL_UnlockMutex(l_RequestLock);
 }
 
 static void apply_speed_limiter(void)
@@ -804,12 +967,16 @@ static void pause_loop(void)
 {
     if(rompause)
     {
-        osd_render();  // draw Paused message in case gfx.updateScreen didn't do it
-        VidExt_GL_SwapBuffers();
+        if (!batch_end())
+        {
+            osd_render();  // draw Paused message in case gfx.updateScreen didn't do it
+            VidExt_GL_SwapBuffers();
+        }
+
         while(rompause)
         {
-            SDL_Delay(10);
-            main_check_inputs();
+            if (SDL_SemWaitTimeout(l_PauseWake, 10) != 0)
+                main_check_inputs();
         }
     }
 }
@@ -818,7 +985,24 @@ static void pause_loop(void)
  * Allow the core to perform various things */
 void new_vi(void)
 {
+    int batch_unit;
+
     gs_apply_cheats();
+    savestates_report_saves();
+
+    SDL_LockMutex(l_RequestLock);
+    batch_unit = l_BatchUnit;
+    if (batch_unit == M64BATCH_VIS)
+        batch_step();
+    SDL_UnlockMutex(l_RequestLock);
+
+    if (batch_unit != 0)
+    {
+        // batches run unthrottled and don't poll for inputs
+        timed_sections_refresh();
+        pause_loop();
+        return;
+    }
 
     main_check_inputs();
 
@@ -829,29 +1013,6 @@ void new_vi(void)
     apply_speed_limiter();
 }
 
-static void connect_all(
-        struct r4300_core* r4300,
-        struct rdp_core* dp,
-        struct rsp_core* sp,
-        struct ai_controller* ai,
-        struct pi_controller* pi,
-        struct ri_controller* ri,
-        struct si_controller* si,
-        struct vi_controller* vi,
-        uint32_t* dram,
-        size_t dram_size,
-        uint8_t* rom,
-        size_t rom_size)
-{
-    connect_rdp(dp, r4300, sp, ri);
-    connect_rsp(sp, r4300, dp, ri);
-    connect_ai(ai, r4300, ri, vi);
-    connect_pi(pi, r4300, ri, rom, rom_size);
-    connect_ri(ri, dram, dram_size);
-    connect_si(si, r4300, ri);
-    connect_vi(vi, r4300);
-}
-
 /*********************************************************************************************************
 * emulation thread - runs the core
 */
@@ -872,7 +1033,16 @@ m64p_error main_run(void)
     savestates_set_autoinc_slot(ConfigGetParamBool(g_CoreConfig, "AutoStateSlotIncrement"));
     savestates_select_slot(ConfigGetParamInt(g_CoreConfig, "CurrentStateSlot"));
     no_compiled_jump = ConfigGetParamBool(g_CoreConfig, "NoCompiledJump");
+    use_fastmem = ConfigGetParamBool(g_CoreConfig, "FastMem");
+    code_cache_size_mb = ConfigGetParamInt(g_CoreConfig, "CodeCacheSize");
     g_delay_si = ConfigGetParamBool(g_CoreConfig, "DelaySI");
+    l_RenderSkip = ConfigGetParamInt(g_CoreConfig, "RenderSkip");
+    if (l_RenderSkip < -1)
+        l_RenderSkip = 0;
+    SDL_LockMutex(l_RequestLock);
+    l_RenderNextFrame = 0;
+    SDL_UnlockMutex(l_RequestLock);
+    l_RenderFrame = 1;
     disable_extra_mem = ConfigGetParamInt(g_CoreConfig, "DisableExtraMem");
     count_per_op = ConfigGetParamInt(g_CoreConfig, "CountPerOp");
     if (count_per_op <= 0)
@@ -886,25 +1056,29 @@ m64p_error main_run(void)
         g_MemHasBeenBSwapped = 1;
     }
 
-    connect_all(&g_r4300, &g_dp, &g_sp,
-                &g_ai, &g_pi, &g_ri, &g_si, &g_vi,
-                g_rdram, (disable_extra_mem == 0) ? 0x800000 : 0x400000,
-                g_rom, g_rom_size);
+    connect_device(&g_dev,
+                   g_rdram, (disable_extra_mem == 0) ? 0x800000 : 0x400000,
+                   g_rom, g_rom_size);
+
+    /* before init_memory, which maps RDRAM according to the audio mode */
+    g_dev.sp.skip_audio = ConfigGetParamBool(g_CoreConfig, "SkipRspAudio") && !plugin_audio_attached();
+    if (ConfigGetParamBool(g_CoreConfig, "AsyncRspAudio") && !enable_async_rsp_audio(&g_dev.sp))
+        DebugMessage(M64MSG_WARNING, "Couldn't run RSP audio tasks asynchronously, running them on the emulation thread.");
 
     init_memory();
 
     // Attach rom to plugins
     if (!gfx.romOpen())
     {
-        return M64ERR_PLUGIN_FAIL;
+        disable_async_rsp_audio(&g_dev.sp); return M64ERR_PLUGIN_FAIL;
     }
     if (!audio.romOpen())
     {
-        gfx.romClosed(); return M64ERR_PLUGIN_FAIL;
+        gfx.romClosed(); disable_async_rsp_audio(&g_dev.sp); return M64ERR_PLUGIN_FAIL;
     }
     if (!input.romOpen())
     {
-        audio.romClosed(); gfx.romClosed(); return M64ERR_PLUGIN_FAIL;
+        audio.romClosed(); gfx.romClosed(); disable_async_rsp_audio(&g_dev.sp); return M64ERR_PLUGIN_FAIL;
     }
 
     /* set up the SDL key repeat and event filter to catch keyboard/joystick commands for the core */
@@ -923,67 +1097,67 @@ m64p_error main_run(void)
     gfx.setRenderingCallback(video_plugin_render_callback);
 
     /* connect external audio sink to AI component */
-    g_ai.user_data = &g_ai;
-    g_ai.set_audio_format = set_audio_format_via_audio_plugin;
-    g_ai.push_audio_samples = push_audio_samples_via_audio_plugin;
+    g_dev.ai.user_data = &g_dev.ai;
+    g_dev.ai.set_audio_format = set_audio_format_via_audio_plugin;
+    g_dev.ai.push_audio_samples = push_audio_samples_via_audio_plugin;
 
     /* connect external time source to AF_RTC component */
-    g_si.pif.af_rtc.user_data = NULL;
-    g_si.pif.af_rtc.get_time = get_time_using_C_localtime;
+    g_dev.si.pif.af_rtc.user_data = NULL;
+    g_dev.si.pif.af_rtc.get_time = get_time_using_C_localtime;
 
     /* connect external game controllers */
     for(i = 0; i < GAME_CONTROLLERS_COUNT; ++i)
     {
-        g_si.pif.controllers[i].user_data = &channels[i];
-        g_si.pif.controllers[i].is_connected = egcvip_is_connected;
-        g_si.pif.controllers[i].get_input = egcvip_get_input;
+        g_dev.si.pif.controllers[i].user_data = &channels[i];
+        g_dev.si.pif.controllers[i].is_connected = egcvip_is_connected;
+        g_dev.si.pif.controllers[i].get_input = egcvip_get_input;
     }
 
     /* connect external rumblepaks */
     for(i = 0; i < GAME_CONTROLLERS_COUNT; ++i)
     {
-        g_si.pif.controllers[i].rumblepak.user_data = &channels[i];
-        g_si.pif.controllers[i].rumblepak.rumble = rvip_rumble;
+        g_dev.si.pif.controllers[i].rumblepak.user_data = &channels[i];
+        g_dev.si.pif.controllers[i].rumblepak.rumble = rvip_rumble;
     }
 
     /* open mpk file (if any) and connect it to mempaks */
     open_mpk_file(&mpk, get_mempaks_path());
     for(i = 0; i < GAME_CONTROLLERS_COUNT; ++i)
     {
-        g_si.pif.controllers[i].mempak.user_data = &mpk;
-        g_si.pif.controllers[i].mempak.save = save_mpk_file;
-        g_si.pif.controllers[i].mempak.data = mpk_file_ptr(&mpk, i);
+        g_dev.si.pif.controllers[i].mempak.user_data = &mpk;
+        g_dev.si.pif.controllers[i].mempak.save = save_mpk_file;
+        g_dev.si.pif.controllers[i].mempak.data = mpk_file_ptr(&mpk, i);
     }
 
     /* open eep file (if any) and connect it to eeprom */
     open_eep_file(&eep, get_eeprom_path());
-    g_si.pif.eeprom.user_data = &eep;
-    g_si.pif.eeprom.save = save_eep_file;
-    g_si.pif.eeprom.data = eep_file_ptr(&eep);
+    g_dev.si.pif.eeprom.user_data = &eep;
+    g_dev.si.pif.eeprom.save = save_eep_file;
+    g_dev.si.pif.eeprom.data = eep_file_ptr(&eep);
     if (ROM_SETTINGS.savetype != EEPROM_16KB)
     {
         /* 4kbits EEPROM */
-        g_si.pif.eeprom.size = 0x200;
-        g_si.pif.eeprom.id = 0x8000;
+        g_dev.si.pif.eeprom.size = 0x200;
+        g_dev.si.pif.eeprom.id = 0x8000;
     }
     else
     {
         /* 16kbits EEPROM */
-        g_si.pif.eeprom.size = 0x800;
-        g_si.pif.eeprom.id = 0xc000;
+        g_dev.si.pif.eeprom.size = 0x800;
+        g_dev.si.pif.eeprom.id = 0xc000;
     }
 
     /* open fla file (if any) and connect it to flashram */
     open_fla_file(&fla, get_flashram_path());
-    g_pi.flashram.user_data = &fla;
-    g_pi.flashram.save = save_fla_file;
-    g_pi.flashram.data = fla_file_ptr(&fla);
+    g_dev.pi.flashram.user_data = &fla;
+    g_dev.pi.flashram.save = save_fla_file;
+    g_dev.pi.flashram.data = fla_file_ptr(&fla);
 
     /* open sra file (if any) and connect it to SRAM */
     open_sra_file(&sra, get_sram_path());
-    g_pi.sram.user_data = &sra;
-    g_pi.sram.save = save_sra_file;
-    g_pi.sram.data = sra_file_ptr(&sra);
+    g_dev.pi.sram.user_data = &sra;
+    g_dev.pi.sram.save = save_sra_file;
+    g_dev.pi.sram.data = sra_file_ptr(&sra);
 
 #ifdef WITH_LIRC
     lircStart();
@@ -997,15 +1171,20 @@ m64p_error main_run(void)
     /* Startup message on the OSD */
     osd_new_message(OSD_MIDDLE_CENTER, "Mupen64Plus Started...");
 
+    rewind_init(ConfigGetParamInt(g_CoreConfig, "RewindBufferSize"),
+                ConfigGetParamInt(g_CoreConfig, "RewindInterval"));
+
     g_EmulatorRunning = 1;
     StateChanged(M64CORE_EMU_STATE, M64EMU_RUNNING);
 
     /* call r4300 CPU core and run the game */
     r4300_reset_hard();
-    r4300_reset_soft();
+    r4300_reset_soft(&g_dev);
     r4300_execute();
 
     /* now begin to shut down */
+    disable_async_rsp_audio(&g_dev.sp);
+
 #ifdef WITH_LIRC
     lircStop();
 #endif // WITH_LIRC
@@ -1015,6 +1194,9 @@ m64p_error main_run(void)
         destroy_debugger();
 #endif
 
+    rewind_deinit();
+    savestates_report_saves();
+
     close_sra_file(&sra);
     close_fla_file(&fla);
     close_eep_file(&eep);
@@ -1034,6 +1216,9 @@ m64p_error main_run(void)
     g_EmulatorRunning = 0;
     StateChanged(M64CORE_EMU_STATE, M64EMU_STOPPED);
 
+    /* release a frontend thread still waiting for a batch to finish */
+    batch_end();
+
     return M64ERR_SUCCESS;
 }
 
@@ -1063,6 +1248,7 @@ void main_stop(void)
     if (rompause)
     {
         rompause = 0;
+        SDL_SemPost(l_PauseWake);
         StateChanged(M64CORE_EMU_STATE, M64EMU_RUNNING);
     }
     stop = 1;
@@ -23,19 +23,13 @@
 #ifndef __MAIN_H__
 #define __MAIN_H__
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include "api/m64p_types.h"
 #include "osal/preproc.h"
 
-struct ai_controller;
-struct pi_controller;
-struct r4300_core;
-struct rdp_core;
-struct ri_controller;
-struct rsp_core;
-struct si_controller;
-struct vi_controller;
+struct device;
 
 enum { RDRAM_MAX_SIZE = 0x800000 };
 
@@ -45,17 +39,10 @@ extern m64p_handle g_CoreConfig;
 extern int g_MemHasBeenBSwapped;
 extern int g_EmulatorRunning;
 
-extern ALIGN(16, uint32_t g_rdram[RDRAM_MAX_SIZE/4]);
+/* page aligned so that it can be remapped for fastmem */
+extern ALIGN(4096, uint32_t g_rdram[RDRAM_MAX_SIZE/4]);
 
-extern struct ai_controller g_ai;
-extern struct pi_controller g_pi;
-extern struct ri_controller g_ri;
-extern struct si_controller g_si;
-extern struct vi_controller g_vi;
-
-extern struct r4300_core g_r4300;
-extern struct rdp_core g_dp;
-extern struct rsp_core g_sp;
+extern struct device g_dev;
 
 extern m64p_frame_callback g_FrameCallback;
 
@@ -71,6 +58,8 @@ void main_check_inputs(void);
 void new_frame(void);
 void new_vi(void);
 
+void main_init(void);
+void main_deinit(void);
 int  main_set_core_defaults(void);
 void main_message(m64p_msg_level level, unsigned int osd_corner, const char *format, ...);
 
@@ -78,6 +67,9 @@ m64p_error main_run(void);
 void main_stop(void);
 void main_toggle_pause(void);
 void main_advance_one(void);
+void main_render_next_frame(void);
+int main_frame_rendered(void);
+m64p_error main_advance_batch(m64p_batch_unit unit, int *count);
 
 void main_speedup(int percent);
 void main_speeddown(int percent);
@@ -89,6 +81,9 @@ void main_state_set_slot(int slot);
 void main_state_inc_slot(void);
 void main_state_load(const char *filename);
 void main_state_save(int format, const char *filename);
+void main_state_load_buffer(void *buffer, size_t size);
+void main_state_save_buffer(void *buffer, size_t size);
+m64p_error main_state_rewind(int frames);
 
 m64p_error main_core_state_query(m64p_core_param param, int *rval);
 m64p_error main_core_state_set(m64p_core_param param, int val);
@@ -50,10 +50,13 @@ void open_mpk_file(struct mpk_file* mpk, const char* filename)
     default:
         break;
     }
+
+    open_write_behind(&mpk->wb, mpk->filename, "mem pak", &mpk->mempaks[0][0], GAME_CONTROLLERS_COUNT*MEMPAK_SIZE);
 }
 
 void close_mpk_file(struct mpk_file* mpk)
 {
+    close_write_behind(&mpk->wb);
     free((void*)mpk->filename);
 }
 
@@ -64,18 +67,8 @@ uint8_t* mpk_file_ptr(struct mpk_file* mpk, size_t controller_idx)
 
 void save_mpk_file(void* opaque)
 {
-    /* flush mempak to disk */
+    /* queue mempak flush to disk */
     struct mpk_file* mpk = (struct mpk_file*)opaque;
 
-    switch(write_to_file(mpk->filename, mpk->mempaks, GAME_CONTROLLERS_COUNT*MEMPAK_SIZE))
-    {
-    case file_open_error:
-        DebugMessage(M64MSG_WARNING, "couldn't open mem pak file '%s' for writing", mpk->filename);
-        break;
-    case file_write_error:
-        DebugMessage(M64MSG_WARNING, "failed to write mem pak file '%s'", mpk->filename);
-        break;
-    default:
-        break;
-    }
+    write_behind_mark_dirty(&mpk->wb);
 }
@@ -27,11 +27,13 @@
 
 #include "si/mempak.h"
 #include "si/pif.h"
+#include "write_behind.h"
 
 struct mpk_file
 {
     uint8_t mempaks[GAME_CONTROLLERS_COUNT][MEMPAK_SIZE];
     const char* filename;
+    struct write_behind wb;
 };
 
 void open_mpk_file(struct mpk_file* mpk, const char* filename);
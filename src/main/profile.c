@@ -21,15 +21,11 @@
  *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
-#ifdef PROFILE
 #include "profile.h"
 
 #include "api/callbacks.h"
 #include "api/m64p_types.h"
 
-static long long int time_in_section[NUM_TIMED_SECTIONS];
-static long long int last_start[NUM_TIMED_SECTIONS];
-
 #if defined(WIN32) && !defined(__MINGW32__)
   // timing
   #include <windows.h>
@@ -64,6 +60,17 @@ static long long int last_start[NUM_TIMED_SECTIONS];
   }
 #endif
 
+long long int profile_time_nsec(void)
+{
+   return time_to_nsec(get_time());
+}
+
+#ifdef PROFILE
+static long long int time_in_section[NUM_TIMED_SECTIONS];
+static long long int last_start[NUM_TIMED_SECTIONS];
+static long long int total_in_section[NUM_TIMED_SECTIONS];
+static long long int counters[NUM_PROFILE_COUNTERS];
+
 void timed_section_start(enum timed_section section)
 {
    last_start[section] = get_time();
@@ -73,6 +80,22 @@ void timed_section_end(enum timed_section section)
 {
    long long int end = get_time();
    time_in_section[section] += end - last_start[section];
+   total_in_section[section] += end - last_start[section];
+}
+
+void profile_counter_inc(enum profile_counter counter)
+{
+   ++counters[counter];
+}
+
+long long int timed_section_total_nsec(enum timed_section section)
+{
+   return time_to_nsec(total_in_section[section]);
+}
+
+long long int profile_counter_get(enum profile_counter counter)
+{
+   return counters[counter];
 }
 
 void timed_sections_refresh()
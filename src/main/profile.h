@@ -34,14 +34,29 @@ enum timed_section
     NUM_TIMED_SECTIONS
 };
 
+enum profile_counter
+{
+    PROFILE_COUNTER_BLOCKS_INITIALIZED,
+    PROFILE_COUNTER_BLOCKS_COMPILED,
+    NUM_PROFILE_COUNTERS
+};
+
+/* monotonic clock, available even without PROFILE */
+long long int profile_time_nsec(void);
+
 #ifdef PROFILE
   void timed_section_start(enum timed_section section);
   void timed_section_end(enum timed_section section);
   void timed_sections_refresh(void);
+  void profile_counter_inc(enum profile_counter counter);
+  /* totals since startup, unaffected by timed_sections_refresh() */
+  long long int timed_section_total_nsec(enum timed_section section);
+  long long int profile_counter_get(enum profile_counter counter);
 #else
   #define timed_section_start(a)
   #define timed_section_end(a)
   #define timed_sections_refresh()
+  #define profile_counter_inc(a)
 #endif
 
 #endif
@@ -0,0 +1,401 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - rewind.c                                                *
+ *   Mupen64Plus homepage: http://code.google.com/p/mupen64plus/           *
+ *   Copyright (C) 2015 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <SDL.h>
+#include <SDL_thread.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "api/callbacks.h"
+#include "api/m64p_types.h"
+#include "main.h"
+#include "main/list.h"
+#include "osd/osd.h"
+#include "rewind.h"
+#include "savestates.h"
+#include "workqueue.h"
+
+/* Snapshots are deltas against the last keyframe, which is a full savestate.
+ * A new keyframe is started every REWIND_KEYFRAME_INTERVAL snapshots, so that
+ * restoring any snapshot needs at most two decompressions. */
+enum { REWIND_KEYFRAME_INTERVAL = 60 };
+
+/* largest memory budget, in MB, which also fits a 32-bit size_t */
+enum { REWIND_MAX_BUDGET = 2048 };
+
+struct rewind_snapshot {
+    struct list_head list;
+    struct work_struct work;
+    struct rewind_snapshot *keyframe;   /* NULL if this snapshot is a keyframe */
+    unsigned int frame;
+    unsigned char *raw;                 /* uncompressed data, until compressed */
+    size_t raw_size;
+    unsigned char *data;                /* zlib compressed data */
+    size_t size;
+    int pending;                        /* compression is queued or running */
+    int discarded;                      /* removed from the buffer while pending */
+};
+
+static struct list_head l_snapshots;    // oldest snapshot first
+static SDL_mutex *l_lock = NULL;        // protects l_snapshots, l_used and l_keyframe
+static struct work_fence l_fence;       // pending compressions
+static size_t l_used = 0;               // memory used by the snapshots
+static size_t l_budget = 0;             // 0 if rewinding is disabled
+static int l_interval = 1;
+
+static unsigned int l_frame = 0;
+static volatile int l_save_job = 0;     // a snapshot is due
+static volatile int l_load_job = 0;     // number of frames to step back
+
+static unsigned char *l_state = NULL;           // full savestate scratch buffer
+static unsigned char *l_delta = NULL;           // delta savestate scratch buffer
+static unsigned char *l_keyframe_state = NULL;  // uncompressed copy of l_keyframe
+static size_t l_keyframe_size = 0;
+static struct rewind_snapshot *l_keyframe = NULL;
+static int l_since_keyframe = 0;
+
+static size_t rewind_snapshot_used(const struct rewind_snapshot *s)
+{
+    return (s->raw != NULL) ? s->raw_size : s->size;
+}
+
+static void rewind_free_snapshot(struct rewind_snapshot *s)
+{
+    free(s->raw);
+    free(s->data);
+    free(s);
+}
+
+/* Remove a snapshot from the buffer; the lock must be held. Snapshots still
+ * being compressed are freed by the worker once it is done with them. */
+static void rewind_drop_snapshot(struct rewind_snapshot *s)
+{
+    list_del(&s->list);
+    l_used -= rewind_snapshot_used(s);
+
+    if (s == l_keyframe)
+        l_keyframe = NULL;
+
+    if (s->pending)
+        s->discarded = 1;
+    else
+        rewind_free_snapshot(s);
+}
+
+/* Drop the oldest snapshots until the buffer fits the budget; the lock must
+ * be held. A keyframe is dropped together with the deltas based on it. */
+static void rewind_trim(void)
+{
+    struct rewind_snapshot *oldest, *s, *safe;
+
+    while (l_used > l_budget && !list_empty(&l_snapshots))
+    {
+        oldest = list_first_entry(&l_snapshots, struct rewind_snapshot, list);
+        if (oldest->pending)
+            break;
+
+        list_for_each_entry_safe_t(s, safe, &l_snapshots, struct rewind_snapshot, list)
+        {
+            if (s->keyframe == oldest)
+                rewind_drop_snapshot(s);
+        }
+        rewind_drop_snapshot(oldest);
+    }
+}
+
+static void rewind_compress_work(struct work_struct *work)
+{
+    struct rewind_snapshot *s = container_of(work, struct rewind_snapshot, work);
+    uLongf size = compressBound(s->raw_size);
+    unsigned char *data = (unsigned char *)malloc(size);
+
+    if (data != NULL && compress2(data, &size, s->raw, s->raw_size, Z_BEST_SPEED) != Z_OK)
+    {
+        free(data);
+        data = NULL;
+    }
+
+    /* if compression failed, the snapshot is simply kept uncompressed */
+    SDL_LockMutex(l_lock);
+    s->pending = 0;
+    if (s->discarded)
+    {
+        free(data);
+        rewind_free_snapshot(s);
+    }
+    else if (data != NULL)
+    {
+        l_used -= s->raw_size;
+        free(s->raw);
+        s->raw = NULL;
+        s->data = data;
+        s->size = size;
+        l_used += size;
+        rewind_trim();
+    }
+    SDL_UnlockMutex(l_lock);
+}
+
+/* Copy the uncompressed data of a snapshot to out; the lock must be held */
+static size_t rewind_decode(const struct rewind_snapshot *s, unsigned char *out, size_t out_size)
+{
+    uLongf size = out_size;
+
+    if (s->raw != NULL)
+    {
+        if (s->raw_size > out_size)
+            return 0;
+        memcpy(out, s->raw, s->raw_size);
+        return s->raw_size;
+    }
+
+    if (uncompress(out, &size, s->data, s->size) != Z_OK)
+        return 0;
+
+    return size;
+}
+
+int rewind_init(int budget, int interval)
+{
+    INIT_LIST_HEAD(&l_snapshots);
+    l_used = 0;
+    l_frame = 0;
+    l_save_job = 0;
+    l_load_job = 0;
+    l_keyframe = NULL;
+    l_since_keyframe = 0;
+    if (budget > REWIND_MAX_BUDGET)
+    {
+        DebugMessage(M64MSG_WARNING, "Rewind buffer size limited to %i MB", REWIND_MAX_BUDGET);
+        budget = REWIND_MAX_BUDGET;
+    }
+    l_budget = (budget > 0) ? (size_t)budget << 20 : 0;
+    l_interval = (interval > 0) ? interval : 1;
+
+    if (l_budget == 0)
+        return 1;
+
+    l_lock = SDL_CreateMutex();
+    l_state = (unsigned char *)malloc(savestates_get_full_mem_size());
+    l_keyframe_state = (unsigned char *)malloc(savestates_get_full_mem_size());
+    l_delta = (unsigned char *)malloc(savestates_get_mem_size());
+
+    if (l_lock == NULL || init_work_fence(&l_fence) != 0 || l_state == NULL || l_keyframe_state == NULL || l_delta == NULL)
+    {
+        DebugMessage(M64MSG_ERROR, "Could not allocate rewind buffer, rewinding is disabled");
+        rewind_deinit();
+        return 0;
+    }
+
+    DebugMessage(M64MSG_INFO, "Rewind buffer of %u MB, one snapshot every %i frame(s)",
+                 (unsigned int)(l_budget >> 20), l_interval);
+    return 1;
+}
+
+void rewind_deinit(void)
+{
+    struct rewind_snapshot *s, *safe;
+
+    if (l_lock != NULL)
+    {
+        wait_work_fence(&l_fence);
+        destroy_work_fence(&l_fence);
+
+        SDL_LockMutex(l_lock);
+        list_for_each_entry_safe_t(s, safe, &l_snapshots, struct rewind_snapshot, list)
+            rewind_drop_snapshot(s);
+        SDL_UnlockMutex(l_lock);
+
+        SDL_DestroyMutex(l_lock);
+        l_lock = NULL;
+    }
+
+    free(l_state);
+    free(l_keyframe_state);
+    free(l_delta);
+    l_state = NULL;
+    l_keyframe_state = NULL;
+    l_delta = NULL;
+
+    l_budget = 0;
+    l_save_job = 0;
+    l_load_job = 0;
+}
+
+void rewind_new_frame(void)
+{
+    if (l_budget == 0)
+        return;
+
+    if (++l_frame % l_interval == 0)
+        l_save_job = 1;
+}
+
+int rewind_request(int frames)
+{
+    if (l_budget == 0 || frames <= 0)
+        return 0;
+
+    l_load_job = frames;
+    return 1;
+}
+
+int rewind_save_pending(void)
+{
+    return l_save_job;
+}
+
+int rewind_load_pending(void)
+{
+    return l_load_job != 0;
+}
+
+void rewind_save(struct device* dev)
+{
+    struct rewind_snapshot *s;
+    size_t full_size, size;
+    int keyframe;
+
+    l_save_job = 0;
+
+    full_size = savestates_save_m64p_buffer(dev, l_state, savestates_get_full_mem_size());
+    if (full_size == 0)
+        return;
+
+    SDL_LockMutex(l_lock);
+    keyframe = (l_keyframe == NULL || l_since_keyframe >= REWIND_KEYFRAME_INTERVAL);
+    SDL_UnlockMutex(l_lock);
+
+    if (keyframe)
+    {
+        memcpy(l_keyframe_state, l_state, full_size);
+        l_keyframe_size = full_size;
+        size = full_size;
+    }
+    else
+    {
+        size = savestates_make_delta(l_keyframe_state, l_keyframe_size,
+                                     l_state, full_size, l_delta, savestates_get_mem_size());
+        if (size == 0)
+            return;
+    }
+
+    s = (struct rewind_snapshot *)malloc(sizeof(*s));
+    if (s == NULL)
+        return;
+    memset(s, 0, sizeof(*s));
+    s->raw = (unsigned char *)malloc(size);
+    if (s->raw == NULL)
+    {
+        free(s);
+        return;
+    }
+    memcpy(s->raw, keyframe ? l_state : l_delta, size);
+    s->raw_size = size;
+    s->frame = l_frame;
+    s->pending = 1;
+    init_work(&s->work, rewind_compress_work);
+
+    SDL_LockMutex(l_lock);
+    if (!keyframe && l_keyframe == NULL)
+    {
+        /* the keyframe was dropped meanwhile, start a new one next time */
+        SDL_UnlockMutex(l_lock);
+        rewind_free_snapshot(s);
+        return;
+    }
+
+    if (keyframe)
+    {
+        l_keyframe = s;
+        l_since_keyframe = 0;
+    }
+    else
+        s->keyframe = l_keyframe;
+    ++l_since_keyframe;
+
+    list_add_tail(&s->list, &l_snapshots);
+    l_used += size;
+    rewind_trim();
+    SDL_UnlockMutex(l_lock);
+
+    queue_work_fenced(&s->work, &l_fence);
+}
+
+void rewind_load(struct device* dev)
+{
+    struct rewind_snapshot *s, *safe, *target = NULL;
+    unsigned int frames = l_load_job;
+    unsigned int frame = (frames < l_frame) ? l_frame - frames : 0;
+    size_t size = 0, delta_size;
+    int ret = 0;
+
+    l_load_job = 0;
+
+    SDL_LockMutex(l_lock);
+
+    /* pick the latest snapshot at or before the requested frame, or the oldest one */
+    list_for_each_entry_safe_t(s, safe, &l_snapshots, struct rewind_snapshot, list)
+    {
+        if (target != NULL && s->frame > frame)
+            break;
+        target = s;
+    }
+
+    if (target == NULL)
+    {
+        SDL_UnlockMutex(l_lock);
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Rewind buffer is empty.");
+        StateChanged(M64CORE_STATE_LOADCOMPLETE, 0);
+        return;
+    }
+
+    if (target->keyframe == NULL)
+        size = rewind_decode(target, l_state, savestates_get_full_mem_size());
+    else
+    {
+        size = rewind_decode(target->keyframe, l_state, savestates_get_full_mem_size());
+        delta_size = rewind_decode(target, l_delta, savestates_get_mem_size());
+        if (size != 0 && delta_size != 0)
+            size = savestates_apply_delta(l_state, size, l_delta, delta_size, l_state);
+        else
+            size = 0;
+    }
+
+    /* the snapshots after the target belong to a future which is about to vanish */
+    list_for_each_entry_safe_t(s, safe, &l_snapshots, struct rewind_snapshot, list)
+    {
+        if (s->frame > target->frame)
+            rewind_drop_snapshot(s);
+    }
+    l_frame = target->frame;
+    l_keyframe = NULL;
+    SDL_UnlockMutex(l_lock);
+
+    if (size != 0)
+        ret = savestates_load_m64p_buffer(dev, l_state, size);
+    else
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Corrupted rewind snapshot.");
+
+    StateChanged(M64CORE_STATE_LOADCOMPLETE, ret);
+}
@@ -0,0 +1,45 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - rewind.h                                                *
+ *   Mupen64Plus homepage: http://code.google.com/p/mupen64plus/           *
+ *   Copyright (C) 2015 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_MAIN_REWIND_H
+#define M64P_MAIN_REWIND_H
+
+#include <stddef.h>
+
+struct device;
+
+/* The rewind buffer keeps compressed snapshots of the emulator state taken
+ * every RewindInterval frames, within a memory budget of RewindBufferSize MB.
+ * Snapshots are requested by new_frame() but taken (and restored) by
+ * gen_interupt(), where the emulator state can be safely serialized. */
+
+int rewind_init(int budget, int interval);
+void rewind_deinit(void);
+
+void rewind_new_frame(void);
+int rewind_request(int frames);
+
+int rewind_save_pending(void);
+int rewind_load_pending(void);
+void rewind_save(struct device* dev);
+void rewind_load(struct device* dev);
+
+#endif
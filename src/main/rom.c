@@ -38,6 +38,7 @@
 #include "main.h"
 #include "md5.h"
 #include "memory/memory.h"
+#include "osal/files.h"
 #include "osal/preproc.h"
 #include "osd/osd.h"
 #include "r4300/r4300.h"
@@ -56,6 +57,8 @@ static _romdatabase g_romdatabase;
 unsigned char* g_rom = NULL;
 /* Global loaded rom size. */
 int g_rom_size = 0;
+/* Size of the ROM cache file mapping g_rom, 0 if g_rom was malloc'd. */
+static size_t l_rom_mapped_size = 0;
 
 unsigned char isGoldeneyeRom = 0;
 
@@ -66,6 +69,7 @@ m64p_rom_settings ROM_SETTINGS;
 static m64p_system_type rom_country_code_to_system_type(uint16_t country_code);
 static int rom_system_type_to_ai_dac_rate(m64p_system_type system_type);
 static int rom_system_type_to_vi_limit(m64p_system_type system_type);
+static void swap_copy_rom_part(void* dst, const void* src, size_t len, unsigned char imagetype);
 
 static const uint8_t Z64_SIGNATURE[4] = { 0x80, 0x37, 0x12, 0x40 };
 static const uint8_t V64_SIGNATURE[4] = { 0x37, 0x80, 0x40, 0x12 };
@@ -100,25 +104,36 @@ static int is_valid_rom(const unsigned char *buffer)
 static void swap_copy_rom(void* dst, const void* src, size_t len, unsigned char* imagetype)
 {
     if (memcmp(src, V64_SIGNATURE, sizeof(V64_SIGNATURE)) == 0)
+        *imagetype = V64IMAGE;
+    else if (memcmp(src, N64_SIGNATURE, sizeof(N64_SIGNATURE)) == 0)
+        *imagetype = N64IMAGE;
+    else
+        *imagetype = Z64IMAGE;
+
+    swap_copy_rom_part(dst, src, len, *imagetype);
+}
+
+/* Same as swap_copy_rom, for any part of an image of a known format. */
+static void swap_copy_rom_part(void* dst, const void* src, size_t len, unsigned char imagetype)
+{
+    if (imagetype == V64IMAGE)
     {
         size_t i;
         const uint16_t* src16 = (const uint16_t*) src;
         uint16_t* dst16 = (uint16_t*) dst;
 
-        *imagetype = V64IMAGE;
         /* .v64 images have byte-swapped half-words (16-bit). */
         for (i = 0; i < len; i += 2)
         {
             *dst16++ = m64p_swap16(*src16++);
         }
     }
-    else if (memcmp(src, N64_SIGNATURE, sizeof(N64_SIGNATURE)) == 0)
+    else if (imagetype == N64IMAGE)
     {
         size_t i;
         const uint32_t* src32 = (const uint32_t*) src;
         uint32_t* dst32 = (uint32_t*) dst;
 
-        *imagetype = N64IMAGE;
         /* .n64 images have byte-swapped words (32-bit). */
         for (i = 0; i < len; i += 4)
         {
@@ -126,11 +141,129 @@ static void swap_copy_rom(void* dst, const void* src, size_t len, unsigned char*
         }
     }
     else {
-        *imagetype = Z64IMAGE;
         memcpy(dst, src, len);
     }
 }
 
+/* Checks a ROM cache file against ROM_HEADER. Cache files are named by the
+ * MD5 of the image and renamed into place once complete, so one of the right
+ * size and header holds the converted image. */
+static int check_rom_cache(const unsigned char* mapped, size_t mapped_size, size_t size)
+{
+    m64p_rom_header header;
+
+    if (mapped_size != size)
+        return 0;
+
+    memcpy(&header, &ROM_HEADER, sizeof(header));
+    swap_buffer(&header, 4, sizeof(header)/4);
+
+    return memcmp(&header, mapped, sizeof(header)) == 0;
+}
+
+/* Maps g_rom from the shared ROM cache, which holds images already converted
+ * to the layout main_run() expects (.z64 then 32-bit byte-swapped), named by
+ * MD5. The cache file is created if needed. All processes running the same
+ * ROM this way share the same read-only pages.
+ *
+ * Returns 1 with ROM_HEADER and digest filled, or 0 to fall back to a
+ * private copy of the ROM. */
+static int open_rom_cache(const unsigned char* romimage, size_t size,
+                          unsigned char* imagetype, md5_byte_t digest[16])
+{
+    md5_state_t state;
+    unsigned char *chunk;
+    const char *cachepath;
+    char *dirpath, *filepath;
+    char md5[33];
+    unsigned char *image;
+    const void *mapped;
+    size_t offset, len, mapped_size = 0;
+    int i;
+
+    if ((cachepath = osal_get_user_cachepath()) == NULL || (size % 4) != 0)
+        return 0;
+
+    chunk = (unsigned char *) malloc(CHUNKSIZE);
+    if (chunk == NULL)
+        return 0;
+
+    /* convert the image in chunks only to hash it, without a full private copy */
+    swap_copy_rom(chunk, romimage, 4, imagetype);
+    md5_init(&state);
+    for (offset = 0; offset < size; offset += len)
+    {
+        len = (size - offset < CHUNKSIZE) ? size - offset : CHUNKSIZE;
+        swap_copy_rom_part(chunk, romimage + offset, len, *imagetype);
+        if (offset == 0)
+            memcpy(&ROM_HEADER, chunk, sizeof(m64p_rom_header));
+        md5_append(&state, (const md5_byte_t*)chunk, len);
+    }
+    md5_finish(&state, digest);
+    for (i = 0; i < 16; ++i)
+        sprintf(md5+i*2, "%02X", digest[i]);
+    md5[32] = '\0';
+
+    dirpath = formatstr("%sroms", cachepath);
+    filepath = formatstr("%sroms%c%s.rom", cachepath, OSAL_DIR_SEPARATORS[0], md5);
+    if (dirpath == NULL || filepath == NULL)
+    {
+        free(dirpath);
+        free(filepath);
+        free(chunk);
+        return 0;
+    }
+
+    mapped = osal_map_file(filepath, &mapped_size);
+    if (mapped != NULL && !check_rom_cache((const unsigned char *) mapped, mapped_size, size))
+    {
+        DebugMessage(M64MSG_WARNING, "ROM cache file '%s' doesn't match the ROM, rebuilding it", filepath);
+        osal_unmap_file(mapped, mapped_size);
+        mapped = NULL;
+    }
+    free(chunk);
+
+    if (mapped == NULL)
+    {
+        image = (unsigned char *) malloc(size);
+        if (image == NULL)
+        {
+            free(dirpath);
+            free(filepath);
+            return 0;
+        }
+        swap_copy_rom(image, romimage, size, imagetype);
+        swap_buffer(image, 4, size/4);
+
+        /* the file is renamed into place once complete, so a concurrent
+         * process never maps a partially written image */
+        if (osal_mkdirp(dirpath, 0700) != 0
+         || write_to_file_atomic(filepath, image, size) != file_ok
+         || (mapped = osal_map_file(filepath, &mapped_size)) == NULL
+         || mapped_size != size)
+        {
+            if (mapped != NULL)
+                osal_unmap_file(mapped, mapped_size);
+            DebugMessage(M64MSG_WARNING, "couldn't use ROM cache file '%s'", filepath);
+
+            /* use the converted image as a private copy */
+            g_rom = image;
+            l_rom_mapped_size = 0;
+            free(dirpath);
+            free(filepath);
+            return 1;
+        }
+        free(image);
+    }
+
+    DebugMessage(M64MSG_VERBOSE, "ROM mapped from cache file '%s'", filepath);
+    g_rom = (unsigned char *) mapped;
+    l_rom_mapped_size = mapped_size;
+    free(dirpath);
+    free(filepath);
+    return 1;
+}
+
 m64p_error open_rom(const unsigned char* romimage, unsigned int size)
 {
     md5_state_t state;
@@ -154,19 +287,30 @@ m64p_error open_rom(const unsigned char* romimage, unsigned int size)
 
     /* Clear Byte-swapped flag, since ROM is now deleted. */
     g_MemHasBeenBSwapped = 0;
-    /* allocate new buffer for ROM and copy into this buffer */
     g_rom_size = size;
-    g_rom = (unsigned char *) malloc(size);
-    if (g_rom == NULL)
-        return M64ERR_NO_MEMORY;
-    swap_copy_rom(g_rom, romimage, size, &imagetype);
 
-    memcpy(&ROM_HEADER, g_rom, sizeof(m64p_rom_header));
+    if (ConfigGetParamBool(g_CoreConfig, "SharedRomCache") &&
+        open_rom_cache(romimage, size, &imagetype, digest))
+    {
+        /* the cached image is already byte-swapped */
+        g_MemHasBeenBSwapped = 1;
+    }
+    else
+    {
+        /* allocate new buffer for ROM and copy into this buffer */
+        g_rom = (unsigned char *) malloc(size);
+        if (g_rom == NULL)
+            return M64ERR_NO_MEMORY;
+        swap_copy_rom(g_rom, romimage, size, &imagetype);
+
+        memcpy(&ROM_HEADER, g_rom, sizeof(m64p_rom_header));
+
+        /* Calculate MD5 hash  */
+        md5_init(&state);
+        md5_append(&state, (const md5_byte_t*)g_rom, g_rom_size);
+        md5_finish(&state, digest);
+    }
 
-    /* Calculate MD5 hash  */
-    md5_init(&state);
-    md5_append(&state, (const md5_byte_t*)g_rom, g_rom_size);
-    md5_finish(&state, digest);
     for ( i = 0; i < 16; ++i )
         sprintf(buffer+i*2, "%02X", digest[i]);
     buffer[32] = '\0';
@@ -241,8 +385,12 @@ m64p_error close_rom(void)
     if (g_rom == NULL)
         return M64ERR_INVALID_STATE;
 
-    free(g_rom);
+    if (l_rom_mapped_size != 0)
+        osal_unmap_file(g_rom, l_rom_mapped_size);
+    else
+        free(g_rom);
     g_rom = NULL;
+    l_rom_mapped_size = 0;
 
     /* Clear Byte-swapped flag, since ROM is now deleted. */
     g_MemHasBeenBSwapped = 0;
@@ -38,6 +38,7 @@
 #include "api/config.h"
 #include "api/m64p_config.h"
 #include "api/m64p_types.h"
+#include "device/device.h"
 #include "main.h"
 #include "main/list.h"
 #include "memory/memory.h"
@@ -68,20 +69,56 @@ static const char* savestate_magic = "M64+SAVE";
 static const int savestate_latest_version = 0x00010000;  /* 1.0 */
 static const unsigned char pj64_magic[4] = { 0xC8, 0xA6, 0xD8, 0x23 };
 
+/* Mupen64Plus savestate layout: header (magic, version, ROM MD5),
+ * machine state and the event queue, which is at most 1024 bytes long. */
+enum { M64P_HEADER_SIZE = 44 };
+enum { M64P_DATA_SIZE = 16788244 };
+enum { M64P_QUEUE_MAX_SIZE = 1024 };
+
+/* Delta savestates share the header of full ones (with a different magic),
+ * followed by the full state size, the number of chunks and the chunks
+ * (offset + data) which differ from the base savestate. */
+static const char* savestate_delta_magic = "M64+DELT";
+enum { M64P_DELTA_CHUNK_SIZE = 4096 };
+
 static savestates_job job = savestates_job_nothing;
 static savestates_type type = savestates_type_unknown;
 static char *fname = NULL;
+static void *mem_buffer = NULL;
+static size_t mem_size = 0;
+
+static const unsigned char *delta_base = NULL;
+static size_t delta_base_size = 0;
+static unsigned char *delta_scratch = NULL;
 
 static unsigned int slot = 0;
 static int autoinc_save_slot = 0;
 
-static SDL_mutex *savestates_lock;
+/* in-flight compressed savestate writes */
+static struct work_fence savestates_fence;
+
+/* serializes the state file writes, only taken by the workers */
+static SDL_mutex *savestates_write_lock;
+
+/* protects savestates_done, never held during I/O */
+static SDL_mutex *savestates_done_lock;
+
+/* completed writes, whose outcome is reported by the emulation thread */
+static LIST_HEAD(savestates_done);
+
+enum savestate_work_result {
+    savestate_work_saved,
+    savestate_work_open_failed,
+    savestate_work_write_failed
+};
 
 struct savestate_work {
     char *filepath;
     char *data;
     size_t size;
+    enum savestate_work_result result;
     struct work_struct work;
+    struct list_head done;
 };
 
 /* Returns the malloc'd full path of the currently selected savestate. */
@@ -164,12 +201,58 @@ void savestates_set_job(savestates_job j, savestates_type t, const char *fn)
         fname = NULL;
     }
 
+    mem_buffer = NULL;
+    mem_size = 0;
+
     job = j;
     type = t;
     if (fn != NULL)
         fname = strdup(fn);
 }
 
+void savestates_set_mem_job(savestates_job j, void *buffer, size_t size)
+{
+    savestates_set_job(j, savestates_type_m64p_mem, NULL);
+    mem_buffer = buffer;
+    mem_size = size;
+}
+
+size_t savestates_get_full_mem_size(void)
+{
+    return M64P_HEADER_SIZE + M64P_DATA_SIZE + M64P_QUEUE_MAX_SIZE;
+}
+
+size_t savestates_get_mem_size(void)
+{
+    /* worst case is a delta savestate where every chunk changed */
+    size_t chunks = (savestates_get_full_mem_size() + M64P_DELTA_CHUNK_SIZE - 1) / M64P_DELTA_CHUNK_SIZE;
+
+    return M64P_HEADER_SIZE + 8 + chunks * (4 + M64P_DELTA_CHUNK_SIZE);
+}
+
+int savestates_set_delta_base(const void *base, size_t size)
+{
+    if (base != NULL &&
+        (size < M64P_HEADER_SIZE + M64P_DATA_SIZE || memcmp(base, savestate_magic, 8) != 0))
+        return 0;
+
+    delta_base = (const unsigned char *)base;
+    delta_base_size = (base != NULL) ? size : 0;
+    return 1;
+}
+
+static unsigned char *savestates_get_delta_scratch(void)
+{
+    if (delta_scratch == NULL)
+    {
+        delta_scratch = (unsigned char *)malloc(savestates_get_full_mem_size());
+        if (delta_scratch == NULL)
+            main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory for delta savestate.");
+    }
+
+    return delta_scratch;
+}
+
 static void savestates_clear_job(void)
 {
     savestates_set_job(savestates_job_nothing, savestates_type_unknown, NULL);
@@ -191,45 +274,15 @@ static void savestates_clear_job(void)
 #define PUTDATA(buff, type, value) \
     do { type x = value; PUTARRAY(&x, buff, type, 1); } while(0)
 
-static int savestates_load_m64p(char *filepath)
+/* Check magic, version and ROM MD5 of a Mupen64Plus savestate header */
+static int savestates_check_m64p_header(const unsigned char *header, const char *magic, const char *name)
 {
-    unsigned char header[44];
-    gzFile f;
+    const unsigned char *curr = header;
     int version;
-    int i;
-    uint32_t FCR31;
-
-    size_t savestateSize;
-    unsigned char *savestateData, *curr;
-    char queue[1024];
-
-    uint32_t* cp0_regs = r4300_cp0_regs();
-
-    SDL_LockMutex(savestates_lock);
-
-    f = gzopen(filepath, "rb");
-    if(f==NULL)
-    {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not open state file: %s", filepath);
-        SDL_UnlockMutex(savestates_lock);
-        return 0;
-    }
 
-    /* Read and check Mupen64Plus magic number. */
-    if (gzread(f, header, 44) != 44)
+    if(strncmp((const char *)curr, magic, 8)!=0)
     {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read header from state file %s", filepath);
-        gzclose(f);
-        SDL_UnlockMutex(savestates_lock);
-        return 0;
-    }
-    curr = header;
-
-    if(strncmp((char *)curr, savestate_magic, 8)!=0)
-    {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State file: %s is not a valid Mupen64plus savestate.", filepath);
-        gzclose(f);
-        SDL_UnlockMutex(savestates_lock);
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State file: %s is not a valid Mupen64plus savestate.", name);
         return 0;
     }
     curr += 8;
@@ -241,167 +294,165 @@ static int savestates_load_m64p(char *filepath)
     if(version != 0x00010000)
     {
         main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State version (%08x) isn't compatible. Please update Mupen64Plus.", version);
-        gzclose(f);
-        SDL_UnlockMutex(savestates_lock);
         return 0;
     }
 
-    if(memcmp((char *)curr, ROM_SETTINGS.MD5, 32))
+    if(memcmp((const char *)curr, ROM_SETTINGS.MD5, 32))
     {
         main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State ROM MD5 does not match current ROM.");
-        gzclose(f);
-        SDL_UnlockMutex(savestates_lock);
         return 0;
     }
-    curr += 32;
 
-    /* Read the rest of the savestate */
-    savestateSize = 16788244;
-    savestateData = curr = (unsigned char *)malloc(savestateSize);
-    if (savestateData == NULL)
-    {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory to load state.");
-        gzclose(f);
-        SDL_UnlockMutex(savestates_lock);
-        return 0;
-    }
-    if (gzread(f, savestateData, savestateSize) != savestateSize ||
-        (gzread(f, queue, sizeof(queue)) % 4) != 0)
+    return 1;
+}
+
+/* Check that a saved interrupt queue of length bytes is terminated */
+static int savestates_check_queue(const char *queue, size_t length)
+{
+    size_t len;
+    uint32_t type;
+
+    for (len = 0; len + 4 <= length; len += 8)
     {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read Mupen64Plus savestate data from %s", filepath);
-        free(savestateData);
-        gzclose(f);
-        SDL_UnlockMutex(savestates_lock);
-        return 0;
+        memcpy(&type, queue + len, 4);
+        if (type == 0xFFFFFFFF)
+            return 1;
     }
 
-    gzclose(f);
-    SDL_UnlockMutex(savestates_lock);
-
-    // Parse savestate
-    g_ri.rdram.regs[RDRAM_CONFIG_REG]       = GETDATA(curr, uint32_t);
-    g_ri.rdram.regs[RDRAM_DEVICE_ID_REG]    = GETDATA(curr, uint32_t);
-    g_ri.rdram.regs[RDRAM_DELAY_REG]        = GETDATA(curr, uint32_t);
-    g_ri.rdram.regs[RDRAM_MODE_REG]         = GETDATA(curr, uint32_t);
-    g_ri.rdram.regs[RDRAM_REF_INTERVAL_REG] = GETDATA(curr, uint32_t);
-    g_ri.rdram.regs[RDRAM_REF_ROW_REG]      = GETDATA(curr, uint32_t);
-    g_ri.rdram.regs[RDRAM_RAS_INTERVAL_REG] = GETDATA(curr, uint32_t);
-    g_ri.rdram.regs[RDRAM_MIN_INTERVAL_REG] = GETDATA(curr, uint32_t);
-    g_ri.rdram.regs[RDRAM_ADDR_SELECT_REG]  = GETDATA(curr, uint32_t);
-    g_ri.rdram.regs[RDRAM_DEVICE_MANUF_REG] = GETDATA(curr, uint32_t);
+    return 0;
+}
+
+/* Restore machine state from the data following the savestate header */
+static void savestates_load_m64p_data(struct device* dev, unsigned char *curr, char *queue)
+{
+    int i;
+    uint32_t FCR31;
+
+    uint32_t* cp0_regs = r4300_cp0_regs();
+
+    dev->ri.rdram.regs[RDRAM_CONFIG_REG]       = GETDATA(curr, uint32_t);
+    dev->ri.rdram.regs[RDRAM_DEVICE_ID_REG]    = GETDATA(curr, uint32_t);
+    dev->ri.rdram.regs[RDRAM_DELAY_REG]        = GETDATA(curr, uint32_t);
+    dev->ri.rdram.regs[RDRAM_MODE_REG]         = GETDATA(curr, uint32_t);
+    dev->ri.rdram.regs[RDRAM_REF_INTERVAL_REG] = GETDATA(curr, uint32_t);
+    dev->ri.rdram.regs[RDRAM_REF_ROW_REG]      = GETDATA(curr, uint32_t);
+    dev->ri.rdram.regs[RDRAM_RAS_INTERVAL_REG] = GETDATA(curr, uint32_t);
+    dev->ri.rdram.regs[RDRAM_MIN_INTERVAL_REG] = GETDATA(curr, uint32_t);
+    dev->ri.rdram.regs[RDRAM_ADDR_SELECT_REG]  = GETDATA(curr, uint32_t);
+    dev->ri.rdram.regs[RDRAM_DEVICE_MANUF_REG] = GETDATA(curr, uint32_t);
 
     curr += 4; /* Padding from old implementation */
-    g_r4300.mi.regs[MI_INIT_MODE_REG] = GETDATA(curr, uint32_t);
+    dev->r4300.mi.regs[MI_INIT_MODE_REG] = GETDATA(curr, uint32_t);
     curr += 4; // Duplicate MI init mode flags from old implementation
-    g_r4300.mi.regs[MI_VERSION_REG]   = GETDATA(curr, uint32_t);
-    g_r4300.mi.regs[MI_INTR_REG]      = GETDATA(curr, uint32_t);
-    g_r4300.mi.regs[MI_INTR_MASK_REG] = GETDATA(curr, uint32_t);
+    dev->r4300.mi.regs[MI_VERSION_REG]   = GETDATA(curr, uint32_t);
+    dev->r4300.mi.regs[MI_INTR_REG]      = GETDATA(curr, uint32_t);
+    dev->r4300.mi.regs[MI_INTR_MASK_REG] = GETDATA(curr, uint32_t);
     curr += 4; /* Padding from old implementation */
     curr += 8; // Duplicated MI intr flags and padding from old implementation
 
-    g_pi.regs[PI_DRAM_ADDR_REG]    = GETDATA(curr, uint32_t);
-    g_pi.regs[PI_CART_ADDR_REG]    = GETDATA(curr, uint32_t);
-    g_pi.regs[PI_RD_LEN_REG]       = GETDATA(curr, uint32_t);
-    g_pi.regs[PI_WR_LEN_REG]       = GETDATA(curr, uint32_t);
-    g_pi.regs[PI_STATUS_REG]       = GETDATA(curr, uint32_t);
-    g_pi.regs[PI_BSD_DOM1_LAT_REG] = GETDATA(curr, uint32_t);
-    g_pi.regs[PI_BSD_DOM1_PWD_REG] = GETDATA(curr, uint32_t);
-    g_pi.regs[PI_BSD_DOM1_PGS_REG] = GETDATA(curr, uint32_t);
-    g_pi.regs[PI_BSD_DOM1_RLS_REG] = GETDATA(curr, uint32_t);
-    g_pi.regs[PI_BSD_DOM2_LAT_REG] = GETDATA(curr, uint32_t);
-    g_pi.regs[PI_BSD_DOM2_PWD_REG] = GETDATA(curr, uint32_t);
-    g_pi.regs[PI_BSD_DOM2_PGS_REG] = GETDATA(curr, uint32_t);
-    g_pi.regs[PI_BSD_DOM2_RLS_REG] = GETDATA(curr, uint32_t);
-
-    g_sp.regs[SP_MEM_ADDR_REG]  = GETDATA(curr, uint32_t);
-    g_sp.regs[SP_DRAM_ADDR_REG] = GETDATA(curr, uint32_t);
-    g_sp.regs[SP_RD_LEN_REG]    = GETDATA(curr, uint32_t);
-    g_sp.regs[SP_WR_LEN_REG]    = GETDATA(curr, uint32_t);
+    dev->pi.regs[PI_DRAM_ADDR_REG]    = GETDATA(curr, uint32_t);
+    dev->pi.regs[PI_CART_ADDR_REG]    = GETDATA(curr, uint32_t);
+    dev->pi.regs[PI_RD_LEN_REG]       = GETDATA(curr, uint32_t);
+    dev->pi.regs[PI_WR_LEN_REG]       = GETDATA(curr, uint32_t);
+    dev->pi.regs[PI_STATUS_REG]       = GETDATA(curr, uint32_t);
+    dev->pi.regs[PI_BSD_DOM1_LAT_REG] = GETDATA(curr, uint32_t);
+    dev->pi.regs[PI_BSD_DOM1_PWD_REG] = GETDATA(curr, uint32_t);
+    dev->pi.regs[PI_BSD_DOM1_PGS_REG] = GETDATA(curr, uint32_t);
+    dev->pi.regs[PI_BSD_DOM1_RLS_REG] = GETDATA(curr, uint32_t);
+    dev->pi.regs[PI_BSD_DOM2_LAT_REG] = GETDATA(curr, uint32_t);
+    dev->pi.regs[PI_BSD_DOM2_PWD_REG] = GETDATA(curr, uint32_t);
+    dev->pi.regs[PI_BSD_DOM2_PGS_REG] = GETDATA(curr, uint32_t);
+    dev->pi.regs[PI_BSD_DOM2_RLS_REG] = GETDATA(curr, uint32_t);
+
+    dev->sp.regs[SP_MEM_ADDR_REG]  = GETDATA(curr, uint32_t);
+    dev->sp.regs[SP_DRAM_ADDR_REG] = GETDATA(curr, uint32_t);
+    dev->sp.regs[SP_RD_LEN_REG]    = GETDATA(curr, uint32_t);
+    dev->sp.regs[SP_WR_LEN_REG]    = GETDATA(curr, uint32_t);
     curr += 4; /* Padding from old implementation */
-    g_sp.regs[SP_STATUS_REG]    = GETDATA(curr, uint32_t);
+    dev->sp.regs[SP_STATUS_REG]    = GETDATA(curr, uint32_t);
     curr += 16; // Duplicated SP flags and padding from old implementation
-    g_sp.regs[SP_DMA_FULL_REG]  = GETDATA(curr, uint32_t);
-    g_sp.regs[SP_DMA_BUSY_REG]  = GETDATA(curr, uint32_t);
-    g_sp.regs[SP_SEMAPHORE_REG] = GETDATA(curr, uint32_t);
-
-    g_sp.regs2[SP_PC_REG]    = GETDATA(curr, uint32_t);
-    g_sp.regs2[SP_IBIST_REG] = GETDATA(curr, uint32_t);
-
-    g_si.regs[SI_DRAM_ADDR_REG]      = GETDATA(curr, uint32_t);
-    g_si.regs[SI_PIF_ADDR_RD64B_REG] = GETDATA(curr, uint32_t);
-    g_si.regs[SI_PIF_ADDR_WR64B_REG] = GETDATA(curr, uint32_t);
-    g_si.regs[SI_STATUS_REG]         = GETDATA(curr, uint32_t);
-
-    g_vi.regs[VI_STATUS_REG]  = GETDATA(curr, uint32_t);
-    g_vi.regs[VI_ORIGIN_REG]  = GETDATA(curr, uint32_t);
-    g_vi.regs[VI_WIDTH_REG]   = GETDATA(curr, uint32_t);
-    g_vi.regs[VI_V_INTR_REG]  = GETDATA(curr, uint32_t);
-    g_vi.regs[VI_CURRENT_REG] = GETDATA(curr, uint32_t);
-    g_vi.regs[VI_BURST_REG]   = GETDATA(curr, uint32_t);
-    g_vi.regs[VI_V_SYNC_REG]  = GETDATA(curr, uint32_t);
-    g_vi.regs[VI_H_SYNC_REG]  = GETDATA(curr, uint32_t);
-    g_vi.regs[VI_LEAP_REG]    = GETDATA(curr, uint32_t);
-    g_vi.regs[VI_H_START_REG] = GETDATA(curr, uint32_t);
-    g_vi.regs[VI_V_START_REG] = GETDATA(curr, uint32_t);
-    g_vi.regs[VI_V_BURST_REG] = GETDATA(curr, uint32_t);
-    g_vi.regs[VI_X_SCALE_REG] = GETDATA(curr, uint32_t);
-    g_vi.regs[VI_Y_SCALE_REG] = GETDATA(curr, uint32_t);
-    g_vi.delay = GETDATA(curr, unsigned int);
+    dev->sp.regs[SP_DMA_FULL_REG]  = GETDATA(curr, uint32_t);
+    dev->sp.regs[SP_DMA_BUSY_REG]  = GETDATA(curr, uint32_t);
+    dev->sp.regs[SP_SEMAPHORE_REG] = GETDATA(curr, uint32_t);
+
+    dev->sp.regs2[SP_PC_REG]    = GETDATA(curr, uint32_t);
+    dev->sp.regs2[SP_IBIST_REG] = GETDATA(curr, uint32_t);
+
+    dev->si.regs[SI_DRAM_ADDR_REG]      = GETDATA(curr, uint32_t);
+    dev->si.regs[SI_PIF_ADDR_RD64B_REG] = GETDATA(curr, uint32_t);
+    dev->si.regs[SI_PIF_ADDR_WR64B_REG] = GETDATA(curr, uint32_t);
+    dev->si.regs[SI_STATUS_REG]         = GETDATA(curr, uint32_t);
+
+    dev->vi.regs[VI_STATUS_REG]  = GETDATA(curr, uint32_t);
+    dev->vi.regs[VI_ORIGIN_REG]  = GETDATA(curr, uint32_t);
+    dev->vi.regs[VI_WIDTH_REG]   = GETDATA(curr, uint32_t);
+    dev->vi.regs[VI_V_INTR_REG]  = GETDATA(curr, uint32_t);
+    dev->vi.regs[VI_CURRENT_REG] = GETDATA(curr, uint32_t);
+    dev->vi.regs[VI_BURST_REG]   = GETDATA(curr, uint32_t);
+    dev->vi.regs[VI_V_SYNC_REG]  = GETDATA(curr, uint32_t);
+    dev->vi.regs[VI_H_SYNC_REG]  = GETDATA(curr, uint32_t);
+    dev->vi.regs[VI_LEAP_REG]    = GETDATA(curr, uint32_t);
+    dev->vi.regs[VI_H_START_REG] = GETDATA(curr, uint32_t);
+    dev->vi.regs[VI_V_START_REG] = GETDATA(curr, uint32_t);
+    dev->vi.regs[VI_V_BURST_REG] = GETDATA(curr, uint32_t);
+    dev->vi.regs[VI_X_SCALE_REG] = GETDATA(curr, uint32_t);
+    dev->vi.regs[VI_Y_SCALE_REG] = GETDATA(curr, uint32_t);
+    dev->vi.delay = GETDATA(curr, unsigned int);
     gfx.viStatusChanged();
     gfx.viWidthChanged();
 
-    g_ri.regs[RI_MODE_REG]         = GETDATA(curr, uint32_t);
-    g_ri.regs[RI_CONFIG_REG]       = GETDATA(curr, uint32_t);
-    g_ri.regs[RI_CURRENT_LOAD_REG] = GETDATA(curr, uint32_t);
-    g_ri.regs[RI_SELECT_REG]       = GETDATA(curr, uint32_t);
-    g_ri.regs[RI_REFRESH_REG]      = GETDATA(curr, uint32_t);
-    g_ri.regs[RI_LATENCY_REG]      = GETDATA(curr, uint32_t);
-    g_ri.regs[RI_ERROR_REG]        = GETDATA(curr, uint32_t);
-    g_ri.regs[RI_WERROR_REG]       = GETDATA(curr, uint32_t);
-
-    g_ai.regs[AI_DRAM_ADDR_REG] = GETDATA(curr, uint32_t);
-    g_ai.regs[AI_LEN_REG]       = GETDATA(curr, uint32_t);
-    g_ai.regs[AI_CONTROL_REG]   = GETDATA(curr, uint32_t);
-    g_ai.regs[AI_STATUS_REG]    = GETDATA(curr, uint32_t);
-    g_ai.regs[AI_DACRATE_REG]   = GETDATA(curr, uint32_t);
-    g_ai.regs[AI_BITRATE_REG]   = GETDATA(curr, uint32_t);
-    g_ai.fifo[1].duration  = GETDATA(curr, unsigned int);
-    g_ai.fifo[1].length = GETDATA(curr, uint32_t);
-    g_ai.fifo[0].duration  = GETDATA(curr, unsigned int);
-    g_ai.fifo[0].length = GETDATA(curr, uint32_t);
+    dev->ri.regs[RI_MODE_REG]         = GETDATA(curr, uint32_t);
+    dev->ri.regs[RI_CONFIG_REG]       = GETDATA(curr, uint32_t);
+    dev->ri.regs[RI_CURRENT_LOAD_REG] = GETDATA(curr, uint32_t);
+    dev->ri.regs[RI_SELECT_REG]       = GETDATA(curr, uint32_t);
+    dev->ri.regs[RI_REFRESH_REG]      = GETDATA(curr, uint32_t);
+    dev->ri.regs[RI_LATENCY_REG]      = GETDATA(curr, uint32_t);
+    dev->ri.regs[RI_ERROR_REG]        = GETDATA(curr, uint32_t);
+    dev->ri.regs[RI_WERROR_REG]       = GETDATA(curr, uint32_t);
+
+    dev->ai.regs[AI_DRAM_ADDR_REG] = GETDATA(curr, uint32_t);
+    dev->ai.regs[AI_LEN_REG]       = GETDATA(curr, uint32_t);
+    dev->ai.regs[AI_CONTROL_REG]   = GETDATA(curr, uint32_t);
+    dev->ai.regs[AI_STATUS_REG]    = GETDATA(curr, uint32_t);
+    dev->ai.regs[AI_DACRATE_REG]   = GETDATA(curr, uint32_t);
+    dev->ai.regs[AI_BITRATE_REG]   = GETDATA(curr, uint32_t);
+    dev->ai.fifo[1].duration  = GETDATA(curr, unsigned int);
+    dev->ai.fifo[1].length = GETDATA(curr, uint32_t);
+    dev->ai.fifo[0].duration  = GETDATA(curr, unsigned int);
+    dev->ai.fifo[0].length = GETDATA(curr, uint32_t);
     /* best effort initialization of fifo addresses...
      * You might get a small sound "pop" because address might be wrong.
      * Proper initialization requires changes to savestate format
      */
-    g_ai.fifo[0].address = g_ai.regs[AI_DRAM_ADDR_REG];
-    g_ai.fifo[1].address = g_ai.regs[AI_DRAM_ADDR_REG];
-    g_ai.samples_format_changed = 1;
+    dev->ai.fifo[0].address = dev->ai.regs[AI_DRAM_ADDR_REG];
+    dev->ai.fifo[1].address = dev->ai.regs[AI_DRAM_ADDR_REG];
+    dev->ai.samples_format_changed = 1;
 
-    g_dp.dpc_regs[DPC_START_REG]    = GETDATA(curr, uint32_t);
-    g_dp.dpc_regs[DPC_END_REG]      = GETDATA(curr, uint32_t);
-    g_dp.dpc_regs[DPC_CURRENT_REG]  = GETDATA(curr, uint32_t);
+    dev->dp.dpc_regs[DPC_START_REG]    = GETDATA(curr, uint32_t);
+    dev->dp.dpc_regs[DPC_END_REG]      = GETDATA(curr, uint32_t);
+    dev->dp.dpc_regs[DPC_CURRENT_REG]  = GETDATA(curr, uint32_t);
     curr += 4; // Padding from old implementation
-    g_dp.dpc_regs[DPC_STATUS_REG]   = GETDATA(curr, uint32_t);
+    dev->dp.dpc_regs[DPC_STATUS_REG]   = GETDATA(curr, uint32_t);
     curr += 12; // Duplicated DPC flags and padding from old implementation
-    g_dp.dpc_regs[DPC_CLOCK_REG]    = GETDATA(curr, uint32_t);
-    g_dp.dpc_regs[DPC_BUFBUSY_REG]  = GETDATA(curr, uint32_t);
-    g_dp.dpc_regs[DPC_PIPEBUSY_REG] = GETDATA(curr, uint32_t);
-    g_dp.dpc_regs[DPC_TMEM_REG]     = GETDATA(curr, uint32_t);
+    dev->dp.dpc_regs[DPC_CLOCK_REG]    = GETDATA(curr, uint32_t);
+    dev->dp.dpc_regs[DPC_BUFBUSY_REG]  = GETDATA(curr, uint32_t);
+    dev->dp.dpc_regs[DPC_PIPEBUSY_REG] = GETDATA(curr, uint32_t);
+    dev->dp.dpc_regs[DPC_TMEM_REG]     = GETDATA(curr, uint32_t);
 
-    g_dp.dps_regs[DPS_TBIST_REG]        = GETDATA(curr, uint32_t);
-    g_dp.dps_regs[DPS_TEST_MODE_REG]    = GETDATA(curr, uint32_t);
-    g_dp.dps_regs[DPS_BUFTEST_ADDR_REG] = GETDATA(curr, uint32_t);
-    g_dp.dps_regs[DPS_BUFTEST_DATA_REG] = GETDATA(curr, uint32_t);
+    dev->dp.dps_regs[DPS_TBIST_REG]        = GETDATA(curr, uint32_t);
+    dev->dp.dps_regs[DPS_TEST_MODE_REG]    = GETDATA(curr, uint32_t);
+    dev->dp.dps_regs[DPS_BUFTEST_ADDR_REG] = GETDATA(curr, uint32_t);
+    dev->dp.dps_regs[DPS_BUFTEST_DATA_REG] = GETDATA(curr, uint32_t);
 
     COPYARRAY(g_rdram, curr, uint32_t, RDRAM_MAX_SIZE/4);
-    COPYARRAY(g_sp.mem, curr, uint32_t, SP_MEM_SIZE/4);
-    COPYARRAY(g_si.pif.ram, curr, uint8_t, PIF_RAM_SIZE);
+    COPYARRAY(dev->sp.mem, curr, uint32_t, SP_MEM_SIZE/4);
+    COPYARRAY(dev->si.pif.ram, curr, uint8_t, PIF_RAM_SIZE);
 
-    g_pi.use_flashram = GETDATA(curr, int);
-    g_pi.flashram.mode = GETDATA(curr, int);
-    g_pi.flashram.status = GETDATA(curr, unsigned long long);
-    g_pi.flashram.erase_offset = GETDATA(curr, unsigned int);
-    g_pi.flashram.write_pointer = GETDATA(curr, unsigned int);
+    dev->pi.use_flashram = GETDATA(curr, int);
+    dev->pi.flashram.mode = GETDATA(curr, int);
+    dev->pi.flashram.status = GETDATA(curr, unsigned long long);
+    dev->pi.flashram.erase_offset = GETDATA(curr, unsigned int);
+    dev->pi.flashram.write_pointer = GETDATA(curr, unsigned int);
 
     COPYARRAY(tlb_LUT_r, curr, unsigned int, 0x100000);
     COPYARRAY(tlb_LUT_w, curr, unsigned int, 0x100000);
@@ -450,8 +501,8 @@ static int savestates_load_m64p(char *filepath)
     savestates_load_set_pc(GETDATA(curr, uint32_t));
 
     *r4300_next_interrupt() = GETDATA(curr, unsigned int);
-    g_vi.next_vi = GETDATA(curr, unsigned int);
-    g_vi.field = GETDATA(curr, unsigned int);
+    dev->vi.next_vi = GETDATA(curr, unsigned int);
+    dev->vi.field = GETDATA(curr, unsigned int);
 
     // assert(savestateData+savestateSize == curr)
 
@@ -459,13 +510,225 @@ static int savestates_load_m64p(char *filepath)
     load_eventqueue_infos(queue);
 
     *r4300_last_addr() = *r4300_pc();
+}
+
+static int savestates_load_m64p(struct device* dev, char *filepath)
+{
+    unsigned char header[M64P_HEADER_SIZE];
+    gzFile f;
+
+    size_t savestateSize;
+    unsigned char *savestateData;
+    char queue[M64P_QUEUE_MAX_SIZE];
+    int queuelength;
+
+    /* the state file may still be being written */
+    wait_work_fence(&savestates_fence);
+
+    f = gzopen(filepath, "rb");
+    if(f==NULL)
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not open state file: %s", filepath);
+        return 0;
+    }
+
+    /* Read and check Mupen64Plus magic number. */
+    if (gzread(f, header, M64P_HEADER_SIZE) != M64P_HEADER_SIZE)
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read header from state file %s", filepath);
+        gzclose(f);
+        return 0;
+    }
+
+    if (!savestates_check_m64p_header(header, savestate_magic, filepath))
+    {
+        gzclose(f);
+        return 0;
+    }
+
+    /* Read the rest of the savestate */
+    savestateSize = M64P_DATA_SIZE;
+    savestateData = (unsigned char *)malloc(savestateSize);
+    if (savestateData == NULL)
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory to load state.");
+        gzclose(f);
+        return 0;
+    }
+    if (gzread(f, savestateData, savestateSize) != savestateSize ||
+        (queuelength = gzread(f, queue, sizeof(queue))) < 0 ||
+        !savestates_check_queue(queue, queuelength))
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read Mupen64Plus savestate data from %s", filepath);
+        free(savestateData);
+        gzclose(f);
+        return 0;
+    }
+
+    gzclose(f);
+
+    savestates_load_m64p_data(dev, savestateData, queue);
 
     free(savestateData);
     main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State loaded from: %s", namefrompath(filepath));
     return 1;
 }
 
-static int savestates_load_pj64(char *filepath, void *handle,
+/* Load an uncompressed Mupen64Plus savestate from a buffer */
+int savestates_load_m64p_buffer(struct device* dev, void *buffer, size_t size)
+{
+    unsigned char *data = (unsigned char *)buffer;
+    char queue[M64P_QUEUE_MAX_SIZE];
+    size_t queuelength;
+
+    /* the state of a running RSP task can't be saved or replaced */
+    rsp_wait_task(&dev->sp);
+
+    if (size < M64P_HEADER_SIZE + M64P_DATA_SIZE + 4)
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Savestate buffer is too small.");
+        return 0;
+    }
+
+    if (!savestates_check_m64p_header(data, savestate_magic, "memory buffer"))
+        return 0;
+
+    queuelength = size - (M64P_HEADER_SIZE + M64P_DATA_SIZE);
+    if (queuelength > sizeof(queue))
+        queuelength = sizeof(queue);
+    memcpy(queue, data + M64P_HEADER_SIZE + M64P_DATA_SIZE, queuelength);
+    if (!savestates_check_queue(queue, queuelength))
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Truncated savestate.");
+        return 0;
+    }
+
+#ifdef M64P_BIG_ENDIAN
+    {
+        /* data is byteswapped in place while parsed, so keep the buffer intact */
+        unsigned char *copy = (unsigned char *)malloc(M64P_DATA_SIZE);
+        if (copy == NULL)
+        {
+            main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory to load state.");
+            return 0;
+        }
+        memcpy(copy, data + M64P_HEADER_SIZE, M64P_DATA_SIZE);
+        savestates_load_m64p_data(dev, copy, queue);
+        free(copy);
+    }
+#else
+    savestates_load_m64p_data(dev, data + M64P_HEADER_SIZE, queue);
+#endif
+
+    return 1;
+}
+
+static uint32_t read_le32(const unsigned char *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* Rebuild the full savestate described by a delta savestate into out, which
+ * must hold savestates_get_full_mem_size() bytes (out may be the base itself).
+ * Returns the size of the full savestate, or 0 on error. */
+size_t savestates_apply_delta(const void *base, size_t base_size,
+                              const void *delta, size_t delta_size, void *out)
+{
+    const unsigned char *curr = (const unsigned char *)delta;
+    const unsigned char *end = curr + delta_size;
+    unsigned char *full = (unsigned char *)out;
+    uint32_t full_size, count, offset, next_offset, i;
+    size_t len, first_missing, missing;
+
+    if (delta_size < M64P_HEADER_SIZE + 8 ||
+        !savestates_check_m64p_header(curr, savestate_delta_magic, "memory buffer"))
+        return 0;
+    curr += M64P_HEADER_SIZE;
+
+    full_size = read_le32(curr); curr += 4;
+    count = read_le32(curr); curr += 4;
+    if (full_size < M64P_HEADER_SIZE + M64P_DATA_SIZE || full_size > savestates_get_full_mem_size())
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Invalid delta savestate.");
+        return 0;
+    }
+
+    if (base_size < M64P_HEADER_SIZE + M64P_DATA_SIZE)
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Invalid base savestate.");
+        return 0;
+    }
+
+    /* every chunk which the base doesn't fully hold must be in the delta */
+    if (base_size < full_size)
+    {
+        first_missing = base_size - base_size % M64P_DELTA_CHUNK_SIZE;
+        missing = (full_size - first_missing + M64P_DELTA_CHUNK_SIZE - 1) / M64P_DELTA_CHUNK_SIZE;
+    }
+    else
+    {
+        first_missing = full_size;
+        missing = 0;
+    }
+
+    if (full != base)
+        memcpy(full, base, (base_size < full_size) ? base_size : full_size);
+    if (base_size < full_size)
+        memset(full + base_size, 0, full_size - base_size);
+
+    next_offset = 0;
+    for (i = 0; i < count; ++i)
+    {
+        if (end - curr < 4)
+            break;
+        offset = read_le32(curr); curr += 4;
+        if (offset >= full_size || offset < next_offset || (offset % M64P_DELTA_CHUNK_SIZE) != 0)
+            break;
+        len = full_size - offset;
+        if (len > M64P_DELTA_CHUNK_SIZE)
+            len = M64P_DELTA_CHUNK_SIZE;
+        if ((size_t)(end - curr) < len)
+            break;
+        memcpy(full + offset, curr, len);
+        curr += len;
+        next_offset = offset + M64P_DELTA_CHUNK_SIZE;
+        if (offset >= first_missing)
+            --missing;
+    }
+
+    if (i != count || missing != 0)
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Truncated delta savestate.");
+        return 0;
+    }
+
+    return full_size;
+}
+
+/* Load a Mupen64Plus savestate (full or delta, without compression) from mem_buffer */
+static int savestates_load_m64p_mem(struct device* dev)
+{
+    size_t full_size;
+
+    if (mem_size >= 8 && memcmp(mem_buffer, savestate_delta_magic, 8) == 0)
+    {
+        if (delta_base == NULL)
+        {
+            main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Delta savestate given without a base savestate.");
+            return 0;
+        }
+        if (savestates_get_delta_scratch() == NULL)
+            return 0;
+        full_size = savestates_apply_delta(delta_base, delta_base_size, mem_buffer, mem_size, delta_scratch);
+        if (full_size == 0)
+            return 0;
+        return savestates_load_m64p_buffer(dev, delta_scratch, full_size);
+    }
+
+    return savestates_load_m64p_buffer(dev, (unsigned char *)mem_buffer, mem_size);
+}
+
+static int savestates_load_pj64(struct device* dev, char *filepath, void *handle,
                                 int (*read_func)(void *, void *, size_t))
 {
     char buffer[1024];
@@ -546,8 +809,8 @@ static int savestates_load_pj64(char *filepath, void *handle,
     *r4300_next_interrupt() = (cp0_regs[CP0_COMPARE_REG] < vi_timer)
                   ? cp0_regs[CP0_COMPARE_REG]
                   : vi_timer;
-    g_vi.next_vi = vi_timer;
-    g_vi.field = 0;
+    dev->vi.next_vi = vi_timer;
+    dev->vi.field = 0;
     *((unsigned int*)&buffer[0]) = VI_INT;
     *((unsigned int*)&buffer[4]) = vi_timer;
     *((unsigned int*)&buffer[8]) = COMPARE_INT;
@@ -568,106 +831,106 @@ static int savestates_load_pj64(char *filepath, void *handle,
     *r4300_mult_lo() = GETDATA(curr, int64_t);
 
     // rdram register
-    g_ri.rdram.regs[RDRAM_CONFIG_REG]       = GETDATA(curr, uint32_t);
-    g_ri.rdram.regs[RDRAM_DEVICE_ID_REG]    = GETDATA(curr, uint32_t);
-    g_ri.rdram.regs[RDRAM_DELAY_REG]        = GETDATA(curr, uint32_t);
-    g_ri.rdram.regs[RDRAM_MODE_REG]         = GETDATA(curr, uint32_t);
-    g_ri.rdram.regs[RDRAM_REF_INTERVAL_REG] = GETDATA(curr, uint32_t);
-    g_ri.rdram.regs[RDRAM_REF_ROW_REG]      = GETDATA(curr, uint32_t);
-    g_ri.rdram.regs[RDRAM_RAS_INTERVAL_REG] = GETDATA(curr, uint32_t);
-    g_ri.rdram.regs[RDRAM_MIN_INTERVAL_REG] = GETDATA(curr, uint32_t);
-    g_ri.rdram.regs[RDRAM_ADDR_SELECT_REG]  = GETDATA(curr, uint32_t);
-    g_ri.rdram.regs[RDRAM_DEVICE_MANUF_REG] = GETDATA(curr, uint32_t);
+    dev->ri.rdram.regs[RDRAM_CONFIG_REG]       = GETDATA(curr, uint32_t);
+    dev->ri.rdram.regs[RDRAM_DEVICE_ID_REG]    = GETDATA(curr, uint32_t);
+    dev->ri.rdram.regs[RDRAM_DELAY_REG]        = GETDATA(curr, uint32_t);
+    dev->ri.rdram.regs[RDRAM_MODE_REG]         = GETDATA(curr, uint32_t);
+    dev->ri.rdram.regs[RDRAM_REF_INTERVAL_REG] = GETDATA(curr, uint32_t);
+    dev->ri.rdram.regs[RDRAM_REF_ROW_REG]      = GETDATA(curr, uint32_t);
+    dev->ri.rdram.regs[RDRAM_RAS_INTERVAL_REG] = GETDATA(curr, uint32_t);
+    dev->ri.rdram.regs[RDRAM_MIN_INTERVAL_REG] = GETDATA(curr, uint32_t);
+    dev->ri.rdram.regs[RDRAM_ADDR_SELECT_REG]  = GETDATA(curr, uint32_t);
+    dev->ri.rdram.regs[RDRAM_DEVICE_MANUF_REG] = GETDATA(curr, uint32_t);
 
     // sp_register
-    g_sp.regs[SP_MEM_ADDR_REG]  = GETDATA(curr, uint32_t);
-    g_sp.regs[SP_DRAM_ADDR_REG] = GETDATA(curr, uint32_t);
-    g_sp.regs[SP_RD_LEN_REG]    = GETDATA(curr, uint32_t);
-    g_sp.regs[SP_WR_LEN_REG]    = GETDATA(curr, uint32_t);
-    g_sp.regs[SP_STATUS_REG]    = GETDATA(curr, uint32_t);
-    g_sp.regs[SP_DMA_FULL_REG]  = GETDATA(curr, uint32_t);
-    g_sp.regs[SP_DMA_BUSY_REG]  = GETDATA(curr, uint32_t);
-    g_sp.regs[SP_SEMAPHORE_REG] = GETDATA(curr, uint32_t);
-    g_sp.regs2[SP_PC_REG]    = GETDATA(curr, uint32_t);
-    g_sp.regs2[SP_IBIST_REG] = GETDATA(curr, uint32_t);
+    dev->sp.regs[SP_MEM_ADDR_REG]  = GETDATA(curr, uint32_t);
+    dev->sp.regs[SP_DRAM_ADDR_REG] = GETDATA(curr, uint32_t);
+    dev->sp.regs[SP_RD_LEN_REG]    = GETDATA(curr, uint32_t);
+    dev->sp.regs[SP_WR_LEN_REG]    = GETDATA(curr, uint32_t);
+    dev->sp.regs[SP_STATUS_REG]    = GETDATA(curr, uint32_t);
+    dev->sp.regs[SP_DMA_FULL_REG]  = GETDATA(curr, uint32_t);
+    dev->sp.regs[SP_DMA_BUSY_REG]  = GETDATA(curr, uint32_t);
+    dev->sp.regs[SP_SEMAPHORE_REG] = GETDATA(curr, uint32_t);
+    dev->sp.regs2[SP_PC_REG]    = GETDATA(curr, uint32_t);
+    dev->sp.regs2[SP_IBIST_REG] = GETDATA(curr, uint32_t);
 
     // dpc_register
-    g_dp.dpc_regs[DPC_START_REG]    = GETDATA(curr, uint32_t);
-    g_dp.dpc_regs[DPC_END_REG]      = GETDATA(curr, uint32_t);
-    g_dp.dpc_regs[DPC_CURRENT_REG]  = GETDATA(curr, uint32_t);
-    g_dp.dpc_regs[DPC_STATUS_REG]   = GETDATA(curr, uint32_t);
-    g_dp.dpc_regs[DPC_CLOCK_REG]    = GETDATA(curr, uint32_t);
-    g_dp.dpc_regs[DPC_BUFBUSY_REG]  = GETDATA(curr, uint32_t);
-    g_dp.dpc_regs[DPC_PIPEBUSY_REG] = GETDATA(curr, uint32_t);
-    g_dp.dpc_regs[DPC_TMEM_REG]     = GETDATA(curr, uint32_t);
+    dev->dp.dpc_regs[DPC_START_REG]    = GETDATA(curr, uint32_t);
+    dev->dp.dpc_regs[DPC_END_REG]      = GETDATA(curr, uint32_t);
+    dev->dp.dpc_regs[DPC_CURRENT_REG]  = GETDATA(curr, uint32_t);
+    dev->dp.dpc_regs[DPC_STATUS_REG]   = GETDATA(curr, uint32_t);
+    dev->dp.dpc_regs[DPC_CLOCK_REG]    = GETDATA(curr, uint32_t);
+    dev->dp.dpc_regs[DPC_BUFBUSY_REG]  = GETDATA(curr, uint32_t);
+    dev->dp.dpc_regs[DPC_PIPEBUSY_REG] = GETDATA(curr, uint32_t);
+    dev->dp.dpc_regs[DPC_TMEM_REG]     = GETDATA(curr, uint32_t);
     (void)GETDATA(curr, unsigned int); // Dummy read
     (void)GETDATA(curr, unsigned int); // Dummy read
 
     // mi_register
-    g_r4300.mi.regs[MI_INIT_MODE_REG] = GETDATA(curr, uint32_t);
-    g_r4300.mi.regs[MI_VERSION_REG]   = GETDATA(curr, uint32_t);
-    g_r4300.mi.regs[MI_INTR_REG]      = GETDATA(curr, uint32_t);
-    g_r4300.mi.regs[MI_INTR_MASK_REG] = GETDATA(curr, uint32_t);
+    dev->r4300.mi.regs[MI_INIT_MODE_REG] = GETDATA(curr, uint32_t);
+    dev->r4300.mi.regs[MI_VERSION_REG]   = GETDATA(curr, uint32_t);
+    dev->r4300.mi.regs[MI_INTR_REG]      = GETDATA(curr, uint32_t);
+    dev->r4300.mi.regs[MI_INTR_MASK_REG] = GETDATA(curr, uint32_t);
 
     // vi_register
-    g_vi.regs[VI_STATUS_REG]  = GETDATA(curr, uint32_t);
-    g_vi.regs[VI_ORIGIN_REG]  = GETDATA(curr, uint32_t);
-    g_vi.regs[VI_WIDTH_REG]   = GETDATA(curr, uint32_t);
-    g_vi.regs[VI_V_INTR_REG]  = GETDATA(curr, uint32_t);
-    g_vi.regs[VI_CURRENT_REG] = GETDATA(curr, uint32_t);
-    g_vi.regs[VI_BURST_REG]   = GETDATA(curr, uint32_t);
-    g_vi.regs[VI_V_SYNC_REG]  = GETDATA(curr, uint32_t);
-    g_vi.regs[VI_H_SYNC_REG]  = GETDATA(curr, uint32_t);
-    g_vi.regs[VI_LEAP_REG]    = GETDATA(curr, uint32_t);
-    g_vi.regs[VI_H_START_REG] = GETDATA(curr, uint32_t);
-    g_vi.regs[VI_V_START_REG] = GETDATA(curr, uint32_t);
-    g_vi.regs[VI_V_BURST_REG] = GETDATA(curr, uint32_t);
-    g_vi.regs[VI_X_SCALE_REG] = GETDATA(curr, uint32_t);
-    g_vi.regs[VI_Y_SCALE_REG] = GETDATA(curr, uint32_t);
+    dev->vi.regs[VI_STATUS_REG]  = GETDATA(curr, uint32_t);
+    dev->vi.regs[VI_ORIGIN_REG]  = GETDATA(curr, uint32_t);
+    dev->vi.regs[VI_WIDTH_REG]   = GETDATA(curr, uint32_t);
+    dev->vi.regs[VI_V_INTR_REG]  = GETDATA(curr, uint32_t);
+    dev->vi.regs[VI_CURRENT_REG] = GETDATA(curr, uint32_t);
+    dev->vi.regs[VI_BURST_REG]   = GETDATA(curr, uint32_t);
+    dev->vi.regs[VI_V_SYNC_REG]  = GETDATA(curr, uint32_t);
+    dev->vi.regs[VI_H_SYNC_REG]  = GETDATA(curr, uint32_t);
+    dev->vi.regs[VI_LEAP_REG]    = GETDATA(curr, uint32_t);
+    dev->vi.regs[VI_H_START_REG] = GETDATA(curr, uint32_t);
+    dev->vi.regs[VI_V_START_REG] = GETDATA(curr, uint32_t);
+    dev->vi.regs[VI_V_BURST_REG] = GETDATA(curr, uint32_t);
+    dev->vi.regs[VI_X_SCALE_REG] = GETDATA(curr, uint32_t);
+    dev->vi.regs[VI_Y_SCALE_REG] = GETDATA(curr, uint32_t);
     // TODO vi delay?
     gfx.viStatusChanged();
     gfx.viWidthChanged();
 
     // ai_register
-    g_ai.regs[AI_DRAM_ADDR_REG] = GETDATA(curr, uint32_t);
-    g_ai.regs[AI_LEN_REG]       = GETDATA(curr, uint32_t);
-    g_ai.regs[AI_CONTROL_REG]   = GETDATA(curr, uint32_t);
-    g_ai.regs[AI_STATUS_REG]    = GETDATA(curr, uint32_t);
-    g_ai.regs[AI_DACRATE_REG]   = GETDATA(curr, uint32_t);
-    g_ai.regs[AI_BITRATE_REG]   = GETDATA(curr, uint32_t);
-    g_ai.samples_format_changed = 1;
+    dev->ai.regs[AI_DRAM_ADDR_REG] = GETDATA(curr, uint32_t);
+    dev->ai.regs[AI_LEN_REG]       = GETDATA(curr, uint32_t);
+    dev->ai.regs[AI_CONTROL_REG]   = GETDATA(curr, uint32_t);
+    dev->ai.regs[AI_STATUS_REG]    = GETDATA(curr, uint32_t);
+    dev->ai.regs[AI_DACRATE_REG]   = GETDATA(curr, uint32_t);
+    dev->ai.regs[AI_BITRATE_REG]   = GETDATA(curr, uint32_t);
+    dev->ai.samples_format_changed = 1;
 
     // pi_register
-    g_pi.regs[PI_DRAM_ADDR_REG]    = GETDATA(curr, uint32_t);
-    g_pi.regs[PI_CART_ADDR_REG]    = GETDATA(curr, uint32_t);
-    g_pi.regs[PI_RD_LEN_REG]       = GETDATA(curr, uint32_t);
-    g_pi.regs[PI_WR_LEN_REG]       = GETDATA(curr, uint32_t);
-    g_pi.regs[PI_STATUS_REG]       = GETDATA(curr, uint32_t);
-    g_pi.regs[PI_BSD_DOM1_LAT_REG] = GETDATA(curr, uint32_t);
-    g_pi.regs[PI_BSD_DOM1_PWD_REG] = GETDATA(curr, uint32_t);
-    g_pi.regs[PI_BSD_DOM1_PGS_REG] = GETDATA(curr, uint32_t);
-    g_pi.regs[PI_BSD_DOM1_RLS_REG] = GETDATA(curr, uint32_t);
-    g_pi.regs[PI_BSD_DOM2_LAT_REG] = GETDATA(curr, uint32_t);
-    g_pi.regs[PI_BSD_DOM2_PWD_REG] = GETDATA(curr, uint32_t);
-    g_pi.regs[PI_BSD_DOM2_PGS_REG] = GETDATA(curr, uint32_t);
-    g_pi.regs[PI_BSD_DOM2_RLS_REG] = GETDATA(curr, uint32_t);
-    read_func(handle, g_pi.regs, PI_REGS_COUNT*sizeof(g_pi.regs[0]));
+    dev->pi.regs[PI_DRAM_ADDR_REG]    = GETDATA(curr, uint32_t);
+    dev->pi.regs[PI_CART_ADDR_REG]    = GETDATA(curr, uint32_t);
+    dev->pi.regs[PI_RD_LEN_REG]       = GETDATA(curr, uint32_t);
+    dev->pi.regs[PI_WR_LEN_REG]       = GETDATA(curr, uint32_t);
+    dev->pi.regs[PI_STATUS_REG]       = GETDATA(curr, uint32_t);
+    dev->pi.regs[PI_BSD_DOM1_LAT_REG] = GETDATA(curr, uint32_t);
+    dev->pi.regs[PI_BSD_DOM1_PWD_REG] = GETDATA(curr, uint32_t);
+    dev->pi.regs[PI_BSD_DOM1_PGS_REG] = GETDATA(curr, uint32_t);
+    dev->pi.regs[PI_BSD_DOM1_RLS_REG] = GETDATA(curr, uint32_t);
+    dev->pi.regs[PI_BSD_DOM2_LAT_REG] = GETDATA(curr, uint32_t);
+    dev->pi.regs[PI_BSD_DOM2_PWD_REG] = GETDATA(curr, uint32_t);
+    dev->pi.regs[PI_BSD_DOM2_PGS_REG] = GETDATA(curr, uint32_t);
+    dev->pi.regs[PI_BSD_DOM2_RLS_REG] = GETDATA(curr, uint32_t);
+    read_func(handle, dev->pi.regs, PI_REGS_COUNT*sizeof(dev->pi.regs[0]));
 
     // ri_register
-    g_ri.regs[RI_MODE_REG]         = GETDATA(curr, uint32_t);
-    g_ri.regs[RI_CONFIG_REG]       = GETDATA(curr, uint32_t);
-    g_ri.regs[RI_CURRENT_LOAD_REG] = GETDATA(curr, uint32_t);
-    g_ri.regs[RI_SELECT_REG]       = GETDATA(curr, uint32_t);
-    g_ri.regs[RI_REFRESH_REG]      = GETDATA(curr, uint32_t);
-    g_ri.regs[RI_LATENCY_REG]      = GETDATA(curr, uint32_t);
-    g_ri.regs[RI_ERROR_REG]        = GETDATA(curr, uint32_t);
-    g_ri.regs[RI_WERROR_REG]       = GETDATA(curr, uint32_t);
+    dev->ri.regs[RI_MODE_REG]         = GETDATA(curr, uint32_t);
+    dev->ri.regs[RI_CONFIG_REG]       = GETDATA(curr, uint32_t);
+    dev->ri.regs[RI_CURRENT_LOAD_REG] = GETDATA(curr, uint32_t);
+    dev->ri.regs[RI_SELECT_REG]       = GETDATA(curr, uint32_t);
+    dev->ri.regs[RI_REFRESH_REG]      = GETDATA(curr, uint32_t);
+    dev->ri.regs[RI_LATENCY_REG]      = GETDATA(curr, uint32_t);
+    dev->ri.regs[RI_ERROR_REG]        = GETDATA(curr, uint32_t);
+    dev->ri.regs[RI_WERROR_REG]       = GETDATA(curr, uint32_t);
 
     // si_register
-    g_si.regs[SI_DRAM_ADDR_REG]      = GETDATA(curr, uint32_t);
-    g_si.regs[SI_PIF_ADDR_RD64B_REG] = GETDATA(curr, uint32_t);
-    g_si.regs[SI_PIF_ADDR_WR64B_REG] = GETDATA(curr, uint32_t);
-    g_si.regs[SI_STATUS_REG]         = GETDATA(curr, uint32_t);
+    dev->si.regs[SI_DRAM_ADDR_REG]      = GETDATA(curr, uint32_t);
+    dev->si.regs[SI_PIF_ADDR_RD64B_REG] = GETDATA(curr, uint32_t);
+    dev->si.regs[SI_PIF_ADDR_WR64B_REG] = GETDATA(curr, uint32_t);
+    dev->si.regs[SI_STATUS_REG]         = GETDATA(curr, uint32_t);
 
     // tlb
     memset(tlb_LUT_r, 0, 0x400000);
@@ -711,25 +974,25 @@ static int savestates_load_pj64(char *filepath, void *handle,
     }
 
     // pif ram
-    COPYARRAY(g_si.pif.ram, curr, uint8_t, PIF_RAM_SIZE);
+    COPYARRAY(dev->si.pif.ram, curr, uint8_t, PIF_RAM_SIZE);
 
     // RDRAM
     memset(g_rdram, 0, RDRAM_MAX_SIZE);
     COPYARRAY(g_rdram, curr, uint32_t, SaveRDRAMSize/4);
 
     // DMEM + IMEM
-    COPYARRAY(g_sp.mem, curr, uint32_t, SP_MEM_SIZE/4);
+    COPYARRAY(dev->sp.mem, curr, uint32_t, SP_MEM_SIZE/4);
 
     // The following values should not matter because we don't have any AI interrupt
-    // g_ai.fifo[1].delay = 0; g_ai.fifo[1].length = 0;
-    // g_ai.fifo[0].delay = 0; g_ai.fifo[0].length = 0;
+    // dev->ai.fifo[1].delay = 0; dev->ai.fifo[1].length = 0;
+    // dev->ai.fifo[0].delay = 0; dev->ai.fifo[0].length = 0;
 
     // The following is not available in PJ64 savestate. Keep the values as is.
-    // g_dp.dps_regs[DPS_TBIST_REG] = 0; g_dp.dps_regs[DPS_TEST_MODE_REG] = 0;
-    // g_dp.dps_regs[DPS_BUFTEST_ADDR_REG] = 0; g_dp.dps_regs[DPS_BUFTEST_DATA_REG] = 0; *r4300_llbit() = 0;
+    // dev->dp.dps_regs[DPS_TBIST_REG] = 0; dev->dp.dps_regs[DPS_TEST_MODE_REG] = 0;
+    // dev->dp.dps_regs[DPS_BUFTEST_ADDR_REG] = 0; dev->dp.dps_regs[DPS_BUFTEST_DATA_REG] = 0; *r4300_llbit() = 0;
 
     // No flashram info in pj64 savestate.
-    init_flashram(&g_pi.flashram);
+    init_flashram(&dev->pi.flashram);
 
     savestates_load_set_pc(*r4300_last_addr());
 
@@ -744,7 +1007,7 @@ static int read_data_from_zip(void *zip, void *buffer, size_t length)
     return unzReadCurrentFile((unzFile)zip, buffer, (unsigned)length) == length;
 }
 
-static int savestates_load_pj64_zip(char *filepath)
+static int savestates_load_pj64_zip(struct device* dev, char *filepath)
 {
     char szFileName[256], szExtraField[256], szComment[256];
     unzFile zipstatefile = NULL;
@@ -762,7 +1025,7 @@ static int savestates_load_pj64_zip(char *filepath)
         goto clean_and_exit;
     }
 
-    if (!savestates_load_pj64(filepath, zipstatefile, read_data_from_zip))
+    if (!savestates_load_pj64(dev, filepath, zipstatefile, read_data_from_zip))
         goto clean_and_exit;
 
     main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State loaded from: %s", namefrompath(filepath));
@@ -779,7 +1042,7 @@ static int read_data_from_file(void *file, void *buffer, size_t length)
     return fread(buffer, 1, length, file) == length;
 }
 
-static int savestates_load_pj64_unc(char *filepath)
+static int savestates_load_pj64_unc(struct device* dev, char *filepath)
 {
     FILE *f;
 
@@ -791,7 +1054,7 @@ static int savestates_load_pj64_unc(char *filepath)
         return 0;
     }
 
-    if (!savestates_load_pj64(filepath, f, read_data_from_file))
+    if (!savestates_load_pj64(dev, filepath, f, read_data_from_file))
     {
         fclose(f);
         return 0;
@@ -834,12 +1097,22 @@ static savestates_type savestates_detect_type(char *filepath)
     }
 }
 
-int savestates_load(void)
+int savestates_load(struct device* dev)
 {
     FILE *fPtr = NULL;
     char *filepath = NULL;
     int ret = 0;
 
+    rsp_wait_task(&dev->sp);
+
+    if (type == savestates_type_m64p_mem)
+    {
+        ret = savestates_load_m64p_mem(dev);
+        StateChanged(M64CORE_STATE_LOADCOMPLETE, ret);
+        savestates_clear_job();
+        return ret;
+    }
+
     if (fname == NULL) // For slots, autodetect the savestate type
     {
         // try M64P type first
@@ -895,9 +1168,9 @@ int savestates_load(void)
     {
         switch (type)
         {
-            case savestates_type_m64p: ret = savestates_load_m64p(filepath); break;
-            case savestates_type_pj64_zip: ret = savestates_load_pj64_zip(filepath); break;
-            case savestates_type_pj64_unc: ret = savestates_load_pj64_unc(filepath); break;
+            case savestates_type_m64p: ret = savestates_load_m64p(dev, filepath); break;
+            case savestates_type_pj64_zip: ret = savestates_load_pj64_zip(dev, filepath); break;
+            case savestates_type_pj64_unc: ret = savestates_load_pj64_unc(dev, filepath); break;
             default: ret = 0; break;
         }
         free(filepath);
@@ -917,73 +1190,83 @@ static void savestates_save_m64p_work(struct work_struct *work)
     gzFile f;
     struct savestate_work *save = container_of(work, struct savestate_work, work);
 
-    SDL_LockMutex(savestates_lock);
+    /* two saves to the same file must not be written at the same time */
+    SDL_LockMutex(savestates_write_lock);
 
     // Write the state to a GZIP file
     f = gzopen(save->filepath, "wb");
 
     if (f==NULL)
     {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not open state file: %s", save->filepath);
-        free(save->data);
-        return;
+        save->result = savestate_work_open_failed;
     }
-
-    if (gzwrite(f, save->data, save->size) != save->size)
+    else
     {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not write data to state file: %s", save->filepath);
-        gzclose(f);
-        free(save->data);
-        return;
+        if (gzwrite(f, save->data, save->size) != save->size)
+            save->result = savestate_work_write_failed;
+        if (gzclose(f) != Z_OK)
+            save->result = savestate_work_write_failed;
     }
 
-    gzclose(f);
-    main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Saved state to: %s", namefrompath(save->filepath));
+    SDL_UnlockMutex(savestates_write_lock);
+
     free(save->data);
-    free(save->filepath);
-    free(save);
+    save->data = NULL;
 
-    SDL_UnlockMutex(savestates_lock);
+    SDL_LockMutex(savestates_done_lock);
+    list_add_tail(&save->done, &savestates_done);
+    SDL_UnlockMutex(savestates_done_lock);
 }
 
-static int savestates_save_m64p(char *filepath)
+static struct savestate_work *savestates_pop_done(void)
 {
-    unsigned char outbuf[4];
-    int i;
-
-    char queue[1024];
-    int queuelength;
+    struct savestate_work *save = NULL;
 
-    struct savestate_work *save;
-    char *curr;
-
-    uint32_t* cp0_regs = r4300_cp0_regs();
-
-    save = malloc(sizeof(*save));
-    if (!save) {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory to save state.");
-        return 0;
+    SDL_LockMutex(savestates_done_lock);
+    if (!list_empty(&savestates_done))
+    {
+        save = list_first_entry(&savestates_done, struct savestate_work, done);
+        list_del_init(&save->done);
     }
+    SDL_UnlockMutex(savestates_done_lock);
 
-    save->filepath = strdup(filepath);
-
-    if(autoinc_save_slot)
-        savestates_inc_slot();
+    return save;
+}
 
-    queuelength = save_eventqueue_infos(queue);
+/* Report the outcome of the completed state file writes.
+ * OSD messages may only be posted from the emulation thread. */
+void savestates_report_saves(void)
+{
+    struct savestate_work *save;
 
-    // Allocate memory for the save state data
-    save->size = 16788288 + queuelength;
-    save->data = curr = malloc(save->size);
-    if (save->data == NULL)
+    while ((save = savestates_pop_done()) != NULL)
     {
+        switch (save->result)
+        {
+            case savestate_work_saved:
+                main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Saved state to: %s", namefrompath(save->filepath));
+                break;
+            case savestate_work_open_failed:
+                main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not open state file: %s", save->filepath);
+                break;
+            case savestate_work_write_failed:
+                main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not write data to state file: %s", save->filepath);
+                break;
+        }
+
         free(save->filepath);
         free(save);
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory to save state.");
-        return 0;
     }
+}
+
+/* Write a complete Mupen64Plus savestate (header, machine state and event queue) to curr */
+static void savestates_save_m64p_data(struct device* dev, char *curr, char *queue, int queuelength)
+{
+    unsigned char outbuf[4];
+    int i;
+
+    uint32_t* cp0_regs = r4300_cp0_regs();
 
-    // Write the save state data to memory
     PUTARRAY(savestate_magic, curr, unsigned char, 8);
 
     outbuf[0] = (savestate_latest_version >> 24) & 0xff;
@@ -994,155 +1277,155 @@ static int savestates_save_m64p(char *filepath)
 
     PUTARRAY(ROM_SETTINGS.MD5, curr, char, 32);
 
-    PUTDATA(curr, uint32_t, g_ri.rdram.regs[RDRAM_CONFIG_REG]);
-    PUTDATA(curr, uint32_t, g_ri.rdram.regs[RDRAM_DEVICE_ID_REG]);
-    PUTDATA(curr, uint32_t, g_ri.rdram.regs[RDRAM_DELAY_REG]);
-    PUTDATA(curr, uint32_t, g_ri.rdram.regs[RDRAM_MODE_REG]);
-    PUTDATA(curr, uint32_t, g_ri.rdram.regs[RDRAM_REF_INTERVAL_REG]);
-    PUTDATA(curr, uint32_t, g_ri.rdram.regs[RDRAM_REF_ROW_REG]);
-    PUTDATA(curr, uint32_t, g_ri.rdram.regs[RDRAM_RAS_INTERVAL_REG]);
-    PUTDATA(curr, uint32_t, g_ri.rdram.regs[RDRAM_MIN_INTERVAL_REG]);
-    PUTDATA(curr, uint32_t, g_ri.rdram.regs[RDRAM_ADDR_SELECT_REG]);
-    PUTDATA(curr, uint32_t, g_ri.rdram.regs[RDRAM_DEVICE_MANUF_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.rdram.regs[RDRAM_CONFIG_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.rdram.regs[RDRAM_DEVICE_ID_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.rdram.regs[RDRAM_DELAY_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.rdram.regs[RDRAM_MODE_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.rdram.regs[RDRAM_REF_INTERVAL_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.rdram.regs[RDRAM_REF_ROW_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.rdram.regs[RDRAM_RAS_INTERVAL_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.rdram.regs[RDRAM_MIN_INTERVAL_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.rdram.regs[RDRAM_ADDR_SELECT_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.rdram.regs[RDRAM_DEVICE_MANUF_REG]);
 
     PUTDATA(curr, uint32_t, 0); // Padding from old implementation
-    PUTDATA(curr, uint32_t, g_r4300.mi.regs[MI_INIT_MODE_REG]);
-    PUTDATA(curr, uint8_t,  g_r4300.mi.regs[MI_INIT_MODE_REG] & 0x7F);
-    PUTDATA(curr, uint8_t, (g_r4300.mi.regs[MI_INIT_MODE_REG] & 0x80) != 0);
-    PUTDATA(curr, uint8_t, (g_r4300.mi.regs[MI_INIT_MODE_REG] & 0x100) != 0);
-    PUTDATA(curr, uint8_t, (g_r4300.mi.regs[MI_INIT_MODE_REG] & 0x200) != 0);
-    PUTDATA(curr, uint32_t, g_r4300.mi.regs[MI_VERSION_REG]);
-    PUTDATA(curr, uint32_t, g_r4300.mi.regs[MI_INTR_REG]);
-    PUTDATA(curr, uint32_t, g_r4300.mi.regs[MI_INTR_MASK_REG]);
+    PUTDATA(curr, uint32_t, dev->r4300.mi.regs[MI_INIT_MODE_REG]);
+    PUTDATA(curr, uint8_t,  dev->r4300.mi.regs[MI_INIT_MODE_REG] & 0x7F);
+    PUTDATA(curr, uint8_t, (dev->r4300.mi.regs[MI_INIT_MODE_REG] & 0x80) != 0);
+    PUTDATA(curr, uint8_t, (dev->r4300.mi.regs[MI_INIT_MODE_REG] & 0x100) != 0);
+    PUTDATA(curr, uint8_t, (dev->r4300.mi.regs[MI_INIT_MODE_REG] & 0x200) != 0);
+    PUTDATA(curr, uint32_t, dev->r4300.mi.regs[MI_VERSION_REG]);
+    PUTDATA(curr, uint32_t, dev->r4300.mi.regs[MI_INTR_REG]);
+    PUTDATA(curr, uint32_t, dev->r4300.mi.regs[MI_INTR_MASK_REG]);
     PUTDATA(curr, uint32_t, 0); //Padding from old implementation
-    PUTDATA(curr, uint8_t, (g_r4300.mi.regs[MI_INTR_MASK_REG] & 0x1) != 0);
-    PUTDATA(curr, uint8_t, (g_r4300.mi.regs[MI_INTR_MASK_REG] & 0x2) != 0);
-    PUTDATA(curr, uint8_t, (g_r4300.mi.regs[MI_INTR_MASK_REG] & 0x4) != 0);
-    PUTDATA(curr, uint8_t, (g_r4300.mi.regs[MI_INTR_MASK_REG] & 0x8) != 0);
-    PUTDATA(curr, uint8_t, (g_r4300.mi.regs[MI_INTR_MASK_REG] & 0x10) != 0);
-    PUTDATA(curr, uint8_t, (g_r4300.mi.regs[MI_INTR_MASK_REG] & 0x20) != 0);
+    PUTDATA(curr, uint8_t, (dev->r4300.mi.regs[MI_INTR_MASK_REG] & 0x1) != 0);
+    PUTDATA(curr, uint8_t, (dev->r4300.mi.regs[MI_INTR_MASK_REG] & 0x2) != 0);
+    PUTDATA(curr, uint8_t, (dev->r4300.mi.regs[MI_INTR_MASK_REG] & 0x4) != 0);
+    PUTDATA(curr, uint8_t, (dev->r4300.mi.regs[MI_INTR_MASK_REG] & 0x8) != 0);
+    PUTDATA(curr, uint8_t, (dev->r4300.mi.regs[MI_INTR_MASK_REG] & 0x10) != 0);
+    PUTDATA(curr, uint8_t, (dev->r4300.mi.regs[MI_INTR_MASK_REG] & 0x20) != 0);
     PUTDATA(curr, uint16_t, 0); // Padding from old implementation
 
-    PUTDATA(curr, uint32_t, g_pi.regs[PI_DRAM_ADDR_REG]);
-    PUTDATA(curr, uint32_t, g_pi.regs[PI_CART_ADDR_REG]);
-    PUTDATA(curr, uint32_t, g_pi.regs[PI_RD_LEN_REG]);
-    PUTDATA(curr, uint32_t, g_pi.regs[PI_WR_LEN_REG]);
-    PUTDATA(curr, uint32_t, g_pi.regs[PI_STATUS_REG]);
-    PUTDATA(curr, uint32_t, g_pi.regs[PI_BSD_DOM1_LAT_REG]);
-    PUTDATA(curr, uint32_t, g_pi.regs[PI_BSD_DOM1_PWD_REG]);
-    PUTDATA(curr, uint32_t, g_pi.regs[PI_BSD_DOM1_PGS_REG]);
-    PUTDATA(curr, uint32_t, g_pi.regs[PI_BSD_DOM1_RLS_REG]);
-    PUTDATA(curr, uint32_t, g_pi.regs[PI_BSD_DOM2_LAT_REG]);
-    PUTDATA(curr, uint32_t, g_pi.regs[PI_BSD_DOM2_PWD_REG]);
-    PUTDATA(curr, uint32_t, g_pi.regs[PI_BSD_DOM2_PGS_REG]);
-    PUTDATA(curr, uint32_t, g_pi.regs[PI_BSD_DOM2_RLS_REG]);
-
-    PUTDATA(curr, uint32_t, g_sp.regs[SP_MEM_ADDR_REG]);
-    PUTDATA(curr, uint32_t, g_sp.regs[SP_DRAM_ADDR_REG]);
-    PUTDATA(curr, uint32_t, g_sp.regs[SP_RD_LEN_REG]);
-    PUTDATA(curr, uint32_t, g_sp.regs[SP_WR_LEN_REG]);
+    PUTDATA(curr, uint32_t, dev->pi.regs[PI_DRAM_ADDR_REG]);
+    PUTDATA(curr, uint32_t, dev->pi.regs[PI_CART_ADDR_REG]);
+    PUTDATA(curr, uint32_t, dev->pi.regs[PI_RD_LEN_REG]);
+    PUTDATA(curr, uint32_t, dev->pi.regs[PI_WR_LEN_REG]);
+    PUTDATA(curr, uint32_t, dev->pi.regs[PI_STATUS_REG]);
+    PUTDATA(curr, uint32_t, dev->pi.regs[PI_BSD_DOM1_LAT_REG]);
+    PUTDATA(curr, uint32_t, dev->pi.regs[PI_BSD_DOM1_PWD_REG]);
+    PUTDATA(curr, uint32_t, dev->pi.regs[PI_BSD_DOM1_PGS_REG]);
+    PUTDATA(curr, uint32_t, dev->pi.regs[PI_BSD_DOM1_RLS_REG]);
+    PUTDATA(curr, uint32_t, dev->pi.regs[PI_BSD_DOM2_LAT_REG]);
+    PUTDATA(curr, uint32_t, dev->pi.regs[PI_BSD_DOM2_PWD_REG]);
+    PUTDATA(curr, uint32_t, dev->pi.regs[PI_BSD_DOM2_PGS_REG]);
+    PUTDATA(curr, uint32_t, dev->pi.regs[PI_BSD_DOM2_RLS_REG]);
+
+    PUTDATA(curr, uint32_t, dev->sp.regs[SP_MEM_ADDR_REG]);
+    PUTDATA(curr, uint32_t, dev->sp.regs[SP_DRAM_ADDR_REG]);
+    PUTDATA(curr, uint32_t, dev->sp.regs[SP_RD_LEN_REG]);
+    PUTDATA(curr, uint32_t, dev->sp.regs[SP_WR_LEN_REG]);
     PUTDATA(curr, uint32_t, 0); /* Padding from old implementation */
-    PUTDATA(curr, uint32_t, g_sp.regs[SP_STATUS_REG]);
-    PUTDATA(curr, uint8_t, (g_sp.regs[SP_STATUS_REG] & 0x1) != 0);
-    PUTDATA(curr, uint8_t, (g_sp.regs[SP_STATUS_REG] & 0x2) != 0);
-    PUTDATA(curr, uint8_t, (g_sp.regs[SP_STATUS_REG] & 0x4) != 0);
-    PUTDATA(curr, uint8_t, (g_sp.regs[SP_STATUS_REG] & 0x8) != 0);
-    PUTDATA(curr, uint8_t, (g_sp.regs[SP_STATUS_REG] & 0x10) != 0);
-    PUTDATA(curr, uint8_t, (g_sp.regs[SP_STATUS_REG] & 0x20) != 0);
-    PUTDATA(curr, uint8_t, (g_sp.regs[SP_STATUS_REG] & 0x40) != 0);
-    PUTDATA(curr, uint8_t, (g_sp.regs[SP_STATUS_REG] & 0x80) != 0);
-    PUTDATA(curr, uint8_t, (g_sp.regs[SP_STATUS_REG] & 0x100) != 0);
-    PUTDATA(curr, uint8_t, (g_sp.regs[SP_STATUS_REG] & 0x200) != 0);
-    PUTDATA(curr, uint8_t, (g_sp.regs[SP_STATUS_REG] & 0x400) != 0);
-    PUTDATA(curr, uint8_t, (g_sp.regs[SP_STATUS_REG] & 0x800) != 0);
-    PUTDATA(curr, uint8_t, (g_sp.regs[SP_STATUS_REG] & 0x1000) != 0);
-    PUTDATA(curr, uint8_t, (g_sp.regs[SP_STATUS_REG] & 0x2000) != 0);
-    PUTDATA(curr, uint8_t, (g_sp.regs[SP_STATUS_REG] & 0x4000) != 0);
+    PUTDATA(curr, uint32_t, dev->sp.regs[SP_STATUS_REG]);
+    PUTDATA(curr, uint8_t, (dev->sp.regs[SP_STATUS_REG] & 0x1) != 0);
+    PUTDATA(curr, uint8_t, (dev->sp.regs[SP_STATUS_REG] & 0x2) != 0);
+    PUTDATA(curr, uint8_t, (dev->sp.regs[SP_STATUS_REG] & 0x4) != 0);
+    PUTDATA(curr, uint8_t, (dev->sp.regs[SP_STATUS_REG] & 0x8) != 0);
+    PUTDATA(curr, uint8_t, (dev->sp.regs[SP_STATUS_REG] & 0x10) != 0);
+    PUTDATA(curr, uint8_t, (dev->sp.regs[SP_STATUS_REG] & 0x20) != 0);
+    PUTDATA(curr, uint8_t, (dev->sp.regs[SP_STATUS_REG] & 0x40) != 0);
+    PUTDATA(curr, uint8_t, (dev->sp.regs[SP_STATUS_REG] & 0x80) != 0);
+    PUTDATA(curr, uint8_t, (dev->sp.regs[SP_STATUS_REG] & 0x100) != 0);
+    PUTDATA(curr, uint8_t, (dev->sp.regs[SP_STATUS_REG] & 0x200) != 0);
+    PUTDATA(curr, uint8_t, (dev->sp.regs[SP_STATUS_REG] & 0x400) != 0);
+    PUTDATA(curr, uint8_t, (dev->sp.regs[SP_STATUS_REG] & 0x800) != 0);
+    PUTDATA(curr, uint8_t, (dev->sp.regs[SP_STATUS_REG] & 0x1000) != 0);
+    PUTDATA(curr, uint8_t, (dev->sp.regs[SP_STATUS_REG] & 0x2000) != 0);
+    PUTDATA(curr, uint8_t, (dev->sp.regs[SP_STATUS_REG] & 0x4000) != 0);
     PUTDATA(curr, uint8_t, 0);
-    PUTDATA(curr, uint32_t, g_sp.regs[SP_DMA_FULL_REG]);
-    PUTDATA(curr, uint32_t, g_sp.regs[SP_DMA_BUSY_REG]);
-    PUTDATA(curr, uint32_t, g_sp.regs[SP_SEMAPHORE_REG]);
-
-    PUTDATA(curr, uint32_t, g_sp.regs2[SP_PC_REG]);
-    PUTDATA(curr, uint32_t, g_sp.regs2[SP_IBIST_REG]);
-
-    PUTDATA(curr, uint32_t, g_si.regs[SI_DRAM_ADDR_REG]);
-    PUTDATA(curr, uint32_t, g_si.regs[SI_PIF_ADDR_RD64B_REG]);
-    PUTDATA(curr, uint32_t, g_si.regs[SI_PIF_ADDR_WR64B_REG]);
-    PUTDATA(curr, uint32_t, g_si.regs[SI_STATUS_REG]);
-
-    PUTDATA(curr, uint32_t, g_vi.regs[VI_STATUS_REG]);
-    PUTDATA(curr, uint32_t, g_vi.regs[VI_ORIGIN_REG]);
-    PUTDATA(curr, uint32_t, g_vi.regs[VI_WIDTH_REG]);
-    PUTDATA(curr, uint32_t, g_vi.regs[VI_V_INTR_REG]);
-    PUTDATA(curr, uint32_t, g_vi.regs[VI_CURRENT_REG]);
-    PUTDATA(curr, uint32_t, g_vi.regs[VI_BURST_REG]);
-    PUTDATA(curr, uint32_t, g_vi.regs[VI_V_SYNC_REG]);
-    PUTDATA(curr, uint32_t, g_vi.regs[VI_H_SYNC_REG]);
-    PUTDATA(curr, uint32_t, g_vi.regs[VI_LEAP_REG]);
-    PUTDATA(curr, uint32_t, g_vi.regs[VI_H_START_REG]);
-    PUTDATA(curr, uint32_t, g_vi.regs[VI_V_START_REG]);
-    PUTDATA(curr, uint32_t, g_vi.regs[VI_V_BURST_REG]);
-    PUTDATA(curr, uint32_t, g_vi.regs[VI_X_SCALE_REG]);
-    PUTDATA(curr, uint32_t, g_vi.regs[VI_Y_SCALE_REG]);
-    PUTDATA(curr, unsigned int, g_vi.delay);
-
-    PUTDATA(curr, uint32_t, g_ri.regs[RI_MODE_REG]);
-    PUTDATA(curr, uint32_t, g_ri.regs[RI_CONFIG_REG]);
-    PUTDATA(curr, uint32_t, g_ri.regs[RI_CURRENT_LOAD_REG]);
-    PUTDATA(curr, uint32_t, g_ri.regs[RI_SELECT_REG]);
-    PUTDATA(curr, uint32_t, g_ri.regs[RI_REFRESH_REG]);
-    PUTDATA(curr, uint32_t, g_ri.regs[RI_LATENCY_REG]);
-    PUTDATA(curr, uint32_t, g_ri.regs[RI_ERROR_REG]);
-    PUTDATA(curr, uint32_t, g_ri.regs[RI_WERROR_REG]);
-
-    PUTDATA(curr, uint32_t, g_ai.regs[AI_DRAM_ADDR_REG]);
-    PUTDATA(curr, uint32_t, g_ai.regs[AI_LEN_REG]);
-    PUTDATA(curr, uint32_t, g_ai.regs[AI_CONTROL_REG]);
-    PUTDATA(curr, uint32_t, g_ai.regs[AI_STATUS_REG]);
-    PUTDATA(curr, uint32_t, g_ai.regs[AI_DACRATE_REG]);
-    PUTDATA(curr, uint32_t, g_ai.regs[AI_BITRATE_REG]);
-    PUTDATA(curr, unsigned int, g_ai.fifo[1].duration);
-    PUTDATA(curr, uint32_t    , g_ai.fifo[1].length);
-    PUTDATA(curr, unsigned int, g_ai.fifo[0].duration);
-    PUTDATA(curr, uint32_t    , g_ai.fifo[0].length);
-
-    PUTDATA(curr, uint32_t, g_dp.dpc_regs[DPC_START_REG]);
-    PUTDATA(curr, uint32_t, g_dp.dpc_regs[DPC_END_REG]);
-    PUTDATA(curr, uint32_t, g_dp.dpc_regs[DPC_CURRENT_REG]);
+    PUTDATA(curr, uint32_t, dev->sp.regs[SP_DMA_FULL_REG]);
+    PUTDATA(curr, uint32_t, dev->sp.regs[SP_DMA_BUSY_REG]);
+    PUTDATA(curr, uint32_t, dev->sp.regs[SP_SEMAPHORE_REG]);
+
+    PUTDATA(curr, uint32_t, dev->sp.regs2[SP_PC_REG]);
+    PUTDATA(curr, uint32_t, dev->sp.regs2[SP_IBIST_REG]);
+
+    PUTDATA(curr, uint32_t, dev->si.regs[SI_DRAM_ADDR_REG]);
+    PUTDATA(curr, uint32_t, dev->si.regs[SI_PIF_ADDR_RD64B_REG]);
+    PUTDATA(curr, uint32_t, dev->si.regs[SI_PIF_ADDR_WR64B_REG]);
+    PUTDATA(curr, uint32_t, dev->si.regs[SI_STATUS_REG]);
+
+    PUTDATA(curr, uint32_t, dev->vi.regs[VI_STATUS_REG]);
+    PUTDATA(curr, uint32_t, dev->vi.regs[VI_ORIGIN_REG]);
+    PUTDATA(curr, uint32_t, dev->vi.regs[VI_WIDTH_REG]);
+    PUTDATA(curr, uint32_t, dev->vi.regs[VI_V_INTR_REG]);
+    PUTDATA(curr, uint32_t, dev->vi.regs[VI_CURRENT_REG]);
+    PUTDATA(curr, uint32_t, dev->vi.regs[VI_BURST_REG]);
+    PUTDATA(curr, uint32_t, dev->vi.regs[VI_V_SYNC_REG]);
+    PUTDATA(curr, uint32_t, dev->vi.regs[VI_H_SYNC_REG]);
+    PUTDATA(curr, uint32_t, dev->vi.regs[VI_LEAP_REG]);
+    PUTDATA(curr, uint32_t, dev->vi.regs[VI_H_START_REG]);
+    PUTDATA(curr, uint32_t, dev->vi.regs[VI_V_START_REG]);
+    PUTDATA(curr, uint32_t, dev->vi.regs[VI_V_BURST_REG]);
+    PUTDATA(curr, uint32_t, dev->vi.regs[VI_X_SCALE_REG]);
+    PUTDATA(curr, uint32_t, dev->vi.regs[VI_Y_SCALE_REG]);
+    PUTDATA(curr, unsigned int, dev->vi.delay);
+
+    PUTDATA(curr, uint32_t, dev->ri.regs[RI_MODE_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.regs[RI_CONFIG_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.regs[RI_CURRENT_LOAD_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.regs[RI_SELECT_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.regs[RI_REFRESH_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.regs[RI_LATENCY_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.regs[RI_ERROR_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.regs[RI_WERROR_REG]);
+
+    PUTDATA(curr, uint32_t, dev->ai.regs[AI_DRAM_ADDR_REG]);
+    PUTDATA(curr, uint32_t, dev->ai.regs[AI_LEN_REG]);
+    PUTDATA(curr, uint32_t, dev->ai.regs[AI_CONTROL_REG]);
+    PUTDATA(curr, uint32_t, dev->ai.regs[AI_STATUS_REG]);
+    PUTDATA(curr, uint32_t, dev->ai.regs[AI_DACRATE_REG]);
+    PUTDATA(curr, uint32_t, dev->ai.regs[AI_BITRATE_REG]);
+    PUTDATA(curr, unsigned int, dev->ai.fifo[1].duration);
+    PUTDATA(curr, uint32_t    , dev->ai.fifo[1].length);
+    PUTDATA(curr, unsigned int, dev->ai.fifo[0].duration);
+    PUTDATA(curr, uint32_t    , dev->ai.fifo[0].length);
+
+    PUTDATA(curr, uint32_t, dev->dp.dpc_regs[DPC_START_REG]);
+    PUTDATA(curr, uint32_t, dev->dp.dpc_regs[DPC_END_REG]);
+    PUTDATA(curr, uint32_t, dev->dp.dpc_regs[DPC_CURRENT_REG]);
     PUTDATA(curr, uint32_t, 0); /* Padding from old implementation */
-    PUTDATA(curr, uint32_t, g_dp.dpc_regs[DPC_STATUS_REG]);
-    PUTDATA(curr, uint8_t, (g_dp.dpc_regs[DPC_STATUS_REG] & 0x1) != 0);
-    PUTDATA(curr, uint8_t, (g_dp.dpc_regs[DPC_STATUS_REG] & 0x2) != 0);
-    PUTDATA(curr, uint8_t, (g_dp.dpc_regs[DPC_STATUS_REG] & 0x4) != 0);
-    PUTDATA(curr, uint8_t, (g_dp.dpc_regs[DPC_STATUS_REG] & 0x8) != 0);
-    PUTDATA(curr, uint8_t, (g_dp.dpc_regs[DPC_STATUS_REG] & 0x10) != 0);
-    PUTDATA(curr, uint8_t, (g_dp.dpc_regs[DPC_STATUS_REG] & 0x20) != 0);
-    PUTDATA(curr, uint8_t, (g_dp.dpc_regs[DPC_STATUS_REG] & 0x40) != 0);
-    PUTDATA(curr, uint8_t, (g_dp.dpc_regs[DPC_STATUS_REG] & 0x80) != 0);
-    PUTDATA(curr, uint8_t, (g_dp.dpc_regs[DPC_STATUS_REG] & 0x100) != 0);
-    PUTDATA(curr, uint8_t, (g_dp.dpc_regs[DPC_STATUS_REG] & 0x200) != 0);
-    PUTDATA(curr, uint8_t, (g_dp.dpc_regs[DPC_STATUS_REG] & 0x400) != 0);
+    PUTDATA(curr, uint32_t, dev->dp.dpc_regs[DPC_STATUS_REG]);
+    PUTDATA(curr, uint8_t, (dev->dp.dpc_regs[DPC_STATUS_REG] & 0x1) != 0);
+    PUTDATA(curr, uint8_t, (dev->dp.dpc_regs[DPC_STATUS_REG] & 0x2) != 0);
+    PUTDATA(curr, uint8_t, (dev->dp.dpc_regs[DPC_STATUS_REG] & 0x4) != 0);
+    PUTDATA(curr, uint8_t, (dev->dp.dpc_regs[DPC_STATUS_REG] & 0x8) != 0);
+    PUTDATA(curr, uint8_t, (dev->dp.dpc_regs[DPC_STATUS_REG] & 0x10) != 0);
+    PUTDATA(curr, uint8_t, (dev->dp.dpc_regs[DPC_STATUS_REG] & 0x20) != 0);
+    PUTDATA(curr, uint8_t, (dev->dp.dpc_regs[DPC_STATUS_REG] & 0x40) != 0);
+    PUTDATA(curr, uint8_t, (dev->dp.dpc_regs[DPC_STATUS_REG] & 0x80) != 0);
+    PUTDATA(curr, uint8_t, (dev->dp.dpc_regs[DPC_STATUS_REG] & 0x100) != 0);
+    PUTDATA(curr, uint8_t, (dev->dp.dpc_regs[DPC_STATUS_REG] & 0x200) != 0);
+    PUTDATA(curr, uint8_t, (dev->dp.dpc_regs[DPC_STATUS_REG] & 0x400) != 0);
     PUTDATA(curr, uint8_t, 0);
-    PUTDATA(curr, uint32_t, g_dp.dpc_regs[DPC_CLOCK_REG]);
-    PUTDATA(curr, uint32_t, g_dp.dpc_regs[DPC_BUFBUSY_REG]);
-    PUTDATA(curr, uint32_t, g_dp.dpc_regs[DPC_PIPEBUSY_REG]);
-    PUTDATA(curr, uint32_t, g_dp.dpc_regs[DPC_TMEM_REG]);
+    PUTDATA(curr, uint32_t, dev->dp.dpc_regs[DPC_CLOCK_REG]);
+    PUTDATA(curr, uint32_t, dev->dp.dpc_regs[DPC_BUFBUSY_REG]);
+    PUTDATA(curr, uint32_t, dev->dp.dpc_regs[DPC_PIPEBUSY_REG]);
+    PUTDATA(curr, uint32_t, dev->dp.dpc_regs[DPC_TMEM_REG]);
 
-    PUTDATA(curr, uint32_t, g_dp.dps_regs[DPS_TBIST_REG]);
-    PUTDATA(curr, uint32_t, g_dp.dps_regs[DPS_TEST_MODE_REG]);
-    PUTDATA(curr, uint32_t, g_dp.dps_regs[DPS_BUFTEST_ADDR_REG]);
-    PUTDATA(curr, uint32_t, g_dp.dps_regs[DPS_BUFTEST_DATA_REG]);
+    PUTDATA(curr, uint32_t, dev->dp.dps_regs[DPS_TBIST_REG]);
+    PUTDATA(curr, uint32_t, dev->dp.dps_regs[DPS_TEST_MODE_REG]);
+    PUTDATA(curr, uint32_t, dev->dp.dps_regs[DPS_BUFTEST_ADDR_REG]);
+    PUTDATA(curr, uint32_t, dev->dp.dps_regs[DPS_BUFTEST_DATA_REG]);
 
     PUTARRAY(g_rdram, curr, uint32_t, RDRAM_MAX_SIZE/4);
-    PUTARRAY(g_sp.mem, curr, uint32_t, SP_MEM_SIZE/4);
-    PUTARRAY(g_si.pif.ram, curr, uint8_t, PIF_RAM_SIZE);
+    PUTARRAY(dev->sp.mem, curr, uint32_t, SP_MEM_SIZE/4);
+    PUTARRAY(dev->si.pif.ram, curr, uint8_t, PIF_RAM_SIZE);
 
-    PUTDATA(curr, int, g_pi.use_flashram);
-    PUTDATA(curr, int, g_pi.flashram.mode);
-    PUTDATA(curr, unsigned long long, g_pi.flashram.status);
-    PUTDATA(curr, unsigned int, g_pi.flashram.erase_offset);
-    PUTDATA(curr, unsigned int, g_pi.flashram.write_pointer);
+    PUTDATA(curr, int, dev->pi.use_flashram);
+    PUTDATA(curr, int, dev->pi.flashram.mode);
+    PUTDATA(curr, unsigned long long, dev->pi.flashram.status);
+    PUTDATA(curr, unsigned int, dev->pi.flashram.erase_offset);
+    PUTDATA(curr, unsigned int, dev->pi.flashram.write_pointer);
 
     PUTARRAY(tlb_LUT_r, curr, unsigned int, 0x100000);
     PUTARRAY(tlb_LUT_w, curr, unsigned int, 0x100000);
@@ -1190,21 +1473,150 @@ static int savestates_save_m64p(char *filepath)
     PUTDATA(curr, uint32_t, *r4300_pc());
 
     PUTDATA(curr, unsigned int, *r4300_next_interrupt());
-    PUTDATA(curr, unsigned int, g_vi.next_vi);
-    PUTDATA(curr, unsigned int, g_vi.field);
+    PUTDATA(curr, unsigned int, dev->vi.next_vi);
+    PUTDATA(curr, unsigned int, dev->vi.field);
 
     to_little_endian_buffer(queue, 4, queuelength/4);
     PUTARRAY(queue, curr, char, queuelength);
 
-    // assert(curr == save->data + save->size)
+}
 
+static int savestates_save_m64p(struct device* dev, char *filepath)
+{
+    char queue[M64P_QUEUE_MAX_SIZE];
+    int queuelength;
+
+    struct savestate_work *save;
+
+    save = malloc(sizeof(*save));
+    if (!save) {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory to save state.");
+        return 0;
+    }
+
+    save->filepath = strdup(filepath);
+
+    if(autoinc_save_slot)
+        savestates_inc_slot();
+
+    queuelength = save_eventqueue_infos(queue);
+
+    // Allocate memory for the save state data
+    save->size = M64P_HEADER_SIZE + M64P_DATA_SIZE + queuelength;
+    save->data = malloc(save->size);
+    if (save->data == NULL)
+    {
+        free(save->filepath);
+        free(save);
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory to save state.");
+        return 0;
+    }
+
+    // Write the save state data to memory
+    savestates_save_m64p_data(dev, save->data, queue, queuelength);
+
+    save->result = savestate_work_saved;
+    INIT_LIST_HEAD(&save->done);
     init_work(&save->work, savestates_save_m64p_work);
-    queue_work(&save->work);
+    queue_work_fenced(&save->work, &savestates_fence);
 
     return 1;
 }
 
-static int savestates_save_pj64(char *filepath, void *handle,
+/* Store the chunks of a full savestate which differ from base into out.
+ * Returns the size of the delta savestate, or 0 if out is too small. */
+size_t savestates_make_delta(const void *base, size_t base_size,
+                             const void *full_state, size_t full_size,
+                             void *out, size_t out_size)
+{
+    const unsigned char *full = (const unsigned char *)full_state;
+    const unsigned char *old = (const unsigned char *)base;
+    unsigned char *start = (unsigned char *)out;
+    unsigned char *curr = start;
+    unsigned char *count_ptr;
+    uint32_t count = 0;
+    size_t offset, len;
+
+    if (out_size < M64P_HEADER_SIZE + 8)
+        return 0;
+
+    PUTARRAY(savestate_delta_magic, curr, unsigned char, 8);
+    PUTARRAY(full + 8, curr, unsigned char, M64P_HEADER_SIZE - 8);
+    PUTDATA(curr, uint32_t, full_size);
+    count_ptr = curr;
+    curr += 4;
+
+    for (offset = 0; offset < full_size; offset += M64P_DELTA_CHUNK_SIZE)
+    {
+        len = full_size - offset;
+        if (len > M64P_DELTA_CHUNK_SIZE)
+            len = M64P_DELTA_CHUNK_SIZE;
+
+        if (offset + len <= base_size && memcmp(full + offset, old + offset, len) == 0)
+            continue;
+
+        if ((size_t)(curr - start) + 4 + len > out_size)
+            return 0;
+
+        PUTDATA(curr, uint32_t, offset);
+        PUTARRAY(full + offset, curr, unsigned char, len);
+        ++count;
+    }
+
+    PUTDATA(count_ptr, uint32_t, count);
+
+    return curr - start;
+}
+
+/* Save an uncompressed Mupen64Plus savestate to a buffer.
+ * Returns the size of the savestate, or 0 if the buffer is too small. */
+size_t savestates_save_m64p_buffer(struct device* dev, void *buffer, size_t size)
+{
+    char queue[M64P_QUEUE_MAX_SIZE];
+    int queuelength;
+    size_t full_size;
+
+    rsp_wait_task(&dev->sp);
+
+    queuelength = save_eventqueue_infos(queue);
+    full_size = M64P_HEADER_SIZE + M64P_DATA_SIZE + queuelength;
+
+    if (size < full_size)
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Savestate buffer is too small.");
+        return 0;
+    }
+
+    savestates_save_m64p_data(dev, (char *)buffer, queue, queuelength);
+    return full_size;
+}
+
+/* Save a Mupen64Plus savestate (without compression) to mem_buffer.
+ * If a delta base is set, only the chunks which differ from it are stored.
+ * Returns the number of bytes written, or 0 on error. */
+static size_t savestates_save_m64p_mem(struct device* dev)
+{
+    size_t full_size, size;
+    unsigned char *full;
+
+    if (delta_base == NULL)
+        return savestates_save_m64p_buffer(dev, mem_buffer, mem_size);
+
+    if ((full = savestates_get_delta_scratch()) == NULL)
+        return 0;
+
+    full_size = savestates_save_m64p_buffer(dev, full, savestates_get_full_mem_size());
+    if (full_size == 0)
+        return 0;
+
+    size = savestates_make_delta(delta_base, delta_base_size, full, full_size, mem_buffer, mem_size);
+    if (size == 0)
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Savestate buffer is too small.");
+
+    return size;
+}
+
+static int savestates_save_pj64(struct device* dev, char *filepath, void *handle,
                                 int (*write_func)(void *, const void *, size_t))
 {
     unsigned int i;
@@ -1244,94 +1656,94 @@ static int savestates_save_pj64(char *filepath, void *handle,
     PUTDATA(curr, int64_t, *r4300_mult_hi());
     PUTDATA(curr, int64_t, *r4300_mult_lo());
 
-    PUTDATA(curr, uint32_t, g_ri.rdram.regs[RDRAM_CONFIG_REG]);
-    PUTDATA(curr, uint32_t, g_ri.rdram.regs[RDRAM_DEVICE_ID_REG]);
-    PUTDATA(curr, uint32_t, g_ri.rdram.regs[RDRAM_DELAY_REG]);
-    PUTDATA(curr, uint32_t, g_ri.rdram.regs[RDRAM_MODE_REG]);
-    PUTDATA(curr, uint32_t, g_ri.rdram.regs[RDRAM_REF_INTERVAL_REG]);
-    PUTDATA(curr, uint32_t, g_ri.rdram.regs[RDRAM_REF_ROW_REG]);
-    PUTDATA(curr, uint32_t, g_ri.rdram.regs[RDRAM_RAS_INTERVAL_REG]);
-    PUTDATA(curr, uint32_t, g_ri.rdram.regs[RDRAM_MIN_INTERVAL_REG]);
-    PUTDATA(curr, uint32_t, g_ri.rdram.regs[RDRAM_ADDR_SELECT_REG]);
-    PUTDATA(curr, uint32_t, g_ri.rdram.regs[RDRAM_DEVICE_MANUF_REG]);
-
-    PUTDATA(curr, uint32_t, g_sp.regs[SP_MEM_ADDR_REG]);
-    PUTDATA(curr, uint32_t, g_sp.regs[SP_DRAM_ADDR_REG]);
-    PUTDATA(curr, uint32_t, g_sp.regs[SP_RD_LEN_REG]);
-    PUTDATA(curr, uint32_t, g_sp.regs[SP_WR_LEN_REG]);
-    PUTDATA(curr, uint32_t, g_sp.regs[SP_STATUS_REG]);
-    PUTDATA(curr, uint32_t, g_sp.regs[SP_DMA_FULL_REG]);
-    PUTDATA(curr, uint32_t, g_sp.regs[SP_DMA_BUSY_REG]);
-    PUTDATA(curr, uint32_t, g_sp.regs[SP_SEMAPHORE_REG]);
-
-    PUTDATA(curr, uint32_t, g_sp.regs2[SP_PC_REG]);
-    PUTDATA(curr, uint32_t, g_sp.regs2[SP_IBIST_REG]);
-
-    PUTDATA(curr, uint32_t, g_dp.dpc_regs[DPC_START_REG]);
-    PUTDATA(curr, uint32_t, g_dp.dpc_regs[DPC_END_REG]);
-    PUTDATA(curr, uint32_t, g_dp.dpc_regs[DPC_CURRENT_REG]);
-    PUTDATA(curr, uint32_t, g_dp.dpc_regs[DPC_STATUS_REG]);
-    PUTDATA(curr, uint32_t, g_dp.dpc_regs[DPC_CLOCK_REG]);
-    PUTDATA(curr, uint32_t, g_dp.dpc_regs[DPC_BUFBUSY_REG]);
-    PUTDATA(curr, uint32_t, g_dp.dpc_regs[DPC_PIPEBUSY_REG]);
-    PUTDATA(curr, uint32_t, g_dp.dpc_regs[DPC_TMEM_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.rdram.regs[RDRAM_CONFIG_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.rdram.regs[RDRAM_DEVICE_ID_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.rdram.regs[RDRAM_DELAY_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.rdram.regs[RDRAM_MODE_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.rdram.regs[RDRAM_REF_INTERVAL_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.rdram.regs[RDRAM_REF_ROW_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.rdram.regs[RDRAM_RAS_INTERVAL_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.rdram.regs[RDRAM_MIN_INTERVAL_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.rdram.regs[RDRAM_ADDR_SELECT_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.rdram.regs[RDRAM_DEVICE_MANUF_REG]);
+
+    PUTDATA(curr, uint32_t, dev->sp.regs[SP_MEM_ADDR_REG]);
+    PUTDATA(curr, uint32_t, dev->sp.regs[SP_DRAM_ADDR_REG]);
+    PUTDATA(curr, uint32_t, dev->sp.regs[SP_RD_LEN_REG]);
+    PUTDATA(curr, uint32_t, dev->sp.regs[SP_WR_LEN_REG]);
+    PUTDATA(curr, uint32_t, dev->sp.regs[SP_STATUS_REG]);
+    PUTDATA(curr, uint32_t, dev->sp.regs[SP_DMA_FULL_REG]);
+    PUTDATA(curr, uint32_t, dev->sp.regs[SP_DMA_BUSY_REG]);
+    PUTDATA(curr, uint32_t, dev->sp.regs[SP_SEMAPHORE_REG]);
+
+    PUTDATA(curr, uint32_t, dev->sp.regs2[SP_PC_REG]);
+    PUTDATA(curr, uint32_t, dev->sp.regs2[SP_IBIST_REG]);
+
+    PUTDATA(curr, uint32_t, dev->dp.dpc_regs[DPC_START_REG]);
+    PUTDATA(curr, uint32_t, dev->dp.dpc_regs[DPC_END_REG]);
+    PUTDATA(curr, uint32_t, dev->dp.dpc_regs[DPC_CURRENT_REG]);
+    PUTDATA(curr, uint32_t, dev->dp.dpc_regs[DPC_STATUS_REG]);
+    PUTDATA(curr, uint32_t, dev->dp.dpc_regs[DPC_CLOCK_REG]);
+    PUTDATA(curr, uint32_t, dev->dp.dpc_regs[DPC_BUFBUSY_REG]);
+    PUTDATA(curr, uint32_t, dev->dp.dpc_regs[DPC_PIPEBUSY_REG]);
+    PUTDATA(curr, uint32_t, dev->dp.dpc_regs[DPC_TMEM_REG]);
     PUTDATA(curr, unsigned int, 0); // ?
     PUTDATA(curr, unsigned int, 0); // ?
 
-    PUTDATA(curr, uint32_t, g_r4300.mi.regs[MI_INIT_MODE_REG]); //TODO Secial handling in pj64
-    PUTDATA(curr, uint32_t, g_r4300.mi.regs[MI_VERSION_REG]);
-    PUTDATA(curr, uint32_t, g_r4300.mi.regs[MI_INTR_REG]);
-    PUTDATA(curr, uint32_t, g_r4300.mi.regs[MI_INTR_MASK_REG]);
-
-    PUTDATA(curr, uint32_t, g_vi.regs[VI_STATUS_REG]);
-    PUTDATA(curr, uint32_t, g_vi.regs[VI_ORIGIN_REG]);
-    PUTDATA(curr, uint32_t, g_vi.regs[VI_WIDTH_REG]);
-    PUTDATA(curr, uint32_t, g_vi.regs[VI_V_INTR_REG]);
-    PUTDATA(curr, uint32_t, g_vi.regs[VI_CURRENT_REG]);
-    PUTDATA(curr, uint32_t, g_vi.regs[VI_BURST_REG]);
-    PUTDATA(curr, uint32_t, g_vi.regs[VI_V_SYNC_REG]);
-    PUTDATA(curr, uint32_t, g_vi.regs[VI_H_SYNC_REG]);
-    PUTDATA(curr, uint32_t, g_vi.regs[VI_LEAP_REG]);
-    PUTDATA(curr, uint32_t, g_vi.regs[VI_H_START_REG]);
-    PUTDATA(curr, uint32_t, g_vi.regs[VI_V_START_REG]);
-    PUTDATA(curr, uint32_t, g_vi.regs[VI_V_BURST_REG]);
-    PUTDATA(curr, uint32_t, g_vi.regs[VI_X_SCALE_REG]);
-    PUTDATA(curr, uint32_t, g_vi.regs[VI_Y_SCALE_REG]);
-
-    PUTDATA(curr, uint32_t, g_ai.regs[AI_DRAM_ADDR_REG]);
-    PUTDATA(curr, uint32_t, g_ai.regs[AI_LEN_REG]);
-    PUTDATA(curr, uint32_t, g_ai.regs[AI_CONTROL_REG]);
-    PUTDATA(curr, uint32_t, g_ai.regs[AI_STATUS_REG]);
-    PUTDATA(curr, uint32_t, g_ai.regs[AI_DACRATE_REG]);
-    PUTDATA(curr, uint32_t, g_ai.regs[AI_BITRATE_REG]);
-
-    PUTDATA(curr, uint32_t, g_pi.regs[PI_DRAM_ADDR_REG]);
-    PUTDATA(curr, uint32_t, g_pi.regs[PI_CART_ADDR_REG]);
-    PUTDATA(curr, uint32_t, g_pi.regs[PI_RD_LEN_REG]);
-    PUTDATA(curr, uint32_t, g_pi.regs[PI_WR_LEN_REG]);
-    PUTDATA(curr, uint32_t, g_pi.regs[PI_STATUS_REG]);
-    PUTDATA(curr, uint32_t, g_pi.regs[PI_BSD_DOM1_LAT_REG]);
-    PUTDATA(curr, uint32_t, g_pi.regs[PI_BSD_DOM1_PWD_REG]);
-    PUTDATA(curr, uint32_t, g_pi.regs[PI_BSD_DOM1_PGS_REG]);
-    PUTDATA(curr, uint32_t, g_pi.regs[PI_BSD_DOM1_RLS_REG]);
-    PUTDATA(curr, uint32_t, g_pi.regs[PI_BSD_DOM2_LAT_REG]);
-    PUTDATA(curr, uint32_t, g_pi.regs[PI_BSD_DOM2_PWD_REG]);
-    PUTDATA(curr, uint32_t, g_pi.regs[PI_BSD_DOM2_PGS_REG]);
-    PUTDATA(curr, uint32_t, g_pi.regs[PI_BSD_DOM2_RLS_REG]);
-
-    PUTDATA(curr, uint32_t, g_ri.regs[RI_MODE_REG]);
-    PUTDATA(curr, uint32_t, g_ri.regs[RI_CONFIG_REG]);
-    PUTDATA(curr, uint32_t, g_ri.regs[RI_CURRENT_LOAD_REG]);
-    PUTDATA(curr, uint32_t, g_ri.regs[RI_SELECT_REG]);
-    PUTDATA(curr, uint32_t, g_ri.regs[RI_REFRESH_REG]);
-    PUTDATA(curr, uint32_t, g_ri.regs[RI_LATENCY_REG]);
-    PUTDATA(curr, uint32_t, g_ri.regs[RI_ERROR_REG]);
-    PUTDATA(curr, uint32_t, g_ri.regs[RI_WERROR_REG]);
-
-    PUTDATA(curr, uint32_t, g_si.regs[SI_DRAM_ADDR_REG]);
-    PUTDATA(curr, uint32_t, g_si.regs[SI_PIF_ADDR_RD64B_REG]);
-    PUTDATA(curr, uint32_t, g_si.regs[SI_PIF_ADDR_WR64B_REG]);
-    PUTDATA(curr, uint32_t, g_si.regs[SI_STATUS_REG]);
+    PUTDATA(curr, uint32_t, dev->r4300.mi.regs[MI_INIT_MODE_REG]); //TODO Secial handling in pj64
+    PUTDATA(curr, uint32_t, dev->r4300.mi.regs[MI_VERSION_REG]);
+    PUTDATA(curr, uint32_t, dev->r4300.mi.regs[MI_INTR_REG]);
+    PUTDATA(curr, uint32_t, dev->r4300.mi.regs[MI_INTR_MASK_REG]);
+
+    PUTDATA(curr, uint32_t, dev->vi.regs[VI_STATUS_REG]);
+    PUTDATA(curr, uint32_t, dev->vi.regs[VI_ORIGIN_REG]);
+    PUTDATA(curr, uint32_t, dev->vi.regs[VI_WIDTH_REG]);
+    PUTDATA(curr, uint32_t, dev->vi.regs[VI_V_INTR_REG]);
+    PUTDATA(curr, uint32_t, dev->vi.regs[VI_CURRENT_REG]);
+    PUTDATA(curr, uint32_t, dev->vi.regs[VI_BURST_REG]);
+    PUTDATA(curr, uint32_t, dev->vi.regs[VI_V_SYNC_REG]);
+    PUTDATA(curr, uint32_t, dev->vi.regs[VI_H_SYNC_REG]);
+    PUTDATA(curr, uint32_t, dev->vi.regs[VI_LEAP_REG]);
+    PUTDATA(curr, uint32_t, dev->vi.regs[VI_H_START_REG]);
+    PUTDATA(curr, uint32_t, dev->vi.regs[VI_V_START_REG]);
+    PUTDATA(curr, uint32_t, dev->vi.regs[VI_V_BURST_REG]);
+    PUTDATA(curr, uint32_t, dev->vi.regs[VI_X_SCALE_REG]);
+    PUTDATA(curr, uint32_t, dev->vi.regs[VI_Y_SCALE_REG]);
+
+    PUTDATA(curr, uint32_t, dev->ai.regs[AI_DRAM_ADDR_REG]);
+    PUTDATA(curr, uint32_t, dev->ai.regs[AI_LEN_REG]);
+    PUTDATA(curr, uint32_t, dev->ai.regs[AI_CONTROL_REG]);
+    PUTDATA(curr, uint32_t, dev->ai.regs[AI_STATUS_REG]);
+    PUTDATA(curr, uint32_t, dev->ai.regs[AI_DACRATE_REG]);
+    PUTDATA(curr, uint32_t, dev->ai.regs[AI_BITRATE_REG]);
+
+    PUTDATA(curr, uint32_t, dev->pi.regs[PI_DRAM_ADDR_REG]);
+    PUTDATA(curr, uint32_t, dev->pi.regs[PI_CART_ADDR_REG]);
+    PUTDATA(curr, uint32_t, dev->pi.regs[PI_RD_LEN_REG]);
+    PUTDATA(curr, uint32_t, dev->pi.regs[PI_WR_LEN_REG]);
+    PUTDATA(curr, uint32_t, dev->pi.regs[PI_STATUS_REG]);
+    PUTDATA(curr, uint32_t, dev->pi.regs[PI_BSD_DOM1_LAT_REG]);
+    PUTDATA(curr, uint32_t, dev->pi.regs[PI_BSD_DOM1_PWD_REG]);
+    PUTDATA(curr, uint32_t, dev->pi.regs[PI_BSD_DOM1_PGS_REG]);
+    PUTDATA(curr, uint32_t, dev->pi.regs[PI_BSD_DOM1_RLS_REG]);
+    PUTDATA(curr, uint32_t, dev->pi.regs[PI_BSD_DOM2_LAT_REG]);
+    PUTDATA(curr, uint32_t, dev->pi.regs[PI_BSD_DOM2_PWD_REG]);
+    PUTDATA(curr, uint32_t, dev->pi.regs[PI_BSD_DOM2_PGS_REG]);
+    PUTDATA(curr, uint32_t, dev->pi.regs[PI_BSD_DOM2_RLS_REG]);
+
+    PUTDATA(curr, uint32_t, dev->ri.regs[RI_MODE_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.regs[RI_CONFIG_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.regs[RI_CURRENT_LOAD_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.regs[RI_SELECT_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.regs[RI_REFRESH_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.regs[RI_LATENCY_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.regs[RI_ERROR_REG]);
+    PUTDATA(curr, uint32_t, dev->ri.regs[RI_WERROR_REG]);
+
+    PUTDATA(curr, uint32_t, dev->si.regs[SI_DRAM_ADDR_REG]);
+    PUTDATA(curr, uint32_t, dev->si.regs[SI_PIF_ADDR_RD64B_REG]);
+    PUTDATA(curr, uint32_t, dev->si.regs[SI_PIF_ADDR_WR64B_REG]);
+    PUTDATA(curr, uint32_t, dev->si.regs[SI_STATUS_REG]);
 
     for (i=0; i < 32;i++)
     {
@@ -1354,10 +1766,10 @@ static int savestates_save_pj64(char *filepath, void *handle,
         PUTDATA(curr, unsigned int, MyEntryLo1);
     }
 
-    PUTARRAY(g_si.pif.ram, curr, uint8_t, PIF_RAM_SIZE);
+    PUTARRAY(dev->si.pif.ram, curr, uint8_t, PIF_RAM_SIZE);
 
     PUTARRAY(g_rdram, curr, uint32_t, SaveRDRAMSize/4);
-    PUTARRAY(g_sp.mem, curr, uint32_t, SP_MEM_SIZE/4);
+    PUTARRAY(dev->sp.mem, curr, uint32_t, SP_MEM_SIZE/4);
 
     // Write the save state data to the output
     if (!write_func(handle, savestateData, savestateSize))
@@ -1377,7 +1789,7 @@ static int write_data_to_zip(void *zip, const void *buffer, size_t length)
     return zipWriteInFileInZip((zipFile)zip, buffer, (unsigned)length) == ZIP_OK;
 }
 
-static int savestates_save_pj64_zip(char *filepath)
+static int savestates_save_pj64_zip(struct device* dev, char *filepath)
 {
     int retval;
     zipFile zipfile = NULL;
@@ -1396,7 +1808,7 @@ static int savestates_save_pj64_zip(char *filepath)
         goto clean_and_exit;
     }
 
-    if (!savestates_save_pj64(filepath, zipfile, write_data_to_zip))
+    if (!savestates_save_pj64(dev, filepath, zipfile, write_data_to_zip))
         goto clean_and_exit;
 
     main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Saved state to: %s", namefrompath(filepath));
@@ -1415,7 +1827,7 @@ static int write_data_to_file(void *file, const void *buffer, size_t length)
     return fwrite(buffer, 1, length, (FILE *)file) == length;
 }
 
-static int savestates_save_pj64_unc(char *filepath)
+static int savestates_save_pj64_unc(struct device* dev, char *filepath)
 {
     FILE *f;
 
@@ -1426,7 +1838,7 @@ static int savestates_save_pj64_unc(char *filepath)
         return 0;
     }
 
-    if (!savestates_save_pj64(filepath, f, write_data_to_file))
+    if (!savestates_save_pj64(dev, filepath, f, write_data_to_file))
     {
         fclose(f);
         return 0;
@@ -1437,11 +1849,22 @@ static int savestates_save_pj64_unc(char *filepath)
     return 1;
 }
 
-int savestates_save(void)
+int savestates_save(struct device* dev)
 {
     char *filepath;
     int ret = 0;
 
+    rsp_wait_task(&dev->sp);
+
+    if (type == savestates_type_m64p_mem)
+    {
+        /* the frontend gets the number of bytes written instead of 1 */
+        size_t size = savestates_save_m64p_mem(dev);
+        StateChanged(M64CORE_STATE_SAVECOMPLETE, (int)size);
+        savestates_clear_job();
+        return size != 0;
+    }
+
     /* Can only save PJ64 savestates on VI / COMPARE interrupt.
        Otherwise try again in a little while. */
     if ((type == savestates_type_pj64_zip ||
@@ -1459,9 +1882,9 @@ int savestates_save(void)
     {
         switch (type)
         {
-            case savestates_type_m64p: ret = savestates_save_m64p(filepath); break;
-            case savestates_type_pj64_zip: ret = savestates_save_pj64_zip(filepath); break;
-            case savestates_type_pj64_unc: ret = savestates_save_pj64_unc(filepath); break;
+            case savestates_type_m64p: ret = savestates_save_m64p(dev, filepath); break;
+            case savestates_type_pj64_zip: ret = savestates_save_pj64_zip(dev, filepath); break;
+            case savestates_type_pj64_unc: ret = savestates_save_pj64_unc(dev, filepath); break;
             default: ret = 0; break;
         }
         free(filepath);
@@ -1476,15 +1899,44 @@ int savestates_save(void)
 
 void savestates_init(void)
 {
-    savestates_lock = SDL_CreateMutex();
-    if (!savestates_lock) {
+    savestates_write_lock = SDL_CreateMutex();
+    if (!savestates_write_lock) {
+        DebugMessage(M64MSG_ERROR, "Could not create savestates write lock");
+        return;
+    }
+
+    savestates_done_lock = SDL_CreateMutex();
+    if (!savestates_done_lock) {
         DebugMessage(M64MSG_ERROR, "Could not create savestates list lock");
         return;
     }
+
+    if (init_work_fence(&savestates_fence) != 0) {
+        DebugMessage(M64MSG_ERROR, "Could not create savestates fence");
+        return;
+    }
 }
 
 void savestates_deinit(void)
 {
-    SDL_DestroyMutex(savestates_lock);
+    struct savestate_work *save;
+
+    wait_work_fence(&savestates_fence);
+    destroy_work_fence(&savestates_fence);
+
+    /* too late to report them */
+    while ((save = savestates_pop_done()) != NULL)
+    {
+        free(save->filepath);
+        free(save);
+    }
+    SDL_DestroyMutex(savestates_done_lock);
+    savestates_done_lock = NULL;
+    SDL_DestroyMutex(savestates_write_lock);
+    savestates_write_lock = NULL;
     savestates_clear_job();
+
+    free(delta_scratch);
+    delta_scratch = NULL;
+    savestates_set_delta_base(NULL, 0);
 }
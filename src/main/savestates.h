@@ -25,6 +25,10 @@
 #ifndef __SAVESTAVES_H__
 #define __SAVESTAVES_H__
 
+#include <stddef.h>
+
+struct device;
+
 typedef enum _savestates_job
 {
     savestates_job_nothing,
@@ -37,16 +41,32 @@ typedef enum _savestates_type
     savestates_type_unknown,
     savestates_type_m64p,
     savestates_type_pj64_zip,
-    savestates_type_pj64_unc
+    savestates_type_pj64_unc,
+    savestates_type_m64p_mem
 } savestates_type;
 
 savestates_job savestates_get_job(void);
 void savestates_set_job(savestates_job j, savestates_type t, const char *fn);
+void savestates_set_mem_job(savestates_job j, void *buffer, size_t size);
+size_t savestates_get_mem_size(void);
+int savestates_set_delta_base(const void *base, size_t size);
+size_t savestates_get_full_mem_size(void);
 void savestates_init(void);
 void savestates_deinit(void);
+void savestates_report_saves(void);
+
+int savestates_load(struct device* dev);
+int savestates_save(struct device* dev);
 
-int savestates_load(void);
-int savestates_save(void);
+/* Synchronous helpers, only valid from the emulation thread at a point where
+ * savestate jobs are processed */
+int savestates_load_m64p_buffer(struct device* dev, void *buffer, size_t size);
+size_t savestates_save_m64p_buffer(struct device* dev, void *buffer, size_t size);
+size_t savestates_make_delta(const void *base, size_t base_size,
+                             const void *full_state, size_t full_size,
+                             void *out, size_t out_size);
+size_t savestates_apply_delta(const void *base, size_t base_size,
+                              const void *delta, size_t delta_size, void *out);
 
 void savestates_select_slot(unsigned int s);
 unsigned int savestates_get_slot(void);
@@ -47,10 +47,13 @@ void open_sra_file(struct sra_file* sra, const char* filename)
     default:
         break;
     }
+
+    open_write_behind(&sra->wb, sra->filename, "sram", sra->sram, SRAM_SIZE);
 }
 
 void close_sra_file(struct sra_file* sra)
 {
+    close_write_behind(&sra->wb);
     free((void*)sra->filename);
 }
 
@@ -61,19 +64,8 @@ uint8_t* sra_file_ptr(struct sra_file* sra)
 
 void save_sra_file(void* opaque)
 {
-    /* flush sram to disk */
+    /* queue sram flush to disk */
     struct sra_file* sra = (struct sra_file*)opaque;
 
-    switch(write_to_file(sra->filename, sra->sram, SRAM_SIZE))
-    {
-    case file_open_error:
-        DebugMessage(M64MSG_WARNING, "couldn't open sram file '%s' for writing", sra->filename);
-        break;
-    case file_write_error:
-        DebugMessage(M64MSG_WARNING, "failed to write sram file '%s'", sra->filename);
-        break;
-    default:
-        break;
-    }
+    write_behind_mark_dirty(&sra->wb);
 }
-
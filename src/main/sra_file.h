@@ -25,11 +25,13 @@
 #include <stdint.h>
 
 #include "pi/sram.h"
+#include "write_behind.h"
 
 struct sra_file
 {
     uint8_t sram[SRAM_SIZE];
     const char* filename;
+    struct write_behind wb;
 };
 
 void open_sra_file(struct sra_file* sra, const char* filename);
@@ -42,6 +42,12 @@
 #include "rom.h"
 #include "util.h"
 
+#if defined(WIN32) && !defined(__MINGW32__)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
 /**********************
      File utilities
  **********************/
@@ -75,13 +81,43 @@ file_status_t write_to_file(const char *filename, const void *data, size_t size)
     if (fwrite(data, 1, size, f) != size)
     {
         fclose(f);
-        return file_read_error;
+        return file_write_error;
     }
 
-    fclose(f);
+    if (fclose(f) != 0)
+        return file_write_error;
+
     return file_ok;
 }
 
+static int current_process_id(void)
+{
+#if defined(WIN32) && !defined(__MINGW32__)
+    return _getpid();
+#else
+    return (int) getpid();
+#endif
+}
+
+file_status_t write_to_file_atomic(const char *filename, const void *data, size_t size)
+{
+    file_status_t status;
+    /* the temporary file is private to this process */
+    char *tmpname = formatstr("%s.%d.tmp", filename, current_process_id());
+    if (tmpname == NULL)
+        return file_open_error;
+
+    status = write_to_file(tmpname, data, size);
+    if (status == file_ok && osal_rename_file(tmpname, filename) != 0)
+        status = file_write_error;
+
+    if (status != file_ok)
+        remove(tmpname);
+
+    free(tmpname);
+    return status;
+}
+
 /**********************
    Byte swap utilities
  **********************/
@@ -57,6 +57,14 @@ file_status_t read_from_file(const char *filename, void *data, size_t size);
  */ 
 file_status_t write_to_file(const char *filename, const void *data, size_t size);
 
+/** write_to_file_atomic
+ *    writes the specified number of bytes to a temporary file, then renames
+ *    it over the given file, so that the file is never left half-written,
+ *    even with several processes writing it.
+ *    returns zero on sucess, nonzero on failure
+ */
+file_status_t write_to_file_atomic(const char *filename, const void *data, size_t size);
+
 /**********************
    Byte swap utilities
  **********************/
@@ -27,7 +27,7 @@
 #define MUPEN_CORE_NAME "Mupen64Plus Core"
 #define MUPEN_CORE_VERSION 0x020500
 
-#define FRONTEND_API_VERSION 0x020101
+#define FRONTEND_API_VERSION 0x020103
 #define CONFIG_API_VERSION   0x020300
 #define DEBUG_API_VERSION    0x020000
 #define VIDEXT_API_VERSION   0x030000
@@ -31,20 +31,24 @@
 #include "api/m64p_types.h"
 #include "main/list.h"
 
-#define WORKQUEUE_THREADS 1
-
-struct workqueue_mgmt_globals {
-    struct list_head work_queue;
-    struct list_head thread_queue;
-    struct list_head thread_list;
-    SDL_mutex *lock;
-};
+/* upper bound of the pool size when it is derived from the CPU count */
+#define WORKQUEUE_MAX_AUTO_THREADS 4
 
 struct workqueue_thread {
     SDL_Thread *thread;
+    SDL_mutex *lock;
     SDL_cond *work_avail;
+    struct list_head work_queue;
     struct list_head list;
-    struct list_head list_mgmt;
+    size_t index;
+};
+
+struct workqueue_mgmt_globals {
+    struct list_head thread_queue;
+    struct workqueue_thread **threads;
+    size_t thread_count;
+    size_t next_thread;
+    SDL_mutex *lock;
 };
 
 static struct workqueue_mgmt_globals workqueue_mgmt;
@@ -53,29 +57,81 @@ static void workqueue_dismiss(struct work_struct *work)
 {
 }
 
+/* Take the oldest work of a thread queue. Dismiss works are never stolen,
+ * so that each thread processes its own queue up to the end. */
+static struct work_struct *workqueue_pop_work(struct workqueue_thread *thread, int steal)
+{
+    struct work_struct *work = NULL;
+
+    SDL_LockMutex(thread->lock);
+    if (!list_empty(&thread->work_queue)) {
+        work = list_first_entry(&thread->work_queue, struct work_struct, list);
+        if (steal && work->func == workqueue_dismiss)
+            work = NULL;
+        else
+            list_del_init(&work->list);
+    }
+    SDL_UnlockMutex(thread->lock);
+
+    return work;
+}
+
 static struct work_struct *workqueue_get_work(struct workqueue_thread *thread)
 {
-    int found = 0;
+    size_t i;
     struct work_struct *work;
 
     while (1) {
-        SDL_LockMutex(workqueue_mgmt.lock);
-        list_del_init(&thread->list);
-        if (!list_empty(&workqueue_mgmt.work_queue)) {
-            found = 1;
-            work = list_first_entry(&workqueue_mgmt.work_queue, struct work_struct, list);
-            list_del_init(&work->list);
-        } else {
-            list_add(&thread->list, &workqueue_mgmt.thread_queue);
-	    SDL_CondWait(thread->work_avail, workqueue_mgmt.lock);
+        work = workqueue_pop_work(thread, 0);
+        if (work)
+            return work;
+
+        for (i = 1; i < workqueue_mgmt.thread_count; i++) {
+            work = workqueue_pop_work(workqueue_mgmt.threads[(thread->index + i) % workqueue_mgmt.thread_count], 1);
+            if (work)
+                return work;
         }
+
+        /* nothing to do: become idle, so that queue_work hands new work to this thread first */
+        SDL_LockMutex(workqueue_mgmt.lock);
+        list_add_tail(&thread->list, &workqueue_mgmt.thread_queue);
         SDL_UnlockMutex(workqueue_mgmt.lock);
 
-        if (found)
-            break;
+        SDL_LockMutex(thread->lock);
+        if (list_empty(&thread->work_queue))
+            SDL_CondWait(thread->work_avail, thread->lock);
+        SDL_UnlockMutex(thread->lock);
+
+        SDL_LockMutex(workqueue_mgmt.lock);
+        list_del_init(&thread->list);
+        SDL_UnlockMutex(workqueue_mgmt.lock);
     }
+}
 
-    return work;
+static void work_fence_get(struct work_fence *fence)
+{
+    SDL_LockMutex(fence->lock);
+    fence->pending++;
+    SDL_UnlockMutex(fence->lock);
+}
+
+static void work_fence_put(struct work_fence *fence)
+{
+    SDL_LockMutex(fence->lock);
+    if (--fence->pending == 0)
+        SDL_CondBroadcast(fence->done);
+    SDL_UnlockMutex(fence->lock);
+}
+
+static void workqueue_run_work(struct work_struct *work)
+{
+    /* work may be freed by its function */
+    struct work_fence *fence = work->fence;
+
+    work->func(work);
+
+    if (fence)
+        work_fence_put(fence);
 }
 
 static int workqueue_thread_handler(void *data)
@@ -90,21 +146,32 @@ static int workqueue_thread_handler(void *data)
             break;
         }
 
-        work->func(work);
+        workqueue_run_work(work);
     }
 
     return 0;
 }
 
-int workqueue_init(void)
+static size_t workqueue_default_threads(void)
 {
-    size_t i;
+#if SDL_VERSION_ATLEAST(2,0,0)
+    int cpus = SDL_GetCPUCount() - 1;
+
+    if (cpus > WORKQUEUE_MAX_AUTO_THREADS)
+        return WORKQUEUE_MAX_AUTO_THREADS;
+    if (cpus > 1)
+        return cpus;
+#endif
+    return 1;
+}
+
+int workqueue_init(int threads)
+{
+    size_t i, requested;
     struct workqueue_thread *thread;
 
     memset(&workqueue_mgmt, 0, sizeof(workqueue_mgmt));
-    INIT_LIST_HEAD(&workqueue_mgmt.work_queue);
     INIT_LIST_HEAD(&workqueue_mgmt.thread_queue);
-    INIT_LIST_HEAD(&workqueue_mgmt.thread_list);
 
     workqueue_mgmt.lock = SDL_CreateMutex();
     if (!workqueue_mgmt.lock) {
@@ -112,25 +179,48 @@ int workqueue_init(void)
         return -1;
     }
 
-    SDL_LockMutex(workqueue_mgmt.lock);
-    for (i = 0; i < WORKQUEUE_THREADS; i++) {
+    if (threads <= 0)
+        threads = workqueue_default_threads();
+    requested = threads;
+
+    workqueue_mgmt.threads = malloc(threads * sizeof(*workqueue_mgmt.threads));
+    if (!workqueue_mgmt.threads) {
+        DebugMessage(M64MSG_ERROR, "Could not create workqueue thread management data");
+        SDL_DestroyMutex(workqueue_mgmt.lock);
+        workqueue_mgmt.lock = NULL;
+        return -1;
+    }
+
+    /* threads steal work from each other, so they all have to exist before any of them runs */
+    for (i = 0; i < (size_t)threads; i++) {
         thread = malloc(sizeof(*thread));
         if (!thread) {
             DebugMessage(M64MSG_ERROR, "Could not create workqueue thread management data");
-            SDL_UnlockMutex(workqueue_mgmt.lock);
-            return -1;
+            break;
         }
 
         memset(thread, 0, sizeof(*thread));
-        list_add(&thread->list_mgmt, &workqueue_mgmt.thread_list);
+        INIT_LIST_HEAD(&thread->work_queue);
         INIT_LIST_HEAD(&thread->list);
+        thread->index = i;
+        thread->lock = SDL_CreateMutex();
         thread->work_avail = SDL_CreateCond();
-        if (!thread->work_avail) {
+        if (!thread->lock || !thread->work_avail) {
             DebugMessage(M64MSG_ERROR, "Could not create workqueue thread work_avail condition");
-            SDL_UnlockMutex(workqueue_mgmt.lock);
-            return -1;
+            if (thread->lock)
+                SDL_DestroyMutex(thread->lock);
+            if (thread->work_avail)
+                SDL_DestroyCond(thread->work_avail);
+            free(thread);
+            break;
         }
 
+        workqueue_mgmt.threads[i] = thread;
+    }
+    threads = i;
+
+    for (i = 0; i < (size_t)threads; i++) {
+        thread = workqueue_mgmt.threads[i];
 #if SDL_VERSION_ATLEAST(2,0,0)
         thread->thread = SDL_CreateThread(workqueue_thread_handler, "m64pwq", thread);
 #else
@@ -138,13 +228,25 @@ int workqueue_init(void)
 #endif
         if (!thread->thread) {
             DebugMessage(M64MSG_ERROR, "Could not create workqueue thread handler");
-            SDL_UnlockMutex(workqueue_mgmt.lock);
-            return -1;
+            break;
         }
+
+        /* publish the thread only once it runs, queue_work runs works synchronously meanwhile */
+        SDL_LockMutex(workqueue_mgmt.lock);
+        workqueue_mgmt.thread_count = i + 1;
+        SDL_UnlockMutex(workqueue_mgmt.lock);
     }
-    SDL_UnlockMutex(workqueue_mgmt.lock);
 
-    return 0;
+    for (i = workqueue_mgmt.thread_count; i < (size_t)threads; i++) {
+        thread = workqueue_mgmt.threads[i];
+        SDL_DestroyCond(thread->work_avail);
+        SDL_DestroyMutex(thread->lock);
+        free(thread);
+    }
+
+    DebugMessage(M64MSG_VERBOSE, "Workqueue started with %u thread(s)", (unsigned int)workqueue_mgmt.thread_count);
+
+    return (workqueue_mgmt.thread_count == requested) ? 0 : -1;
 }
 
 void workqueue_shutdown(void)
@@ -152,40 +254,105 @@ void workqueue_shutdown(void)
     size_t i;
     int status;
     struct work_struct *work;
-    struct workqueue_thread *thread, *safe;
+    struct workqueue_thread *thread;
 
-    for (i = 0; i < WORKQUEUE_THREADS; i++) {
+    for (i = 0; i < workqueue_mgmt.thread_count; i++) {
+        thread = workqueue_mgmt.threads[i];
         work = malloc(sizeof(*work));
         init_work(work, workqueue_dismiss);
-        queue_work(work);
+
+        SDL_LockMutex(thread->lock);
+        list_add_tail(&work->list, &thread->work_queue);
+        SDL_CondSignal(thread->work_avail);
+        SDL_UnlockMutex(thread->lock);
     }
 
-    list_for_each_entry_safe_t(thread, safe, &workqueue_mgmt.thread_list, struct workqueue_thread, list_mgmt) {
-        list_del(&thread->list_mgmt);
+    for (i = 0; i < workqueue_mgmt.thread_count; i++) {
+        thread = workqueue_mgmt.threads[i];
         SDL_WaitThread(thread->thread, &status);
+    }
+
+    for (i = 0; i < workqueue_mgmt.thread_count; i++) {
+        thread = workqueue_mgmt.threads[i];
+        if (!list_empty(&thread->work_queue))
+            DebugMessage(M64MSG_WARNING, "Stopped workqueue with work still pending");
         SDL_DestroyCond(thread->work_avail);
+        SDL_DestroyMutex(thread->lock);
         free(thread);
     }
 
-    if (!list_empty(&workqueue_mgmt.work_queue))
-        DebugMessage(M64MSG_WARNING, "Stopped workqueue with work still pending");
- 
+    free(workqueue_mgmt.threads);
+    workqueue_mgmt.threads = NULL;
+    workqueue_mgmt.thread_count = 0;
+
     SDL_DestroyMutex(workqueue_mgmt.lock);
 }
 
 int queue_work(struct work_struct *work)
 {
-    struct workqueue_thread *thread;
+    return queue_work_fenced(work, NULL);
+}
+
+int queue_work_fenced(struct work_struct *work, struct work_fence *fence)
+{
+    struct workqueue_thread *thread = NULL;
+
+    work->fence = fence;
+    if (fence)
+        work_fence_get(fence);
 
+    /* prefer an idle thread, otherwise spread the work round-robin */
     SDL_LockMutex(workqueue_mgmt.lock);
-    list_add_tail(&work->list, &workqueue_mgmt.work_queue);
     if (!list_empty(&workqueue_mgmt.thread_queue)) {
         thread = list_first_entry(&workqueue_mgmt.thread_queue, struct workqueue_thread, list);
         list_del_init(&thread->list);
-
-        SDL_CondSignal(thread->work_avail);
+    } else if (workqueue_mgmt.thread_count > 0) {
+        thread = workqueue_mgmt.threads[workqueue_mgmt.next_thread++ % workqueue_mgmt.thread_count];
     }
     SDL_UnlockMutex(workqueue_mgmt.lock);
 
+    if (!thread) {
+        workqueue_run_work(work);
+        return 0;
+    }
+
+    SDL_LockMutex(thread->lock);
+    list_add_tail(&work->list, &thread->work_queue);
+    SDL_CondSignal(thread->work_avail);
+    SDL_UnlockMutex(thread->lock);
+
     return 0;
 }
+
+int init_work_fence(struct work_fence *fence)
+{
+    fence->pending = 0;
+    fence->lock = SDL_CreateMutex();
+    fence->done = SDL_CreateCond();
+    if (!fence->lock || !fence->done) {
+        DebugMessage(M64MSG_ERROR, "Could not create work fence");
+        destroy_work_fence(fence);
+        return -1;
+    }
+
+    return 0;
+}
+
+void destroy_work_fence(struct work_fence *fence)
+{
+    if (fence->done)
+        SDL_DestroyCond(fence->done);
+    if (fence->lock)
+        SDL_DestroyMutex(fence->lock);
+    fence->done = NULL;
+    fence->lock = NULL;
+}
+
+/* Wait until all the works queued with this fence have completed */
+void wait_work_fence(struct work_fence *fence)
+{
+    SDL_LockMutex(fence->lock);
+    while (fence->pending > 0)
+        SDL_CondWait(fence->done, fence->lock);
+    SDL_UnlockMutex(fence->lock);
+}
@@ -26,11 +26,13 @@
 #include "osal/preproc.h"
 
 struct work_struct;
+struct work_fence;
 
 struct work_struct *work;
 typedef void (*work_func_t)(struct work_struct *work);
 struct work_struct {
     work_func_t func;
+    struct work_fence *fence;
     struct list_head list;
 };
 
@@ -38,17 +40,38 @@ static osal_inline void init_work(struct work_struct *work, work_func_t func)
 {
     INIT_LIST_HEAD(&work->list);
     work->func = func;
+    work->fence = NULL;
 }
 
 #ifdef M64P_PARALLEL
 
-int workqueue_init(void);
+struct SDL_mutex;
+struct SDL_cond;
+
+/* A fence counts the works queued with it which have not completed yet,
+ * so that their submitter can wait for them (the works may free themselves) */
+struct work_fence {
+    struct SDL_mutex *lock;
+    struct SDL_cond *done;
+    unsigned int pending;
+};
+
+int workqueue_init(int threads);
 void workqueue_shutdown(void);
 int queue_work(struct work_struct *work);
+int queue_work_fenced(struct work_struct *work, struct work_fence *fence);
+
+int init_work_fence(struct work_fence *fence);
+void destroy_work_fence(struct work_fence *fence);
+void wait_work_fence(struct work_fence *fence);
 
 #else
 
-static osal_inline int workqueue_init(void)
+struct work_fence {
+    unsigned int pending;
+};
+
+static osal_inline int workqueue_init(int threads)
 {
     return 0;
 }
@@ -63,6 +86,25 @@ static osal_inline int queue_work(struct work_struct *work)
     return 0;
 }
 
+static osal_inline int queue_work_fenced(struct work_struct *work, struct work_fence *fence)
+{
+    return queue_work(work);
+}
+
+static osal_inline int init_work_fence(struct work_fence *fence)
+{
+    fence->pending = 0;
+    return 0;
+}
+
+static osal_inline void destroy_work_fence(struct work_fence *fence)
+{
+}
+
+static osal_inline void wait_work_fence(struct work_fence *fence)
+{
+}
+
 #endif
 
 #endif
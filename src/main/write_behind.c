@@ -0,0 +1,152 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - write_behind.c                                          *
+ *   Mupen64Plus homepage: http://code.google.com/p/mupen64plus/           *
+ *   Copyright (C) 2015 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "write_behind.h"
+
+#include <SDL.h>
+#include <SDL_thread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "api/callbacks.h"
+#include "api/m64p_types.h"
+#include "util.h"
+
+static void write_file(struct write_behind* wb, const uint8_t* data)
+{
+    switch(write_to_file_atomic(wb->filename, data, wb->size))
+    {
+    case file_open_error:
+        DebugMessage(M64MSG_WARNING, "couldn't open %s file '%s' for writing", wb->desc, wb->filename);
+        break;
+    case file_write_error:
+        DebugMessage(M64MSG_WARNING, "failed to write %s file '%s'", wb->desc, wb->filename);
+        break;
+    default:
+        break;
+    }
+}
+
+static void write_behind_work(struct work_struct* work)
+{
+    struct write_behind* wb = container_of(work, struct write_behind, work);
+    uint8_t* tmp;
+
+    /* keep writing until no change happened during the last write */
+    for(;;)
+    {
+        SDL_LockMutex(wb->lock);
+        if (!wb->dirty)
+        {
+            wb->queued = 0;
+            SDL_UnlockMutex(wb->lock);
+            break;
+        }
+
+        tmp = wb->writing;
+        wb->writing = wb->pending;
+        wb->pending = tmp;
+        wb->dirty = 0;
+        SDL_UnlockMutex(wb->lock);
+
+        write_file(wb, wb->writing);
+    }
+}
+
+void open_write_behind(struct write_behind* wb, const char* filename, const char* desc,
+                       const uint8_t* data, size_t size)
+{
+    memset(wb, 0, sizeof(*wb));
+
+    wb->filename = filename;
+    wb->desc = desc;
+    wb->data = data;
+    wb->size = size;
+
+    init_work(&wb->work, write_behind_work);
+
+    wb->lock = SDL_CreateMutex();
+    wb->pending = malloc(size);
+    wb->writing = malloc(size);
+    if (wb->lock == NULL || wb->pending == NULL || wb->writing == NULL
+     || init_work_fence(&wb->fence) != 0)
+    {
+        /* write_behind_mark_dirty() falls back to synchronous writes */
+        DebugMessage(M64MSG_WARNING, "couldn't set up write-behind for %s file '%s'", desc, filename);
+        if (wb->lock != NULL)
+            SDL_DestroyMutex(wb->lock);
+        free(wb->pending);
+        free(wb->writing);
+        wb->lock = NULL;
+        wb->pending = NULL;
+        wb->writing = NULL;
+    }
+}
+
+void close_write_behind(struct write_behind* wb)
+{
+    if (wb->lock == NULL)
+        return;
+
+    write_behind_flush(wb);
+
+    destroy_work_fence(&wb->fence);
+    SDL_DestroyMutex(wb->lock);
+    free(wb->pending);
+    free(wb->writing);
+    wb->lock = NULL;
+    wb->pending = NULL;
+    wb->writing = NULL;
+}
+
+void write_behind_mark_dirty(struct write_behind* wb)
+{
+    int queue = 0;
+
+    if (wb->lock == NULL)
+    {
+        write_file(wb, wb->data);
+        return;
+    }
+
+    SDL_LockMutex(wb->lock);
+    memcpy(wb->pending, wb->data, wb->size);
+    wb->dirty = 1;
+    if (!wb->queued)
+    {
+        wb->queued = 1;
+        queue = 1;
+    }
+    SDL_UnlockMutex(wb->lock);
+
+    if (queue)
+        queue_work_fenced(&wb->work, &wb->fence);
+}
+
+/* Wait until all the changes made so far are written to the file */
+void write_behind_flush(struct write_behind* wb)
+{
+    if (wb->lock == NULL)
+        return;
+
+    wait_work_fence(&wb->fence);
+}
@@ -0,0 +1,62 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - write_behind.h                                          *
+ *   Mupen64Plus homepage: http://code.google.com/p/mupen64plus/           *
+ *   Copyright (C) 2015 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef M64P_MAIN_WRITE_BEHIND_H
+#define M64P_MAIN_WRITE_BEHIND_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "workqueue.h"
+
+struct SDL_mutex;
+
+/* Write-behind flushing of a memory buffer (battery-backed save memory)
+ * to its file. Each change takes a copy of the buffer on the emulation
+ * thread; the copy is written by the workqueue, where consecutive changes
+ * are coalesced into a single write. Files are replaced atomically.
+ */
+struct write_behind
+{
+    const char* filename;
+    const char* desc;
+    const uint8_t* data;
+    size_t size;
+
+    struct SDL_mutex* lock;
+    uint8_t* pending;       /* latest copy of data, not written yet */
+    uint8_t* writing;       /* copy being written by the workqueue */
+    int dirty;              /* pending holds unwritten changes */
+    int queued;             /* the flush work is queued or running */
+
+    struct work_struct work;
+    struct work_fence fence;
+};
+
+void open_write_behind(struct write_behind* wb, const char* filename, const char* desc,
+                       const uint8_t* data, size_t size);
+void close_write_behind(struct write_behind* wb);
+
+void write_behind_mark_dirty(struct write_behind* wb);
+void write_behind_flush(struct write_behind* wb);
+
+#endif
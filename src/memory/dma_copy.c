@@ -0,0 +1,178 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - dma_copy.c                                              *
+ *   Mupen64Plus homepage: http://code.google.com/p/mupen64plus/           *
+ *   Copyright (C) 2015 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "dma_copy.h"
+
+#include <string.h>
+
+#include "memory.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DMA_COPY_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define DMA_COPY_NEON
+#include <arm_neon.h>
+#endif
+
+/* When source and destination disagree on their alignment within a word,
+ * each destination word is made of the tail of one source word and the
+ * head of the next. As words hold big endian data in native order, this
+ * is the same pair of shifts whatever the host endianness.
+ * src must hold count+1 words. Returns the number of words written. */
+static size_t shifted_words_simd(uint32_t* dst, const uint32_t* src, size_t count, unsigned int shift)
+{
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m128i lshift256 = _mm_cvtsi32_si128(shift);
+    const __m128i rshift256 = _mm_cvtsi32_si128(32 - shift);
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i lo = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i hi = _mm256_loadu_si256((const __m256i*)(src + i + 1));
+        _mm256_storeu_si256((__m256i*)(dst + i),
+            _mm256_or_si256(_mm256_sll_epi32(lo, lshift256), _mm256_srl_epi32(hi, rshift256)));
+    }
+#endif
+
+#if defined(DMA_COPY_SSE2)
+    {
+        const __m128i lshift = _mm_cvtsi32_si128(shift);
+        const __m128i rshift = _mm_cvtsi32_si128(32 - shift);
+
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i lo = _mm_loadu_si128((const __m128i*)(src + i));
+            __m128i hi = _mm_loadu_si128((const __m128i*)(src + i + 1));
+            _mm_storeu_si128((__m128i*)(dst + i),
+                _mm_or_si128(_mm_sll_epi32(lo, lshift), _mm_srl_epi32(hi, rshift)));
+        }
+    }
+#elif defined(DMA_COPY_NEON)
+    {
+        const int32x4_t lshift = vdupq_n_s32((int32_t)shift);
+        const int32x4_t rshift = vdupq_n_s32((int32_t)shift - 32);
+
+        for (; i + 4 <= count; i += 4)
+        {
+            uint32x4_t lo = vld1q_u32(src + i);
+            uint32x4_t hi = vld1q_u32(src + i + 1);
+            vst1q_u32(dst + i, vorrq_u32(vshlq_u32(lo, lshift), vshlq_u32(hi, rshift)));
+        }
+    }
+#endif
+
+    return i;
+}
+
+static void shifted_words(uint32_t* dst, const uint32_t* src, size_t count, unsigned int shift)
+{
+    size_t i = shifted_words_simd(dst, src, count, shift);
+
+    for (; i < count; ++i)
+    {
+        dst[i] = (src[i] << shift) | (src[i + 1] >> (32 - shift));
+    }
+}
+
+void dma_copy(uint8_t* dst, uint32_t dst_offset,
+              const uint8_t* src, uint32_t src_offset,
+              size_t size)
+{
+    size_t head;
+    size_t words;
+
+    /* copy bytes until the destination is word aligned */
+    head = (4 - (dst_offset & 3)) & 3;
+    if (head > size)
+        head = size;
+
+    size -= head;
+    while (head-- != 0)
+    {
+        dst[(dst_offset++)^S8] = src[(src_offset++)^S8];
+    }
+
+    words = size / 4;
+    if (words != 0)
+    {
+        if ((src_offset & 3) == 0)
+        {
+            /* same layout on both sides */
+            memcpy(dst + dst_offset, src + src_offset, words * 4);
+        }
+        else
+        {
+            shifted_words((uint32_t*)(dst + dst_offset),
+                          (const uint32_t*)(src + (src_offset & ~UINT32_C(3))),
+                          words, (src_offset & 3) * 8);
+        }
+
+        dst_offset += (uint32_t)(words * 4);
+        src_offset += (uint32_t)(words * 4);
+        size -= words * 4;
+    }
+
+    /* remaining bytes */
+    while (size-- != 0)
+    {
+        dst[(dst_offset++)^S8] = src[(src_offset++)^S8];
+    }
+}
+
+void dma_copy_be32(void* dst, const void* src, size_t count)
+{
+#ifdef M64P_BIG_ENDIAN
+    memcpy(dst, src, count * 4);
+#else
+    uint32_t* d = (uint32_t*)dst;
+    const uint32_t* s = (const uint32_t*)src;
+    size_t i = 0;
+
+#if defined(DMA_COPY_SSE2)
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i*)(s + i));
+        /* swap the bytes of each halfword, then the halfwords of each word */
+        x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+        x = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0xb1), 0xb1);
+        _mm_storeu_si128((__m128i*)(d + i), x);
+    }
+#elif defined(DMA_COPY_NEON)
+    for (; i + 4 <= count; i += 4)
+    {
+        vst1q_u8((uint8_t*)(d + i), vrev32q_u8(vld1q_u8((const uint8_t*)(s + i))));
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        d[i] = sl(s[i]);
+    }
+#endif
+}
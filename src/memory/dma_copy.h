@@ -0,0 +1,41 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - dma_copy.h                                              *
+ *   Mupen64Plus homepage: http://code.google.com/p/mupen64plus/           *
+ *   Copyright (C) 2015 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef M64P_MEMORY_DMA_COPY_H
+#define M64P_MEMORY_DMA_COPY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* RDRAM, cart ROM and RSP memory all hold big endian data as native endian
+ * 32-bit words, so byte i of a transfer lives at (offset+i)^S8.
+ * Copy size bytes from src+src_offset to dst+dst_offset in that layout.
+ * Both buffers must be 32-bit aligned. */
+void dma_copy(uint8_t* dst, uint32_t dst_offset,
+              const uint8_t* src, uint32_t src_offset,
+              size_t size);
+
+/* Copy count 32-bit words between big endian and native byte order.
+ * Used for transfers between RDRAM and the byte-addressed PIF RAM. */
+void dma_copy_be32(void* dst, const void* src, size_t count);
+
+#endif
@@ -0,0 +1,253 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - fastmem.c                                               *
+ *   Mupen64Plus homepage: http://code.google.com/p/mupen64plus/           *
+ *   Copyright (C) 2015 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* for REG_RIP */
+#endif
+
+#include "fastmem.h"
+
+#include <stddef.h>
+
+unsigned char* g_fastmem_base = NULL;
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__FreeBSD__) || defined(__APPLE__))
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include "api/callbacks.h"
+#include "api/m64p_types.h"
+#include "main/main.h"
+
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+
+/* the whole 32-bit guest address space, plus some slack for accesses
+ * straddling its end */
+#define FASTMEM_WINDOW_SIZE (UINT64_C(0x100000000) + 0x10000)
+
+static const uint32_t rdram_views[] = { UINT32_C(0x80000000), UINT32_C(0xa0000000) };
+
+static int l_rdram_fd = -1;
+static size_t l_dram_size = 0;
+static fastmem_fixup_func l_fixup = NULL;
+static struct sigaction l_old_segv;
+static struct sigaction l_old_bus;
+
+static unsigned char* context_pc(void* context)
+{
+    ucontext_t* uc = (ucontext_t*)context;
+#if defined(__linux__)
+    return (unsigned char*)uc->uc_mcontext.gregs[REG_RIP];
+#elif defined(__FreeBSD__)
+    return (unsigned char*)uc->uc_mcontext.mc_rip;
+#else
+    return (unsigned char*)uc->uc_mcontext->__ss.__rip;
+#endif
+}
+
+/* Not a fastmem access: hand the fault to the handler installed before ours,
+ * which stays in place for the next fastmem faults. */
+static void chain_fault(int sig, siginfo_t* info, void* context)
+{
+    const struct sigaction* old = (sig == SIGSEGV) ? &l_old_segv : &l_old_bus;
+
+    if (old->sa_flags & SA_SIGINFO)
+    {
+        if (old->sa_sigaction != NULL)
+        {
+            old->sa_sigaction(sig, info, context);
+            return;
+        }
+    }
+    else if (old->sa_handler != SIG_DFL && old->sa_handler != SIG_IGN)
+    {
+        old->sa_handler(sig);
+        return;
+    }
+
+    /* default action: the faulting instruction runs again without our handler */
+    signal(sig, SIG_DFL);
+}
+
+static void fastmem_fault_handler(int sig, siginfo_t* info, void* context)
+{
+    unsigned char* addr = (unsigned char*)info->si_addr;
+
+    if (g_fastmem_base != NULL
+     && addr >= g_fastmem_base && addr < g_fastmem_base + FASTMEM_WINDOW_SIZE
+     && l_fixup(context_pc(context)))
+        return;
+
+    chain_fault(sig, info, context);
+}
+
+/* Back g_rdram with a shared memory object, so that it can be mapped again
+ * in the fastmem window. This is done once and kept for the process lifetime. */
+static int share_rdram(void)
+{
+    char name[64];
+    void* rdram;
+    int fd;
+
+    if (l_rdram_fd >= 0)
+        return 1;
+
+    if (((uintptr_t)g_rdram % sysconf(_SC_PAGESIZE)) != 0)
+        return 0;
+
+    sprintf(name, "/m64p-rdram-%d", (int)getpid());
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0)
+        return 0;
+    shm_unlink(name);
+
+    if (ftruncate(fd, RDRAM_MAX_SIZE) != 0)
+    {
+        close(fd);
+        return 0;
+    }
+
+    /* carry the current RDRAM content over, then map the object in place of g_rdram */
+    rdram = mmap(NULL, RDRAM_MAX_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (rdram == MAP_FAILED)
+    {
+        close(fd);
+        return 0;
+    }
+    memcpy(rdram, g_rdram, RDRAM_MAX_SIZE);
+    munmap(rdram, RDRAM_MAX_SIZE);
+
+    if (mmap(g_rdram, RDRAM_MAX_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+    {
+        DebugMessage(M64MSG_ERROR, "Fastmem: couldn't remap RDRAM: %s", strerror(errno));
+        close(fd);
+        return 0;
+    }
+
+    l_rdram_fd = fd;
+    return 1;
+}
+
+int fastmem_init(size_t dram_size, fastmem_fixup_func fixup)
+{
+    struct sigaction sa;
+    unsigned char* window;
+    size_t i;
+
+    fastmem_deinit();
+
+    if (!share_rdram())
+    {
+        DebugMessage(M64MSG_WARNING, "Fastmem: couldn't back RDRAM with shared memory");
+        return 0;
+    }
+
+    window = (unsigned char*)mmap(NULL, FASTMEM_WINDOW_SIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (window == MAP_FAILED)
+    {
+        DebugMessage(M64MSG_WARNING, "Fastmem: couldn't reserve host address window: %s", strerror(errno));
+        return 0;
+    }
+
+    for (i = 0; i < sizeof(rdram_views) / sizeof(rdram_views[0]); ++i)
+    {
+        if (mmap(window + rdram_views[i], dram_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, l_rdram_fd, 0) == MAP_FAILED)
+        {
+            DebugMessage(M64MSG_WARNING, "Fastmem: couldn't map RDRAM view at %08x: %s", rdram_views[i], strerror(errno));
+            munmap(window, FASTMEM_WINDOW_SIZE);
+            return 0;
+        }
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = fastmem_fault_handler;
+    sa.sa_flags = SA_SIGINFO;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGSEGV, &sa, &l_old_segv);
+    sigaction(SIGBUS, &sa, &l_old_bus);
+
+    l_fixup = fixup;
+    l_dram_size = dram_size;
+    g_fastmem_base = window;
+
+    DebugMessage(M64MSG_INFO, "Fastmem: RDRAM mapped in host window at %p", (void*)window);
+    return 1;
+}
+
+void fastmem_deinit(void)
+{
+    if (g_fastmem_base == NULL)
+        return;
+
+    sigaction(SIGSEGV, &l_old_segv, NULL);
+    sigaction(SIGBUS, &l_old_bus, NULL);
+
+    munmap(g_fastmem_base, FASTMEM_WINDOW_SIZE);
+    g_fastmem_base = NULL;
+    l_fixup = NULL;
+    l_dram_size = 0;
+}
+
+void fastmem_protect(uint32_t address, size_t size, int protect)
+{
+    size_t i;
+
+    if (g_fastmem_base == NULL || address >= l_dram_size)
+        return;
+    if (size > l_dram_size - address)
+        size = l_dram_size - address;
+
+    for (i = 0; i < sizeof(rdram_views) / sizeof(rdram_views[0]); ++i)
+    {
+        if (mprotect(g_fastmem_base + rdram_views[i] + address, size,
+                     protect ? PROT_NONE : PROT_READ | PROT_WRITE) != 0)
+            DebugMessage(M64MSG_WARNING, "Fastmem: couldn't change protection at %08x: %s",
+                         rdram_views[i] + address, strerror(errno));
+    }
+}
+
+#else
+
+int fastmem_init(size_t dram_size, fastmem_fixup_func fixup)
+{
+    return 0;
+}
+
+void fastmem_deinit(void)
+{
+}
+
+void fastmem_protect(uint32_t address, size_t size, int protect)
+{
+}
+
+#endif
@@ -0,0 +1,48 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - fastmem.h                                               *
+ *   Mupen64Plus homepage: http://code.google.com/p/mupen64plus/           *
+ *   Copyright (C) 2015 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_MEMORY_FASTMEM_H
+#define M64P_MEMORY_FASTMEM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fastmem reserves a 4GB host address window in which the KSEG0 and KSEG1
+ * views of RDRAM are mapped at their guest addresses, so that the recompiler
+ * can access RDRAM with a single host load or store at g_fastmem_base + address.
+ * Everything else in the window is inaccessible: such accesses fault, and the
+ * recompiler's fixup function redirects the faulting site to its slow path. */
+
+/* NULL unless the fastmem window is set up */
+extern unsigned char* g_fastmem_base;
+
+/* returns non-zero if the fault at pc was a fastmem access that has been fixed up */
+typedef int (*fastmem_fixup_func)(unsigned char* pc);
+
+int fastmem_init(size_t dram_size, fastmem_fixup_func fixup);
+void fastmem_deinit(void);
+
+/* Make RDRAM [address, address+size) inaccessible (or accessible again)
+ * through the fastmem window, so that recompiled accesses to it fault and
+ * take their slow path through the memory handlers. */
+void fastmem_protect(uint32_t address, size_t size, int protect);
+
+#endif
@@ -24,6 +24,7 @@
 #include "ai/ai_controller.h"
 #include "api/callbacks.h"
 #include "api/m64p_types.h"
+#include "device/device.h"
 #include "main/main.h"
 #include "main/rom.h"
 #include "pi/pi_controller.h"
@@ -76,8 +77,8 @@ void (*writememb[0x10000])(void);
 void (*writememd[0x10000])(void);
 void (*writememh[0x10000])(void);
 
-typedef int (*readfn)(void*,uint32_t,uint32_t*);
-typedef int (*writefn)(void*,uint32_t,uint32_t,uint32_t);
+// register-passing handlers
+struct mem_handler mem_handlers[0x10000];
 
 static unsigned int bshift(uint32_t address)
 {
@@ -94,7 +95,8 @@ static int readb(readfn read_word, void* opaque, uint32_t address, uint64_t* val
     uint32_t w;
     unsigned shift = bshift(address);
     int result = read_word(opaque, address, &w);
-    *value = (w >> shift) & 0xff;
+    if (result == 0)
+        *value = (w >> shift) & 0xff;
 
     return result;
 }
@@ -104,7 +106,8 @@ static int readh(readfn read_word, void* opaque, uint32_t address, uint64_t* val
     uint32_t w;
     unsigned shift = hshift(address);
     int result = read_word(opaque, address, &w);
-    *value = (w >> shift) & 0xffff;
+    if (result == 0)
+        *value = (w >> shift) & 0xffff;
 
     return result;
 }
@@ -113,7 +116,8 @@ static int readw(readfn read_word, void* opaque, uint32_t address, uint64_t* val
 {
     uint32_t w;
     int result = read_word(opaque, address, &w);
-    *value = w;
+    if (result == 0)
+        *value = w;
 
     return result;
 }
@@ -121,8 +125,10 @@ static int readw(readfn read_word, void* opaque, uint32_t address, uint64_t* val
 static int readd(readfn read_word, void* opaque, uint32_t address, uint64_t* value)
 {
     uint32_t w[2];
-    int result =
-    read_word(opaque, address    , &w[0]);
+    int result = read_word(opaque, address, &w[0]);
+    if (result != 0)
+        return result;
+
     read_word(opaque, address + 4, &w[1]);
     *value = ((uint64_t)w[0] << 32) | w[1];
 
@@ -154,8 +160,10 @@ static int writew(writefn write_word, void* opaque, uint32_t address, uint32_t v
 
 static int writed(writefn write_word, void* opaque, uint32_t address, uint64_t value)
 {
-    int result =
-    write_word(opaque, address    , (uint32_t) (value >> 32), ~0U);
+    int result = write_word(opaque, address, (uint32_t) (value >> 32), ~0U);
+    if (result != 0)
+        return result;
+
     write_word(opaque, address + 4, (uint32_t) (value      ), ~0U);
 
     return result;
@@ -205,6 +213,19 @@ static void read_nomem(void)
     read_word_in_memory();
 }
 
+static int read_unmapped(void* opaque, uint32_t address, uint32_t* value)
+{
+    *value = 0;
+    return 0;
+}
+
+static int write_unmapped(void* opaque, uint32_t address, uint32_t value, uint32_t mask)
+{
+    return 0;
+}
+
+static const struct mem_handler nothing_handler = { NULL, read_unmapped, write_unmapped };
+
 static void read_nomemb(void)
 {
     address = virtual_to_physical_address(address,0);
@@ -258,687 +279,816 @@ static void write_nomemd(void)
     write_dword_in_memory();
 }
 
+static int read_tlb_mapped(void* opaque, uint32_t address, uint32_t* value)
+{
+    const struct mem_handler* handler;
+
+    address = virtual_to_physical_address(address,0);
+    if (address == 0x00000000) return -1;
+
+    handler = &mem_handlers[address >> 16];
+    return handler->read32(handler->opaque, address, value);
+}
+
+static int write_tlb_mapped(void* opaque, uint32_t address, uint32_t value, uint32_t mask)
+{
+    const struct mem_handler* handler;
+
+    invalidate_r4300_cached_code(address, 4);
+    address = virtual_to_physical_address(address,1);
+    if (address == 0x00000000) return -1;
+
+    /* callers only know the virtual address, so check the physical one here */
+    invalidate_r4300_cached_code(address, 4);
+
+    handler = &mem_handlers[address >> 16];
+    return handler->write32(handler->opaque, address, value, mask);
+}
+
+static const struct mem_handler nomem_handler = { NULL, read_tlb_mapped, write_tlb_mapped };
+
 
 void read_rdram(void)
 {
-    readw(read_rdram_dram, &g_ri, address, rdword);
+    readw(read_rdram_dram, &g_dev.ri, address, rdword);
 }
 
 void read_rdramb(void)
 {
-    readb(read_rdram_dram, &g_ri, address, rdword);
+    readb(read_rdram_dram, &g_dev.ri, address, rdword);
 }
 
 void read_rdramh(void)
 {
-    readh(read_rdram_dram, &g_ri, address, rdword);
+    readh(read_rdram_dram, &g_dev.ri, address, rdword);
 }
 
 void read_rdramd(void)
 {
-    readd(read_rdram_dram, &g_ri, address, rdword);
+    readd(read_rdram_dram, &g_dev.ri, address, rdword);
 }
 
 void write_rdram(void)
 {
-    writew(write_rdram_dram, &g_ri, address, cpu_word);
+    writew(write_rdram_dram, &g_dev.ri, address, cpu_word);
 }
 
 void write_rdramb(void)
 {
-    writeb(write_rdram_dram, &g_ri, address, cpu_byte);
+    writeb(write_rdram_dram, &g_dev.ri, address, cpu_byte);
 }
 
 void write_rdramh(void)
 {
-    writeh(write_rdram_dram, &g_ri, address, cpu_hword);
+    writeh(write_rdram_dram, &g_dev.ri, address, cpu_hword);
 }
 
 void write_rdramd(void)
 {
-    writed(write_rdram_dram, &g_ri, address, cpu_dword);
+    writed(write_rdram_dram, &g_dev.ri, address, cpu_dword);
+}
+
+const struct mem_handler rdram_handler = { &g_dev.ri, read_rdram_dram, write_rdram_dram };
+
+/* RDRAM while RSP audio tasks run on a worker thread, which may be writing
+ * it: these wait for the task first. The recompilers access RDRAM directly
+ * in the regions mapped to read_rdram and friends only. */
+static int read_rdram_async_dram(void* opaque, uint32_t address, uint32_t* value)
+{
+    rsp_wait_task(&g_dev.sp);
+    return read_rdram_dram(opaque, address, value);
+}
+
+static int write_rdram_async_dram(void* opaque, uint32_t address, uint32_t value, uint32_t mask)
+{
+    rsp_wait_task(&g_dev.sp);
+    return write_rdram_dram(opaque, address, value, mask);
+}
+
+static void read_rdram_async(void)
+{
+    readw(read_rdram_async_dram, &g_dev.ri, address, rdword);
+}
+
+static void read_rdram_asyncb(void)
+{
+    readb(read_rdram_async_dram, &g_dev.ri, address, rdword);
+}
+
+static void read_rdram_asynch(void)
+{
+    readh(read_rdram_async_dram, &g_dev.ri, address, rdword);
+}
+
+static void read_rdram_asyncd(void)
+{
+    readd(read_rdram_async_dram, &g_dev.ri, address, rdword);
+}
+
+static void write_rdram_async(void)
+{
+    writew(write_rdram_async_dram, &g_dev.ri, address, cpu_word);
 }
 
+static void write_rdram_asyncb(void)
+{
+    writeb(write_rdram_async_dram, &g_dev.ri, address, cpu_byte);
+}
+
+static void write_rdram_asynch(void)
+{
+    writeh(write_rdram_async_dram, &g_dev.ri, address, cpu_hword);
+}
+
+static void write_rdram_asyncd(void)
+{
+    writed(write_rdram_async_dram, &g_dev.ri, address, cpu_dword);
+}
+
+static const struct mem_handler rdram_async_handler = { &g_dev.ri, read_rdram_async_dram, write_rdram_async_dram };
+
 
 void read_rdramFB(void)
 {
-    readw(read_rdram_fb, &g_dp, address, rdword);
+    readw(read_rdram_fb, &g_dev.dp, address, rdword);
 }
 
 void read_rdramFBb(void)
 {
-    readb(read_rdram_fb, &g_dp, address, rdword);
+    readb(read_rdram_fb, &g_dev.dp, address, rdword);
 }
 
 void read_rdramFBh(void)
 {
-    readh(read_rdram_fb, &g_dp, address, rdword);
+    readh(read_rdram_fb, &g_dev.dp, address, rdword);
 }
 
 void read_rdramFBd(void)
 {
-    readd(read_rdram_fb, &g_dp, address, rdword);
+    readd(read_rdram_fb, &g_dev.dp, address, rdword);
 }
 
 void write_rdramFB(void)
 {
-    writew(write_rdram_fb, &g_dp, address, cpu_word);
+    writew(write_rdram_fb, &g_dev.dp, address, cpu_word);
 }
 
 void write_rdramFBb(void)
 {
-    writeb(write_rdram_fb, &g_dp, address, cpu_byte);
+    writeb(write_rdram_fb, &g_dev.dp, address, cpu_byte);
 }
 
 void write_rdramFBh(void)
 {
-    writeh(write_rdram_fb, &g_dp, address, cpu_hword);
+    writeh(write_rdram_fb, &g_dev.dp, address, cpu_hword);
 }
 
 void write_rdramFBd(void)
 {
-    writed(write_rdram_fb, &g_dp, address, cpu_dword);
+    writed(write_rdram_fb, &g_dev.dp, address, cpu_dword);
 }
 
+const struct mem_handler rdramFB_handler = { &g_dev.dp, read_rdram_fb, write_rdram_fb };
+
 
 static void read_rdramreg(void)
 {
-    readw(read_rdram_regs, &g_ri, address, rdword);
+    readw(read_rdram_regs, &g_dev.ri, address, rdword);
 }
 
 static void read_rdramregb(void)
 {
-    readb(read_rdram_regs, &g_ri, address, rdword);
+    readb(read_rdram_regs, &g_dev.ri, address, rdword);
 }
 
 static void read_rdramregh(void)
 {
-    readh(read_rdram_regs, &g_ri, address, rdword);
+    readh(read_rdram_regs, &g_dev.ri, address, rdword);
 }
 
 static void read_rdramregd(void)
 {
-    readd(read_rdram_regs, &g_ri, address, rdword);
+    readd(read_rdram_regs, &g_dev.ri, address, rdword);
 }
 
 static void write_rdramreg(void)
 {
-    writew(write_rdram_regs, &g_ri, address, cpu_word);
+    writew(write_rdram_regs, &g_dev.ri, address, cpu_word);
 }
 
 static void write_rdramregb(void)
 {
-    writeb(write_rdram_regs, &g_ri, address, cpu_byte);
+    writeb(write_rdram_regs, &g_dev.ri, address, cpu_byte);
 }
 
 static void write_rdramregh(void)
 {
-    writeh(write_rdram_regs, &g_ri, address, cpu_hword);
+    writeh(write_rdram_regs, &g_dev.ri, address, cpu_hword);
 }
 
 static void write_rdramregd(void)
 {
-    writed(write_rdram_regs, &g_ri, address, cpu_dword);
+    writed(write_rdram_regs, &g_dev.ri, address, cpu_dword);
 }
 
+static const struct mem_handler rdramreg_handler = { &g_dev.ri, read_rdram_regs, write_rdram_regs };
+
 
 static void read_rspmem(void)
 {
-    readw(read_rsp_mem, &g_sp, address, rdword);
+    readw(read_rsp_mem, &g_dev.sp, address, rdword);
 }
 
 static void read_rspmemb(void)
 {
-    readb(read_rsp_mem, &g_sp, address, rdword);
+    readb(read_rsp_mem, &g_dev.sp, address, rdword);
 }
 
 static void read_rspmemh(void)
 {
-    readh(read_rsp_mem, &g_sp, address, rdword);
+    readh(read_rsp_mem, &g_dev.sp, address, rdword);
 }
 
 static void read_rspmemd(void)
 {
-    readd(read_rsp_mem, &g_sp, address, rdword);
+    readd(read_rsp_mem, &g_dev.sp, address, rdword);
 }
 
 static void write_rspmem(void)
 {
-    writew(write_rsp_mem, &g_sp, address, cpu_word);
+    writew(write_rsp_mem, &g_dev.sp, address, cpu_word);
 }
 
 static void write_rspmemb(void)
 {
-    writeb(write_rsp_mem, &g_sp, address, cpu_byte);
+    writeb(write_rsp_mem, &g_dev.sp, address, cpu_byte);
 }
 
 static void write_rspmemh(void)
 {
-    writeh(write_rsp_mem, &g_sp, address, cpu_hword);
+    writeh(write_rsp_mem, &g_dev.sp, address, cpu_hword);
 }
 
 static void write_rspmemd(void)
 {
-    writed(write_rsp_mem, &g_sp, address, cpu_dword);
+    writed(write_rsp_mem, &g_dev.sp, address, cpu_dword);
 }
 
+static const struct mem_handler rspmem_handler = { &g_dev.sp, read_rsp_mem, write_rsp_mem };
+
 
 static void read_rspreg(void)
 {
-    readw(read_rsp_regs, &g_sp, address, rdword);
+    readw(read_rsp_regs, &g_dev.sp, address, rdword);
 }
 
 static void read_rspregb(void)
 {
-    readb(read_rsp_regs, &g_sp, address, rdword);
+    readb(read_rsp_regs, &g_dev.sp, address, rdword);
 }
 
 static void read_rspregh(void)
 {
-    readh(read_rsp_regs, &g_sp, address, rdword);
+    readh(read_rsp_regs, &g_dev.sp, address, rdword);
 }
 
 static void read_rspregd(void)
 {
-    readd(read_rsp_regs, &g_sp, address, rdword);
+    readd(read_rsp_regs, &g_dev.sp, address, rdword);
 }
 
 static void write_rspreg(void)
 {
-    writew(write_rsp_regs, &g_sp, address, cpu_word);
+    writew(write_rsp_regs, &g_dev.sp, address, cpu_word);
 }
 
 static void write_rspregb(void)
 {
-    writeb(write_rsp_regs, &g_sp, address, cpu_byte);
+    writeb(write_rsp_regs, &g_dev.sp, address, cpu_byte);
 }
 
 static void write_rspregh(void)
 {
-    writeh(write_rsp_regs, &g_sp, address, cpu_hword);
+    writeh(write_rsp_regs, &g_dev.sp, address, cpu_hword);
 }
 
 static void write_rspregd(void)
 {
-    writed(write_rsp_regs, &g_sp, address, cpu_dword);
+    writed(write_rsp_regs, &g_dev.sp, address, cpu_dword);
 }
 
+static const struct mem_handler rspreg_handler = { &g_dev.sp, read_rsp_regs, write_rsp_regs };
+
 
 static void read_rspreg2(void)
 {
-    readw(read_rsp_regs2, &g_sp, address, rdword);
+    readw(read_rsp_regs2, &g_dev.sp, address, rdword);
 }
 
 static void read_rspreg2b(void)
 {
-    readb(read_rsp_regs2, &g_sp, address, rdword);
+    readb(read_rsp_regs2, &g_dev.sp, address, rdword);
 }
 
 static void read_rspreg2h(void)
 {
-    readh(read_rsp_regs2, &g_sp, address, rdword);
+    readh(read_rsp_regs2, &g_dev.sp, address, rdword);
 }
 
 static void read_rspreg2d(void)
 {
-    readd(read_rsp_regs2, &g_sp, address, rdword);
+    readd(read_rsp_regs2, &g_dev.sp, address, rdword);
 }
 
 static void write_rspreg2(void)
 {
-    writew(write_rsp_regs2, &g_sp, address, cpu_word);
+    writew(write_rsp_regs2, &g_dev.sp, address, cpu_word);
 }
 
 static void write_rspreg2b(void)
 {
-    writeb(write_rsp_regs2, &g_sp, address, cpu_byte);
+    writeb(write_rsp_regs2, &g_dev.sp, address, cpu_byte);
 }
 
 static void write_rspreg2h(void)
 {
-    writeh(write_rsp_regs2, &g_sp, address, cpu_hword);
+    writeh(write_rsp_regs2, &g_dev.sp, address, cpu_hword);
 }
 
 static void write_rspreg2d(void)
 {
-    writed(write_rsp_regs2, &g_sp, address, cpu_dword);
+    writed(write_rsp_regs2, &g_dev.sp, address, cpu_dword);
 }
 
+static const struct mem_handler rspreg2_handler = { &g_dev.sp, read_rsp_regs2, write_rsp_regs2 };
+
 
 static void read_dp(void)
 {
-    readw(read_dpc_regs, &g_dp, address, rdword);
+    readw(read_dpc_regs, &g_dev.dp, address, rdword);
 }
 
 static void read_dpb(void)
 {
-    readb(read_dpc_regs, &g_dp, address, rdword);
+    readb(read_dpc_regs, &g_dev.dp, address, rdword);
 }
 
 static void read_dph(void)
 {
-    readh(read_dpc_regs, &g_dp, address, rdword);
+    readh(read_dpc_regs, &g_dev.dp, address, rdword);
 }
 
 static void read_dpd(void)
 {
-    readd(read_dpc_regs, &g_dp, address, rdword);
+    readd(read_dpc_regs, &g_dev.dp, address, rdword);
 }
 
 static void write_dp(void)
 {
-    writew(write_dpc_regs, &g_dp, address, cpu_word);
+    writew(write_dpc_regs, &g_dev.dp, address, cpu_word);
 }
 
 static void write_dpb(void)
 {
-    writeb(write_dpc_regs, &g_dp, address, cpu_byte);
+    writeb(write_dpc_regs, &g_dev.dp, address, cpu_byte);
 }
 
 static void write_dph(void)
 {
-    writeh(write_dpc_regs, &g_dp, address, cpu_hword);
+    writeh(write_dpc_regs, &g_dev.dp, address, cpu_hword);
 }
 
 static void write_dpd(void)
 {
-    writed(write_dpc_regs, &g_dp, address, cpu_dword);
+    writed(write_dpc_regs, &g_dev.dp, address, cpu_dword);
 }
 
+static const struct mem_handler dp_handler = { &g_dev.dp, read_dpc_regs, write_dpc_regs };
+
 
 static void read_dps(void)
 {
-    readw(read_dps_regs, &g_dp, address, rdword);
+    readw(read_dps_regs, &g_dev.dp, address, rdword);
 }
 
 static void read_dpsb(void)
 {
-    readb(read_dps_regs, &g_dp, address, rdword);
+    readb(read_dps_regs, &g_dev.dp, address, rdword);
 }
 
 static void read_dpsh(void)
 {
-    readh(read_dps_regs, &g_dp, address, rdword);
+    readh(read_dps_regs, &g_dev.dp, address, rdword);
 }
 
 static void read_dpsd(void)
 {
-    readd(read_dps_regs, &g_dp, address, rdword);
+    readd(read_dps_regs, &g_dev.dp, address, rdword);
 }
 
 static void write_dps(void)
 {
-    writew(write_dps_regs, &g_dp, address, cpu_word);
+    writew(write_dps_regs, &g_dev.dp, address, cpu_word);
 }
 
 static void write_dpsb(void)
 {
-    writeb(write_dps_regs, &g_dp, address, cpu_byte);
+    writeb(write_dps_regs, &g_dev.dp, address, cpu_byte);
 }
 
 static void write_dpsh(void)
 {
-    writeh(write_dps_regs, &g_dp, address, cpu_hword);
+    writeh(write_dps_regs, &g_dev.dp, address, cpu_hword);
 }
 
 static void write_dpsd(void)
 {
-    writed(write_dps_regs, &g_dp, address, cpu_dword);
+    writed(write_dps_regs, &g_dev.dp, address, cpu_dword);
 }
 
+static const struct mem_handler dps_handler = { &g_dev.dp, read_dps_regs, write_dps_regs };
+
 
 static void read_mi(void)
 {
-    readw(read_mi_regs, &g_r4300, address, rdword);
+    readw(read_mi_regs, &g_dev.r4300, address, rdword);
 }
 
 static void read_mib(void)
 {
-    readb(read_mi_regs, &g_r4300, address, rdword);
+    readb(read_mi_regs, &g_dev.r4300, address, rdword);
 }
 
 static void read_mih(void)
 {
-    readh(read_mi_regs, &g_r4300, address, rdword);
+    readh(read_mi_regs, &g_dev.r4300, address, rdword);
 }
 
 static void read_mid(void)
 {
-    readd(read_mi_regs, &g_r4300, address, rdword);
+    readd(read_mi_regs, &g_dev.r4300, address, rdword);
 }
 
 static void write_mi(void)
 {
-    writew(write_mi_regs, &g_r4300, address, cpu_word);
+    writew(write_mi_regs, &g_dev.r4300, address, cpu_word);
 }
 
 static void write_mib(void)
 {
-    writeb(write_mi_regs, &g_r4300, address, cpu_byte);
+    writeb(write_mi_regs, &g_dev.r4300, address, cpu_byte);
 }
 
 static void write_mih(void)
 {
-    writeh(write_mi_regs, &g_r4300, address, cpu_hword);
+    writeh(write_mi_regs, &g_dev.r4300, address, cpu_hword);
 }
 
 static void write_mid(void)
 {
-    writed(write_mi_regs, &g_r4300, address, cpu_dword);
+    writed(write_mi_regs, &g_dev.r4300, address, cpu_dword);
 }
 
+static const struct mem_handler mi_handler = { &g_dev.r4300, read_mi_regs, write_mi_regs };
+
 
 static void read_vi(void)
 {
-    readw(read_vi_regs, &g_vi, address, rdword);
+    readw(read_vi_regs, &g_dev.vi, address, rdword);
 }
 
 static void read_vib(void)
 {
-    readb(read_vi_regs, &g_vi, address, rdword);
+    readb(read_vi_regs, &g_dev.vi, address, rdword);
 }
 
 static void read_vih(void)
 {
-    readh(read_vi_regs, &g_vi, address, rdword);
+    readh(read_vi_regs, &g_dev.vi, address, rdword);
 }
 
 static void read_vid(void)
 {
-    readd(read_vi_regs, &g_vi, address, rdword);
+    readd(read_vi_regs, &g_dev.vi, address, rdword);
 }
 
 static void write_vi(void)
 {
-    writew(write_vi_regs, &g_vi, address, cpu_word);
+    writew(write_vi_regs, &g_dev.vi, address, cpu_word);
 }
 
 static void write_vib(void)
 {
-    writeb(write_vi_regs, &g_vi, address, cpu_byte);
+    writeb(write_vi_regs, &g_dev.vi, address, cpu_byte);
 }
 
 static void write_vih(void)
 {
-    writeh(write_vi_regs, &g_vi, address, cpu_hword);
+    writeh(write_vi_regs, &g_dev.vi, address, cpu_hword);
 }
 
 static void write_vid(void)
 {
-    writed(write_vi_regs, &g_vi, address, cpu_dword);
+    writed(write_vi_regs, &g_dev.vi, address, cpu_dword);
 }
 
+static const struct mem_handler vi_handler = { &g_dev.vi, read_vi_regs, write_vi_regs };
+
 
 static void read_ai(void)
 {
-    readw(read_ai_regs, &g_ai, address, rdword);
+    readw(read_ai_regs, &g_dev.ai, address, rdword);
 }
 
 static void read_aib(void)
 {
-    readb(read_ai_regs, &g_ai, address, rdword);
+    readb(read_ai_regs, &g_dev.ai, address, rdword);
 }
 
 static void read_aih(void)
 {
-    readh(read_ai_regs, &g_ai, address, rdword);
+    readh(read_ai_regs, &g_dev.ai, address, rdword);
 }
 
 static void read_aid(void)
 {
-    readd(read_ai_regs, &g_ai, address, rdword);
+    readd(read_ai_regs, &g_dev.ai, address, rdword);
 }
 
 static void write_ai(void)
 {
-    writew(write_ai_regs, &g_ai, address, cpu_word);
+    writew(write_ai_regs, &g_dev.ai, address, cpu_word);
 }
 
 static void write_aib(void)
 {
-    writeb(write_ai_regs, &g_ai, address, cpu_byte);
+    writeb(write_ai_regs, &g_dev.ai, address, cpu_byte);
 }
 
 static void write_aih(void)
 {
-    writeh(write_ai_regs, &g_ai, address, cpu_hword);
+    writeh(write_ai_regs, &g_dev.ai, address, cpu_hword);
 }
 
 static void write_aid(void)
 {
-    writed(write_ai_regs, &g_ai, address, cpu_dword);
+    writed(write_ai_regs, &g_dev.ai, address, cpu_dword);
 }
 
+static const struct mem_handler ai_handler = { &g_dev.ai, read_ai_regs, write_ai_regs };
+
 
 static void read_pi(void)
 {
-    readw(read_pi_regs, &g_pi, address, rdword);
+    readw(read_pi_regs, &g_dev.pi, address, rdword);
 }
 
 static void read_pib(void)
 {
-    readb(read_pi_regs, &g_pi, address, rdword);
+    readb(read_pi_regs, &g_dev.pi, address, rdword);
 }
 
 static void read_pih(void)
 {
-    readh(read_pi_regs, &g_pi, address, rdword);
+    readh(read_pi_regs, &g_dev.pi, address, rdword);
 }
 
 static void read_pid(void)
 {
-    readd(read_pi_regs, &g_pi, address, rdword);
+    readd(read_pi_regs, &g_dev.pi, address, rdword);
 }
 
 static void write_pi(void)
 {
-    writew(write_pi_regs, &g_pi, address, cpu_word);
+    writew(write_pi_regs, &g_dev.pi, address, cpu_word);
 }
 
 static void write_pib(void)
 {
-    writeb(write_pi_regs, &g_pi, address, cpu_byte);
+    writeb(write_pi_regs, &g_dev.pi, address, cpu_byte);
 }
 
 static void write_pih(void)
 {
-    writeh(write_pi_regs, &g_pi, address, cpu_hword);
+    writeh(write_pi_regs, &g_dev.pi, address, cpu_hword);
 }
 
 static void write_pid(void)
 {
-    writed(write_pi_regs, &g_pi, address, cpu_dword);
+    writed(write_pi_regs, &g_dev.pi, address, cpu_dword);
 }
 
+static const struct mem_handler pi_handler = { &g_dev.pi, read_pi_regs, write_pi_regs };
+
 
 static void read_ri(void)
 {
-    readw(read_ri_regs, &g_ri, address, rdword);
+    readw(read_ri_regs, &g_dev.ri, address, rdword);
 }
 
 static void read_rib(void)
 {
-    readb(read_ri_regs, &g_ri, address, rdword);
+    readb(read_ri_regs, &g_dev.ri, address, rdword);
 }
 
 static void read_rih(void)
 {
-    readh(read_ri_regs, &g_ri, address, rdword);
+    readh(read_ri_regs, &g_dev.ri, address, rdword);
 }
 
 static void read_rid(void)
 {
-    readd(read_ri_regs, &g_ri, address, rdword);
+    readd(read_ri_regs, &g_dev.ri, address, rdword);
 }
 
 static void write_ri(void)
 {
-    writew(write_ri_regs, &g_ri, address, cpu_word);
+    writew(write_ri_regs, &g_dev.ri, address, cpu_word);
 }
 
 static void write_rib(void)
 {
-    writeb(write_ri_regs, &g_ri, address, cpu_byte);
+    writeb(write_ri_regs, &g_dev.ri, address, cpu_byte);
 }
 
 static void write_rih(void)
 {
-    writeh(write_ri_regs, &g_ri, address, cpu_hword);
+    writeh(write_ri_regs, &g_dev.ri, address, cpu_hword);
 }
 
 static void write_rid(void)
 {
-    writed(write_ri_regs, &g_ri, address, cpu_dword);
+    writed(write_ri_regs, &g_dev.ri, address, cpu_dword);
 }
 
+static const struct mem_handler ri_handler = { &g_dev.ri, read_ri_regs, write_ri_regs };
+
 
 static void read_si(void)
 {
-    readw(read_si_regs, &g_si, address, rdword);
+    readw(read_si_regs, &g_dev.si, address, rdword);
 }
 
 static void read_sib(void)
 {
-    readb(read_si_regs, &g_si, address, rdword);
+    readb(read_si_regs, &g_dev.si, address, rdword);
 }
 
 static void read_sih(void)
 {
-    readh(read_si_regs, &g_si, address, rdword);
+    readh(read_si_regs, &g_dev.si, address, rdword);
 }
 
 static void read_sid(void)
 {
-    readd(read_si_regs, &g_si, address, rdword);
+    readd(read_si_regs, &g_dev.si, address, rdword);
 }
 
 static void write_si(void)
 {
-    writew(write_si_regs, &g_si, address, cpu_word);
+    writew(write_si_regs, &g_dev.si, address, cpu_word);
 }
 
 static void write_sib(void)
 {
-    writeb(write_si_regs, &g_si, address, cpu_byte);
+    writeb(write_si_regs, &g_dev.si, address, cpu_byte);
 }
 
 static void write_sih(void)
 {
-    writeh(write_si_regs, &g_si, address, cpu_hword);
+    writeh(write_si_regs, &g_dev.si, address, cpu_hword);
 }
 
 static void write_sid(void)
 {
-    writed(write_si_regs, &g_si, address, cpu_dword);
+    writed(write_si_regs, &g_dev.si, address, cpu_dword);
 }
 
+static const struct mem_handler si_handler = { &g_dev.si, read_si_regs, write_si_regs };
+
 static void read_pi_flashram_status(void)
 {
-    readw(read_flashram_status, &g_pi, address, rdword);
+    readw(read_flashram_status, &g_dev.pi, address, rdword);
 }
 
 static void read_pi_flashram_statusb(void)
 {
-    readb(read_flashram_status, &g_pi, address, rdword);
+    readb(read_flashram_status, &g_dev.pi, address, rdword);
 }
 
 static void read_pi_flashram_statush(void)
 {
-    readh(read_flashram_status, &g_pi, address, rdword);
+    readh(read_flashram_status, &g_dev.pi, address, rdword);
 }
 
 static void read_pi_flashram_statusd(void)
 {
-    readd(read_flashram_status, &g_pi, address, rdword);
+    readd(read_flashram_status, &g_dev.pi, address, rdword);
 }
 
 static void write_pi_flashram_command(void)
 {
-    writew(write_flashram_command, &g_pi, address, cpu_word);
+    writew(write_flashram_command, &g_dev.pi, address, cpu_word);
 }
 
 static void write_pi_flashram_commandb(void)
 {
-    writeb(write_flashram_command, &g_pi, address, cpu_byte);
+    writeb(write_flashram_command, &g_dev.pi, address, cpu_byte);
 }
 
 static void write_pi_flashram_commandh(void)
 {
-    writeh(write_flashram_command, &g_pi, address, cpu_hword);
+    writeh(write_flashram_command, &g_dev.pi, address, cpu_hword);
 }
 
 static void write_pi_flashram_commandd(void)
 {
-    writed(write_flashram_command, &g_pi, address, cpu_dword);
+    writed(write_flashram_command, &g_dev.pi, address, cpu_dword);
 }
 
+static const struct mem_handler pi_flashram_status_handler = { &g_dev.pi, read_flashram_status, write_unmapped };
+static const struct mem_handler pi_flashram_command_handler = { &g_dev.pi, read_unmapped, write_flashram_command };
+
 
 static void read_rom(void)
 {
-    readw(read_cart_rom, &g_pi, address, rdword);
+    readw(read_cart_rom, &g_dev.pi, address, rdword);
 }
 
 static void read_romb(void)
 {
-    readb(read_cart_rom, &g_pi, address, rdword);
+    readb(read_cart_rom, &g_dev.pi, address, rdword);
 }
 
 static void read_romh(void)
 {
-    readh(read_cart_rom, &g_pi, address, rdword);
+    readh(read_cart_rom, &g_dev.pi, address, rdword);
 }
 
 static void read_romd(void)
 {
-    readd(read_cart_rom, &g_pi, address, rdword);
+    readd(read_cart_rom, &g_dev.pi, address, rdword);
 }
 
 static void write_rom(void)
 {
-    writew(write_cart_rom, &g_pi, address, cpu_word);
+    writew(write_cart_rom, &g_dev.pi, address, cpu_word);
+}
+
+static int write_cart_rom_word(void* opaque, uint32_t address, uint32_t value, uint32_t mask)
+{
+    /* like write_rom, only word writes reach the cart */
+    return (mask == ~0U)
+         ? write_cart_rom(opaque, address, value, mask)
+         : 0;
 }
 
+static const struct mem_handler rom_handler = { &g_dev.pi, read_cart_rom, write_unmapped };
+static const struct mem_handler rom_kseg1_handler = { &g_dev.pi, read_cart_rom, write_cart_rom_word };
+
 
 static void read_pif(void)
 {
-    readw(read_pif_ram, &g_si, address, rdword);
+    readw(read_pif_ram, &g_dev.si, address, rdword);
 }
 
 static void read_pifb(void)
 {
-    readb(read_pif_ram, &g_si, address, rdword);
+    readb(read_pif_ram, &g_dev.si, address, rdword);
 }
 
 static void read_pifh(void)
 {
-    readh(read_pif_ram, &g_si, address, rdword);
+    readh(read_pif_ram, &g_dev.si, address, rdword);
 }
 
 static void read_pifd(void)
 {
-    readd(read_pif_ram, &g_si, address, rdword);
+    readd(read_pif_ram, &g_dev.si, address, rdword);
 }
 
 static void write_pif(void)
 {
-    writew(write_pif_ram, &g_si, address, cpu_word);
+    writew(write_pif_ram, &g_dev.si, address, cpu_word);
 }
 
 static void write_pifb(void)
 {
-    writeb(write_pif_ram, &g_si, address, cpu_byte);
+    writeb(write_pif_ram, &g_dev.si, address, cpu_byte);
 }
 
 static void write_pifh(void)
 {
-    writeh(write_pif_ram, &g_si, address, cpu_hword);
+    writeh(write_pif_ram, &g_dev.si, address, cpu_hword);
 }
 
 static void write_pifd(void)
 {
-    writed(write_pif_ram, &g_si, address, cpu_dword);
+    writed(write_pif_ram, &g_dev.si, address, cpu_dword);
 }
 
+static const struct mem_handler pif_handler = { &g_dev.si, read_pif_ram, write_pif_ram };
+
 /* HACK: just to get F-Zero to boot
  * TODO: implement a real DD module
  */
@@ -996,6 +1146,8 @@ static void write_ddd(void)
     writed(write_dd_regs, NULL, address, cpu_dword);
 }
 
+static const struct mem_handler dd_handler = { NULL, read_dd_regs, write_dd_regs };
+
 #ifdef DBG
 static int memtype[0x10000];
 static void (*saved_readmemb[0x10000])(void);
@@ -1148,6 +1300,7 @@ int get_memory_type(uint32_t address)
 #define R(x) read_ ## x ## b, read_ ## x ## h, read_ ## x, read_ ## x ## d
 #define W(x) write_ ## x ## b, write_ ## x ## h, write_ ## x, write_ ## x ## d
 #define RW(x) R(x), W(x)
+#define H(x) &x ## _handler
 
 int init_memory(void)
 {
@@ -1161,183 +1314,177 @@ int init_memory(void)
     /* clear mappings */
     for(i = 0; i < 0x10000; ++i)
     {
-        map_region(i, M64P_MEM_NOMEM, RW(nomem));
+        map_region(i, M64P_MEM_NOMEM, H(nomem), RW(nomem));
     }
 
     /* map RDRAM */
     for(i = 0; i < /*0x40*/0x80; ++i)
     {
-        map_region(0x8000+i, M64P_MEM_RDRAM, RW(rdram));
-        map_region(0xa000+i, M64P_MEM_RDRAM, RW(rdram));
+        map_rdram_region(i);
     }
     for(i = /*0x40*/0x80; i < 0x3f0; ++i)
     {
-        map_region(0x8000+i, M64P_MEM_NOTHING, RW(nothing));
-        map_region(0xa000+i, M64P_MEM_NOTHING, RW(nothing));
+        map_region(0x8000+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
+        map_region(0xa000+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
     }
 
     /* map RDRAM registers */
-    map_region(0x83f0, M64P_MEM_RDRAMREG, RW(rdramreg));
-    map_region(0xa3f0, M64P_MEM_RDRAMREG, RW(rdramreg));
+    map_region(0x83f0, M64P_MEM_RDRAMREG, H(rdramreg), RW(rdramreg));
+    map_region(0xa3f0, M64P_MEM_RDRAMREG, H(rdramreg), RW(rdramreg));
     for(i = 1; i < 0x10; ++i)
     {
-        map_region(0x83f0+i, M64P_MEM_NOTHING, RW(nothing));
-        map_region(0xa3f0+i, M64P_MEM_NOTHING, RW(nothing));
+        map_region(0x83f0+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
+        map_region(0xa3f0+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
     }
 
     /* map RSP memory */
-    map_region(0x8400, M64P_MEM_RSPMEM, RW(rspmem));
-    map_region(0xa400, M64P_MEM_RSPMEM, RW(rspmem));
+    map_region(0x8400, M64P_MEM_RSPMEM, H(rspmem), RW(rspmem));
+    map_region(0xa400, M64P_MEM_RSPMEM, H(rspmem), RW(rspmem));
     for(i = 1; i < 0x4; ++i)
     {
-        map_region(0x8400+i, M64P_MEM_NOTHING, RW(nothing));
-        map_region(0xa400+i, M64P_MEM_NOTHING, RW(nothing));
+        map_region(0x8400+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
+        map_region(0xa400+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
     }
 
     /* map RSP registers (1) */
-    map_region(0x8404, M64P_MEM_RSPREG, RW(rspreg));
-    map_region(0xa404, M64P_MEM_RSPREG, RW(rspreg));
+    map_region(0x8404, M64P_MEM_RSPREG, H(rspreg), RW(rspreg));
+    map_region(0xa404, M64P_MEM_RSPREG, H(rspreg), RW(rspreg));
     for(i = 0x5; i < 0x8; ++i)
     {
-        map_region(0x8400+i, M64P_MEM_NOTHING, RW(nothing));
-        map_region(0xa400+i, M64P_MEM_NOTHING, RW(nothing));
+        map_region(0x8400+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
+        map_region(0xa400+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
     }
 
     /* map RSP registers (2) */
-    map_region(0x8408, M64P_MEM_RSP, RW(rspreg2));
-    map_region(0xa408, M64P_MEM_RSP, RW(rspreg2));
+    map_region(0x8408, M64P_MEM_RSP, H(rspreg2), RW(rspreg2));
+    map_region(0xa408, M64P_MEM_RSP, H(rspreg2), RW(rspreg2));
     for(i = 0x9; i < 0x10; ++i)
     {
-        map_region(0x8400+i, M64P_MEM_NOTHING, RW(nothing));
-        map_region(0xa400+i, M64P_MEM_NOTHING, RW(nothing));
+        map_region(0x8400+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
+        map_region(0xa400+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
     }
 
     /* map DPC registers */
-    map_region(0x8410, M64P_MEM_DP, RW(dp));
-    map_region(0xa410, M64P_MEM_DP, RW(dp));
+    map_region(0x8410, M64P_MEM_DP, H(dp), RW(dp));
+    map_region(0xa410, M64P_MEM_DP, H(dp), RW(dp));
     for(i = 1; i < 0x10; ++i)
     {
-        map_region(0x8410+i, M64P_MEM_NOTHING, RW(nothing));
-        map_region(0xa410+i, M64P_MEM_NOTHING, RW(nothing));
+        map_region(0x8410+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
+        map_region(0xa410+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
     }
 
     /* map DPS registers */
-    map_region(0x8420, M64P_MEM_DPS, RW(dps));
-    map_region(0xa420, M64P_MEM_DPS, RW(dps));
+    map_region(0x8420, M64P_MEM_DPS, H(dps), RW(dps));
+    map_region(0xa420, M64P_MEM_DPS, H(dps), RW(dps));
     for(i = 1; i < 0x10; ++i)
     {
-        map_region(0x8420+i, M64P_MEM_NOTHING, RW(nothing));
-        map_region(0xa420+i, M64P_MEM_NOTHING, RW(nothing));
+        map_region(0x8420+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
+        map_region(0xa420+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
     }
 
     /* map MI registers */
-    map_region(0x8430, M64P_MEM_MI, RW(mi));
-    map_region(0xa430, M64P_MEM_MI, RW(mi));
+    map_region(0x8430, M64P_MEM_MI, H(mi), RW(mi));
+    map_region(0xa430, M64P_MEM_MI, H(mi), RW(mi));
     for(i = 1; i < 0x10; ++i)
     {
-        map_region(0x8430+i, M64P_MEM_NOTHING, RW(nothing));
-        map_region(0xa430+i, M64P_MEM_NOTHING, RW(nothing));
+        map_region(0x8430+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
+        map_region(0xa430+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
     }
 
     /* map VI registers */
-    map_region(0x8440, M64P_MEM_VI, RW(vi));
-    map_region(0xa440, M64P_MEM_VI, RW(vi));
+    map_region(0x8440, M64P_MEM_VI, H(vi), RW(vi));
+    map_region(0xa440, M64P_MEM_VI, H(vi), RW(vi));
     for(i = 1; i < 0x10; ++i)
     {
-        map_region(0x8440+i, M64P_MEM_NOTHING, RW(nothing));
-        map_region(0xa440+i, M64P_MEM_NOTHING, RW(nothing));
+        map_region(0x8440+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
+        map_region(0xa440+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
     }
 
     /* map AI registers */
-    map_region(0x8450, M64P_MEM_AI, RW(ai));
-    map_region(0xa450, M64P_MEM_AI, RW(ai));
+    map_region(0x8450, M64P_MEM_AI, H(ai), RW(ai));
+    map_region(0xa450, M64P_MEM_AI, H(ai), RW(ai));
     for(i = 1; i < 0x10; ++i)
     {
-        map_region(0x8450+i, M64P_MEM_NOTHING, RW(nothing));
-        map_region(0xa450+i, M64P_MEM_NOTHING, RW(nothing));
+        map_region(0x8450+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
+        map_region(0xa450+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
     }
 
     /* map PI registers */
-    map_region(0x8460, M64P_MEM_PI, RW(pi));
-    map_region(0xa460, M64P_MEM_PI, RW(pi));
+    map_region(0x8460, M64P_MEM_PI, H(pi), RW(pi));
+    map_region(0xa460, M64P_MEM_PI, H(pi), RW(pi));
     for(i = 1; i < 0x10; ++i)
     {
-        map_region(0x8460+i, M64P_MEM_NOTHING, RW(nothing));
-        map_region(0xa460+i, M64P_MEM_NOTHING, RW(nothing));
+        map_region(0x8460+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
+        map_region(0xa460+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
     }
 
     /* map RI registers */
-    map_region(0x8470, M64P_MEM_RI, RW(ri));
-    map_region(0xa470, M64P_MEM_RI, RW(ri));
+    map_region(0x8470, M64P_MEM_RI, H(ri), RW(ri));
+    map_region(0xa470, M64P_MEM_RI, H(ri), RW(ri));
     for(i = 1; i < 0x10; ++i)
     {
-        map_region(0x8470+i, M64P_MEM_NOTHING, RW(nothing));
-        map_region(0xa470+i, M64P_MEM_NOTHING, RW(nothing));
+        map_region(0x8470+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
+        map_region(0xa470+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
     }
 
     /* map SI registers */
-    map_region(0x8480, M64P_MEM_SI, RW(si));
-    map_region(0xa480, M64P_MEM_SI, RW(si));
+    map_region(0x8480, M64P_MEM_SI, H(si), RW(si));
+    map_region(0xa480, M64P_MEM_SI, H(si), RW(si));
     for(i = 0x481; i < 0x500; ++i)
     {
-        map_region(0x8000+i, M64P_MEM_NOTHING, RW(nothing));
-        map_region(0xa000+i, M64P_MEM_NOTHING, RW(nothing));
+        map_region(0x8000+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
+        map_region(0xa000+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
     }
 
     /* map DD regsiters */
-    map_region(0x8500, M64P_MEM_NOTHING, RW(dd));
-    map_region(0xa500, M64P_MEM_NOTHING, RW(dd));
+    map_region(0x8500, M64P_MEM_NOTHING, H(dd), RW(dd));
+    map_region(0xa500, M64P_MEM_NOTHING, H(dd), RW(dd));
     for(i = 0x501; i < 0x800; ++i)
     {
-        map_region(0x8000+i, M64P_MEM_NOTHING, RW(nothing));
-        map_region(0xa000+i, M64P_MEM_NOTHING, RW(nothing));
+        map_region(0x8000+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
+        map_region(0xa000+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
     }
 
     /* map flashram/sram */
-    map_region(0x8800, M64P_MEM_FLASHRAMSTAT, R(pi_flashram_status), W(nothing));
-    map_region(0xa800, M64P_MEM_FLASHRAMSTAT, R(pi_flashram_status), W(nothing));
-    map_region(0x8801, M64P_MEM_NOTHING, R(nothing), W(pi_flashram_command));
-    map_region(0xa801, M64P_MEM_NOTHING, R(nothing), W(pi_flashram_command));
+    map_region(0x8800, M64P_MEM_FLASHRAMSTAT, H(pi_flashram_status), R(pi_flashram_status), W(nothing));
+    map_region(0xa800, M64P_MEM_FLASHRAMSTAT, H(pi_flashram_status), R(pi_flashram_status), W(nothing));
+    map_region(0x8801, M64P_MEM_NOTHING, H(pi_flashram_command), R(nothing), W(pi_flashram_command));
+    map_region(0xa801, M64P_MEM_NOTHING, H(pi_flashram_command), R(nothing), W(pi_flashram_command));
     for(i = 0x802; i < 0x1000; ++i)
     {
-        map_region(0x8000+i, M64P_MEM_NOTHING, RW(nothing));
-        map_region(0xa000+i, M64P_MEM_NOTHING, RW(nothing));
+        map_region(0x8000+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
+        map_region(0xa000+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
     }
 
     /* map cart ROM */
     for(i = 0; i < (g_rom_size >> 16); ++i)
     {
-        map_region(0x9000+i, M64P_MEM_ROM, R(rom), W(nothing));
-        map_region(0xb000+i, M64P_MEM_ROM, R(rom),
+        map_region(0x9000+i, M64P_MEM_ROM, H(rom), R(rom), W(nothing));
+        map_region(0xb000+i, M64P_MEM_ROM, H(rom_kseg1), R(rom),
                    write_nothingb, write_nothingh, write_rom, write_nothingd);
     }
     for(i = (g_rom_size >> 16); i < 0xfc0; ++i)
     {
-        map_region(0x9000+i, M64P_MEM_NOTHING, RW(nothing));
-        map_region(0xb000+i, M64P_MEM_NOTHING, RW(nothing));
+        map_region(0x9000+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
+        map_region(0xb000+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
     }
 
     /* map PIF RAM */
-    map_region(0x9fc0, M64P_MEM_PIF, RW(pif));
-    map_region(0xbfc0, M64P_MEM_PIF, RW(pif));
+    map_region(0x9fc0, M64P_MEM_PIF, H(pif), RW(pif));
+    map_region(0xbfc0, M64P_MEM_PIF, H(pif), RW(pif));
     for(i = 0xfc1; i < 0x1000; ++i)
     {
-        map_region(0x9000+i, M64P_MEM_NOTHING, RW(nothing));
-        map_region(0xb000+i, M64P_MEM_NOTHING, RW(nothing));
+        map_region(0x9000+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
+        map_region(0xb000+i, M64P_MEM_NOTHING, H(nothing), RW(nothing));
     }
 
-    fast_memory = 1;
+    /* the recompilers must go through the RDRAM handlers, which wait for
+     * asynchronous RSP audio tasks */
+    fast_memory = !g_dev.sp.async_audio;
 
-    init_cic_using_ipl3(&g_si.pif.cic, g_rom + 0x40);
+    init_cic_using_ipl3(&g_dev.si.pif.cic, g_rom + 0x40);
 
-    init_r4300(&g_r4300);
-    init_rdp(&g_dp);
-    init_rsp(&g_sp);
-    init_ai(&g_ai);
-    init_pi(&g_pi);
-    init_ri(&g_ri);
-    init_si(&g_si);
-    init_vi(&g_vi);
+    init_device(&g_dev);
 
     DebugMessage(M64MSG_VERBOSE, "Memory initialized");
     return 0;
@@ -1411,8 +1558,23 @@ static void map_region_w(uint16_t region,
     }
 }
 
+void map_rdram_region(uint16_t region)
+{
+    if (g_dev.sp.async_audio)
+    {
+        map_region(0x8000+region, M64P_MEM_RDRAM, H(rdram_async), RW(rdram_async));
+        map_region(0xa000+region, M64P_MEM_RDRAM, H(rdram_async), RW(rdram_async));
+    }
+    else
+    {
+        map_region(0x8000+region, M64P_MEM_RDRAM, H(rdram), RW(rdram));
+        map_region(0xa000+region, M64P_MEM_RDRAM, H(rdram), RW(rdram));
+    }
+}
+
 void map_region(uint16_t region,
                 int type,
+                const struct mem_handler* handler,
                 void (*read8)(void),
                 void (*read16)(void),
                 void (*read32)(void),
@@ -1423,10 +1585,86 @@ void map_region(uint16_t region,
                 void (*write64)(void))
 {
     map_region_t(region, type);
+    mem_handlers[region] = *handler;
     map_region_r(region, read8, read16, read32, read64);
     map_region_w(region, write8, write16, write32, write64);
 }
 
+#ifdef DBG
+static void check_read_breakpoints(uint32_t address, int size)
+{
+    if (readmem[address >> 16] == readmem_with_bp_checks)
+        check_breakpoints_on_mem_access(*r4300_pc()-0x4, address, size,
+                M64P_BKP_FLAG_ENABLED | M64P_BKP_FLAG_READ);
+}
+
+static void check_write_breakpoints(uint32_t address, int size)
+{
+    if (writemem[address >> 16] == writemem_with_bp_checks)
+        check_breakpoints_on_mem_access(*r4300_pc()-0x4, address, size,
+                M64P_BKP_FLAG_ENABLED | M64P_BKP_FLAG_WRITE);
+}
+#else
+#define check_read_breakpoints(address, size)
+#define check_write_breakpoints(address, size)
+#endif
+
+int r4300_read_byte(uint32_t address, uint64_t* value)
+{
+    const struct mem_handler* handler = &mem_handlers[address >> 16];
+    check_read_breakpoints(address, 1);
+    return readb(handler->read32, handler->opaque, address, value);
+}
+
+int r4300_read_hword(uint32_t address, uint64_t* value)
+{
+    const struct mem_handler* handler = &mem_handlers[address >> 16];
+    check_read_breakpoints(address, 2);
+    return readh(handler->read32, handler->opaque, address, value);
+}
+
+int r4300_read_word(uint32_t address, uint64_t* value)
+{
+    const struct mem_handler* handler = &mem_handlers[address >> 16];
+    check_read_breakpoints(address, 4);
+    return readw(handler->read32, handler->opaque, address, value);
+}
+
+int r4300_read_dword(uint32_t address, uint64_t* value)
+{
+    const struct mem_handler* handler = &mem_handlers[address >> 16];
+    check_read_breakpoints(address, 8);
+    return readd(handler->read32, handler->opaque, address, value);
+}
+
+int r4300_write_byte(uint32_t address, uint8_t value)
+{
+    const struct mem_handler* handler = &mem_handlers[address >> 16];
+    check_write_breakpoints(address, 1);
+    return writeb(handler->write32, handler->opaque, address, value);
+}
+
+int r4300_write_hword(uint32_t address, uint16_t value)
+{
+    const struct mem_handler* handler = &mem_handlers[address >> 16];
+    check_write_breakpoints(address, 2);
+    return writeh(handler->write32, handler->opaque, address, value);
+}
+
+int r4300_write_word(uint32_t address, uint32_t value)
+{
+    const struct mem_handler* handler = &mem_handlers[address >> 16];
+    check_write_breakpoints(address, 4);
+    return writew(handler->write32, handler->opaque, address, value);
+}
+
+int r4300_write_dword(uint32_t address, uint64_t value)
+{
+    const struct mem_handler* handler = &mem_handlers[address >> 16];
+    check_write_breakpoints(address, 8);
+    return writed(handler->write32, handler->opaque, address, value);
+}
+
 uint32_t *fast_mem_access(uint32_t address)
 {
     /* This code is performance critical, specially on pure interpreter mode.
@@ -1442,7 +1680,7 @@ uint32_t *fast_mem_access(uint32_t address)
     else if (address >= UINT32_C(0x10000000))
         return (uint32_t*) ((uint8_t*) g_rom + (address - UINT32_C(0x10000000)));
     else if ((address & UINT32_C(0xffffe000)) == UINT32_C(0x04000000))
-        return (uint32_t*) ((uint8_t*) g_sp.mem + (address & UINT32_C(0x1ffc)));
+        return (uint32_t*) ((uint8_t*) g_dev.sp.mem + (address & UINT32_C(0x1ffc)));
     else
         return NULL;
 }
@@ -47,6 +47,21 @@ extern void (*writememb[0x10000])(void);
 extern void (*writememh[0x10000])(void);
 extern void (*writememd[0x10000])(void);
 
+typedef int (*readfn)(void*,uint32_t,uint32_t*);
+typedef int (*writefn)(void*,uint32_t,uint32_t,uint32_t);
+
+/* Register-passing counterpart of the tables above: each 64KB region maps
+ * to a device word handler and its opaque pointer. Handlers return 0 on
+ * success and non-zero if the access failed. */
+struct mem_handler
+{
+    void* opaque;
+    readfn read32;
+    writefn write32;
+};
+
+extern struct mem_handler mem_handlers[0x10000];
+
 #ifndef M64P_BIG_ENDIAN
 #if defined(__GNUC__) && (__GNUC__ > 4  || (__GNUC__ == 4 && __GNUC_MINOR__ >= 3))
 #define sl(x) __builtin_bswap32(x)
@@ -79,8 +94,12 @@ static void masked_write(uint32_t* dst, uint32_t value, uint32_t mask)
 
 int init_memory(void);
 
+/* maps the 64KB RDRAM region with the handlers matching the RSP audio mode */
+void map_rdram_region(uint16_t region);
+
 void map_region(uint16_t region,
                 int type,
+                const struct mem_handler* handler,
                 void (*read8)(void),
                 void (*read16)(void),
                 void (*read32)(void),
@@ -107,6 +126,21 @@ void write_rdramFB(void);
 void write_rdramFBb(void);
 void write_rdramFBh(void);
 void write_rdramFBd(void);
+extern const struct mem_handler rdram_handler;
+extern const struct mem_handler rdramFB_handler;
+
+/* Accessors for the interpreters and the recompilers' slow paths.
+ * Reads store the zero-extended value in *value. They return 0 on success
+ * and non-zero if the access failed, e.g. on a TLB miss (in which case the
+ * exception has already been raised and *value is left untouched). */
+int r4300_read_byte(uint32_t address, uint64_t* value);
+int r4300_read_hword(uint32_t address, uint64_t* value);
+int r4300_read_word(uint32_t address, uint64_t* value);
+int r4300_read_dword(uint32_t address, uint64_t* value);
+int r4300_write_byte(uint32_t address, uint8_t value);
+int r4300_write_hword(uint32_t address, uint16_t value);
+int r4300_write_word(uint32_t address, uint32_t value);
+int r4300_write_dword(uint32_t address, uint64_t value);
 
 /* Returns a pointer to a block of contiguous memory
  * Can access RDRAM, SP_DMEM, SP_IMEM and ROM, using TLB if necessary
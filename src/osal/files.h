@@ -26,6 +26,8 @@
 #if !defined (OSAL_FILES_H)
 #define OSAL_FILES_H
 
+#include <stddef.h>
+
 /* some file-related preprocessor definitions */
 #if defined(WIN32) && !defined(__MINGW32__)
   #include <io.h> // For _unlink()
@@ -52,6 +54,18 @@
  */
 extern int osal_mkdirp(const char *dirpath, int mode);
 
+/* Rename a file, replacing the destination file if it exists.
+ * Returns zero on success, nonzero on failure.
+ */
+extern int osal_rename_file(const char *oldpath, const char *newpath);
+
+/* Map a whole file read-only in memory, sharing its pages with the other
+ * processes mapping the same file.
+ * Returns NULL on failure, otherwise the size of the file is put in *size.
+ */
+extern const void * osal_map_file(const char *filename, size_t *size);
+extern void osal_unmap_file(const void *addr, size_t size);
+
 extern const char * osal_get_shared_filepath(const char *filename, const char *firstsearch, const char *secondsearch);
 extern const char * osal_get_user_configpath(void);
 extern const char * osal_get_user_datapath(void);
@@ -26,7 +26,9 @@
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <fcntl.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -179,6 +181,41 @@ int osal_mkdirp(const char *dirpath, int mode)
     return 0;
 }
 
+int osal_rename_file(const char *oldpath, const char *newpath)
+{
+    // rename() atomically replaces newpath on POSIX systems
+    return rename(oldpath, newpath) != 0;
+}
+
+const void * osal_map_file(const char *filename, size_t *size)
+{
+    struct stat fileinfo;
+    void *addr;
+    int fd = open(filename, O_RDONLY);
+
+    if (fd < 0)
+        return NULL;
+
+    if (fstat(fd, &fileinfo) != 0 || fileinfo.st_size <= 0)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    addr = mmap(NULL, fileinfo.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+        return NULL;
+
+    *size = fileinfo.st_size;
+    return addr;
+}
+
+void osal_unmap_file(const void *addr, size_t size)
+{
+    munmap((void *) addr, size);
+}
+
 const char * osal_get_shared_filepath(const char *filename, const char *firstsearch, const char *secondsearch)
 {
     static char retpath[PATH_MAX];
@@ -126,6 +126,44 @@ errorexit:
 	return 1;
 }
 
+int osal_rename_file(const char *oldpath, const char *newpath)
+{
+    // rename() fails on Windows if newpath already exists
+    return MoveFileExA(oldpath, newpath, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) == 0;
+}
+
+const void * osal_map_file(const char *filename, size_t *size)
+{
+    HANDLE file, mapping;
+    LARGE_INTEGER filesize;
+    void *addr = NULL;
+
+    file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return NULL;
+
+    if (GetFileSizeEx(file, &filesize) && filesize.QuadPart > 0)
+    {
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping != NULL)
+        {
+            // the view keeps the mapping alive
+            addr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+
+    if (addr != NULL)
+        *size = (size_t) filesize.QuadPart;
+    return addr;
+}
+
+void osal_unmap_file(const void *addr, size_t size)
+{
+    UnmapViewOfFile(addr);
+}
+
 const char * osal_get_shared_filepath(const char *filename, const char *firstsearch, const char *secondsearch)
 {
     static char retpath[_MAX_PATH];
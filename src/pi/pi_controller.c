@@ -27,6 +27,7 @@
 
 #include "api/callbacks.h"
 #include "api/m64p_types.h"
+#include "memory/dma_copy.h"
 #include "memory/memory.h"
 #include "r4300/r4300_core.h"
 #include "ri/rdram_detection_hack.h"
@@ -126,13 +127,9 @@ static void dma_pi_write(struct pi_controller* pi)
     dram = (uint8_t*)pi->ri->rdram.dram;
     rom = pi->cart_rom.rom;
 
-    for(i = 0; i < longueur; ++i)
-    {
-        dram[(dram_address+i)^S8] = rom[(rom_address+i)^S8];
-    }
+    dma_copy(dram, dram_address, rom, rom_address, longueur);
 
-    invalidate_r4300_cached_code(0x80000000 + dram_address, longueur);
-    invalidate_r4300_cached_code(0xa0000000 + dram_address, longueur);
+    invalidate_r4300_cached_dram(dram_address, longueur);
 
     /* HACK: monitor PI DMA to trigger RDRAM size detection
      * hack just before initial cart ROM loading. */
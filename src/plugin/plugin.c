@@ -28,6 +28,7 @@
 #include "api/m64p_common.h"
 #include "api/m64p_plugin.h"
 #include "api/m64p_types.h"
+#include "device/device.h"
 #include "dummy_audio.h"
 #include "dummy_input.h"
 #include "dummy_rsp.h"
@@ -229,31 +230,31 @@ static m64p_error plugin_start_gfx(void)
     /* fill in the GFX_INFO data structure */
     gfx_info.HEADER = (unsigned char *) g_rom;
     gfx_info.RDRAM = (unsigned char *) g_rdram;
-    gfx_info.DMEM = (unsigned char *) g_sp.mem;
-    gfx_info.IMEM = (unsigned char *) g_sp.mem + 0x1000;
-    gfx_info.MI_INTR_REG = &(g_r4300.mi.regs[MI_INTR_REG]);
-    gfx_info.DPC_START_REG = &(g_dp.dpc_regs[DPC_START_REG]);
-    gfx_info.DPC_END_REG = &(g_dp.dpc_regs[DPC_END_REG]);
-    gfx_info.DPC_CURRENT_REG = &(g_dp.dpc_regs[DPC_CURRENT_REG]);
-    gfx_info.DPC_STATUS_REG = &(g_dp.dpc_regs[DPC_STATUS_REG]);
-    gfx_info.DPC_CLOCK_REG = &(g_dp.dpc_regs[DPC_CLOCK_REG]);
-    gfx_info.DPC_BUFBUSY_REG = &(g_dp.dpc_regs[DPC_BUFBUSY_REG]);
-    gfx_info.DPC_PIPEBUSY_REG = &(g_dp.dpc_regs[DPC_PIPEBUSY_REG]);
-    gfx_info.DPC_TMEM_REG = &(g_dp.dpc_regs[DPC_TMEM_REG]);
-    gfx_info.VI_STATUS_REG = &(g_vi.regs[VI_STATUS_REG]);
-    gfx_info.VI_ORIGIN_REG = &(g_vi.regs[VI_ORIGIN_REG]);
-    gfx_info.VI_WIDTH_REG = &(g_vi.regs[VI_WIDTH_REG]);
-    gfx_info.VI_INTR_REG = &(g_vi.regs[VI_V_INTR_REG]);
-    gfx_info.VI_V_CURRENT_LINE_REG = &(g_vi.regs[VI_CURRENT_REG]);
-    gfx_info.VI_TIMING_REG = &(g_vi.regs[VI_BURST_REG]);
-    gfx_info.VI_V_SYNC_REG = &(g_vi.regs[VI_V_SYNC_REG]);
-    gfx_info.VI_H_SYNC_REG = &(g_vi.regs[VI_H_SYNC_REG]);
-    gfx_info.VI_LEAP_REG = &(g_vi.regs[VI_LEAP_REG]);
-    gfx_info.VI_H_START_REG = &(g_vi.regs[VI_H_START_REG]);
-    gfx_info.VI_V_START_REG = &(g_vi.regs[VI_V_START_REG]);
-    gfx_info.VI_V_BURST_REG = &(g_vi.regs[VI_V_BURST_REG]);
-    gfx_info.VI_X_SCALE_REG = &(g_vi.regs[VI_X_SCALE_REG]);
-    gfx_info.VI_Y_SCALE_REG = &(g_vi.regs[VI_Y_SCALE_REG]);
+    gfx_info.DMEM = (unsigned char *) g_dev.sp.mem;
+    gfx_info.IMEM = (unsigned char *) g_dev.sp.mem + 0x1000;
+    gfx_info.MI_INTR_REG = &(g_dev.r4300.mi.regs[MI_INTR_REG]);
+    gfx_info.DPC_START_REG = &(g_dev.dp.dpc_regs[DPC_START_REG]);
+    gfx_info.DPC_END_REG = &(g_dev.dp.dpc_regs[DPC_END_REG]);
+    gfx_info.DPC_CURRENT_REG = &(g_dev.dp.dpc_regs[DPC_CURRENT_REG]);
+    gfx_info.DPC_STATUS_REG = &(g_dev.dp.dpc_regs[DPC_STATUS_REG]);
+    gfx_info.DPC_CLOCK_REG = &(g_dev.dp.dpc_regs[DPC_CLOCK_REG]);
+    gfx_info.DPC_BUFBUSY_REG = &(g_dev.dp.dpc_regs[DPC_BUFBUSY_REG]);
+    gfx_info.DPC_PIPEBUSY_REG = &(g_dev.dp.dpc_regs[DPC_PIPEBUSY_REG]);
+    gfx_info.DPC_TMEM_REG = &(g_dev.dp.dpc_regs[DPC_TMEM_REG]);
+    gfx_info.VI_STATUS_REG = &(g_dev.vi.regs[VI_STATUS_REG]);
+    gfx_info.VI_ORIGIN_REG = &(g_dev.vi.regs[VI_ORIGIN_REG]);
+    gfx_info.VI_WIDTH_REG = &(g_dev.vi.regs[VI_WIDTH_REG]);
+    gfx_info.VI_INTR_REG = &(g_dev.vi.regs[VI_V_INTR_REG]);
+    gfx_info.VI_V_CURRENT_LINE_REG = &(g_dev.vi.regs[VI_CURRENT_REG]);
+    gfx_info.VI_TIMING_REG = &(g_dev.vi.regs[VI_BURST_REG]);
+    gfx_info.VI_V_SYNC_REG = &(g_dev.vi.regs[VI_V_SYNC_REG]);
+    gfx_info.VI_H_SYNC_REG = &(g_dev.vi.regs[VI_H_SYNC_REG]);
+    gfx_info.VI_LEAP_REG = &(g_dev.vi.regs[VI_LEAP_REG]);
+    gfx_info.VI_H_START_REG = &(g_dev.vi.regs[VI_H_START_REG]);
+    gfx_info.VI_V_START_REG = &(g_dev.vi.regs[VI_V_START_REG]);
+    gfx_info.VI_V_BURST_REG = &(g_dev.vi.regs[VI_V_BURST_REG]);
+    gfx_info.VI_X_SCALE_REG = &(g_dev.vi.regs[VI_X_SCALE_REG]);
+    gfx_info.VI_Y_SCALE_REG = &(g_dev.vi.regs[VI_Y_SCALE_REG]);
     gfx_info.CheckInterrupts = EmptyFunc;
 
     /* call the audio plugin */
@@ -321,15 +322,15 @@ static m64p_error plugin_start_audio(void)
 {
     /* fill in the AUDIO_INFO data structure */
     audio_info.RDRAM = (unsigned char *) g_rdram;
-    audio_info.DMEM = (unsigned char *) g_sp.mem;
-    audio_info.IMEM = (unsigned char *) g_sp.mem + 0x1000;
-    audio_info.MI_INTR_REG = &(g_r4300.mi.regs[MI_INTR_REG]);
-    audio_info.AI_DRAM_ADDR_REG = &(g_ai.regs[AI_DRAM_ADDR_REG]);
-    audio_info.AI_LEN_REG = &(g_ai.regs[AI_LEN_REG]);
-    audio_info.AI_CONTROL_REG = &(g_ai.regs[AI_CONTROL_REG]);
+    audio_info.DMEM = (unsigned char *) g_dev.sp.mem;
+    audio_info.IMEM = (unsigned char *) g_dev.sp.mem + 0x1000;
+    audio_info.MI_INTR_REG = &(g_dev.r4300.mi.regs[MI_INTR_REG]);
+    audio_info.AI_DRAM_ADDR_REG = &(g_dev.ai.regs[AI_DRAM_ADDR_REG]);
+    audio_info.AI_LEN_REG = &(g_dev.ai.regs[AI_LEN_REG]);
+    audio_info.AI_CONTROL_REG = &(g_dev.ai.regs[AI_CONTROL_REG]);
     audio_info.AI_STATUS_REG = &dummy;
-    audio_info.AI_DACRATE_REG = &(g_ai.regs[AI_DACRATE_REG]);
-    audio_info.AI_BITRATE_REG = &(g_ai.regs[AI_BITRATE_REG]);
+    audio_info.AI_DACRATE_REG = &(g_dev.ai.regs[AI_DACRATE_REG]);
+    audio_info.AI_BITRATE_REG = &(g_dev.ai.regs[AI_BITRATE_REG]);
     audio_info.CheckInterrupts = EmptyFunc;
 
     /* call the audio plugin */
@@ -467,26 +468,26 @@ static m64p_error plugin_start_rsp(void)
 {
     /* fill in the RSP_INFO data structure */
     rsp_info.RDRAM = (unsigned char *) g_rdram;
-    rsp_info.DMEM = (unsigned char *) g_sp.mem;
-    rsp_info.IMEM = (unsigned char *) g_sp.mem + 0x1000;
-    rsp_info.MI_INTR_REG = &g_r4300.mi.regs[MI_INTR_REG];
-    rsp_info.SP_MEM_ADDR_REG = &g_sp.regs[SP_MEM_ADDR_REG];
-    rsp_info.SP_DRAM_ADDR_REG = &g_sp.regs[SP_DRAM_ADDR_REG];
-    rsp_info.SP_RD_LEN_REG = &g_sp.regs[SP_RD_LEN_REG];
-    rsp_info.SP_WR_LEN_REG = &g_sp.regs[SP_WR_LEN_REG];
-    rsp_info.SP_STATUS_REG = &g_sp.regs[SP_STATUS_REG];
-    rsp_info.SP_DMA_FULL_REG = &g_sp.regs[SP_DMA_FULL_REG];
-    rsp_info.SP_DMA_BUSY_REG = &g_sp.regs[SP_DMA_BUSY_REG];
-    rsp_info.SP_PC_REG = &g_sp.regs2[SP_PC_REG];
-    rsp_info.SP_SEMAPHORE_REG = &g_sp.regs[SP_SEMAPHORE_REG];
-    rsp_info.DPC_START_REG = &g_dp.dpc_regs[DPC_START_REG];
-    rsp_info.DPC_END_REG = &g_dp.dpc_regs[DPC_END_REG];
-    rsp_info.DPC_CURRENT_REG = &g_dp.dpc_regs[DPC_CURRENT_REG];
-    rsp_info.DPC_STATUS_REG = &g_dp.dpc_regs[DPC_STATUS_REG];
-    rsp_info.DPC_CLOCK_REG = &g_dp.dpc_regs[DPC_CLOCK_REG];
-    rsp_info.DPC_BUFBUSY_REG = &g_dp.dpc_regs[DPC_BUFBUSY_REG];
-    rsp_info.DPC_PIPEBUSY_REG = &g_dp.dpc_regs[DPC_PIPEBUSY_REG];
-    rsp_info.DPC_TMEM_REG = &g_dp.dpc_regs[DPC_TMEM_REG];
+    rsp_info.DMEM = (unsigned char *) g_dev.sp.mem;
+    rsp_info.IMEM = (unsigned char *) g_dev.sp.mem + 0x1000;
+    rsp_info.MI_INTR_REG = &g_dev.sp.mi_intr_reg;
+    rsp_info.SP_MEM_ADDR_REG = &g_dev.sp.regs[SP_MEM_ADDR_REG];
+    rsp_info.SP_DRAM_ADDR_REG = &g_dev.sp.regs[SP_DRAM_ADDR_REG];
+    rsp_info.SP_RD_LEN_REG = &g_dev.sp.regs[SP_RD_LEN_REG];
+    rsp_info.SP_WR_LEN_REG = &g_dev.sp.regs[SP_WR_LEN_REG];
+    rsp_info.SP_STATUS_REG = &g_dev.sp.regs[SP_STATUS_REG];
+    rsp_info.SP_DMA_FULL_REG = &g_dev.sp.regs[SP_DMA_FULL_REG];
+    rsp_info.SP_DMA_BUSY_REG = &g_dev.sp.regs[SP_DMA_BUSY_REG];
+    rsp_info.SP_PC_REG = &g_dev.sp.regs2[SP_PC_REG];
+    rsp_info.SP_SEMAPHORE_REG = &g_dev.sp.regs[SP_SEMAPHORE_REG];
+    rsp_info.DPC_START_REG = &g_dev.dp.dpc_regs[DPC_START_REG];
+    rsp_info.DPC_END_REG = &g_dev.dp.dpc_regs[DPC_END_REG];
+    rsp_info.DPC_CURRENT_REG = &g_dev.dp.dpc_regs[DPC_CURRENT_REG];
+    rsp_info.DPC_STATUS_REG = &g_dev.dp.dpc_regs[DPC_STATUS_REG];
+    rsp_info.DPC_CLOCK_REG = &g_dev.dp.dpc_regs[DPC_CLOCK_REG];
+    rsp_info.DPC_BUFBUSY_REG = &g_dev.dp.dpc_regs[DPC_BUFBUSY_REG];
+    rsp_info.DPC_PIPEBUSY_REG = &g_dev.dp.dpc_regs[DPC_PIPEBUSY_REG];
+    rsp_info.DPC_TMEM_REG = &g_dev.dp.dpc_regs[DPC_TMEM_REG];
     rsp_info.CheckInterrupts = EmptyFunc;
     rsp_info.ProcessDlistList = gfx.processDList;
     rsp_info.ProcessAlistList = audio.processAList;
@@ -558,3 +559,9 @@ m64p_error plugin_check(void)
     return M64ERR_SUCCESS;
 }
 
+/* returns 0 if audio output goes to the dummy audio plugin */
+int plugin_audio_attached(void)
+{
+    return l_AudioAttached;
+}
+
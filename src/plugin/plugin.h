@@ -30,6 +30,7 @@
 extern m64p_error plugin_connect(m64p_plugin_type, m64p_dynlib_handle plugin_handle);
 extern m64p_error plugin_start(m64p_plugin_type);
 extern m64p_error plugin_check(void);
+extern int plugin_audio_attached(void);
 
 extern CONTROL Controls[4];
 
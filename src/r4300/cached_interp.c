@@ -30,6 +30,7 @@
 #include "api/debugger.h"
 #include "api/m64p_types.h"
 #include "cached_interp.h"
+#include "code_cache.h"
 #include "cp0_private.h"
 #include "cp1_private.h"
 #include "exception.h"
@@ -37,8 +38,10 @@
 #include "macros.h"
 #include "main/main.h"
 #include "memory/memory.h"
+#include "new_dynarec/new_dynarec.h"
 #include "ops.h"
 #include "r4300.h"
+#include "r4300_core.h"
 #include "recomp.h"
 #include "tlb.h"
 
@@ -48,11 +51,15 @@
 #endif
 
 /* global variables */
-char invalid_code[0x100000];
-precomp_block *blocks[0x100000];
+struct block_page *block_dir[BLOCK_DIR_SIZE];
 precomp_block *actual;
 unsigned int jump_to_address;
 
+/* shared by every directory entry without allocated pages */
+static struct block_page empty_block_page;
+/* list of the allocated pages, for resets and full invalidations */
+static struct block_page *block_pages;
+
 // -----------------------------------------------------------
 // Cached interpreter functions (and fallback for dynarec).
 // -----------------------------------------------------------
@@ -144,11 +151,11 @@ unsigned int jump_to_address;
       else name(); \
    }
 
-#define CHECK_MEMORY() \
-   if (!invalid_code[address>>12]) \
-      if (blocks[address>>12]->block[(address&0xFFF)/4].ops != \
+#define CHECK_MEMORY(addr) \
+   if (is_r4300_code_page(addr) && !get_invalid_code((addr)>>12)) \
+      if (get_block((addr)>>12)->block[((addr)&0xFFF)/4].ops != \
           current_instruction_table.NOTCOMPILED) \
-         invalid_code[address>>12] = 1;
+         set_invalid_code((addr)>>12, 1);
 
 // two functions are defined from the macros above but never used
 // these prototype declarations will prevent a warning
@@ -201,13 +208,13 @@ Used by dynarec only, check should be unnecessary
 
 static void NOTCOMPILED(void)
 {
-   uint32_t *mem = fast_mem_access(blocks[PC->addr>>12]->start);
+   uint32_t *mem = fast_mem_access(get_block(PC->addr>>12)->start);
 #ifdef CORE_DBG
    DebugMessage(M64MSG_INFO, "NOTCOMPILED: addr = %x ops = %lx", PC->addr, (long) PC->ops);
 #endif
 
    if (mem != NULL)
-      recompile_block(mem, blocks[PC->addr >> 12], PC->addr);
+      recompile_block(mem, get_block(PC->addr >> 12), PC->addr);
    else
       DebugMessage(M64MSG_ERROR, "not compiled exception");
 
@@ -513,8 +520,8 @@ static unsigned int update_invalid_addr(unsigned int addr)
 {
    if (addr >= 0x80000000 && addr < 0xc0000000)
      {
-    if (invalid_code[addr>>12]) invalid_code[(addr^0x20000000)>>12] = 1;
-    if (invalid_code[(addr^0x20000000)>>12]) invalid_code[addr>>12] = 1;
+    if (get_invalid_code(addr>>12)) set_invalid_code((addr^0x20000000)>>12, 1);
+    if (get_invalid_code((addr^0x20000000)>>12)) set_invalid_code(addr>>12, 1);
     return addr;
      }
    else
@@ -524,10 +531,10 @@ static unsigned int update_invalid_addr(unsigned int addr)
       {
          unsigned int beg_paddr = paddr - (addr - (addr&~0xFFF));
          update_invalid_addr(paddr);
-         if (invalid_code[(beg_paddr+0x000)>>12]) invalid_code[addr>>12] = 1;
-         if (invalid_code[(beg_paddr+0xFFC)>>12]) invalid_code[addr>>12] = 1;
-         if (invalid_code[addr>>12]) invalid_code[(beg_paddr+0x000)>>12] = 1;
-         if (invalid_code[addr>>12]) invalid_code[(beg_paddr+0xFFC)>>12] = 1;
+         if (get_invalid_code((beg_paddr+0x000)>>12)) set_invalid_code(addr>>12, 1);
+         if (get_invalid_code((beg_paddr+0xFFC)>>12)) set_invalid_code(addr>>12, 1);
+         if (get_invalid_code(addr>>12)) set_invalid_code((beg_paddr+0x000)>>12, 1);
+         if (get_invalid_code(addr>>12)) set_invalid_code((beg_paddr+0xFFC)>>12, 1);
       }
     return paddr;
      }
@@ -538,90 +545,165 @@ void jump_to_func(void)
 {
    unsigned int paddr;
    if (skip_jump) return;
+   if (r4300emu == CORE_DYNAREC) code_cache_set_running(actual);
    paddr = update_invalid_addr(addr);
    if (!paddr) return;
-   actual = blocks[addr>>12];
-   if (invalid_code[addr>>12])
+   actual = get_block(addr>>12);
+   if (get_invalid_code(addr>>12))
      {
-    if (!blocks[addr>>12])
+    actual = get_or_alloc_block(addr);
+    if (actual == NULL)
+      {
+         DebugMessage(M64MSG_ERROR, "Memory error: couldn't allocate memory for cached interpreter.");
+         stop = 1;
+         return;
+      }
+    if (!init_block(actual))
       {
-         blocks[addr>>12] = (precomp_block *) malloc(sizeof(precomp_block));
-         actual = blocks[addr>>12];
-         blocks[addr>>12]->code = NULL;
-         blocks[addr>>12]->block = NULL;
-         blocks[addr>>12]->jumps_table = NULL;
-         blocks[addr>>12]->riprel_table = NULL;
+         /* stop is set, dyna_jump() leaves the recompiled code */
+         if (r4300emu == CORE_DYNAREC) dyna_jump();
+         return;
       }
-    blocks[addr>>12]->start = addr & ~0xFFF;
-    blocks[addr>>12]->end = (addr & ~0xFFF) + 0x1000;
-    init_block(blocks[addr>>12]);
      }
    PC=actual->block+((addr-actual->start)>>2);
    
-   if (r4300emu == CORE_DYNAREC) dyna_jump();
+   if (r4300emu == CORE_DYNAREC)
+     {
+    code_cache_touch(actual);
+    dyna_jump();
+     }
 }
 #undef addr
 
+/* Returns the block for the page holding addr, creating it and its
+ * block_page if needed. The returned block isn't initialized. */
+precomp_block *get_or_alloc_block(uint32_t addr)
+{
+   uint32_t page = addr >> 12;
+   struct block_page *bp = block_dir[page >> BLOCK_PAGE_BITS];
+   precomp_block **slot;
+
+   if (bp == &empty_block_page)
+   {
+      bp = (struct block_page *) malloc(sizeof(struct block_page));
+      if (bp == NULL)
+         return NULL;
+      memset(bp->invalid_code, 1, sizeof(bp->invalid_code));
+      memset(bp->blocks, 0, sizeof(bp->blocks));
+      bp->next = block_pages;
+      bp->dir_index = page >> BLOCK_PAGE_BITS;
+      block_pages = bp;
+      block_dir[page >> BLOCK_PAGE_BITS] = bp;
+   }
+
+   slot = &bp->blocks[page & (BLOCK_PAGE_SIZE - 1)];
+   if (*slot == NULL)
+   {
+      *slot = (precomp_block *) malloc(sizeof(precomp_block));
+      if (*slot == NULL)
+         return NULL;
+      (*slot)->code = NULL;
+      (*slot)->block = NULL;
+      (*slot)->info = NULL;
+      (*slot)->jumps_table = NULL;
+      (*slot)->riprel_table = NULL;
+      (*slot)->lru_prev = NULL;
+      (*slot)->lru_next = NULL;
+      (*slot)->lru_referenced = 0;
+      (*slot)->adler32 = 0;
+      (*slot)->links_in = NULL;
+      (*slot)->links_out = NULL;
+   }
+   (*slot)->start = addr & ~UINT32_C(0xFFF);
+   (*slot)->end = (addr & ~UINT32_C(0xFFF)) + UINT32_C(0x1000);
+
+   return *slot;
+}
+
 void init_blocks(void)
 {
    int i;
-   for (i=0; i<0x100000; i++)
+
+   /* only the first call has to fill the directory,
+    * free_blocks() puts back the shared page where it removes one */
+   if (block_dir[0] == NULL)
    {
-      invalid_code[i] = 1;
-      blocks[i] = NULL;
+      memset(empty_block_page.invalid_code, 1, sizeof(empty_block_page.invalid_code));
+      for (i=0; i<BLOCK_DIR_SIZE; i++)
+         block_dir[i] = &empty_block_page;
    }
+
+#ifdef NEW_DYNAREC
+   if (r4300emu == CORE_DYNAREC)
+      memset(invalid_code, 1, sizeof(invalid_code));
+#endif
 }
 
 void free_blocks(void)
 {
    int i;
-   for (i=0; i<0x100000; i++)
+
+   while (block_pages != NULL)
    {
-        if (blocks[i])
-        {
-            free_block(blocks[i]);
-            free(blocks[i]);
-            blocks[i] = NULL;
-        }
-    }
+      struct block_page *bp = block_pages;
+      block_pages = bp->next;
+
+      for (i=0; i<BLOCK_PAGE_SIZE; i++)
+      {
+         if (bp->blocks[i])
+         {
+            free_block(bp->blocks[i]);
+            free(bp->blocks[i]);
+         }
+      }
+
+      block_dir[bp->dir_index] = &empty_block_page;
+      free(bp);
+   }
 }
 
 void invalidate_cached_code_hacktarux(uint32_t address, size_t size)
 {
-    size_t i;
     uint32_t addr;
-    uint32_t addr_max;
+    uint32_t addr_end;
+    uint32_t page_end;
+    precomp_block *block;
 
     if (size == 0)
     {
-        /* invalidate everthing */
-        memset(invalid_code, 1, 0x100000);
+        /* invalidate everthing, pages without a block_page already are */
+        struct block_page *bp;
+        for (bp = block_pages; bp != NULL; bp = bp->next)
+            memset(bp->invalid_code, 1, sizeof(bp->invalid_code));
+        return;
     }
-    else
+
+    /* invalidate blocks (if necessary), a page at a time */
+    addr_end = address + (uint32_t)size;
+
+    for (addr = address; addr < addr_end; addr = page_end)
     {
-        /* invalidate blocks (if necessary) */
-        addr_max = address+size;
+        page_end = (addr | 0xfff) + 1;
+        if (page_end == 0 || page_end > addr_end)
+            page_end = addr_end;
+
+        if (get_invalid_code(addr >> 12))
+            continue;
 
-        for(addr = address; addr < addr_max; addr += 4)
+        block = get_block(addr >> 12);
+        if (block == NULL)
         {
-            i = (addr >> 12);
+            set_invalid_code(addr >> 12, 1);
+            continue;
+        }
 
-            if (invalid_code[i] == 0)
-            {
-                if (blocks[i] == NULL
-                || blocks[i]->block[(addr & 0xfff) / 4].ops != current_instruction_table.NOTCOMPILED)
-                {
-                    invalid_code[i] = 1;
-                    /* go directly to next i */
-                    addr &= ~0xfff;
-                    addr |= 0xffc;
-                }
-            }
-            else
+        /* only words which have been compiled matter */
+        for (; addr < page_end; addr += 4)
+        {
+            if (block->block[(addr & 0xfff) / 4].ops != current_instruction_table.NOTCOMPILED)
             {
-                /* go directly to next i */
-                addr &= ~0xfff;
-                addr |= 0xffc;
+                set_invalid_code(addr >> 12, 1);
+                break;
             }
         }
     }
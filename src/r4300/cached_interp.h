@@ -26,15 +26,51 @@
 #include <stdint.h>
 
 #include "ops.h"
+#include "osal/preproc.h"
 /* FIXME: use forward declaration for precomp_block */
 #include "recomp.h"
 
-extern char invalid_code[0x100000];
-extern precomp_block *blocks[0x100000];
+/* Compiled blocks are looked up by 4KB page through a two-level table:
+ * block_dir[page >> BLOCK_PAGE_BITS] points to a block_page covering
+ * BLOCK_PAGE_SIZE consecutive pages. A block_page is only allocated when
+ * one of its pages gets a block, the other directory entries point to a
+ * shared page in which every entry is invalid and has no block. */
+#define BLOCK_PAGE_BITS 8
+#define BLOCK_PAGE_SIZE (1 << BLOCK_PAGE_BITS)
+#define BLOCK_DIR_SIZE (0x100000 >> BLOCK_PAGE_BITS)
+
+struct block_page
+{
+    /* must stay first, the recompilers index it directly */
+    char invalid_code[BLOCK_PAGE_SIZE];
+    precomp_block *blocks[BLOCK_PAGE_SIZE];
+    struct block_page *next;
+    uint32_t dir_index;
+};
+
+extern struct block_page *block_dir[BLOCK_DIR_SIZE];
 extern precomp_block *actual;
 extern uint32_t jump_to_address;
 extern const cpu_instruction_table cached_interpreter_table;
 
+static osal_inline char get_invalid_code(uint32_t page)
+{
+    return block_dir[page >> BLOCK_PAGE_BITS]->invalid_code[page & (BLOCK_PAGE_SIZE - 1)];
+}
+
+/* A page can only be marked valid once get_or_alloc_block() created its block */
+static osal_inline void set_invalid_code(uint32_t page, char invalid)
+{
+    block_dir[page >> BLOCK_PAGE_BITS]->invalid_code[page & (BLOCK_PAGE_SIZE - 1)] = invalid;
+}
+
+static osal_inline precomp_block *get_block(uint32_t page)
+{
+    return block_dir[page >> BLOCK_PAGE_BITS]->blocks[page & (BLOCK_PAGE_SIZE - 1)];
+}
+
+precomp_block *get_or_alloc_block(uint32_t addr);
+
 void init_blocks(void);
 void free_blocks(void);
 void jump_to_func(void);
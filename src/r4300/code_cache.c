@@ -0,0 +1,332 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - code_cache.c                                            *
+ *   Mupen64Plus homepage: http://code.google.com/p/mupen64plus/           *
+ *   Copyright (C) 2015 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(WIN32)
+#include <windows.h>
+#elif defined(__GNUC__)
+#include <sys/mman.h>
+#endif
+
+#include "api/callbacks.h"
+#include "api/m64p_types.h"
+#include "cached_interp.h"
+#include "code_cache.h"
+#include "recomp.h"
+#include "recomph.h"
+
+int code_cache_size_mb = 128;
+
+static unsigned char *arena;
+static size_t arena_units;
+static unsigned char *unit_used;
+static size_t units_used;
+
+/* most and least recently used blocks holding code */
+static precomp_block *lru_head;
+static precomp_block *lru_tail;
+
+/* the block running when the current compilation started */
+static const precomp_block *running_block;
+
+static m64p_code_cache_stats stats;
+
+static size_t size_to_units(size_t size)
+{
+   return (size + CODE_CACHE_UNIT - 1) / CODE_CACHE_UNIT;
+}
+
+static void mark_units(size_t first, size_t count, unsigned char used)
+{
+   memset(unit_used + first, used, count);
+   if (used)
+      units_used += count;
+   else
+      units_used -= count;
+}
+
+/* returns the first run of count free units, arena_units if there is none */
+static size_t find_free_units(size_t count)
+{
+   size_t i, run = 0;
+
+   for (i = 0; i < arena_units; i++)
+   {
+      if (unit_used[i])
+         run = 0;
+      else if (++run == count)
+         return i + 1 - count;
+   }
+
+   return arena_units;
+}
+
+static int is_tracked(const precomp_block *block)
+{
+   return block->lru_prev != NULL || lru_head == block;
+}
+
+static void evict(precomp_block *block)
+{
+   code_cache_forget(block);
+   dyna_unlink_block(block);
+   code_cache_free(block->code, block->max_code_length);
+   block->code = NULL;
+   block->code_length = 0;
+   block->max_code_length = 0;
+   /* a TLB remap must not revalidate the page without code */
+   block->adler32 = 0;
+   /* init_block() will give it new code on the next jump */
+   set_invalid_code(block->start >> 12, 1);
+   ++stats.evictions;
+}
+
+/* The running block is kept with the block being compiled: FIN_BLOCK goes
+ * back to it after the jump. Linked jumps between blocks don't go through
+ * code_cache_touch(), they set lru_referenced instead, which gives the
+ * block a second chance at the head of the list. */
+static int evict_lru(void)
+{
+   precomp_block *block, *prev;
+
+   for (block = lru_tail; block != NULL; block = prev)
+   {
+      prev = block->lru_prev;
+      if (block == dst_block || block == actual || block == running_block)
+         continue;
+      if (block->lru_referenced)
+      {
+         code_cache_touch(block);
+         continue;
+      }
+      evict(block);
+      return 1;
+   }
+
+   return 0;
+}
+
+int code_cache_init(void)
+{
+   size_t size;
+
+   if (code_cache_size_mb < CODE_CACHE_MIN_SIZE_MB)
+      code_cache_size_mb = CODE_CACHE_MIN_SIZE_MB;
+   size = (size_t) code_cache_size_mb << 20;
+
+   arena = (unsigned char *) malloc_exec(size);
+   if (arena == NULL)
+      return 0;
+
+   arena_units = size / CODE_CACHE_UNIT;
+   unit_used = (unsigned char *) calloc(arena_units, 1);
+   if (unit_used == NULL)
+   {
+      free_exec(arena, size);
+      arena = NULL;
+      return 0;
+   }
+
+   units_used = 0;
+   lru_head = lru_tail = NULL;
+   running_block = NULL;
+   memset(&stats, 0, sizeof(stats));
+   stats.bytes_limit = size;
+
+   DebugMessage(M64MSG_VERBOSE, "Code cache: %i MB at %p", code_cache_size_mb, arena);
+   return 1;
+}
+
+void code_cache_deinit(void)
+{
+   if (arena == NULL)
+      return;
+
+   free_exec(arena, arena_units * CODE_CACHE_UNIT);
+   free(unit_used);
+   arena = NULL;
+   unit_used = NULL;
+   arena_units = 0;
+   units_used = 0;
+   lru_head = lru_tail = NULL;
+}
+
+void *code_cache_alloc(size_t size)
+{
+   size_t count = size_to_units(size);
+   size_t first;
+
+   while ((first = find_free_units(count)) == arena_units)
+   {
+      if (!evict_lru())
+      {
+         DebugMessage(M64MSG_ERROR, "Code cache: couldn't find %zi bytes, CodeCacheSize is too small", size);
+         return NULL;
+      }
+   }
+
+   mark_units(first, count, 1);
+   return arena + first * CODE_CACHE_UNIT;
+}
+
+void *code_cache_realloc(void *ptr, size_t oldsize, size_t newsize)
+{
+   size_t first = ((unsigned char *) ptr - arena) / CODE_CACHE_UNIT;
+   size_t oldcount = size_to_units(oldsize);
+   size_t newcount = size_to_units(newsize);
+   size_t i;
+   void *block;
+
+   if (newcount <= oldcount)
+      return ptr;
+
+   /* grow in place when the following units are free */
+   for (i = first + oldcount; i < first + newcount && i < arena_units; i++)
+   {
+      if (unit_used[i])
+         break;
+   }
+   if (i == first + newcount)
+   {
+      mark_units(first + oldcount, newcount - oldcount, 1);
+      return ptr;
+   }
+
+   block = code_cache_alloc(newsize);
+   if (block != NULL)
+      memcpy(block, ptr, oldsize);
+   code_cache_free(ptr, oldsize);
+   return block;
+}
+
+void code_cache_free(void *ptr, size_t size)
+{
+   if (ptr == NULL)
+      return;
+
+   mark_units(((unsigned char *) ptr - arena) / CODE_CACHE_UNIT, size_to_units(size), 0);
+}
+
+int code_cache_contains(const void *ptr, size_t size)
+{
+   const unsigned char *p = (const unsigned char *) ptr;
+
+   return arena != NULL && p >= arena && size <= arena_units * CODE_CACHE_UNIT
+       && (size_t)(p - arena) <= arena_units * CODE_CACHE_UNIT - size;
+}
+
+void code_cache_touch(precomp_block *block)
+{
+   block->lru_referenced = 0;
+   if (lru_head == block)
+      return;
+
+   code_cache_forget(block);
+   block->lru_next = lru_head;
+   if (lru_head != NULL)
+      lru_head->lru_prev = block;
+   else
+      lru_tail = block;
+   lru_head = block;
+}
+
+void code_cache_track(precomp_block *block)
+{
+   if (!is_tracked(block))
+      code_cache_touch(block);
+}
+
+void code_cache_forget(precomp_block *block)
+{
+   if (!is_tracked(block))
+      return;
+
+   if (block->lru_prev != NULL)
+      block->lru_prev->lru_next = block->lru_next;
+   else
+      lru_head = block->lru_next;
+   if (block->lru_next != NULL)
+      block->lru_next->lru_prev = block->lru_prev;
+   else
+      lru_tail = block->lru_prev;
+   block->lru_prev = NULL;
+   block->lru_next = NULL;
+}
+
+void code_cache_set_running(const precomp_block *block)
+{
+   running_block = block;
+}
+
+void code_cache_count_compile(long long int nsec)
+{
+   ++stats.blocks_compiled;
+   stats.recompile_nsec += nsec;
+}
+
+void code_cache_get_stats(m64p_code_cache_stats *out)
+{
+   *out = stats;
+   out->bytes_used = (uint64_t) units_used * CODE_CACHE_UNIT;
+}
+
+/**********************************************************************
+ ************** allocate memory with executable bit set ***************
+ **********************************************************************/
+void *malloc_exec(size_t size)
+{
+#if defined(WIN32)
+   return VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+#elif defined(__GNUC__)
+
+   #ifndef  MAP_ANONYMOUS
+      #ifdef MAP_ANON
+         #define MAP_ANONYMOUS MAP_ANON
+      #endif
+   #endif
+
+   void *block = mmap(NULL, size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if (block == MAP_FAILED)
+       { DebugMessage(M64MSG_ERROR, "Memory error: couldn't allocate %zi byte block of aligned RWX memory.", size); return NULL; }
+
+   return block;
+#else
+   return malloc(size);
+#endif
+}
+
+/**********************************************************************
+ **************** frees memory with executable bit set ****************
+ **********************************************************************/
+void free_exec(void *ptr, size_t length)
+{
+#if defined(WIN32)
+   VirtualFree(ptr, 0, MEM_RELEASE);
+#elif defined(__GNUC__)
+   munmap(ptr, length);
+#else
+   free(ptr);
+#endif
+}
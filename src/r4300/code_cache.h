@@ -0,0 +1,70 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - code_cache.h                                            *
+ *   Mupen64Plus homepage: http://code.google.com/p/mupen64plus/           *
+ *   Copyright (C) 2015 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef M64P_R4300_CODE_CACHE_H
+#define M64P_R4300_CODE_CACHE_H
+
+#include <stddef.h>
+
+#include "api/m64p_types.h"
+
+struct _precomp_block;
+
+/* The dynamic recompiler emits block code in a single executable arena of
+ * code_cache_size_mb megabytes, allocated in CODE_CACHE_UNIT sized units.
+ * Blocks holding code are kept in LRU order, and when the arena is full
+ * the least recently used ones lose their code: their page is marked
+ * invalid so that the next jump there initializes and recompiles them.
+ * Jumps through jump_to_func() move their block to the head of the list;
+ * linked jumps only set its lru_referenced flag, which is looked at when
+ * the block reaches the tail. */
+#define CODE_CACHE_UNIT 4096
+#define CODE_CACHE_MIN_SIZE_MB 8
+
+extern int code_cache_size_mb;
+
+int code_cache_init(void);
+void code_cache_deinit(void);
+
+void *code_cache_alloc(size_t size);
+void *code_cache_realloc(void *ptr, size_t oldsize, size_t newsize);
+void code_cache_free(void *ptr, size_t size);
+/* non-zero if [ptr, ptr+size) lies in the arena */
+int code_cache_contains(const void *ptr, size_t size);
+
+/* the block was just jumped to */
+void code_cache_touch(struct _precomp_block *block);
+/* the block got code, make it the most recently used one */
+void code_cache_track(struct _precomp_block *block);
+/* the block must not be evicted until the next code_cache_track() */
+void code_cache_forget(struct _precomp_block *block);
+/* the block is running, jump_to_func() may return into it */
+void code_cache_set_running(const struct _precomp_block *block);
+
+void code_cache_count_compile(long long int nsec);
+void code_cache_get_stats(m64p_code_cache_stats *stats);
+
+/* executable memory outside of the arena */
+void *malloc_exec(size_t size);
+void free_exec(void *ptr, size_t length);
+
+#endif
@@ -1048,3 +1048,7 @@ void dyna_stop()
 {
 }
 
+void dyna_unlink_block(precomp_block *block)
+{
+}
+
@@ -0,0 +1,318 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - idle_loop.c                                             *
+ *   Mupen64Plus homepage: http://code.google.com/p/mupen64plus/           *
+ *   Copyright (C) 2015 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+/* Detection of idle loops: short loops which only poll memory until an
+ * interrupt changes what they read. The recompilers use it to fast-forward
+ * COUNT to the next event instead of spinning, just like they already do for
+ * jumps to themselves.
+ *
+ * A loop is considered idle when:
+ * - it ends with a backward branch, and only has loads and simple integer
+ *   operations besides that branch;
+ * - no register value is carried from one iteration to the next, so each
+ *   iteration computes the same thing as long as memory doesn't change;
+ * - its loads are at constant addresses in RDRAM or in the VI, AI and SI
+ *   registers, which only change when an event is processed. VI_CURRENT_REG
+ *   and AI_LEN_REG are excluded: they are derived from COUNT.
+ *
+ * The load addresses are found by following the constants built by LUI,
+ * ADDIU and ORI, in the loop itself or in the straight-line code before it. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "idle_loop.h"
+#include "ai/ai_controller.h"
+#include "main/main.h"
+#include "si/si_controller.h"
+#include "vi/vi_controller.h"
+
+enum idle_loop_op
+{
+    IDLE_LOOP_OP_OTHER,
+    IDLE_LOOP_OP_ALU,
+    IDLE_LOOP_OP_LOAD,
+    IDLE_LOOP_OP_STORE,
+    IDLE_LOOP_OP_BRANCH
+};
+
+struct idle_loop_instr
+{
+    enum idle_loop_op op;
+    uint32_t reads;     /* mask of the source registers */
+    unsigned int dest;  /* destination register, 0 if none */
+};
+
+struct idle_loop_consts
+{
+    uint32_t known;     /* mask of the registers holding a constant */
+    uint32_t value[32];
+};
+
+#define RS_OF(w)      (((w) >> 21) & 0x1F)
+#define RT_OF(w)      (((w) >> 16) & 0x1F)
+#define RD_OF(w)      (((w) >> 11) & 0x1F)
+#define IMM16S_OF(w)  ((int16_t) (w))
+#define IMM16U_OF(w)  ((uint16_t) (w))
+#define REG_BIT(r)    (UINT32_C(1) << (r))
+
+static void decode(uint32_t w, struct idle_loop_instr* instr)
+{
+    instr->op = IDLE_LOOP_OP_OTHER;
+    instr->reads = 0;
+    instr->dest = 0;
+
+    switch(w >> 26)
+    {
+    case 0x00: /* SPECIAL */
+        switch(w & 0x3F)
+        {
+        case 0x00: case 0x02: case 0x03: /* SLL, SRL, SRA */
+            instr->op = IDLE_LOOP_OP_ALU;
+            instr->reads = REG_BIT(RT_OF(w));
+            instr->dest = RD_OF(w);
+            break;
+        case 0x04: case 0x06: case 0x07: /* SLLV, SRLV, SRAV */
+        case 0x21: case 0x23: /* ADDU, SUBU */
+        case 0x24: case 0x25: case 0x26: case 0x27: /* AND, OR, XOR, NOR */
+        case 0x2A: case 0x2B: /* SLT, SLTU */
+            instr->op = IDLE_LOOP_OP_ALU;
+            instr->reads = REG_BIT(RS_OF(w)) | REG_BIT(RT_OF(w));
+            instr->dest = RD_OF(w);
+            break;
+        }
+        break;
+
+    case 0x01: /* REGIMM: BLTZ, BGEZ, BLTZL, BGEZL */
+        if (RT_OF(w) <= 0x03)
+        {
+            instr->op = IDLE_LOOP_OP_BRANCH;
+            instr->reads = REG_BIT(RS_OF(w));
+        }
+        break;
+
+    case 0x02: /* J */
+        instr->op = IDLE_LOOP_OP_BRANCH;
+        break;
+
+    case 0x04: case 0x05: case 0x14: case 0x15: /* BEQ, BNE, BEQL, BNEL */
+        instr->op = IDLE_LOOP_OP_BRANCH;
+        instr->reads = REG_BIT(RS_OF(w)) | REG_BIT(RT_OF(w));
+        break;
+
+    case 0x06: case 0x07: case 0x16: case 0x17: /* BLEZ, BGTZ, BLEZL, BGTZL */
+        instr->op = IDLE_LOOP_OP_BRANCH;
+        instr->reads = REG_BIT(RS_OF(w));
+        break;
+
+    case 0x09: case 0x0A: case 0x0B: /* ADDIU, SLTI, SLTIU */
+    case 0x0C: case 0x0D: case 0x0E: /* ANDI, ORI, XORI */
+        instr->op = IDLE_LOOP_OP_ALU;
+        instr->reads = REG_BIT(RS_OF(w));
+        instr->dest = RT_OF(w);
+        break;
+
+    case 0x0F: /* LUI */
+        instr->op = IDLE_LOOP_OP_ALU;
+        instr->dest = RT_OF(w);
+        break;
+
+    case 0x20: case 0x21: case 0x23: /* LB, LH, LW */
+    case 0x24: case 0x25: case 0x27: /* LBU, LHU, LWU */
+    case 0x37: /* LD */
+        instr->op = IDLE_LOOP_OP_LOAD;
+        instr->reads = REG_BIT(RS_OF(w));
+        instr->dest = RT_OF(w);
+        break;
+
+    case 0x28: case 0x29: case 0x2B: case 0x3F: /* SB, SH, SW, SD */
+        instr->op = IDLE_LOOP_OP_STORE;
+        instr->reads = REG_BIT(RS_OF(w)) | REG_BIT(RT_OF(w));
+        break;
+    }
+
+    /* reads of r0 never depend on anything */
+    instr->reads &= ~REG_BIT(0);
+}
+
+static int get_const(const struct idle_loop_consts* consts, unsigned int reg, uint32_t* value)
+{
+    if (reg == 0)
+    {
+        *value = 0;
+        return 1;
+    }
+
+    if (!(consts->known & REG_BIT(reg)))
+        return 0;
+
+    *value = consts->value[reg];
+    return 1;
+}
+
+static void update_consts(struct idle_loop_consts* consts, uint32_t w, const struct idle_loop_instr* instr)
+{
+    uint32_t value;
+    int known;
+
+    if (instr->op == IDLE_LOOP_OP_OTHER)
+    {
+        /* we don't know what it does to the registers */
+        consts->known = 0;
+        return;
+    }
+
+    if (instr->dest == 0)
+        return;
+
+    switch(w >> 26)
+    {
+    case 0x09: /* ADDIU */
+        known = get_const(consts, RS_OF(w), &value);
+        value += (uint32_t) IMM16S_OF(w);
+        break;
+    case 0x0D: /* ORI */
+        known = get_const(consts, RS_OF(w), &value);
+        value |= IMM16U_OF(w);
+        break;
+    case 0x0F: /* LUI */
+        known = 1;
+        value = (uint32_t) IMM16U_OF(w) << 16;
+        break;
+    default:
+        known = 0;
+        value = 0;
+        break;
+    }
+
+    if (known)
+    {
+        consts->known |= REG_BIT(instr->dest);
+        consts->value[instr->dest] = value;
+    }
+    else
+    {
+        consts->known &= ~REG_BIT(instr->dest);
+    }
+}
+
+static int is_straight_line(uint32_t w)
+{
+    struct idle_loop_instr instr;
+    decode(w, &instr);
+
+    return instr.op == IDLE_LOOP_OP_ALU
+        || instr.op == IDLE_LOOP_OP_LOAD
+        || instr.op == IDLE_LOOP_OP_STORE;
+}
+
+static int is_idle_loop_address(uint32_t address)
+{
+    /* TLB mapped addresses could point anywhere */
+    if ((address & UINT32_C(0xC0000000)) != UINT32_C(0x80000000))
+        return 0;
+
+    address &= UINT32_C(0x1FFFFFFF);
+
+    if (address < RDRAM_MAX_SIZE)
+        return 1;
+
+    switch(address >> 16)
+    {
+    case 0x0440:
+        return (address & 0xFFFF) < 4*VI_REGS_COUNT
+            && (address & 0xFFFC) != 4*VI_CURRENT_REG;
+    case 0x0450:
+        return (address & 0xFFFF) < 4*AI_REGS_COUNT
+            && (address & 0xFFFC) != 4*AI_LEN_REG;
+    case 0x0480:
+        return (address & 0xFFFF) < 4*SI_REGS_COUNT;
+    default:
+        return 0;
+    }
+}
+
+/* Determines whether the backward branch at 'branch' closes an idle loop
+ * beginning at 'loop'. The instructions from 'code' to the loop are looked
+ * at to find the constant base addresses of the loads. */
+int is_idle_loop(const uint32_t* code, const uint32_t* loop, const uint32_t* branch)
+{
+    struct idle_loop_instr instrs[IDLE_LOOP_MAX_LENGTH];
+    struct idle_loop_consts consts;
+    uint32_t loop_writes = 0, written = 0, address;
+    const uint32_t* start;
+    ptrdiff_t length, i;
+
+    if (loop > branch)
+        return 0;
+
+    length = branch - loop + 2;
+    if (length > IDLE_LOOP_MAX_LENGTH)
+        return 0;
+
+    for(i = 0; i < length; ++i)
+    {
+        decode(loop[i], &instrs[i]);
+
+        if ((loop + i == branch)
+                ? instrs[i].op != IDLE_LOOP_OP_BRANCH
+                : (instrs[i].op != IDLE_LOOP_OP_ALU && instrs[i].op != IDLE_LOOP_OP_LOAD))
+            return 0;
+
+        loop_writes |= REG_BIT(instrs[i].dest);
+    }
+    loop_writes &= ~REG_BIT(0);
+
+    /* follow the constants from the straight-line code before the loop */
+    consts.known = 0;
+    for(start = loop; start > code && loop - start < IDLE_LOOP_MAX_LENGTH; --start)
+    {
+        /* delay slots are excluded as well */
+        if (!is_straight_line(start[-1]) || (start - 1 > code && !is_straight_line(start[-2])))
+            break;
+    }
+    for(; start < loop; ++start)
+    {
+        struct idle_loop_instr instr;
+        decode(*start, &instr);
+        update_consts(&consts, *start, &instr);
+    }
+
+    for(i = 0; i < length; ++i)
+    {
+        /* a value computed by a previous iteration */
+        if (instrs[i].reads & loop_writes & ~written)
+            return 0;
+
+        if (instrs[i].op == IDLE_LOOP_OP_LOAD)
+        {
+            if (!get_const(&consts, RS_OF(loop[i]), &address)
+                    || !is_idle_loop_address(address + (uint32_t) IMM16S_OF(loop[i])))
+                return 0;
+        }
+
+        update_consts(&consts, loop[i], &instrs[i]);
+        written |= REG_BIT(instrs[i].dest);
+    }
+
+    return 1;
+}
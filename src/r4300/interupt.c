@@ -33,8 +33,10 @@
 #include "api/m64p_types.h"
 #include "cached_interp.h"
 #include "cp0_private.h"
+#include "device/device.h"
 #include "exception.h"
 #include "main/main.h"
+#include "main/rewind.h"
 #include "main/savestates.h"
 #include "mi_controller.h"
 #include "new_dynarec/new_dynarec.h"
@@ -50,114 +52,147 @@
 
 int interupt_unsafe_state = 0;
 
-struct interrupt_event
-{
-    int type;
-    unsigned int count;
-};
-
 
 /***************************************************************************
- * Pool of Single Linked List Nodes
+ * Interrupt Queue
  **************************************************************************/
-#define POOL_CAPACITY 16
 
-struct node
-{
-    struct interrupt_event data;
-    struct node *next;
-};
+#define COUNT_PERIOD UINT64_C(0x100000000)
 
-struct pool
+static int event_slot(int type)
 {
-    struct node nodes[POOL_CAPACITY];
-    struct node* stack[POOL_CAPACITY];
-    size_t index;
-};
+    int slot = 0;
+
+    if (type <= 0 || (type & (type - 1)) != 0)
+        return -1;
 
-static struct node* alloc_node(struct pool* p);
-static void free_node(struct pool* p, struct node* node);
-static void clear_pool(struct pool* p);
+    for(; type > 1; type >>= 1)
+        ++slot;
 
+    return (slot < INTERRUPT_TYPES) ? slot : -1;
+}
 
-/* node allocation/deallocation on a given pool */
-static struct node* alloc_node(struct pool* p)
+static int before_event(const struct interrupt_event* e1, const struct interrupt_event* e2)
 {
-    /* return NULL if pool is too small */
-    if (p->index >= POOL_CAPACITY)
-        return NULL;
+    return (e1->count != e2->count)
+        ? e1->count < e2->count
+        : e1->order < e2->order;
+}
 
-    return p->stack[p->index++];
+static void set_heap_event(struct interrupt_queue* q, size_t i, const struct interrupt_event* event)
+{
+    q->heap[i] = *event;
+    q->index[event_slot(event->type)] = (int)i;
 }
 
-static void free_node(struct pool* p, struct node* node)
+static void sift_up(struct interrupt_queue* q, size_t i)
 {
-    if (p->index == 0 || node == NULL)
-        return;
+    struct interrupt_event event = q->heap[i];
 
-    p->stack[--p->index] = node;
+    while (i > 0 && before_event(&event, &q->heap[(i - 1) / 2]))
+    {
+        set_heap_event(q, i, &q->heap[(i - 1) / 2]);
+        i = (i - 1) / 2;
+    }
+
+    set_heap_event(q, i, &event);
 }
 
-/* release all nodes */
-static void clear_pool(struct pool* p)
+static void sift_down(struct interrupt_queue* q, size_t i)
 {
-    size_t i;
+    struct interrupt_event event = q->heap[i];
+    size_t child;
 
-    for(i = 0; i < POOL_CAPACITY; ++i)
-        p->stack[i] = &p->nodes[i];
+    while ((child = 2 * i + 1) < q->size)
+    {
+        if (child + 1 < q->size && before_event(&q->heap[child + 1], &q->heap[child]))
+            ++child;
 
-    p->index = 0;
-}
+        if (!before_event(&q->heap[child], &event))
+            break;
 
-/***************************************************************************
- * Interrupt Queue
- **************************************************************************/
+        set_heap_event(q, i, &q->heap[child]);
+        i = child;
+    }
 
-struct interrupt_queue
-{
-    struct pool pool;
-    struct node* first;
-};
+    set_heap_event(q, i, &event);
+}
 
-static struct interrupt_queue q;
+static void remove_heap_event(struct interrupt_queue* q, size_t i)
+{
+    q->index[event_slot(q->heap[i].type)] = -1;
 
+    if (i != --q->size)
+    {
+        set_heap_event(q, i, &q->heap[q->size]);
+        sift_down(q, i);
+        sift_up(q, i);
+    }
+}
 
 static void clear_queue(void)
 {
-    q.first = NULL;
-    clear_pool(&q.pool);
+    struct interrupt_queue* q = &g_dev.r4300.q;
+    size_t i;
+
+    for(i = 0; i < INTERRUPT_TYPES; ++i)
+        q->index[i] = -1;
+
+    q->size = 0;
+    q->base = 0;
+    q->order = 0;
 }
 
+/* next_interupt is compared against the 32-bit COUNT register. Events past
+ * the next wrap-around can't be expressed that way, so in that case
+ * gen_interupt is requested right away and SPECIAL_INT waits for the wrap. */
+static void update_next_interupt(void)
+{
+    const struct interrupt_queue* q = &g_dev.r4300.q;
 
-static int SPECIAL_done = 0;
+    next_interupt = (q->size > 0 && q->heap[0].count - q->base < COUNT_PERIOD)
+        ? (uint32_t)(q->heap[0].count - q->base)
+        : 0;
+}
 
-static int before_event(unsigned int evt1, unsigned int evt2, int type2)
+/* converts a 32-bit count to a 64-bit one, relative to the given COUNT value */
+static uint64_t event_count(int type, unsigned int count, uint32_t current)
 {
-    if(evt1 - g_cp0_regs[CP0_COUNT_REG] < UINT32_C(0x80000000))
+    const struct interrupt_queue* q = &g_dev.r4300.q;
+    uint64_t now = q->base + current;
+
+    switch(type)
     {
-        if(evt2 - g_cp0_regs[CP0_COUNT_REG] < UINT32_C(0x80000000))
-        {
-            if((evt1 - g_cp0_regs[CP0_COUNT_REG]) < (evt2 - g_cp0_regs[CP0_COUNT_REG])) return 1;
-            else return 0;
-        }
-        else
-        {
-            if((g_cp0_regs[CP0_COUNT_REG] - evt2) < UINT32_C(0x10000000))
-            {
-                switch(type2)
-                {
-                    case SPECIAL_INT:
-                        if(SPECIAL_done) return 1;
-                        else return 0;
-                        break;
-                    default:
-                        return 0;
-                }
-            }
-            else return 1;
-        }
+        case SPECIAL_INT:
+            return q->base + COUNT_PERIOD;
+
+        case COMPARE_INT:
+            /* COMPARE can be up to a whole COUNT period ahead */
+            return now + (uint32_t)(count - current);
+
+        default:
+            /* other events are scheduled a short delay ahead:
+             * those already due (e.g. when loading a state) fire right away */
+            return ((int32_t)(count - current) > 0)
+                ? now + (uint32_t)(count - current)
+                : now;
     }
-    else return 0;
+}
+
+static void schedule_event(int type, uint64_t count)
+{
+    struct interrupt_queue* q = &g_dev.r4300.q;
+    struct interrupt_event event;
+
+    event.type = type;
+    event.count = count;
+    event.order = q->order++;
+
+    set_heap_event(q, q->size++, &event);
+    sift_up(q, q->size - 1);
+
+    if (q->heap[0].type == type)
+        update_next_interupt();
 }
 
 void add_interupt_event(int type, unsigned int delay)
@@ -167,15 +202,15 @@ void add_interupt_event(int type, unsigned int delay)
 
 void add_interupt_event_count(int type, unsigned int count)
 {
-    struct node* event;
-    struct node* e;
-    int special;
+    int slot = event_slot(type);
 
-    special = (type == SPECIAL_INT);
-   
-    if(g_cp0_regs[CP0_COUNT_REG] > UINT32_C(0x80000000)) SPECIAL_done = 0;
-   
-    if (get_event(type)) {
+    if (slot < 0)
+    {
+        DebugMessage(M64MSG_ERROR, "Unknown interrupt queue event type %.8X.", type);
+        return;
+    }
+
+    if (g_dev.r4300.q.index[slot] >= 0) {
         DebugMessage(M64MSG_WARNING, "two events of type 0x%x in interrupt queue", type);
         /* FIXME: hack-fix for freezing in Perfect Dark
          * http://code.google.com/p/mupen64plus/issues/detail?id=553
@@ -184,142 +219,93 @@ void add_interupt_event_count(int type, unsigned int count)
         return;
     }
 
-    event = alloc_node(&q.pool);
-    if (event == NULL)
-    {
-        DebugMessage(M64MSG_ERROR, "Failed to allocate node for new interrupt event");
-        return;
-    }
-
-    event->data.count = count;
-    event->data.type = type;
-
-    if (q.first == NULL)
-    {
-        q.first = event;
-        event->next = NULL;
-        next_interupt = q.first->data.count;
-    }
-    else if (before_event(count, q.first->data.count, q.first->data.type) && !special)
-    {
-        event->next = q.first;
-        q.first = event;
-        next_interupt = q.first->data.count;
-    }
-    else
-    {
-        for(e = q.first;
-            e->next != NULL &&
-            (!before_event(count, e->next->data.count, e->next->data.type) || special);
-            e = e->next);
-
-        if (e->next == NULL)
-        {
-            e->next = event;
-            event->next = NULL;
-        }
-        else
-        {
-            if (!special)
-                for(; e->next != NULL && e->next->data.count == count; e = e->next);
-
-            event->next = e->next;
-            e->next = event;
-        }
-    }
+    schedule_event(type, event_count(type, count, g_cp0_regs[CP0_COUNT_REG]));
 }
 
 static void remove_interupt_event(void)
 {
-    struct node* e;
-
-    e = q.first;
-    q.first = e->next;
-    free_node(&q.pool, e);
-
-    next_interupt = (q.first != NULL
-         && (q.first->data.count > g_cp0_regs[CP0_COUNT_REG]
-         || (g_cp0_regs[CP0_COUNT_REG] - q.first->data.count) < UINT32_C(0x80000000)))
-        ? q.first->data.count
-        : 0;
+    remove_heap_event(&g_dev.r4300.q, 0);
+    update_next_interupt();
 }
 
 unsigned int get_event(int type)
 {
-    struct node* e = q.first;
-
-    if (e == NULL)
-        return 0;
+    const struct interrupt_queue* q = &g_dev.r4300.q;
+    int slot = event_slot(type);
 
-    if (e->data.type == type)
-        return e->data.count;
-
-    for(; e->next != NULL && e->next->data.type != type; e = e->next);
-
-    return (e->next != NULL)
-        ? e->next->data.count
+    return (slot >= 0 && q->index[slot] >= 0)
+        ? (unsigned int)(q->heap[q->index[slot]].count - q->base)
         : 0;
 }
 
 int get_next_event_type(void)
 {
-    return (q.first == NULL)
+    return (g_dev.r4300.q.size == 0)
         ? 0
-        : q.first->data.type;
+        : g_dev.r4300.q.heap[0].type;
 }
 
 void remove_event(int type)
 {
-    struct node* to_del;
-    struct node* e = q.first;
+    struct interrupt_queue* q = &g_dev.r4300.q;
+    int slot = event_slot(type);
 
-    if (e == NULL)
+    if (slot < 0 || q->index[slot] < 0)
         return;
 
-    if (e->data.type == type)
-    {
-        q.first = e->next;
-        free_node(&q.pool, e);
-    }
-    else
-    {
-        for(; e->next != NULL && e->next->data.type != type; e = e->next);
-
-        if (e->next != NULL)
-        {
-            to_del = e->next;
-            e->next = to_del->next;
-            free_node(&q.pool, to_del);
-        }
-    }
+    remove_heap_event(q, q->index[slot]);
+    update_next_interupt();
 }
 
 void translate_event_queue(unsigned int base)
 {
-    struct node* e;
+    struct interrupt_queue* q = &g_dev.r4300.q;
+    uint64_t now = q->base + g_cp0_regs[CP0_COUNT_REG];
+    size_t i;
 
     remove_event(COMPARE_INT);
     remove_event(SPECIAL_INT);
 
-    for(e = q.first; e != NULL; e = e->next)
+    /* keep the remaining events at the same distance from COUNT */
+    for(i = 0; i < q->size; ++i)
     {
-        e->data.count = (e->data.count - g_cp0_regs[CP0_COUNT_REG]) + base;
+        q->heap[i].count = (q->heap[i].count > now)
+            ? q->base + base + (q->heap[i].count - now)
+            : q->base + base;
     }
-    add_interupt_event_count(COMPARE_INT, g_cp0_regs[CP0_COMPARE_REG]);
-    add_interupt_event_count(SPECIAL_INT, 0);
+    for(i = q->size / 2; i-- > 0; )
+        sift_down(q, i);
+
+    schedule_event(COMPARE_INT, event_count(COMPARE_INT, g_cp0_regs[CP0_COMPARE_REG], base));
+    schedule_event(SPECIAL_INT, event_count(SPECIAL_INT, 0, base));
+    update_next_interupt();
 }
 
 int save_eventqueue_infos(char *buf)
 {
+    const struct interrupt_queue* q = &g_dev.r4300.q;
+    struct interrupt_event events[INTERRUPT_TYPES];
+    struct interrupt_event event;
+    unsigned int count;
+    size_t i, j;
     int len;
-    struct node* e;
+
+    /* events are saved in the order they will be processed */
+    for(i = 0; i < q->size; ++i)
+    {
+        event = q->heap[i];
+        for(j = i; j > 0 && before_event(&event, &events[j - 1]); --j)
+            events[j] = events[j - 1];
+        events[j] = event;
+    }
 
     len = 0;
 
-    for(e = q.first; e != NULL; e = e->next)
+    for(i = 0; i < q->size; ++i)
     {
-        memcpy(buf + len    , &e->data.type , 4);
-        memcpy(buf + len + 4, &e->data.count, 4);
+        count = (unsigned int)(events[i].count - q->base);
+        memcpy(buf + len    , &events[i].type, 4);
+        memcpy(buf + len + 4, &count         , 4);
         len += 8;
     }
 
@@ -338,52 +324,33 @@ void load_eventqueue_infos(char *buf)
         add_interupt_event_count(type, count);
         len += 8;
     }
+
+    /* PJ64 states don't have it */
+    if (g_dev.r4300.q.index[event_slot(SPECIAL_INT)] < 0)
+        add_interupt_event_count(SPECIAL_INT, 0);
 }
 
 void init_interupt(void)
 {
-    SPECIAL_done = 1;
-
-    g_vi.delay = g_vi.next_vi = 5000;
+    g_dev.vi.delay = g_dev.vi.next_vi = 5000;
 
     clear_queue();
-    add_interupt_event_count(VI_INT, g_vi.next_vi);
+    add_interupt_event_count(VI_INT, g_dev.vi.next_vi);
     add_interupt_event_count(SPECIAL_INT, 0);
 }
 
 void check_interupt(void)
 {
-    struct node* event;
-
-    if (g_r4300.mi.regs[MI_INTR_REG] & g_r4300.mi.regs[MI_INTR_MASK_REG])
+    if (g_dev.r4300.mi.regs[MI_INTR_REG] & g_dev.r4300.mi.regs[MI_INTR_MASK_REG])
         g_cp0_regs[CP0_CAUSE_REG] = (g_cp0_regs[CP0_CAUSE_REG] | UINT32_C(0x400)) & UINT32_C(0xFFFFFF83);
     else
         g_cp0_regs[CP0_CAUSE_REG] &= ~UINT32_C(0x400);
     if ((g_cp0_regs[CP0_STATUS_REG] & UINT32_C(7)) != 1) return;
     if (g_cp0_regs[CP0_STATUS_REG] & g_cp0_regs[CP0_CAUSE_REG] & UINT32_C(0xFF00))
     {
-        event = alloc_node(&q.pool);
-
-        if (event == NULL)
-        {
-            DebugMessage(M64MSG_ERROR, "Failed to allocate node for new interrupt event");
-            return;
-        }
-
-        event->data.count = next_interupt = g_cp0_regs[CP0_COUNT_REG];
-        event->data.type = CHECK_INT;
-
-        if (q.first == NULL)
-        {
-            q.first = event;
-            event->next = NULL;
-        }
-        else
-        {
-            event->next = q.first;
-            q.first = event;
-
-        }
+        remove_event(CHECK_INT);
+        schedule_event(CHECK_INT, g_dev.r4300.q.base + g_cp0_regs[CP0_COUNT_REG]);
+        next_interupt = g_cp0_regs[CP0_COUNT_REG];
     }
 }
 
@@ -419,11 +386,11 @@ void raise_maskable_interrupt(uint32_t cause)
 
 static void special_int_handler(void)
 {
+    /* COUNT hasn't wrapped around yet */
     if (g_cp0_regs[CP0_COUNT_REG] > UINT32_C(0x10000000))
         return;
 
-
-    SPECIAL_done = 1;
+    g_dev.r4300.q.base += COUNT_PERIOD;
     remove_interupt_event();
     add_interupt_event_count(SPECIAL_INT, 0);
 }
@@ -457,13 +424,13 @@ static void nmi_int_handler(void)
     g_cp0_regs[CP0_STATUS_REG] = (g_cp0_regs[CP0_STATUS_REG] & ~UINT32_C(0x00380000)) | UINT32_C(0x00500004);
     g_cp0_regs[CP0_CAUSE_REG]  = 0x00000000;
     // simulate the soft reset code which would run from the PIF ROM
-    r4300_reset_soft();
+    r4300_reset_soft(&g_dev);
     // clear all interrupts, reset interrupt counters back to 0
     g_cp0_regs[CP0_COUNT_REG] = 0;
     g_gs_vi_counter = 0;
     init_interupt();
     // clear the audio status register so that subsequent write_ai() calls will work properly
-    g_ai.regs[AI_STATUS_REG] = 0;
+    g_dev.ai.regs[AI_STATUS_REG] = 0;
     // set ErrorEPC with the last instruction address
     g_cp0_regs[CP0_ERROREPC_REG] = PC->addr;
     // reset the r4300 internal state
@@ -498,7 +465,13 @@ void gen_interupt(void)
     {
         if (savestates_get_job() == savestates_job_load)
         {
-            savestates_load();
+            savestates_load(&g_dev);
+            return;
+        }
+
+        if (rewind_load_pending())
+        {
+            rewind_load(&g_dev);
             return;
         }
 
@@ -515,17 +488,14 @@ void gen_interupt(void)
         uint32_t dest = skip_jump;
         skip_jump = 0;
 
-        next_interupt = (q.first->data.count > g_cp0_regs[CP0_COUNT_REG]
-                || (g_cp0_regs[CP0_COUNT_REG] - q.first->data.count) < UINT32_C(0x80000000))
-            ? q.first->data.count
-            : 0;
+        update_next_interupt();
 
         last_addr = dest;
         generic_jump_to(dest);
         return;
     } 
 
-    switch(q.first->data.type)
+    switch(g_dev.r4300.q.heap[0].type)
     {
         case SPECIAL_INT:
             special_int_handler();
@@ -533,7 +503,7 @@ void gen_interupt(void)
 
         case VI_INT:
             remove_interupt_event();
-            vi_vertical_interrupt_event(&g_vi);
+            vi_vertical_interrupt_event(&g_dev.vi);
             break;
     
         case COMPARE_INT:
@@ -547,27 +517,27 @@ void gen_interupt(void)
     
         case SI_INT:
             remove_interupt_event();
-            si_end_of_dma_event(&g_si);
+            si_end_of_dma_event(&g_dev.si);
             break;
     
         case PI_INT:
             remove_interupt_event();
-            pi_end_of_dma_event(&g_pi);
+            pi_end_of_dma_event(&g_dev.pi);
             break;
     
         case AI_INT:
             remove_interupt_event();
-            ai_end_of_dma_event(&g_ai);
+            ai_end_of_dma_event(&g_dev.ai);
             break;
 
         case SP_INT:
             remove_interupt_event();
-            rsp_interrupt_event(&g_sp);
+            rsp_interrupt_event(&g_dev.sp);
             break;
     
         case DP_INT:
             remove_interupt_event();
-            rdp_interrupt_event(&g_dp);
+            rdp_interrupt_event(&g_dev.dp);
             break;
 
         case HW2_INT:
@@ -579,7 +549,7 @@ void gen_interupt(void)
             break;
 
         default:
-            DebugMessage(M64MSG_ERROR, "Unknown interrupt queue event type %.8X.", q.first->data.type);
+            DebugMessage(M64MSG_ERROR, "Unknown interrupt queue event type %.8X.", g_dev.r4300.q.heap[0].type);
             remove_interupt_event();
             wrapped_exception_general();
             break;
@@ -589,9 +559,12 @@ void gen_interupt(void)
     {
         if (savestates_get_job() == savestates_job_save)
         {
-            savestates_save();
+            savestates_save(&g_dev);
             return;
         }
+
+        if (rewind_save_pending())
+            rewind_save(&g_dev);
     }
 }
 
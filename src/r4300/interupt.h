@@ -22,8 +22,34 @@
 #ifndef M64P_R4300_INTERUPT_H
 #define M64P_R4300_INTERUPT_H
 
+#include <stddef.h>
 #include <stdint.h>
 
+/* number of event types: the *_INT values below are single bits */
+#define INTERRUPT_TYPES 11
+
+struct interrupt_event
+{
+    int type;
+    uint64_t count;
+    uint64_t order;
+};
+
+/* Pending events, as a binary min-heap ordered by count, then by insertion
+ * order. Counts are 64-bit: 'base' is the count at which the 32-bit COUNT
+ * register last wrapped around. It is advanced by the SPECIAL_INT event,
+ * which is always scheduled at the next wrap-around.
+ * index[] holds the heap position of each event type, or -1.
+ */
+struct interrupt_queue
+{
+    struct interrupt_event heap[INTERRUPT_TYPES];
+    int index[INTERRUPT_TYPES];
+    size_t size;
+    uint64_t base;
+    uint64_t order;
+};
+
 void init_interupt(void);
 
 // set to avoid savestates/reset if state may be inconsistent
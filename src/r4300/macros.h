@@ -26,16 +26,16 @@
 #define SE16(a) ((int64_t) ((int16_t) (a)))
 #define SE32(a) ((int64_t) ((int32_t) (a)))
 
-#define rrt *PC->f.r.rt
-#define rrd *PC->f.r.rd
+#define rrt reg[PC->f.r.rt]
+#define rrd reg[PC->f.r.rd]
 #define rfs PC->f.r.nrd
-#define rrs *PC->f.r.rs
+#define rrs reg[PC->f.r.rs]
 #define rsa PC->f.r.sa
-#define irt *PC->f.i.rt
+#define irt reg[PC->f.i.rt]
 #define ioffset PC->f.i.immediate
 #define iimmediate PC->f.i.immediate
-#define irs *PC->f.i.rs
-#define ibase *PC->f.i.rs
+#define irs reg[PC->f.i.rs]
+#define ibase reg[PC->f.i.rs]
 #define jinst_index PC->f.j.inst_index
 #define lfbase PC->f.lf.base
 #define lfft PC->f.lf.ft
@@ -46,17 +46,17 @@
 
 // 32 bits macros
 #ifndef M64P_BIG_ENDIAN
-#define rrt32 *((int32_t*) PC->f.r.rt)
-#define rrd32 *((int32_t*) PC->f.r.rd)
-#define rrs32 *((int32_t*) PC->f.r.rs)
-#define irs32 *((int32_t*) PC->f.i.rs)
-#define irt32 *((int32_t*) PC->f.i.rt)
+#define rrt32 *((int32_t*) &reg[PC->f.r.rt])
+#define rrd32 *((int32_t*) &reg[PC->f.r.rd])
+#define rrs32 *((int32_t*) &reg[PC->f.r.rs])
+#define irs32 *((int32_t*) &reg[PC->f.i.rs])
+#define irt32 *((int32_t*) &reg[PC->f.i.rt])
 #else
-#define rrt32 *((int32_t*) PC->f.r.rt + 1)
-#define rrd32 *((int32_t*) PC->f.r.rd + 1)
-#define rrs32 *((int32_t*) PC->f.r.rs + 1)
-#define irs32 *((int32_t*) PC->f.i.rs + 1)
-#define irt32 *((int32_t*) PC->f.i.rt + 1)
+#define rrt32 *((int32_t*) &reg[PC->f.r.rt] + 1)
+#define rrd32 *((int32_t*) &reg[PC->f.r.rd] + 1)
+#define rrs32 *((int32_t*) &reg[PC->f.r.rs] + 1)
+#define irs32 *((int32_t*) &reg[PC->f.i.rs] + 1)
+#define irt32 *((int32_t*) &reg[PC->f.i.rt] + 1)
 #endif
 
 #endif /* M64P_R4300_MACROS_H */
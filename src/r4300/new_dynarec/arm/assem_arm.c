@@ -362,6 +362,7 @@ void *dynamic_linker(void * src, u_int vaddr)
             if(tlb_LUT_r[vaddr>>12]) {
               invalid_code[tlb_LUT_r[vaddr>>12]>>12]=0;
               memory_map[tlb_LUT_r[vaddr>>12]>>12]|=0x40000000;
+              mark_r4300_code_page(tlb_LUT_r[vaddr>>12]);
             }
             restore_candidate[vpage>>3]|=1<<(vpage&7);
           }
@@ -452,6 +453,7 @@ void *dynamic_linker_ds(void * src, u_int vaddr)
             if(tlb_LUT_r[vaddr>>12]) {
               invalid_code[tlb_LUT_r[vaddr>>12]>>12]=0;
               memory_map[tlb_LUT_r[vaddr>>12]>>12]|=0x40000000;
+              mark_r4300_code_page(tlb_LUT_r[vaddr>>12]);
             }
             restore_candidate[vpage>>3]|=1<<(vpage&7);
           }
@@ -3645,6 +3647,8 @@ static void cop0_assemble(int i,struct regstat *i_regs)
         emit_movimm((source[i]>>11)&0x1f,1);
         emit_writeword(0,(int)&PC);
         emit_writebyte(1,(int)&(fake_pc.f.r.nrd));
+        emit_movimm(rt1[i],1);
+        emit_writebyte(1,(int)&(fake_pc.f.r.rt));
         if(copr==9) {
           emit_readword((int)&last_count,ECX);
           emit_loadreg(CCREG,HOST_CCREG); // TODO: do proper reg alloc
@@ -3653,7 +3657,7 @@ static void cop0_assemble(int i,struct regstat *i_regs)
           emit_writeword(HOST_CCREG,(int)&g_cp0_regs[CP0_COUNT_REG]);
         }
         emit_call((int)cached_interpreter_table.MFC0);
-        emit_readword((int)&readmem_dword,t);
+        emit_readword((int)&reg[rt1[i]],t);
       }
     }
   }
@@ -3662,12 +3666,14 @@ static void cop0_assemble(int i,struct regstat *i_regs)
     signed char s=get_reg(i_regs->regmap,rs1[i]);
     char copr=(source[i]>>11)&0x1f;
     assert(s>=0);
-    emit_writeword(s,(int)&readmem_dword);
+    emit_writeword(s,(int)&reg[rs1[i]]);
     wb_register(rs1[i],i_regs->regmap,i_regs->dirty,i_regs->is32);
     emit_addimm(FP,(int)&fake_pc-(int)&dynarec_local,0);
     emit_movimm((source[i]>>11)&0x1f,1);
     emit_writeword(0,(int)&PC);
     emit_writebyte(1,(int)&(fake_pc.f.r.nrd));
+    emit_movimm(rs1[i],1);
+    emit_writebyte(1,(int)&(fake_pc.f.r.rt));
     if(copr==9||copr==11||copr==12) {
       emit_readword((int)&last_count,ECX);
       emit_loadreg(CCREG,HOST_CCREG); // TODO: do proper reg alloc
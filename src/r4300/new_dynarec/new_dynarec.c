@@ -34,6 +34,7 @@
 #ifdef __cplusplus
 extern "C" {
 #endif
+#include "../../device/device.h"
 #include "../../main/main.h"
 #include "../../main/rom.h"
 #include "../../memory/memory.h"
@@ -41,9 +42,11 @@ extern "C" {
 #include "../cached_interp.h"
 #include "../cp0_private.h"
 #include "../cp1_private.h"
+#include "../idle_loop.h"
 #include "../interupt.h"
 #include "../ops.h"
 #include "../r4300.h"
+#include "../r4300_core.h"
 #include "../recomp.h"
 #include "../recomph.h" //include for function prototypes
 #include "../tlb.h"
@@ -165,6 +168,7 @@ struct ll_entry *jump_in[4096];
 static struct ll_entry *jump_out[4096];
 struct ll_entry *jump_dirty[4096];
 ALIGN(16, u_int hash_table[65536][4]);
+char invalid_code[0x100000];
 ALIGN(16, static char shadow[2097152]);
 static char *copy;
 static int expirep;
@@ -432,6 +436,7 @@ void *get_addr(u_int vaddr)
             if(tlb_LUT_r[vaddr>>12]) {
               invalid_code[tlb_LUT_r[vaddr>>12]>>12]=0;
               memory_map[tlb_LUT_r[vaddr>>12]>>12]|=0x40000000;
+              mark_r4300_code_page(tlb_LUT_r[vaddr>>12]);
             }
             restore_candidate[vpage>>3]|=1<<(vpage&7);
           }
@@ -524,6 +529,7 @@ void *get_addr_32(u_int vaddr,u_int flags)
             if(tlb_LUT_r[vaddr>>12]) {
               invalid_code[tlb_LUT_r[vaddr>>12]>>12]=0;
               memory_map[tlb_LUT_r[vaddr>>12]>>12]|=0x40000000;
+              mark_r4300_code_page(tlb_LUT_r[vaddr>>12]);
             }
             restore_candidate[vpage>>3]|=1<<(vpage&7);
           }
@@ -1278,8 +1284,14 @@ void invalidate_cached_code_new_dynarec(uint32_t address, size_t size)
         end = (address+size-1) >> 12;
     }
 
+    /* writes to pages without live code aren't trapped anyway, and dirty
+     * blocks are verified before being restored */
     for(i = begin; i <= end; ++i)
+    {
+        if (size != 0 && (invalid_code[i] || !is_r4300_code_page(i << 12)))
+            continue;
         invalidate_block(i);
+    }
 }
 
 #if NEW_DYNAREC == NEW_DYNAREC_ARM
@@ -4722,6 +4734,17 @@ static void ds_assemble_entry(int i)
   emit_jmp(0);
 }
 
+// Branch to itself with a nop in the delay slot, or back to the beginning of
+// a loop polling memory (see idle_loop.c)
+static int is_idle_branch(int i)
+{
+  int t=(ba[i]-start)>>2;
+  if(source[i+1]!=0) return 0;
+  if(t==i) return 1;
+  return ba[i]>=start && t<i && instr_addr[t] && internal_branch(branch_regs[i].is32,ba[i])
+    && is_idle_loop(source,source+t,source+i);
+}
+
 static void do_cc(int i,signed char i_regmap[],int *adj,int addr,int taken,int invert)
 {
   int count;
@@ -4743,7 +4766,7 @@ static void do_cc(int i,signed char i_regmap[],int *adj,int addr,int taken,int i
     *adj=0;
   }
   count=ccadj[i];
-  if(taken==TAKEN && i==(ba[i]-start)>>2 && source[i+1]==0) {
+  if(taken==TAKEN && is_idle_branch(i)) {
     // Idle loop
     if(count&1) emit_addimm_and_set_flags(2*(count+2),HOST_CCREG);
     idle=(int)out;
@@ -4751,6 +4774,11 @@ static void do_cc(int i,signed char i_regmap[],int *adj,int addr,int taken,int i
     emit_andimm(HOST_CCREG,3,HOST_CCREG);
     jaddr=(int)out;
     emit_jmp(0);
+    // Longer loops are resumed from their first instruction, to read again
+    // what they poll once the interrupt has been processed.  Return into the
+    // caller's taken branch path so dirty registers are written back and the
+    // target's register map is matched as for any other jump there.
+    if(i!=(ba[i]-start)>>2) idle=(int)out;
   }
   else if(*adj==0||invert) {
     emit_addimm_and_set_flags(CLOCK_DIVIDER*(count+2),HOST_CCREG);
@@ -7668,9 +7696,6 @@ void new_dynarec_init()
   out=(u_char *)base_addr;
 
   rdword=&readmem_dword;
-  fake_pc.f.r.rs=(long long int *)&readmem_dword;
-  fake_pc.f.r.rt=(long long int *)&readmem_dword;
-  fake_pc.f.r.rd=(long long int *)&readmem_dword;
   int n;
   for(n=0x80000;n<0x80800;n++)
     invalid_code[n]=1;
@@ -7769,7 +7794,7 @@ int new_recompile_block(int addr)
   start = (u_int)addr&~3;
   //assert(((u_int)addr&1)==0);
   if ((int)addr >= 0xa4000000 && (int)addr < 0xa4001000) {
-    source = (u_int *)((u_int)g_sp.mem+start-0xa4000000);
+    source = (u_int *)((u_int)g_dev.sp.mem+start-0xa4000000);
     pagelimit = 0xa4001000;
   }
   else if ((int)addr >= 0x80000000 && (int)addr < 0x80800000) {
@@ -10974,8 +10999,10 @@ int new_recompile_block(int addr)
       j=(((u_int)i<<12)+(memory_map[i]<<2)-(u_int)g_rdram+(u_int)0x80000000)>>12;
       invalid_code[j]=0;
       memory_map[j]|=0x40000000;
+      mark_r4300_code_page((u_int)j<<12);
       //DebugMessage(M64MSG_VERBOSE, "write protect physical page: %x (virtual %x)",j<<12,start);
     }
+    else mark_r4300_code_page((u_int)i<<12);
   }
   
   /* Pass 10 - Free memory by expiring oldest blocks */
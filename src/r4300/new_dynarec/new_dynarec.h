@@ -34,6 +34,8 @@ extern "C" {
 #endif
 extern int pcaddr;
 extern int pending_exception;
+/* one byte per 4KB page, the cached interpreter uses its own sparse table */
+extern char invalid_code[0x100000];
 #ifdef __cplusplus
 }
 #endif
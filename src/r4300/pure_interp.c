@@ -19,7 +19,9 @@
  *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
+#include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
 
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
@@ -27,7 +29,7 @@
 #include "api/callbacks.h"
 #include "api/debugger.h"
 #include "api/m64p_types.h"
-/* TLBWrite requires invalid_code and blocks from cached_interp.h, but only if
+/* TLBWrite requires the block table from cached_interp.h, but only if
  * (at run time) the active core is not the Pure Interpreter. */
 #include "cached_interp.h"
 #include "cp0_private.h"
@@ -37,7 +39,9 @@
 #include "main/main.h"
 #include "memory/memory.h"
 #include "osal/preproc.h"
+#include "pure_interp.h"
 #include "r4300.h"
+#include "r4300_core.h"
 #include "tlb.h"
 
 #ifdef DBG
@@ -47,6 +51,8 @@
 
 static precomp_instr interp_PC;
 
+typedef void (*pure_instr_func)(uint32_t op);
+
 static void InterpretOpcode(void);
 
 #define PCADDR interp_PC.addr
@@ -97,7 +103,7 @@ static void InterpretOpcode(void);
       } \
       else name(op); \
    }
-#define CHECK_MEMORY()
+#define CHECK_MEMORY(addr)
 
 #define RD_OF(op)      (((op) >> 11) & 0x1F)
 #define RS_OF(op)      (((op) >> 21) & 0x1F)
@@ -173,555 +179,496 @@ static void InterpretOpcode(void);
 
 #include "interpreter.def"
 
-void InterpretOpcode()
+/* Whether a jump is an idle loop also depends on its delay slot, so this is
+ * checked when it runs: this way, decoding only depends on the opcode. */
+#define DECLARE_IDLE_CHECK(name, is_idle_loop) \
+   static void name##_CHECK_IDLE(uint32_t op) \
+   { \
+      if (is_idle_loop(op, PC->addr)) name##_IDLE(op); \
+      else                            name(op); \
+   }
+
+DECLARE_IDLE_CHECK(BLTZ, IS_RELATIVE_IDLE_LOOP)
+DECLARE_IDLE_CHECK(BGEZ, IS_RELATIVE_IDLE_LOOP)
+DECLARE_IDLE_CHECK(BLTZL, IS_RELATIVE_IDLE_LOOP)
+DECLARE_IDLE_CHECK(BGEZL, IS_RELATIVE_IDLE_LOOP)
+DECLARE_IDLE_CHECK(BLTZAL, IS_RELATIVE_IDLE_LOOP)
+DECLARE_IDLE_CHECK(BGEZAL, IS_RELATIVE_IDLE_LOOP)
+DECLARE_IDLE_CHECK(BLTZALL, IS_RELATIVE_IDLE_LOOP)
+DECLARE_IDLE_CHECK(BGEZALL, IS_RELATIVE_IDLE_LOOP)
+DECLARE_IDLE_CHECK(J, IS_ABSOLUTE_IDLE_LOOP)
+DECLARE_IDLE_CHECK(JAL, IS_ABSOLUTE_IDLE_LOOP)
+DECLARE_IDLE_CHECK(BEQ, IS_RELATIVE_IDLE_LOOP)
+DECLARE_IDLE_CHECK(BNE, IS_RELATIVE_IDLE_LOOP)
+DECLARE_IDLE_CHECK(BLEZ, IS_RELATIVE_IDLE_LOOP)
+DECLARE_IDLE_CHECK(BGTZ, IS_RELATIVE_IDLE_LOOP)
+DECLARE_IDLE_CHECK(BC1F, IS_RELATIVE_IDLE_LOOP)
+DECLARE_IDLE_CHECK(BC1T, IS_RELATIVE_IDLE_LOOP)
+DECLARE_IDLE_CHECK(BC1FL, IS_RELATIVE_IDLE_LOOP)
+DECLARE_IDLE_CHECK(BC1TL, IS_RELATIVE_IDLE_LOOP)
+DECLARE_IDLE_CHECK(BEQL, IS_RELATIVE_IDLE_LOOP)
+DECLARE_IDLE_CHECK(BNEL, IS_RELATIVE_IDLE_LOOP)
+DECLARE_IDLE_CHECK(BLEZL, IS_RELATIVE_IDLE_LOOP)
+DECLARE_IDLE_CHECK(BGTZL, IS_RELATIVE_IDLE_LOOP)
+
+static pure_instr_func decode_opcode(uint32_t op)
 {
-	uint32_t op = *fast_mem_access(PC->addr);
 	switch ((op >> 26) & 0x3F) {
 	case 0: /* SPECIAL prefix */
 		switch (op & 0x3F) {
 		case 0: /* SPECIAL opcode 0: SLL */
-			if (RD_OF(op) != 0) SLL(op);
-			else                NOP(0);
-			break;
+			return (RD_OF(op) != 0) ? SLL : NOP;
 		case 2: /* SPECIAL opcode 2: SRL */
-			if (RD_OF(op) != 0) SRL(op);
-			else                NOP(0);
-			break;
+			return (RD_OF(op) != 0) ? SRL : NOP;
 		case 3: /* SPECIAL opcode 3: SRA */
-			if (RD_OF(op) != 0) SRA(op);
-			else                NOP(0);
-			break;
+			return (RD_OF(op) != 0) ? SRA : NOP;
 		case 4: /* SPECIAL opcode 4: SLLV */
-			if (RD_OF(op) != 0) SLLV(op);
-			else                NOP(0);
-			break;
+			return (RD_OF(op) != 0) ? SLLV : NOP;
 		case 6: /* SPECIAL opcode 6: SRLV */
-			if (RD_OF(op) != 0) SRLV(op);
-			else                NOP(0);
-			break;
+			return (RD_OF(op) != 0) ? SRLV : NOP;
 		case 7: /* SPECIAL opcode 7: SRAV */
-			if (RD_OF(op) != 0) SRAV(op);
-			else                NOP(0);
-			break;
-		case 8: JR(op); break;
+			return (RD_OF(op) != 0) ? SRAV : NOP;
+		case 8: return JR;
 		case 9: /* SPECIAL opcode 9: JALR */
 			/* Note: This can omit the check for Rd == 0 because the JALR
 			 * function checks for link_register != &reg[0]. If you're
 			 * using this as a reference for a JIT, do check Rd == 0 in it. */
-			JALR(op);
-			break;
-		case 12: SYSCALL(op); break;
+			return JALR;
+		case 12: return SYSCALL;
 		case 13: /* SPECIAL opcode 13: BREAK (Not implemented) */
-			NI(op);
-			break;
-		case 15: SYNC(op); break;
+			return NI;
+		case 15: return SYNC;
 		case 16: /* SPECIAL opcode 16: MFHI */
-			if (RD_OF(op) != 0) MFHI(op);
-			else                NOP(0);
-			break;
-		case 17: MTHI(op); break;
+			return (RD_OF(op) != 0) ? MFHI : NOP;
+		case 17: return MTHI;
 		case 18: /* SPECIAL opcode 18: MFLO */
-			if (RD_OF(op) != 0) MFLO(op);
-			else                NOP(0);
-			break;
-		case 19: MTLO(op); break;
+			return (RD_OF(op) != 0) ? MFLO : NOP;
+		case 19: return MTLO;
 		case 20: /* SPECIAL opcode 20: DSLLV */
-			if (RD_OF(op) != 0) DSLLV(op);
-			else                NOP(0);
-			break;
+			return (RD_OF(op) != 0) ? DSLLV : NOP;
 		case 22: /* SPECIAL opcode 22: DSRLV */
-			if (RD_OF(op) != 0) DSRLV(op);
-			else                NOP(0);
-			break;
+			return (RD_OF(op) != 0) ? DSRLV : NOP;
 		case 23: /* SPECIAL opcode 23: DSRAV */
-			if (RD_OF(op) != 0) DSRAV(op);
-			else                NOP(0);
-			break;
-		case 24: MULT(op); break;
-		case 25: MULTU(op); break;
-		case 26: DIV(op); break;
-		case 27: DIVU(op); break;
-		case 28: DMULT(op); break;
-		case 29: DMULTU(op); break;
-		case 30: DDIV(op); break;
-		case 31: DDIVU(op); break;
+			return (RD_OF(op) != 0) ? DSRAV : NOP;
+		case 24: return MULT;
+		case 25: return MULTU;
+		case 26: return DIV;
+		case 27: return DIVU;
+		case 28: return DMULT;
+		case 29: return DMULTU;
+		case 30: return DDIV;
+		case 31: return DDIVU;
 		case 32: /* SPECIAL opcode 32: ADD */
-			if (RD_OF(op) != 0) ADD(op);
-			else                NOP(0);
-			break;
+			return (RD_OF(op) != 0) ? ADD : NOP;
 		case 33: /* SPECIAL opcode 33: ADDU */
-			if (RD_OF(op) != 0) ADDU(op);
-			else                NOP(0);
-			break;
+			return (RD_OF(op) != 0) ? ADDU : NOP;
 		case 34: /* SPECIAL opcode 34: SUB */
-			if (RD_OF(op) != 0) SUB(op);
-			else                NOP(0);
-			break;
+			return (RD_OF(op) != 0) ? SUB : NOP;
 		case 35: /* SPECIAL opcode 35: SUBU */
-			if (RD_OF(op) != 0) SUBU(op);
-			else                NOP(0);
-			break;
+			return (RD_OF(op) != 0) ? SUBU : NOP;
 		case 36: /* SPECIAL opcode 36: AND */
-			if (RD_OF(op) != 0) AND(op);
-			else                NOP(0);
-			break;
+			return (RD_OF(op) != 0) ? AND : NOP;
 		case 37: /* SPECIAL opcode 37: OR */
-			if (RD_OF(op) != 0) OR(op);
-			else                NOP(0);
-			break;
+			return (RD_OF(op) != 0) ? OR : NOP;
 		case 38: /* SPECIAL opcode 38: XOR */
-			if (RD_OF(op) != 0) XOR(op);
-			else                NOP(0);
-			break;
+			return (RD_OF(op) != 0) ? XOR : NOP;
 		case 39: /* SPECIAL opcode 39: NOR */
-			if (RD_OF(op) != 0) NOR(op);
-			else                NOP(0);
-			break;
+			return (RD_OF(op) != 0) ? NOR : NOP;
 		case 42: /* SPECIAL opcode 42: SLT */
-			if (RD_OF(op) != 0) SLT(op);
-			else                NOP(0);
-			break;
+			return (RD_OF(op) != 0) ? SLT : NOP;
 		case 43: /* SPECIAL opcode 43: SLTU */
-			if (RD_OF(op) != 0) SLTU(op);
-			else                NOP(0);
-			break;
+			return (RD_OF(op) != 0) ? SLTU : NOP;
 		case 44: /* SPECIAL opcode 44: DADD */
-			if (RD_OF(op) != 0) DADD(op);
-			else                NOP(0);
-			break;
+			return (RD_OF(op) != 0) ? DADD : NOP;
 		case 45: /* SPECIAL opcode 45: DADDU */
-			if (RD_OF(op) != 0) DADDU(op);
-			else                NOP(0);
-			break;
+			return (RD_OF(op) != 0) ? DADDU : NOP;
 		case 46: /* SPECIAL opcode 46: DSUB */
-			if (RD_OF(op) != 0) DSUB(op);
-			else                NOP(0);
-			break;
+			return (RD_OF(op) != 0) ? DSUB : NOP;
 		case 47: /* SPECIAL opcode 47: DSUBU */
-			if (RD_OF(op) != 0) DSUBU(op);
-			else                NOP(0);
-			break;
+			return (RD_OF(op) != 0) ? DSUBU : NOP;
 		case 48: /* SPECIAL opcode 48: TGE (Not implemented) */
 		case 49: /* SPECIAL opcode 49: TGEU (Not implemented) */
 		case 50: /* SPECIAL opcode 50: TLT (Not implemented) */
 		case 51: /* SPECIAL opcode 51: TLTU (Not implemented) */
-			NI(op);
-			break;
-		case 52: TEQ(op); break;
+			return NI;
+		case 52: return TEQ;
 		case 54: /* SPECIAL opcode 54: TNE (Not implemented) */
-			NI(op);
-			break;
+			return NI;
 		case 56: /* SPECIAL opcode 56: DSLL */
-			if (RD_OF(op) != 0) DSLL(op);
-			else                NOP(0);
-			break;
+			return (RD_OF(op) != 0) ? DSLL : NOP;
 		case 58: /* SPECIAL opcode 58: DSRL */
-			if (RD_OF(op) != 0) DSRL(op);
-			else                NOP(0);
-			break;
+			return (RD_OF(op) != 0) ? DSRL : NOP;
 		case 59: /* SPECIAL opcode 59: DSRA */
-			if (RD_OF(op) != 0) DSRA(op);
-			else                NOP(0);
-			break;
+			return (RD_OF(op) != 0) ? DSRA : NOP;
 		case 60: /* SPECIAL opcode 60: DSLL32 */
-			if (RD_OF(op) != 0) DSLL32(op);
-			else                NOP(0);
-			break;
+			return (RD_OF(op) != 0) ? DSLL32 : NOP;
 		case 62: /* SPECIAL opcode 62: DSRL32 */
-			if (RD_OF(op) != 0) DSRL32(op);
-			else                NOP(0);
-			break;
+			return (RD_OF(op) != 0) ? DSRL32 : NOP;
 		case 63: /* SPECIAL opcode 63: DSRA32 */
-			if (RD_OF(op) != 0) DSRA32(op);
-			else                NOP(0);
-			break;
+			return (RD_OF(op) != 0) ? DSRA32 : NOP;
 		default: /* SPECIAL opcodes 1, 5, 10, 11, 14, 21, 40, 41, 53, 55, 57,
 		            61: Reserved Instructions */
-			RESERVED(op);
-			break;
+			return RESERVED;
 		} /* switch (op & 0x3F) for the SPECIAL prefix */
-		break;
 	case 1: /* REGIMM prefix */
 		switch ((op >> 16) & 0x1F) {
 		case 0: /* REGIMM opcode 0: BLTZ */
-			if (IS_RELATIVE_IDLE_LOOP(op, PC->addr)) BLTZ_IDLE(op);
-			else                                     BLTZ(op);
-			break;
+			return BLTZ_CHECK_IDLE;
 		case 1: /* REGIMM opcode 1: BGEZ */
-			if (IS_RELATIVE_IDLE_LOOP(op, PC->addr)) BGEZ_IDLE(op);
-			else                                     BGEZ(op);
-			break;
+			return BGEZ_CHECK_IDLE;
 		case 2: /* REGIMM opcode 2: BLTZL */
-			if (IS_RELATIVE_IDLE_LOOP(op, PC->addr)) BLTZL_IDLE(op);
-			else                                     BLTZL(op);
-			break;
+			return BLTZL_CHECK_IDLE;
 		case 3: /* REGIMM opcode 3: BGEZL */
-			if (IS_RELATIVE_IDLE_LOOP(op, PC->addr)) BGEZL_IDLE(op);
-			else                                     BGEZL(op);
-			break;
+			return BGEZL_CHECK_IDLE;
 		case 8: /* REGIMM opcode 8: TGEI (Not implemented) */
 		case 9: /* REGIMM opcode 9: TGEIU (Not implemented) */
 		case 10: /* REGIMM opcode 10: TLTI (Not implemented) */
 		case 11: /* REGIMM opcode 11: TLTIU (Not implemented) */
 		case 12: /* REGIMM opcode 12: TEQI (Not implemented) */
 		case 14: /* REGIMM opcode 14: TNEI (Not implemented) */
-			NI(op);
-			break;
+			return NI;
 		case 16: /* REGIMM opcode 16: BLTZAL */
-			if (IS_RELATIVE_IDLE_LOOP(op, PC->addr)) BLTZAL_IDLE(op);
-			else                                     BLTZAL(op);
-			break;
+			return BLTZAL_CHECK_IDLE;
 		case 17: /* REGIMM opcode 17: BGEZAL */
-			if (IS_RELATIVE_IDLE_LOOP(op, PC->addr)) BGEZAL_IDLE(op);
-			else                                     BGEZAL(op);
-			break;
+			return BGEZAL_CHECK_IDLE;
 		case 18: /* REGIMM opcode 18: BLTZALL */
-			if (IS_RELATIVE_IDLE_LOOP(op, PC->addr)) BLTZALL_IDLE(op);
-			else                                     BLTZALL(op);
-			break;
+			return BLTZALL_CHECK_IDLE;
 		case 19: /* REGIMM opcode 19: BGEZALL */
-			if (IS_RELATIVE_IDLE_LOOP(op, PC->addr)) BGEZALL_IDLE(op);
-			else                                     BGEZALL(op);
-			break;
+			return BGEZALL_CHECK_IDLE;
 		default: /* REGIMM opcodes 4..7, 13, 15, 20..31:
 		            Reserved Instructions */
-			RESERVED(op);
-			break;
+			return RESERVED;
 		} /* switch ((op >> 16) & 0x1F) for the REGIMM prefix */
-		break;
 	case 2: /* Major opcode 2: J */
-		if (IS_ABSOLUTE_IDLE_LOOP(op, PC->addr)) J_IDLE(op);
-		else                                     J(op);
-		break;
+		return J_CHECK_IDLE;
 	case 3: /* Major opcode 3: JAL */
-		if (IS_ABSOLUTE_IDLE_LOOP(op, PC->addr)) JAL_IDLE(op);
-		else                                     JAL(op);
-		break;
+		return JAL_CHECK_IDLE;
 	case 4: /* Major opcode 4: BEQ */
-		if (IS_RELATIVE_IDLE_LOOP(op, PC->addr)) BEQ_IDLE(op);
-		else                                     BEQ(op);
-		break;
+		return BEQ_CHECK_IDLE;
 	case 5: /* Major opcode 5: BNE */
-		if (IS_RELATIVE_IDLE_LOOP(op, PC->addr)) BNE_IDLE(op);
-		else                                     BNE(op);
-		break;
+		return BNE_CHECK_IDLE;
 	case 6: /* Major opcode 6: BLEZ */
-		if (IS_RELATIVE_IDLE_LOOP(op, PC->addr)) BLEZ_IDLE(op);
-		else                                     BLEZ(op);
-		break;
+		return BLEZ_CHECK_IDLE;
 	case 7: /* Major opcode 7: BGTZ */
-		if (IS_RELATIVE_IDLE_LOOP(op, PC->addr)) BGTZ_IDLE(op);
-		else                                     BGTZ(op);
-		break;
+		return BGTZ_CHECK_IDLE;
 	case 8: /* Major opcode 8: ADDI */
-		if (RT_OF(op) != 0) ADDI(op);
-		else                NOP(0);
-		break;
+		return (RT_OF(op) != 0) ? ADDI : NOP;
 	case 9: /* Major opcode 9: ADDIU */
-		if (RT_OF(op) != 0) ADDIU(op);
-		else                NOP(0);
-		break;
+		return (RT_OF(op) != 0) ? ADDIU : NOP;
 	case 10: /* Major opcode 10: SLTI */
-		if (RT_OF(op) != 0) SLTI(op);
-		else                NOP(0);
-		break;
+		return (RT_OF(op) != 0) ? SLTI : NOP;
 	case 11: /* Major opcode 11: SLTIU */
-		if (RT_OF(op) != 0) SLTIU(op);
-		else                NOP(0);
-		break;
+		return (RT_OF(op) != 0) ? SLTIU : NOP;
 	case 12: /* Major opcode 12: ANDI */
-		if (RT_OF(op) != 0) ANDI(op);
-		else                NOP(0);
-		break;
+		return (RT_OF(op) != 0) ? ANDI : NOP;
 	case 13: /* Major opcode 13: ORI */
-		if (RT_OF(op) != 0) ORI(op);
-		else                NOP(0);
-		break;
+		return (RT_OF(op) != 0) ? ORI : NOP;
 	case 14: /* Major opcode 14: XORI */
-		if (RT_OF(op) != 0) XORI(op);
-		else                NOP(0);
-		break;
+		return (RT_OF(op) != 0) ? XORI : NOP;
 	case 15: /* Major opcode 15: LUI */
-		if (RT_OF(op) != 0) LUI(op);
-		else                NOP(0);
-		break;
+		return (RT_OF(op) != 0) ? LUI : NOP;
 	case 16: /* Coprocessor 0 prefix */
 		switch ((op >> 21) & 0x1F) {
 		case 0: /* Coprocessor 0 opcode 0: MFC0 */
-			if (RT_OF(op) != 0) MFC0(op);
-			else                NOP(0);
-			break;
-		case 4: MTC0(op); break;
+			return (RT_OF(op) != 0) ? MFC0 : NOP;
+		case 4: return MTC0;
 		case 16: /* Coprocessor 0 opcode 16: TLB */
 			switch (op & 0x3F) {
-			case 1: TLBR(op); break;
-			case 2: TLBWI(op); break;
-			case 6: TLBWR(op); break;
-			case 8: TLBP(op); break;
-			case 24: ERET(op); break;
+			case 1: return TLBR;
+			case 2: return TLBWI;
+			case 6: return TLBWR;
+			case 8: return TLBP;
+			case 24: return ERET;
 			default: /* TLB sub-opcodes 0, 3..5, 7, 9..23, 25..63:
 			            Reserved Instructions */
-				RESERVED(op);
-				break;
+				return RESERVED;
 			} /* switch (op & 0x3F) for Coprocessor 0 TLB opcodes */
-			break;
 		default: /* Coprocessor 0 opcodes 1..3, 4..15, 17..31:
 		            Reserved Instructions */
-			RESERVED(op);
-			break;
+			return RESERVED;
 		} /* switch ((op >> 21) & 0x1F) for the Coprocessor 0 prefix */
-		break;
 	case 17: /* Coprocessor 1 prefix */
 		switch ((op >> 21) & 0x1F) {
 		case 0: /* Coprocessor 1 opcode 0: MFC1 */
-			if (RT_OF(op) != 0) MFC1(op);
-			else                NOP(0);
-			break;
+			return (RT_OF(op) != 0) ? MFC1 : NOP;
 		case 1: /* Coprocessor 1 opcode 1: DMFC1 */
-			if (RT_OF(op) != 0) DMFC1(op);
-			else                NOP(0);
-			break;
+			return (RT_OF(op) != 0) ? DMFC1 : NOP;
 		case 2: /* Coprocessor 1 opcode 2: CFC1 */
-			if (RT_OF(op) != 0) CFC1(op);
-			else                NOP(0);
-			break;
-		case 4: MTC1(op); break;
-		case 5: DMTC1(op); break;
-		case 6: CTC1(op); break;
+			return (RT_OF(op) != 0) ? CFC1 : NOP;
+		case 4: return MTC1;
+		case 5: return DMTC1;
+		case 6: return CTC1;
 		case 8: /* Coprocessor 1 opcode 8: Branch on C1 condition... */
 			switch ((op >> 16) & 0x3) {
 			case 0: /* opcode 0: BC1F */
-				if (IS_RELATIVE_IDLE_LOOP(op, PC->addr)) BC1F_IDLE(op);
-				else                                     BC1F(op);
-				break;
+				return BC1F_CHECK_IDLE;
 			case 1: /* opcode 1: BC1T */
-				if (IS_RELATIVE_IDLE_LOOP(op, PC->addr)) BC1T_IDLE(op);
-				else                                     BC1T(op);
-				break;
+				return BC1T_CHECK_IDLE;
 			case 2: /* opcode 2: BC1FL */
-				if (IS_RELATIVE_IDLE_LOOP(op, PC->addr)) BC1FL_IDLE(op);
-				else                                     BC1FL(op);
-				break;
-			case 3: /* opcode 3: BC1TL */
-				if (IS_RELATIVE_IDLE_LOOP(op, PC->addr)) BC1TL_IDLE(op);
-				else                                     BC1TL(op);
-				break;
+				return BC1FL_CHECK_IDLE;
+			default: /* opcode 3: BC1TL */
+				return BC1TL_CHECK_IDLE;
 			} /* switch ((op >> 16) & 0x3) for branches on C1 condition */
-			break;
 		case 16: /* Coprocessor 1 S-format opcodes */
 			switch (op & 0x3F) {
-			case 0: ADD_S(op); break;
-			case 1: SUB_S(op); break;
-			case 2: MUL_S(op); break;
-			case 3: DIV_S(op); break;
-			case 4: SQRT_S(op); break;
-			case 5: ABS_S(op); break;
-			case 6: MOV_S(op); break;
-			case 7: NEG_S(op); break;
-			case 8: ROUND_L_S(op); break;
-			case 9: TRUNC_L_S(op); break;
-			case 10: CEIL_L_S(op); break;
-			case 11: FLOOR_L_S(op); break;
-			case 12: ROUND_W_S(op); break;
-			case 13: TRUNC_W_S(op); break;
-			case 14: CEIL_W_S(op); break;
-			case 15: FLOOR_W_S(op); break;
-			case 33: CVT_D_S(op); break;
-			case 36: CVT_W_S(op); break;
-			case 37: CVT_L_S(op); break;
-			case 48: C_F_S(op); break;
-			case 49: C_UN_S(op); break;
-			case 50: C_EQ_S(op); break;
-			case 51: C_UEQ_S(op); break;
-			case 52: C_OLT_S(op); break;
-			case 53: C_ULT_S(op); break;
-			case 54: C_OLE_S(op); break;
-			case 55: C_ULE_S(op); break;
-			case 56: C_SF_S(op); break;
-			case 57: C_NGLE_S(op); break;
-			case 58: C_SEQ_S(op); break;
-			case 59: C_NGL_S(op); break;
-			case 60: C_LT_S(op); break;
-			case 61: C_NGE_S(op); break;
-			case 62: C_LE_S(op); break;
-			case 63: C_NGT_S(op); break;
+			case 0: return ADD_S;
+			case 1: return SUB_S;
+			case 2: return MUL_S;
+			case 3: return DIV_S;
+			case 4: return SQRT_S;
+			case 5: return ABS_S;
+			case 6: return MOV_S;
+			case 7: return NEG_S;
+			case 8: return ROUND_L_S;
+			case 9: return TRUNC_L_S;
+			case 10: return CEIL_L_S;
+			case 11: return FLOOR_L_S;
+			case 12: return ROUND_W_S;
+			case 13: return TRUNC_W_S;
+			case 14: return CEIL_W_S;
+			case 15: return FLOOR_W_S;
+			case 33: return CVT_D_S;
+			case 36: return CVT_W_S;
+			case 37: return CVT_L_S;
+			case 48: return C_F_S;
+			case 49: return C_UN_S;
+			case 50: return C_EQ_S;
+			case 51: return C_UEQ_S;
+			case 52: return C_OLT_S;
+			case 53: return C_ULT_S;
+			case 54: return C_OLE_S;
+			case 55: return C_ULE_S;
+			case 56: return C_SF_S;
+			case 57: return C_NGLE_S;
+			case 58: return C_SEQ_S;
+			case 59: return C_NGL_S;
+			case 60: return C_LT_S;
+			case 61: return C_NGE_S;
+			case 62: return C_LE_S;
+			case 63: return C_NGT_S;
 			default: /* Coprocessor 1 S-format opcodes 16..32, 34..35, 38..47:
 			            Reserved Instructions */
-				RESERVED(op);
-				break;
+				return RESERVED;
 			} /* switch (op & 0x3F) for Coprocessor 1 S-format opcodes */
-			break;
 		case 17: /* Coprocessor 1 D-format opcodes */
 			switch (op & 0x3F) {
-			case 0: ADD_D(op); break;
-			case 1: SUB_D(op); break;
-			case 2: MUL_D(op); break;
-			case 3: DIV_D(op); break;
-			case 4: SQRT_D(op); break;
-			case 5: ABS_D(op); break;
-			case 6: MOV_D(op); break;
-			case 7: NEG_D(op); break;
-			case 8: ROUND_L_D(op); break;
-			case 9: TRUNC_L_D(op); break;
-			case 10: CEIL_L_D(op); break;
-			case 11: FLOOR_L_D(op); break;
-			case 12: ROUND_W_D(op); break;
-			case 13: TRUNC_W_D(op); break;
-			case 14: CEIL_W_D(op); break;
-			case 15: FLOOR_W_D(op); break;
-			case 32: CVT_S_D(op); break;
-			case 36: CVT_W_D(op); break;
-			case 37: CVT_L_D(op); break;
-			case 48: C_F_D(op); break;
-			case 49: C_UN_D(op); break;
-			case 50: C_EQ_D(op); break;
-			case 51: C_UEQ_D(op); break;
-			case 52: C_OLT_D(op); break;
-			case 53: C_ULT_D(op); break;
-			case 54: C_OLE_D(op); break;
-			case 55: C_ULE_D(op); break;
-			case 56: C_SF_D(op); break;
-			case 57: C_NGLE_D(op); break;
-			case 58: C_SEQ_D(op); break;
-			case 59: C_NGL_D(op); break;
-			case 60: C_LT_D(op); break;
-			case 61: C_NGE_D(op); break;
-			case 62: C_LE_D(op); break;
-			case 63: C_NGT_D(op); break;
+			case 0: return ADD_D;
+			case 1: return SUB_D;
+			case 2: return MUL_D;
+			case 3: return DIV_D;
+			case 4: return SQRT_D;
+			case 5: return ABS_D;
+			case 6: return MOV_D;
+			case 7: return NEG_D;
+			case 8: return ROUND_L_D;
+			case 9: return TRUNC_L_D;
+			case 10: return CEIL_L_D;
+			case 11: return FLOOR_L_D;
+			case 12: return ROUND_W_D;
+			case 13: return TRUNC_W_D;
+			case 14: return CEIL_W_D;
+			case 15: return FLOOR_W_D;
+			case 32: return CVT_S_D;
+			case 36: return CVT_W_D;
+			case 37: return CVT_L_D;
+			case 48: return C_F_D;
+			case 49: return C_UN_D;
+			case 50: return C_EQ_D;
+			case 51: return C_UEQ_D;
+			case 52: return C_OLT_D;
+			case 53: return C_ULT_D;
+			case 54: return C_OLE_D;
+			case 55: return C_ULE_D;
+			case 56: return C_SF_D;
+			case 57: return C_NGLE_D;
+			case 58: return C_SEQ_D;
+			case 59: return C_NGL_D;
+			case 60: return C_LT_D;
+			case 61: return C_NGE_D;
+			case 62: return C_LE_D;
+			case 63: return C_NGT_D;
 			default: /* Coprocessor 1 D-format opcodes 16..31, 33..35, 38..47:
 			            Reserved Instructions */
-				RESERVED(op);
-				break;
+				return RESERVED;
 			} /* switch (op & 0x3F) for Coprocessor 1 D-format opcodes */
-			break;
 		case 20: /* Coprocessor 1 W-format opcodes */
 			switch (op & 0x3F) {
-			case 32: CVT_S_W(op); break;
-			case 33: CVT_D_W(op); break;
+			case 32: return CVT_S_W;
+			case 33: return CVT_D_W;
 			default: /* Coprocessor 1 W-format opcodes 0..31, 34..63:
 			            Reserved Instructions */
-				RESERVED(op);
-				break;
+				return RESERVED;
 			}
-			break;
 		case 21: /* Coprocessor 1 L-format opcodes */
 			switch (op & 0x3F) {
-			case 32: CVT_S_L(op); break;
-			case 33: CVT_D_L(op); break;
+			case 32: return CVT_S_L;
+			case 33: return CVT_D_L;
 			default: /* Coprocessor 1 L-format opcodes 0..31, 34..63:
 			            Reserved Instructions */
-				RESERVED(op);
-				break;
+				return RESERVED;
 			}
-			break;
 		default: /* Coprocessor 1 opcodes 3, 7, 9..15, 18..19, 22..31:
 		            Reserved Instructions */
-			RESERVED(op);
-			break;
+			return RESERVED;
 		} /* switch ((op >> 21) & 0x1F) for the Coprocessor 1 prefix */
-		break;
 	case 20: /* Major opcode 20: BEQL */
-		if (IS_RELATIVE_IDLE_LOOP(op, PC->addr)) BEQL_IDLE(op);
-		else                                     BEQL(op);
-		break;
+		return BEQL_CHECK_IDLE;
 	case 21: /* Major opcode 21: BNEL */
-		if (IS_RELATIVE_IDLE_LOOP(op, PC->addr)) BNEL_IDLE(op);
-		else                                     BNEL(op);
-		break;
+		return BNEL_CHECK_IDLE;
 	case 22: /* Major opcode 22: BLEZL */
-		if (IS_RELATIVE_IDLE_LOOP(op, PC->addr)) BLEZL_IDLE(op);
-		else                                     BLEZL(op);
-		break;
+		return BLEZL_CHECK_IDLE;
 	case 23: /* Major opcode 23: BGTZL */
-		if (IS_RELATIVE_IDLE_LOOP(op, PC->addr)) BGTZL_IDLE(op);
-		else                                     BGTZL(op);
-		break;
+		return BGTZL_CHECK_IDLE;
 	case 24: /* Major opcode 24: DADDI */
-		if (RT_OF(op) != 0) DADDI(op);
-		else                NOP(0);
-		break;
+		return (RT_OF(op) != 0) ? DADDI : NOP;
 	case 25: /* Major opcode 25: DADDIU */
-		if (RT_OF(op) != 0) DADDIU(op);
-		else                NOP(0);
-		break;
+		return (RT_OF(op) != 0) ? DADDIU : NOP;
 	case 26: /* Major opcode 26: LDL */
-		if (RT_OF(op) != 0) LDL(op);
-		else                NOP(0);
-		break;
+		return (RT_OF(op) != 0) ? LDL : NOP;
 	case 27: /* Major opcode 27: LDR */
-		if (RT_OF(op) != 0) LDR(op);
-		else                NOP(0);
-		break;
+		return (RT_OF(op) != 0) ? LDR : NOP;
 	case 32: /* Major opcode 32: LB */
-		if (RT_OF(op) != 0) LB(op);
-		else                NOP(0);
-		break;
+		return (RT_OF(op) != 0) ? LB : NOP;
 	case 33: /* Major opcode 33: LH */
-		if (RT_OF(op) != 0) LH(op);
-		else                NOP(0);
-		break;
+		return (RT_OF(op) != 0) ? LH : NOP;
 	case 34: /* Major opcode 34: LWL */
-		if (RT_OF(op) != 0) LWL(op);
-		else                NOP(0);
-		break;
+		return (RT_OF(op) != 0) ? LWL : NOP;
 	case 35: /* Major opcode 35: LW */
-		if (RT_OF(op) != 0) LW(op);
-		else                NOP(0);
-		break;
+		return (RT_OF(op) != 0) ? LW : NOP;
 	case 36: /* Major opcode 36: LBU */
-		if (RT_OF(op) != 0) LBU(op);
-		else                NOP(0);
-		break;
+		return (RT_OF(op) != 0) ? LBU : NOP;
 	case 37: /* Major opcode 37: LHU */
-		if (RT_OF(op) != 0) LHU(op);
-		else                NOP(0);
-		break;
+		return (RT_OF(op) != 0) ? LHU : NOP;
 	case 38: /* Major opcode 38: LWR */
-		if (RT_OF(op) != 0) LWR(op);
-		else                NOP(0);
-		break;
+		return (RT_OF(op) != 0) ? LWR : NOP;
 	case 39: /* Major opcode 39: LWU */
-		if (RT_OF(op) != 0) LWU(op);
-		else                NOP(0);
-		break;
-	case 40: SB(op); break;
-	case 41: SH(op); break;
-	case 42: SWL(op); break;
-	case 43: SW(op); break;
-	case 44: SDL(op); break;
-	case 45: SDR(op); break;
-	case 46: SWR(op); break;
-	case 47: CACHE(op); break;
+		return (RT_OF(op) != 0) ? LWU : NOP;
+	case 40: return SB;
+	case 41: return SH;
+	case 42: return SWL;
+	case 43: return SW;
+	case 44: return SDL;
+	case 45: return SDR;
+	case 46: return SWR;
+	case 47: return CACHE;
 	case 48: /* Major opcode 48: LL */
-		if (RT_OF(op) != 0) LL(op);
-		else                NOP(0);
-		break;
-	case 49: LWC1(op); break;
+		return (RT_OF(op) != 0) ? LL : NOP;
+	case 49: return LWC1;
 	case 52: /* Major opcode 52: LLD (Not implemented) */
-		NI(op);
-		break;
-	case 53: LDC1(op); break;
+		return NI;
+	case 53: return LDC1;
 	case 55: /* Major opcode 55: LD */
-		if (RT_OF(op) != 0) LD(op);
-		else                NOP(0);
-		break;
+		return (RT_OF(op) != 0) ? LD : NOP;
 	case 56: /* Major opcode 56: SC */
-		if (RT_OF(op) != 0) SC(op);
-		else                NOP(0);
-		break;
-	case 57: SWC1(op); break;
+		return (RT_OF(op) != 0) ? SC : NOP;
+	case 57: return SWC1;
 	case 60: /* Major opcode 60: SCD (Not implemented) */
-		NI(op);
-		break;
-	case 61: SDC1(op); break;
-	case 63: SD(op); break;
+		return NI;
+	case 61: return SDC1;
+	case 63: return SD;
 	default: /* Major opcodes 18..19, 28..31, 50..51, 54, 58..59, 62:
 	            Reserved Instructions */
-		RESERVED(op);
-		break;
+		return RESERVED;
 	} /* switch ((op >> 26) & 0x3F) */
 }
 
+/* Instructions in RDRAM are decoded once, and cached per physical page.
+ * An entry is only used if memory still holds the opcode it was decoded from,
+ * so writes which aren't reported to invalidate_r4300_cached_code() (like
+ * those done by the RSP) can't make it stale. */
+struct decoded_instr
+{
+   pure_instr_func func;
+   uint32_t op;
+};
+
+struct decoded_page
+{
+   struct decoded_instr instrs[0x1000 / 4];
+};
+
+static struct decoded_page *decoded_pages[RDRAM_MAX_SIZE / 0x1000];
+
+static void free_decoded_pages(void)
+{
+   size_t i;
+
+   for (i = 0; i < RDRAM_MAX_SIZE / 0x1000; ++i)
+   {
+      free(decoded_pages[i]);
+      decoded_pages[i] = NULL;
+   }
+}
+
+void invalidate_pure_interp_code(uint32_t address, size_t size)
+{
+   struct decoded_page *page;
+   uint32_t end;
+
+   if (size == 0)
+   {
+      free_decoded_pages();
+      return;
+   }
+
+   address &= UINT32_C(0x1ffffffc);
+   if (address >= RDRAM_MAX_SIZE)
+      return;
+
+   end = (size < RDRAM_MAX_SIZE - address) ? address + (uint32_t) size : RDRAM_MAX_SIZE;
+
+   for (; address < end; address += 4)
+   {
+      page = decoded_pages[address >> 12];
+      if (page != NULL)
+         page->instrs[(address & 0xfff) / 4].func = NULL;
+   }
+}
+
+static void InterpretOpcode(void)
+{
+   uint32_t address = PC->addr;
+   struct decoded_page *page;
+   struct decoded_instr *instr;
+   uint32_t op;
+
+   /* same translation as fast_mem_access() */
+   if ((address & UINT32_C(0xc0000000)) != UINT32_C(0x80000000))
+      address = virtual_to_physical_address(address, 2);
+
+   address &= UINT32_C(0x1ffffffc);
+
+   if (address >= RDRAM_MAX_SIZE)
+   {
+      op = *fast_mem_access(UINT32_C(0x80000000) | address);
+      decode_opcode(op)(op);
+      return;
+   }
+
+   op = g_rdram[address / 4];
+
+   page = decoded_pages[address >> 12];
+   if (page == NULL)
+   {
+      page = decoded_pages[address >> 12] = calloc(1, sizeof(*page));
+      if (page == NULL)
+      {
+         decode_opcode(op)(op);
+         return;
+      }
+      mark_r4300_code_page(address);
+   }
+
+   instr = &page->instrs[(address & 0xfff) / 4];
+   if (instr->func == NULL || instr->op != op)
+   {
+      instr->func = decode_opcode(op);
+      instr->op = op;
+   }
+
+   instr->func(op);
+}
+
 void pure_interpreter(void)
 {
    stop = 0;
@@ -738,4 +685,6 @@ void pure_interpreter(void)
 #endif
      InterpretOpcode();
    }
+
+   free_decoded_pages();
 }
@@ -22,6 +22,11 @@
 #ifndef M64P_R4300_PURE_INTERP_H
 #define M64P_R4300_PURE_INTERP_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 void pure_interpreter(void);
 
+void invalidate_pure_interp_code(uint32_t address, size_t size);
+
 #endif /* M64P_R4300_PURE_INTERP_H */
@@ -28,11 +28,14 @@
 #include "api/debugger.h"
 #include "api/m64p_types.h"
 #include "cached_interp.h"
+#include "code_cache.h"
 #include "cp0_private.h"
 #include "cp1_private.h"
+#include "device/device.h"
 #include "interupt.h"
 #include "main/main.h"
 #include "main/rom.h"
+#include "memory/fastmem.h"
 #include "memory/memory.h"
 #include "mi_controller.h"
 #include "new_dynarec/new_dynarec.h"
@@ -166,7 +169,7 @@ static unsigned int get_tv_type(void)
 }
 
 /* Simulates end result of PIFBootROM execution */
-void r4300_reset_soft(void)
+void r4300_reset_soft(struct device* dev)
 {
     unsigned int rom_type = 0;              /* 0:Cart, 1:DD */
     unsigned int reset_type = 0;            /* 0:ColdReset, 1:NMI */
@@ -174,44 +177,46 @@ void r4300_reset_soft(void)
     unsigned int tv_type = get_tv_type();   /* 0:PAL, 1:NTSC, 2:MPAL */
     uint32_t bsd_dom1_config = *(uint32_t*)g_rom;
 
+    rsp_wait_task(&dev->sp);
+
     g_cp0_regs[CP0_STATUS_REG] = 0x34000000;
     g_cp0_regs[CP0_CONFIG_REG] = 0x0006e463;
 
-    g_sp.regs[SP_STATUS_REG] = 1;
-    g_sp.regs2[SP_PC_REG] = 0;
+    dev->sp.regs[SP_STATUS_REG] = 1;
+    dev->sp.regs2[SP_PC_REG] = 0;
 
-    g_pi.regs[PI_BSD_DOM1_LAT_REG] = (bsd_dom1_config      ) & 0xff;
-    g_pi.regs[PI_BSD_DOM1_PWD_REG] = (bsd_dom1_config >>  8) & 0xff;
-    g_pi.regs[PI_BSD_DOM1_PGS_REG] = (bsd_dom1_config >> 16) & 0x0f;
-    g_pi.regs[PI_BSD_DOM1_RLS_REG] = (bsd_dom1_config >> 20) & 0x03;
-    g_pi.regs[PI_STATUS_REG] = 0;
+    dev->pi.regs[PI_BSD_DOM1_LAT_REG] = (bsd_dom1_config      ) & 0xff;
+    dev->pi.regs[PI_BSD_DOM1_PWD_REG] = (bsd_dom1_config >>  8) & 0xff;
+    dev->pi.regs[PI_BSD_DOM1_PGS_REG] = (bsd_dom1_config >> 16) & 0x0f;
+    dev->pi.regs[PI_BSD_DOM1_RLS_REG] = (bsd_dom1_config >> 20) & 0x03;
+    dev->pi.regs[PI_STATUS_REG] = 0;
 
-    g_ai.regs[AI_DRAM_ADDR_REG] = 0;
-    g_ai.regs[AI_LEN_REG] = 0;
+    dev->ai.regs[AI_DRAM_ADDR_REG] = 0;
+    dev->ai.regs[AI_LEN_REG] = 0;
 
-    g_vi.regs[VI_V_INTR_REG] = 1023;
-    g_vi.regs[VI_CURRENT_REG] = 0;
-    g_vi.regs[VI_H_START_REG] = 0;
+    dev->vi.regs[VI_V_INTR_REG] = 1023;
+    dev->vi.regs[VI_CURRENT_REG] = 0;
+    dev->vi.regs[VI_H_START_REG] = 0;
 
-    g_r4300.mi.regs[MI_INTR_REG] &= ~(MI_INTR_PI | MI_INTR_VI | MI_INTR_AI | MI_INTR_SP);
+    dev->r4300.mi.regs[MI_INTR_REG] &= ~(MI_INTR_PI | MI_INTR_VI | MI_INTR_AI | MI_INTR_SP);
 
-    memcpy((unsigned char*)g_sp.mem+0x40, g_rom+0x40, 0xfc0);
+    memcpy((unsigned char*)dev->sp.mem+0x40, g_rom+0x40, 0xfc0);
 
     reg[19] = rom_type;     /* s3 */
     reg[20] = tv_type;      /* s4 */
     reg[21] = reset_type;   /* s5 */
-    reg[22] = g_si.pif.cic.seed;/* s6 */
+    reg[22] = dev->si.pif.cic.seed;/* s6 */
     reg[23] = s7;           /* s7 */
 
     /* required by CIC x105 */
-    g_sp.mem[0x1000/4] = 0x3c0dbfc0;
-    g_sp.mem[0x1004/4] = 0x8da807fc;
-    g_sp.mem[0x1008/4] = 0x25ad07c0;
-    g_sp.mem[0x100c/4] = 0x31080080;
-    g_sp.mem[0x1010/4] = 0x5500fffc;
-    g_sp.mem[0x1014/4] = 0x3c0dbfc0;
-    g_sp.mem[0x1018/4] = 0x8da80024;
-    g_sp.mem[0x101c/4] = 0x3c0bb000;
+    dev->sp.mem[0x1000/4] = 0x3c0dbfc0;
+    dev->sp.mem[0x1004/4] = 0x8da807fc;
+    dev->sp.mem[0x1008/4] = 0x25ad07c0;
+    dev->sp.mem[0x100c/4] = 0x31080080;
+    dev->sp.mem[0x1010/4] = 0x5500fffc;
+    dev->sp.mem[0x1014/4] = 0x3c0dbfc0;
+    dev->sp.mem[0x1018/4] = 0x8da80024;
+    dev->sp.mem[0x101c/4] = 0x3c0bb000;
 
     /* required by CIC x105 */
     reg[11] = INT64_C(0xffffffffa4000040); /* t3 */
@@ -254,6 +259,7 @@ void r4300_execute(void)
     last_addr = 0xa4000040;
     next_interupt = 624999;
     init_interupt();
+    clear_r4300_code_pages();
 
     if (r4300emu == CORE_PURE_INTERPRETER)
     {
@@ -266,6 +272,17 @@ void r4300_execute(void)
     {
         DebugMessage(M64MSG_INFO, "Starting R4300 emulator: Dynamic Recompiler");
         r4300emu = CORE_DYNAREC;
+#if !defined(NEW_DYNAREC)
+        if (!code_cache_init())
+        {
+            DebugMessage(M64MSG_ERROR, "Memory error: couldn't allocate the code cache of the dynamic recompiler. Try to use an interpreter mode.");
+            return;
+        }
+#endif
+#if !defined(NEW_DYNAREC) && defined(__x86_64__)
+        if (use_fastmem && !fastmem_init(g_dev.ri.rdram.dram_size, dynarec_fastmem_fixup))
+            DebugMessage(M64MSG_WARNING, "Fastmem not available, falling back to memory handler tables");
+#endif
         init_blocks();
 
 #ifdef NEW_DYNAREC
@@ -279,21 +296,26 @@ void r4300_execute(void)
 #if defined(PROFILE_R4300)
         pfProfile = fopen("instructionaddrs.dat", "ab");
         for (i=0; i<0x100000; i++)
-            if (invalid_code[i] == 0 && blocks[i] != NULL && blocks[i]->code != NULL && blocks[i]->block != NULL)
+        {
+            precomp_block *block = get_block(i);
+            if (get_invalid_code(i) == 0 && block != NULL && block->code != NULL && block->block != NULL)
             {
                 unsigned char *x86addr;
                 int mipsop;
                 // store final code length for this block
                 mipsop = -1; /* -1 == end of x86 code block */
-                x86addr = blocks[i]->code + blocks[i]->code_length;
+                x86addr = block->code + block->code_length;
                 if (fwrite(&mipsop, 1, 4, pfProfile) != 4 ||
                     fwrite(&x86addr, 1, sizeof(char *), pfProfile) != sizeof(char *))
                     DebugMessage(M64MSG_ERROR, "Error writing R4300 instruction address profiling data");
             }
+        }
         fclose(pfProfile);
         pfProfile = NULL;
 #endif
         free_blocks();
+        code_cache_deinit();
+        fastmem_deinit();
     }
 #endif
     else /* if (r4300emu == CORE_INTERPRETER) */
@@ -28,6 +28,8 @@
 #include "r4300_core.h"
 #include "recomp.h"
 
+struct device;
+
 extern precomp_instr *PC;
 
 extern int stop, rompause;
@@ -45,7 +47,7 @@ extern unsigned int count_per_op;
 extern cpu_instruction_table current_instruction_table;
 
 void r4300_reset_hard(void);
-void r4300_reset_soft(void);
+void r4300_reset_soft(struct device* dev);
 void r4300_execute(void);
 
 // r4300 emulators
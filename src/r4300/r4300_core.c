@@ -21,9 +21,12 @@
 
 #include "r4300_core.h"
 
+#include <string.h>
+
 #include "cached_interp.h"
 #include "mi_controller.h"
 #include "new_dynarec/new_dynarec.h"
+#include "pure_interp.h"
 #include "r4300.h"
 #include "recomp.h"
 
@@ -80,7 +83,14 @@ unsigned int get_r4300_emumode(void)
 
 
 
-void invalidate_r4300_cached_code(uint32_t address, size_t size)
+uint32_t g_r4300_code_pages[RDRAM_MAX_SIZE / 0x1000 / 32];
+
+void clear_r4300_code_pages(void)
+{
+    memset(g_r4300_code_pages, 0, sizeof(g_r4300_code_pages));
+}
+
+static void invalidate_cached_code(uint32_t address, size_t size)
 {
     if (r4300emu != CORE_PURE_INTERPRETER)
     {
@@ -95,6 +105,44 @@ void invalidate_r4300_cached_code(uint32_t address, size_t size)
             invalidate_cached_code_hacktarux(address, size);
         }
     }
+    else
+    {
+        invalidate_pure_interp_code(address, size);
+    }
+}
+
+void invalidate_r4300_cached_code(uint32_t address, size_t size)
+{
+    uint32_t end;
+    uint32_t next;
+
+    /* only RDRAM pages seen through KSEG0/KSEG1 can be filtered */
+    if (size == 0
+    || (address & UINT32_C(0xc0000000)) != UINT32_C(0x80000000)
+    || (address & UINT32_C(0x1fffffff)) >= RDRAM_MAX_SIZE
+    || size > RDRAM_MAX_SIZE - (address & UINT32_C(0x1fffffff)))
+    {
+        invalidate_cached_code(address, size);
+        return;
+    }
+
+    end = address + (uint32_t)size;
+
+    for (; address < end; address = next)
+    {
+        next = (address | 0xfff) + 1;
+        if (next > end)
+            next = end;
+
+        if (is_r4300_code_page(address))
+            invalidate_cached_code(address, next - address);
+    }
+}
+
+void invalidate_r4300_cached_dram(uint32_t dram_address, size_t size)
+{
+    invalidate_r4300_cached_code(UINT32_C(0x80000000) + dram_address, size);
+    invalidate_r4300_cached_code(UINT32_C(0xa0000000) + dram_address, size);
 }
 
 /* XXX: not really a good interface but it gets the job done... */
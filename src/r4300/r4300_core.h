@@ -28,11 +28,14 @@
 #include "cp0.h"
 #include "cp1.h"
 #include "interupt.h"
+#include "main/main.h"
 #include "mi_controller.h"
+#include "osal/preproc.h"
 #include "tlb.h"
 
 struct r4300_core
 {
+    struct interrupt_queue q;
     struct mi_controller mi;
 };
 
@@ -57,6 +60,39 @@ unsigned int get_r4300_emumode(void);
  */
 void invalidate_r4300_cached_code(uint32_t address, size_t size);
 
+/* Invalidate cached code at [dram_address, dram_address+size] through
+ * both the KSEG0 and KSEG1 views of RDRAM. Use this after DMA writes. */
+void invalidate_r4300_cached_dram(uint32_t dram_address, size_t size);
+
+/* One bit per 4KB page of RDRAM, set when a r4300 implementation caches
+ * code from that page. Bits are only cleared when emulation starts, so
+ * writes to a page whose bit is clear can't hit any cached code. */
+extern uint32_t g_r4300_code_pages[RDRAM_MAX_SIZE / 0x1000 / 32];
+
+void clear_r4300_code_pages(void);
+
+/* address is either physical or in KSEG0/KSEG1 */
+static osal_inline void mark_r4300_code_page(uint32_t address)
+{
+    uint32_t page = (address & UINT32_C(0x1fffffff)) >> 12;
+
+    if (page < RDRAM_MAX_SIZE / 0x1000)
+        g_r4300_code_pages[page / 32] |= UINT32_C(1) << (page % 32);
+}
+
+/* address is virtual. TLB mapped addresses and addresses outside of
+ * RDRAM are conservatively reported as possibly holding code. */
+static osal_inline int is_r4300_code_page(uint32_t address)
+{
+    uint32_t page = (address & UINT32_C(0x1fffffff)) >> 12;
+
+    if ((address & UINT32_C(0xc0000000)) != UINT32_C(0x80000000)
+    || page >= RDRAM_MAX_SIZE / 0x1000)
+        return 1;
+
+    return (g_r4300_code_pages[page / 32] >> (page % 32)) & 1;
+}
+
 
 /* Jump to the given address. This works for all r4300 emulator, but is slower.
  * Use this for common code which can be executed from any r4300 emulator. */
@@ -26,28 +26,21 @@
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
 
-#if defined(__GNUC__)
-#include <unistd.h>
-#ifndef __MINGW32__
-#include <sys/mman.h>
-#endif
-#endif
-
 #include "api/callbacks.h"
 #include "api/m64p_types.h"
 #include "cached_interp.h"
+#include "code_cache.h"
 #include "cp0_private.h"
+#include "idle_loop.h"
 #include "main/profile.h"
 #include "memory/memory.h"
 #include "ops.h"
 #include "r4300.h"
+#include "r4300_core.h"
 #include "recomp.h"
 #include "recomph.h" //include for function prototypes
 #include "tlb.h"
 
-static void *malloc_exec(size_t size);
-static void free_exec(void *ptr, size_t length);
-
 // global variables :
 precomp_instr *dst; // destination structure for the recompiled instruction
 int code_length; // current real recompiled code length
@@ -57,6 +50,7 @@ precomp_block *dst_block; // the current block that we are recompiling
 uint32_t src; // the current recompiled instruction
 int fast_memory;
 int no_compiled_jump = 0; /* use cached interpreter instead of recompiler for jumps */
+int use_fastmem = 0; /* let the recompiler access RDRAM through the fastmem window */
 
 static void (*recomp_func)(void); // pointer to the dynarec's generator
                                   // function for the latest decoded opcode
@@ -91,8 +85,8 @@ static void RNOTCOMPILED(void)
 
 static void recompile_standard_i_type(void)
 {
-   dst->f.i.rs = reg + ((src >> 21) & 0x1F);
-   dst->f.i.rt = reg + ((src >> 16) & 0x1F);
+   dst->f.i.rs = (src >> 21) & 0x1F;
+   dst->f.i.rt = (src >> 16) & 0x1F;
    dst->f.i.immediate = (int16_t) src;
 }
 
@@ -103,9 +97,9 @@ static void recompile_standard_j_type(void)
 
 static void recompile_standard_r_type(void)
 {
-   dst->f.r.rs = reg + ((src >> 21) & 0x1F);
-   dst->f.r.rt = reg + ((src >> 16) & 0x1F);
-   dst->f.r.rd = reg + ((src >> 11) & 0x1F);
+   dst->f.r.rs = (src >> 21) & 0x1F;
+   dst->f.r.rt = (src >> 16) & 0x1F;
+   dst->f.r.rd = (src >> 11) & 0x1F;
    dst->f.r.sa = (src >>  6) & 0x1F;
 }
 
@@ -138,7 +132,7 @@ static void RSLL(void)
    dst->ops = current_instruction_table.SLL;
    recomp_func = gensll;
    recompile_standard_r_type();
-   if (dst->f.r.rd == reg) RNOP();
+   if (dst->f.r.rd == 0) RNOP();
 }
 
 static void RSRL(void)
@@ -146,7 +140,7 @@ static void RSRL(void)
    dst->ops = current_instruction_table.SRL;
    recomp_func = gensrl;
    recompile_standard_r_type();
-   if (dst->f.r.rd == reg) RNOP();
+   if (dst->f.r.rd == 0) RNOP();
 }
 
 static void RSRA(void)
@@ -154,7 +148,7 @@ static void RSRA(void)
    dst->ops = current_instruction_table.SRA;
    recomp_func = gensra;
    recompile_standard_r_type();
-   if (dst->f.r.rd == reg) RNOP();
+   if (dst->f.r.rd == 0) RNOP();
 }
 
 static void RSLLV(void)
@@ -162,7 +156,7 @@ static void RSLLV(void)
    dst->ops = current_instruction_table.SLLV;
    recomp_func = gensllv;
    recompile_standard_r_type();
-   if (dst->f.r.rd == reg) RNOP();
+   if (dst->f.r.rd == 0) RNOP();
 }
 
 static void RSRLV(void)
@@ -170,7 +164,7 @@ static void RSRLV(void)
    dst->ops = current_instruction_table.SRLV;
    recomp_func = gensrlv;
    recompile_standard_r_type();
-   if (dst->f.r.rd == reg) RNOP();
+   if (dst->f.r.rd == 0) RNOP();
 }
 
 static void RSRAV(void)
@@ -178,7 +172,7 @@ static void RSRAV(void)
    dst->ops = current_instruction_table.SRAV;
    recomp_func = gensrav;
    recompile_standard_r_type();
-   if (dst->f.r.rd == reg) RNOP();
+   if (dst->f.r.rd == 0) RNOP();
 }
 
 static void RJR(void)
@@ -218,7 +212,7 @@ static void RMFHI(void)
    dst->ops = current_instruction_table.MFHI;
    recomp_func = genmfhi;
    recompile_standard_r_type();
-   if (dst->f.r.rd == reg) RNOP();
+   if (dst->f.r.rd == 0) RNOP();
 }
 
 static void RMTHI(void)
@@ -233,7 +227,7 @@ static void RMFLO(void)
    dst->ops = current_instruction_table.MFLO;
    recomp_func = genmflo;
    recompile_standard_r_type();
-   if (dst->f.r.rd == reg) RNOP();
+   if (dst->f.r.rd == 0) RNOP();
 }
 
 static void RMTLO(void)
@@ -248,7 +242,7 @@ static void RDSLLV(void)
    dst->ops = current_instruction_table.DSLLV;
    recomp_func = gendsllv;
    recompile_standard_r_type();
-   if (dst->f.r.rd == reg) RNOP();
+   if (dst->f.r.rd == 0) RNOP();
 }
 
 static void RDSRLV(void)
@@ -256,7 +250,7 @@ static void RDSRLV(void)
    dst->ops = current_instruction_table.DSRLV;
    recomp_func = gendsrlv;
    recompile_standard_r_type();
-   if (dst->f.r.rd == reg) RNOP();
+   if (dst->f.r.rd == 0) RNOP();
 }
 
 static void RDSRAV(void)
@@ -264,7 +258,7 @@ static void RDSRAV(void)
    dst->ops = current_instruction_table.DSRAV;
    recomp_func = gendsrav;
    recompile_standard_r_type();
-   if (dst->f.r.rd == reg) RNOP();
+   if (dst->f.r.rd == 0) RNOP();
 }
 
 static void RMULT(void)
@@ -328,7 +322,7 @@ static void RADD(void)
    dst->ops = current_instruction_table.ADD;
    recomp_func = genadd;
    recompile_standard_r_type();
-   if (dst->f.r.rd == reg) RNOP();
+   if (dst->f.r.rd == 0) RNOP();
 }
 
 static void RADDU(void)
@@ -336,7 +330,7 @@ static void RADDU(void)
    dst->ops = current_instruction_table.ADDU;
    recomp_func = genaddu;
    recompile_standard_r_type();
-   if (dst->f.r.rd == reg) RNOP();
+   if (dst->f.r.rd == 0) RNOP();
 }
 
 static void RSUB(void)
@@ -344,7 +338,7 @@ static void RSUB(void)
    dst->ops = current_instruction_table.SUB;
    recomp_func = gensub;
    recompile_standard_r_type();
-   if (dst->f.r.rd == reg) RNOP();
+   if (dst->f.r.rd == 0) RNOP();
 }
 
 static void RSUBU(void)
@@ -352,7 +346,7 @@ static void RSUBU(void)
    dst->ops = current_instruction_table.SUBU;
    recomp_func = gensubu;
    recompile_standard_r_type();
-   if (dst->f.r.rd == reg) RNOP();
+   if (dst->f.r.rd == 0) RNOP();
 }
 
 static void RAND(void)
@@ -360,7 +354,7 @@ static void RAND(void)
    dst->ops = current_instruction_table.AND;
    recomp_func = genand;
    recompile_standard_r_type();
-   if(dst->f.r.rd == reg) RNOP();
+   if(dst->f.r.rd == 0) RNOP();
 }
 
 static void ROR(void)
@@ -368,7 +362,7 @@ static void ROR(void)
    dst->ops = current_instruction_table.OR;
    recomp_func = genor;
    recompile_standard_r_type();
-   if(dst->f.r.rd == reg) RNOP();
+   if(dst->f.r.rd == 0) RNOP();
 }
 
 static void RXOR(void)
@@ -376,7 +370,7 @@ static void RXOR(void)
    dst->ops = current_instruction_table.XOR;
    recomp_func = genxor;
    recompile_standard_r_type();
-   if(dst->f.r.rd == reg) RNOP();
+   if(dst->f.r.rd == 0) RNOP();
 }
 
 static void RNOR(void)
@@ -384,7 +378,7 @@ static void RNOR(void)
    dst->ops = current_instruction_table.NOR;
    recomp_func = gennor;
    recompile_standard_r_type();
-   if(dst->f.r.rd == reg) RNOP();
+   if(dst->f.r.rd == 0) RNOP();
 }
 
 static void RSLT(void)
@@ -392,7 +386,7 @@ static void RSLT(void)
    dst->ops = current_instruction_table.SLT;
    recomp_func = genslt;
    recompile_standard_r_type();
-   if(dst->f.r.rd == reg) RNOP();
+   if(dst->f.r.rd == 0) RNOP();
 }
 
 static void RSLTU(void)
@@ -400,7 +394,7 @@ static void RSLTU(void)
    dst->ops = current_instruction_table.SLTU;
    recomp_func = gensltu;
    recompile_standard_r_type();
-   if(dst->f.r.rd == reg) RNOP();
+   if(dst->f.r.rd == 0) RNOP();
 }
 
 static void RDADD(void)
@@ -408,7 +402,7 @@ static void RDADD(void)
    dst->ops = current_instruction_table.DADD;
    recomp_func = gendadd;
    recompile_standard_r_type();
-   if (dst->f.r.rd == reg) RNOP();
+   if (dst->f.r.rd == 0) RNOP();
 }
 
 static void RDADDU(void)
@@ -416,7 +410,7 @@ static void RDADDU(void)
    dst->ops = current_instruction_table.DADDU;
    recomp_func = gendaddu;
    recompile_standard_r_type();
-   if (dst->f.r.rd == reg) RNOP();
+   if (dst->f.r.rd == 0) RNOP();
 }
 
 static void RDSUB(void)
@@ -424,7 +418,7 @@ static void RDSUB(void)
    dst->ops = current_instruction_table.DSUB;
    recomp_func = gendsub;
    recompile_standard_r_type();
-   if (dst->f.r.rd == reg) RNOP();
+   if (dst->f.r.rd == 0) RNOP();
 }
 
 static void RDSUBU(void)
@@ -432,7 +426,7 @@ static void RDSUBU(void)
    dst->ops = current_instruction_table.DSUBU;
    recomp_func = gendsubu;
    recompile_standard_r_type();
-   if (dst->f.r.rd == reg) RNOP();
+   if (dst->f.r.rd == 0) RNOP();
 }
 
 static void RTGE(void)
@@ -477,7 +471,7 @@ static void RDSLL(void)
    dst->ops = current_instruction_table.DSLL;
    recomp_func = gendsll;
    recompile_standard_r_type();
-   if (dst->f.r.rd == reg) RNOP();
+   if (dst->f.r.rd == 0) RNOP();
 }
 
 static void RDSRL(void)
@@ -485,7 +479,7 @@ static void RDSRL(void)
    dst->ops = current_instruction_table.DSRL;
    recomp_func = gendsrl;
    recompile_standard_r_type();
-   if (dst->f.r.rd == reg) RNOP();
+   if (dst->f.r.rd == 0) RNOP();
 }
 
 static void RDSRA(void)
@@ -493,7 +487,7 @@ static void RDSRA(void)
    dst->ops = current_instruction_table.DSRA;
    recomp_func = gendsra;
    recompile_standard_r_type();
-   if (dst->f.r.rd == reg) RNOP();
+   if (dst->f.r.rd == 0) RNOP();
 }
 
 static void RDSLL32(void)
@@ -501,7 +495,7 @@ static void RDSLL32(void)
    dst->ops = current_instruction_table.DSLL32;
    recomp_func = gendsll32;
    recompile_standard_r_type();
-   if (dst->f.r.rd == reg) RNOP();
+   if (dst->f.r.rd == 0) RNOP();
 }
 
 static void RDSRL32(void)
@@ -509,7 +503,7 @@ static void RDSRL32(void)
    dst->ops = current_instruction_table.DSRL32;
    recomp_func = gendsrl32;
    recompile_standard_r_type();
-   if (dst->f.r.rd == reg) RNOP();
+   if (dst->f.r.rd == 0) RNOP();
 }
 
 static void RDSRA32(void)
@@ -517,7 +511,7 @@ static void RDSRA32(void)
    dst->ops = current_instruction_table.DSRA32;
    recomp_func = gendsra32;
    recompile_standard_r_type();
-   if (dst->f.r.rd == reg) RNOP();
+   if (dst->f.r.rd == 0) RNOP();
 }
 
 static void (*recomp_special[64])(void) =
@@ -532,6 +526,18 @@ static void (*recomp_special[64])(void) =
    RDSLL, RSV   , RDSRL, RDSRA, RDSLL32 , RSV    , RDSRL32, RDSRA32
 };
 
+/* Determines whether a jump to target closes an idle loop in the current block.
+ * Jumps to themselves with a nop in their delay slot are handled separately. */
+static int is_idle_loop_jump(uint32_t target)
+{
+   const uint32_t *block_src = SRC - (dst->addr - dst_block->start) / 4;
+
+   if (target < dst_block->start || target >= dst->addr || dst->addr == (dst_block->end-4))
+      return 0;
+
+   return is_idle_loop(block_src, block_src + (target - dst_block->start) / 4, SRC);
+}
+
 //-------------------------------------------------------------------------
 //                                   REGIMM                                
 //-------------------------------------------------------------------------
@@ -551,6 +557,11 @@ static void RBLTZ(void)
          recomp_func = genbltz_idle;
       }
    }
+   else if (is_idle_loop_jump(target))
+   {
+      dst->ops = current_instruction_table.BLTZ_IDLE;
+      recomp_func = genbltz_idle;
+   }
    else if (target < dst_block->start || target >= dst_block->end || dst->addr == (dst_block->end-4))
    {
       dst->ops = current_instruction_table.BLTZ_OUT;
@@ -573,6 +584,11 @@ static void RBGEZ(void)
          recomp_func = genbgez_idle;
       }
    }
+   else if (is_idle_loop_jump(target))
+   {
+      dst->ops = current_instruction_table.BGEZ_IDLE;
+      recomp_func = genbgez_idle;
+   }
    else if (target < dst_block->start || target >= dst_block->end || dst->addr == (dst_block->end-4))
    {
       dst->ops = current_instruction_table.BGEZ_OUT;
@@ -595,6 +611,11 @@ static void RBLTZL(void)
          recomp_func = genbltzl_idle;
       }
    }
+   else if (is_idle_loop_jump(target))
+   {
+      dst->ops = current_instruction_table.BLTZL_IDLE;
+      recomp_func = genbltzl_idle;
+   }
    else if (target < dst_block->start || target >= dst_block->end || dst->addr == (dst_block->end-4))
    {
       dst->ops = current_instruction_table.BLTZL_OUT;
@@ -617,6 +638,11 @@ static void RBGEZL(void)
          recomp_func = genbgezl_idle;
       }
    }
+   else if (is_idle_loop_jump(target))
+   {
+      dst->ops = current_instruction_table.BGEZL_IDLE;
+      recomp_func = genbgezl_idle;
+   }
    else if (target < dst_block->start || target >= dst_block->end || dst->addr == (dst_block->end-4))
    {
       dst->ops = current_instruction_table.BGEZL_OUT;
@@ -811,9 +837,8 @@ static void RMFC0(void)
    dst->ops = current_instruction_table.MFC0;
    recomp_func = genmfc0;
    recompile_standard_r_type();
-   dst->f.r.rd = (int64_t*) (g_cp0_regs + ((src >> 11) & 0x1F));
    dst->f.r.nrd = (src >> 11) & 0x1F;
-   if (dst->f.r.rt == reg) RNOP();
+   if (dst->f.r.rt == 0) RNOP();
 }
 
 static void RMTC0(void)
@@ -1527,7 +1552,7 @@ static void RMFC1(void)
    recomp_func = genmfc1;
    recompile_standard_r_type();
    dst->f.r.nrd = (src >> 11) & 0x1F;
-   if (dst->f.r.rt == reg) RNOP();
+   if (dst->f.r.rt == 0) RNOP();
 }
 
 static void RDMFC1(void)
@@ -1536,7 +1561,7 @@ static void RDMFC1(void)
    recomp_func = gendmfc1;
    recompile_standard_r_type();
    dst->f.r.nrd = (src >> 11) & 0x1F;
-   if (dst->f.r.rt == reg) RNOP();
+   if (dst->f.r.rt == 0) RNOP();
 }
 
 static void RCFC1(void)
@@ -1545,7 +1570,7 @@ static void RCFC1(void)
    recomp_func = gencfc1;
    recompile_standard_r_type();
    dst->f.r.nrd = (src >> 11) & 0x1F;
-   if (dst->f.r.rt == reg) RNOP();
+   if (dst->f.r.rt == 0) RNOP();
 }
 
 static void RMTC1(void)
@@ -1634,6 +1659,11 @@ static void RJ(void)
          recomp_func = genj_idle;
       }
    }
+   else if (is_idle_loop_jump(target))
+   {
+      dst->ops = current_instruction_table.J_IDLE;
+      recomp_func = genj_idle;
+   }
    else if (target < dst_block->start || target >= dst_block->end || dst->addr == (dst_block->end-4))
    {
       dst->ops = current_instruction_table.J_OUT;
@@ -1678,6 +1708,11 @@ static void RBEQ(void)
          recomp_func = genbeq_idle;
       }
    }
+   else if (is_idle_loop_jump(target))
+   {
+      dst->ops = current_instruction_table.BEQ_IDLE;
+      recomp_func = genbeq_idle;
+   }
    else if (target < dst_block->start || target >= dst_block->end || dst->addr == (dst_block->end-4))
    {
       dst->ops = current_instruction_table.BEQ_OUT;
@@ -1700,6 +1735,11 @@ static void RBNE(void)
          recomp_func = genbne_idle;
       }
    }
+   else if (is_idle_loop_jump(target))
+   {
+      dst->ops = current_instruction_table.BNE_IDLE;
+      recomp_func = genbne_idle;
+   }
    else if (target < dst_block->start || target >= dst_block->end || dst->addr == (dst_block->end-4))
    {
       dst->ops = current_instruction_table.BNE_OUT;
@@ -1722,6 +1762,11 @@ static void RBLEZ(void)
          recomp_func = genblez_idle;
       }
    }
+   else if (is_idle_loop_jump(target))
+   {
+      dst->ops = current_instruction_table.BLEZ_IDLE;
+      recomp_func = genblez_idle;
+   }
    else if (target < dst_block->start || target >= dst_block->end || dst->addr == (dst_block->end-4))
    {
       dst->ops = current_instruction_table.BLEZ_OUT;
@@ -1744,6 +1789,11 @@ static void RBGTZ(void)
          recomp_func = genbgtz_idle;
       }
    }
+   else if (is_idle_loop_jump(target))
+   {
+      dst->ops = current_instruction_table.BGTZ_IDLE;
+      recomp_func = genbgtz_idle;
+   }
    else if (target < dst_block->start || target >= dst_block->end || dst->addr == (dst_block->end-4))
    {
       dst->ops = current_instruction_table.BGTZ_OUT;
@@ -1756,7 +1806,7 @@ static void RADDI(void)
    dst->ops = current_instruction_table.ADDI;
    recomp_func = genaddi;
    recompile_standard_i_type();
-   if(dst->f.i.rt == reg) RNOP();
+   if(dst->f.i.rt == 0) RNOP();
 }
 
 static void RADDIU(void)
@@ -1764,7 +1814,7 @@ static void RADDIU(void)
    dst->ops = current_instruction_table.ADDIU;
    recomp_func = genaddiu;
    recompile_standard_i_type();
-   if(dst->f.i.rt == reg) RNOP();
+   if(dst->f.i.rt == 0) RNOP();
 }
 
 static void RSLTI(void)
@@ -1772,7 +1822,7 @@ static void RSLTI(void)
    dst->ops = current_instruction_table.SLTI;
    recomp_func = genslti;
    recompile_standard_i_type();
-   if(dst->f.i.rt == reg) RNOP();
+   if(dst->f.i.rt == 0) RNOP();
 }
 
 static void RSLTIU(void)
@@ -1780,7 +1830,7 @@ static void RSLTIU(void)
    dst->ops = current_instruction_table.SLTIU;
    recomp_func = gensltiu;
    recompile_standard_i_type();
-   if(dst->f.i.rt == reg) RNOP();
+   if(dst->f.i.rt == 0) RNOP();
 }
 
 static void RANDI(void)
@@ -1788,7 +1838,7 @@ static void RANDI(void)
    dst->ops = current_instruction_table.ANDI;
    recomp_func = genandi;
    recompile_standard_i_type();
-   if(dst->f.i.rt == reg) RNOP();
+   if(dst->f.i.rt == 0) RNOP();
 }
 
 static void RORI(void)
@@ -1796,7 +1846,7 @@ static void RORI(void)
    dst->ops = current_instruction_table.ORI;
    recomp_func = genori;
    recompile_standard_i_type();
-   if (dst->f.i.rt == reg) RNOP();
+   if (dst->f.i.rt == 0) RNOP();
 }
 
 static void RXORI(void)
@@ -1804,7 +1854,7 @@ static void RXORI(void)
    dst->ops = current_instruction_table.XORI;
    recomp_func = genxori;
    recompile_standard_i_type();
-   if (dst->f.i.rt == reg) RNOP();
+   if (dst->f.i.rt == 0) RNOP();
 }
 
 static void RLUI(void)
@@ -1812,7 +1862,7 @@ static void RLUI(void)
    dst->ops = current_instruction_table.LUI;
    recomp_func = genlui;
    recompile_standard_i_type();
-   if (dst->f.i.rt == reg) RNOP();
+   if (dst->f.i.rt == 0) RNOP();
 }
 
 static void RCOP0(void)
@@ -1840,6 +1890,11 @@ static void RBEQL(void)
          recomp_func = genbeql_idle;
       }
    }
+   else if (is_idle_loop_jump(target))
+   {
+      dst->ops = current_instruction_table.BEQL_IDLE;
+      recomp_func = genbeql_idle;
+   }
    else if (target < dst_block->start || target >= dst_block->end || dst->addr == (dst_block->end-4))
    {
       dst->ops = current_instruction_table.BEQL_OUT;
@@ -1862,6 +1917,11 @@ static void RBNEL(void)
          recomp_func = genbnel_idle;
       }
    }
+   else if (is_idle_loop_jump(target))
+   {
+      dst->ops = current_instruction_table.BNEL_IDLE;
+      recomp_func = genbnel_idle;
+   }
    else if (target < dst_block->start || target >= dst_block->end || dst->addr == (dst_block->end-4))
    {
       dst->ops = current_instruction_table.BNEL_OUT;
@@ -1884,6 +1944,11 @@ static void RBLEZL(void)
          recomp_func = genblezl_idle;
       }
    }
+   else if (is_idle_loop_jump(target))
+   {
+      dst->ops = current_instruction_table.BLEZL_IDLE;
+      recomp_func = genblezl_idle;
+   }
    else if (target < dst_block->start || target >= dst_block->end || dst->addr == (dst_block->end-4))
    {
       dst->ops = current_instruction_table.BLEZL_OUT;
@@ -1906,6 +1971,11 @@ static void RBGTZL(void)
          recomp_func = genbgtzl_idle;
       }
    }
+   else if (is_idle_loop_jump(target))
+   {
+      dst->ops = current_instruction_table.BGTZL_IDLE;
+      recomp_func = genbgtzl_idle;
+   }
    else if (target < dst_block->start || target >= dst_block->end || dst->addr == (dst_block->end-4))
    {
       dst->ops = current_instruction_table.BGTZL_OUT;
@@ -1918,7 +1988,7 @@ static void RDADDI(void)
    dst->ops = current_instruction_table.DADDI;
    recomp_func = gendaddi;
    recompile_standard_i_type();
-   if(dst->f.i.rt == reg) RNOP();
+   if(dst->f.i.rt == 0) RNOP();
 }
 
 static void RDADDIU(void)
@@ -1926,7 +1996,7 @@ static void RDADDIU(void)
    dst->ops = current_instruction_table.DADDIU;
    recomp_func = gendaddiu;
    recompile_standard_i_type();
-   if(dst->f.i.rt == reg) RNOP();
+   if(dst->f.i.rt == 0) RNOP();
 }
 
 static void RLDL(void)
@@ -1934,7 +2004,7 @@ static void RLDL(void)
    dst->ops = current_instruction_table.LDL;
    recomp_func = genldl;
    recompile_standard_i_type();
-   if(dst->f.i.rt == reg) RNOP();
+   if(dst->f.i.rt == 0) RNOP();
 }
 
 static void RLDR(void)
@@ -1942,7 +2012,7 @@ static void RLDR(void)
    dst->ops = current_instruction_table.LDR;
    recomp_func = genldr;
    recompile_standard_i_type();
-   if(dst->f.i.rt == reg) RNOP();
+   if(dst->f.i.rt == 0) RNOP();
 }
 
 static void RLB(void)
@@ -1950,7 +2020,7 @@ static void RLB(void)
    dst->ops = current_instruction_table.LB;
    recomp_func = genlb;
    recompile_standard_i_type();
-   if (dst->f.i.rt == reg) RNOP();
+   if (dst->f.i.rt == 0) RNOP();
 }
 
 static void RLH(void)
@@ -1958,7 +2028,7 @@ static void RLH(void)
    dst->ops = current_instruction_table.LH;
    recomp_func = genlh;
    recompile_standard_i_type();
-   if (dst->f.i.rt == reg) RNOP();
+   if (dst->f.i.rt == 0) RNOP();
 }
 
 static void RLWL(void)
@@ -1966,7 +2036,7 @@ static void RLWL(void)
    dst->ops = current_instruction_table.LWL;
    recomp_func = genlwl;
    recompile_standard_i_type();
-   if (dst->f.i.rt == reg) RNOP();
+   if (dst->f.i.rt == 0) RNOP();
 }
 
 static void RLW(void)
@@ -1974,7 +2044,7 @@ static void RLW(void)
    dst->ops = current_instruction_table.LW;
    recomp_func = genlw;
    recompile_standard_i_type();
-   if (dst->f.i.rt == reg) RNOP();
+   if (dst->f.i.rt == 0) RNOP();
 }
 
 static void RLBU(void)
@@ -1982,7 +2052,7 @@ static void RLBU(void)
    dst->ops = current_instruction_table.LBU;
    recomp_func = genlbu;
    recompile_standard_i_type();
-   if(dst->f.i.rt == reg) RNOP();
+   if(dst->f.i.rt == 0) RNOP();
 }
 
 static void RLHU(void)
@@ -1990,7 +2060,7 @@ static void RLHU(void)
    dst->ops = current_instruction_table.LHU;
    recomp_func = genlhu;
    recompile_standard_i_type();
-   if(dst->f.i.rt == reg) RNOP();
+   if(dst->f.i.rt == 0) RNOP();
 }
 
 static void RLWR(void)
@@ -1998,7 +2068,7 @@ static void RLWR(void)
    dst->ops = current_instruction_table.LWR;
    recomp_func = genlwr;
    recompile_standard_i_type();
-   if(dst->f.i.rt == reg) RNOP();
+   if(dst->f.i.rt == 0) RNOP();
 }
 
 static void RLWU(void)
@@ -2006,7 +2076,7 @@ static void RLWU(void)
    dst->ops = current_instruction_table.LWU;
    recomp_func = genlwu;
    recompile_standard_i_type();
-   if(dst->f.i.rt == reg) RNOP();
+   if(dst->f.i.rt == 0) RNOP();
 }
 
 static void RSB(void)
@@ -2069,7 +2139,7 @@ static void RLL(void)
    recomp_func = genll;
    dst->ops = current_instruction_table.LL;
    recompile_standard_i_type();
-   if(dst->f.i.rt == reg) RNOP();
+   if(dst->f.i.rt == 0) RNOP();
 }
 
 static void RLWC1(void)
@@ -2098,7 +2168,7 @@ static void RLD(void)
    dst->ops = current_instruction_table.LD;
    recomp_func = genld;
    recompile_standard_i_type();
-   if (dst->f.i.rt == reg) RNOP();
+   if (dst->f.i.rt == 0) RNOP();
 }
 
 static void RSC(void)
@@ -2106,7 +2176,7 @@ static void RSC(void)
    dst->ops = current_instruction_table.SC;
    recomp_func = gensc;
    recompile_standard_i_type();
-   if (dst->f.i.rt == reg) RNOP();
+   if (dst->f.i.rt == 0) RNOP();
 }
 
 static void RSWC1(void)
@@ -2149,23 +2219,47 @@ static void (*recomp_ops[64])(void) =
    RSC     , RSWC1  , RSV  , RSV   , RSCD , RSDC1, RSV   , RSD
 };
 
+/* resets the recompiler information of an instruction, in dynarec mode */
+static void reset_precomp_info(precomp_block *block, precomp_instr *instr, unsigned int local_addr)
+{
+  precomp_info *info;
+
+  if (!block->info)
+    return;
+
+  info = get_precomp_info(block, instr);
+  info->reg_cache_infos.need_map = 0;
+  info->local_addr = local_addr;
+}
+
 static int get_block_length(const precomp_block *block)
 {
   return (block->end-block->start)/4;
 }
 
-static size_t get_block_memsize(const precomp_block *block)
+static size_t get_block_entries(const precomp_block *block)
 {
   int length = get_block_length(block);
-  return ((length+1)+(length>>2)) * sizeof(precomp_instr);
+  return (length+1)+(length>>2);
+}
+
+/* marks the physical page mapped by a TLB block as valid and (re)initializes its block */
+static void init_physical_block(uint32_t paddr)
+{
+  precomp_block *phys_block = get_or_alloc_block(paddr);
+
+  if (phys_block == NULL)
+    return;
+  set_invalid_code(paddr>>12, 0);
+  init_block(phys_block);
 }
 
 /**********************************************************************
  ******************** initialize an empty block ***********************
  **********************************************************************/
-void init_block(precomp_block *block)
+int init_block(precomp_block *block)
 {
-  int i, length, already_exist = 1;
+  int i, length, already_exist = 1, new_code = 0;
   static int init_length;
   timed_section_start(TIMED_SECTION_COMPILER);
 #ifdef CORE_DBG
@@ -2176,28 +2270,39 @@ void init_block(precomp_block *block)
    
   if (!block->block)
   {
-    size_t memsize = get_block_memsize(block);
+    size_t entries = get_block_entries(block);
     if (r4300emu == CORE_DYNAREC) {
-        block->block = (precomp_instr *) malloc_exec(memsize);
-        if (!block->block) {
+        /* the register cache jump wrappers are executed from there */
+        block->info = (precomp_info *) malloc_exec(entries * sizeof(precomp_info));
+        if (!block->info) {
             DebugMessage(M64MSG_ERROR, "Memory error: couldn't allocate executable memory for dynamic recompiler. Try to use an interpreter mode.");
-            return;
+            timed_section_end(TIMED_SECTION_COMPILER);
+            return 0;
         }
+        memset(block->info, 0, entries * sizeof(precomp_info));
     }
-    else {
-        block->block = (precomp_instr *) malloc(memsize);
-        if (!block->block) {
-            DebugMessage(M64MSG_ERROR, "Memory error: couldn't allocate memory for cached interpreter.");
-            return;
+
+    block->block = (precomp_instr *) calloc(entries, sizeof(precomp_instr));
+    if (!block->block) {
+        DebugMessage(M64MSG_ERROR, "Memory error: couldn't allocate memory for cached interpreter.");
+        if (block->info) {
+            free_exec(block->info, entries * sizeof(precomp_info));
+            block->info = NULL;
         }
+        timed_section_end(TIMED_SECTION_COMPILER);
+        return 0;
     }
 
-    memset(block->block, 0, memsize);
     already_exist = 0;
   }
+  profile_counter_inc(PROFILE_COUNTER_BLOCKS_INITIALIZED);
 
   if (r4300emu == CORE_DYNAREC)
   {
+    /* keep the block from being evicted while it is rebuilt */
+    code_cache_forget(block);
+    dyna_unlink_block(block);
+    dst_block = block;
     if (!block->code)
     {
 #if defined(PROFILE_R4300)
@@ -2206,7 +2311,14 @@ void init_block(precomp_block *block)
 #else
       max_code_length = 32768;
 #endif
-      block->code = (unsigned char *) malloc_exec(max_code_length);
+      block->code = (unsigned char *) code_cache_alloc(max_code_length);
+      if (!block->code) {
+        /* the page stays invalid, the caller mustn't run the block */
+        stop = 1;
+        timed_section_end(TIMED_SECTION_COMPILER);
+        return 0;
+      }
+      new_code = 1;
     }
     else
     {
@@ -2229,7 +2341,8 @@ void init_block(precomp_block *block)
     init_cache(block->block);
   }
    
-  if (!already_exist)
+  /* an evicted block needs its NOTCOMPILED stubs again */
+  if (!already_exist || new_code)
   {
 #if defined(PROFILE_R4300)
     pfProfile = fopen("instructionaddrs.dat", "ab");
@@ -2244,8 +2357,7 @@ void init_block(precomp_block *block)
     {
       dst = block->block + i;
       dst->addr = block->start + i*4;
-      dst->reg_cache_infos.need_map = 0;
-      dst->local_addr = code_length;
+      reset_precomp_info(block, dst, code_length);
 #ifdef COMPARE_CORE
       if (r4300emu == CORE_DYNAREC) gendebug();
 #endif
@@ -2268,8 +2380,7 @@ void init_block(precomp_block *block)
     for (i=0; i<length; i++)
     {
       dst = block->block + i;
-      dst->reg_cache_infos.need_map = 0;
-      dst->local_addr = i * (init_length / length);
+      reset_precomp_info(block, dst, i * (init_length / length));
       dst->ops = current_instruction_table.NOTCOMPILED;
     }
   }
@@ -2282,76 +2393,52 @@ void init_block(precomp_block *block)
     block->code_length = code_length;
     block->max_code_length = max_code_length;
     free_assembler(&block->jumps_table, &block->jumps_number, &block->riprel_table, &block->riprel_number);
+    code_cache_track(block);
   }
    
   /* here we're marking the block as a valid code even if it's not compiled
    * yet as the game should have already set up the code correctly.
    */
-  invalid_code[block->start>>12] = 0;
+  set_invalid_code(block->start>>12, 0);
   if (block->end < UINT32_C(0x80000000) || block->start >= UINT32_C(0xc0000000))
   { 
+    /* the physical blocks below mark their RDRAM page as holding code */
     uint32_t paddr = virtual_to_physical_address(block->start, 2);
-    invalid_code[paddr>>12] = 0;
-    if (!blocks[paddr>>12])
-    {
-      blocks[paddr>>12] = (precomp_block *) malloc(sizeof(precomp_block));
-      blocks[paddr>>12]->code = NULL;
-      blocks[paddr>>12]->block = NULL;
-      blocks[paddr>>12]->jumps_table = NULL;
-      blocks[paddr>>12]->riprel_table = NULL;
-      blocks[paddr>>12]->start = paddr & ~UINT32_C(0xFFF);
-      blocks[paddr>>12]->end = (paddr & ~UINT32_C(0xFFF)) + UINT32_C(0x1000);
-    }
-    init_block(blocks[paddr>>12]);
-    
+    init_physical_block(paddr);
+
     paddr += block->end - block->start - 4;
-    invalid_code[paddr>>12] = 0;
-    if (!blocks[paddr>>12])
-    {
-      blocks[paddr>>12] = (precomp_block *) malloc(sizeof(precomp_block));
-      blocks[paddr>>12]->code = NULL;
-      blocks[paddr>>12]->block = NULL;
-      blocks[paddr>>12]->jumps_table = NULL;
-      blocks[paddr>>12]->riprel_table = NULL;
-      blocks[paddr>>12]->start = paddr & ~UINT32_C(0xFFF);
-      blocks[paddr>>12]->end = (paddr & ~UINT32_C(0xFFF)) + UINT32_C(0x1000);
-    }
-    init_block(blocks[paddr>>12]);
+    init_physical_block(paddr);
   }
   else
   {
     uint32_t alt_addr = block->start ^ UINT32_C(0x20000000);
 
-    if (invalid_code[alt_addr>>12])
+    mark_r4300_code_page(block->start);
+
+    if (get_invalid_code(alt_addr>>12))
     {
-      if (!blocks[alt_addr>>12])
-      {
-        blocks[alt_addr>>12] = (precomp_block *) malloc(sizeof(precomp_block));
-        blocks[alt_addr>>12]->code = NULL;
-        blocks[alt_addr>>12]->block = NULL;
-        blocks[alt_addr>>12]->jumps_table = NULL;
-        blocks[alt_addr>>12]->riprel_table = NULL;
-        blocks[alt_addr>>12]->start = alt_addr & ~UINT32_C(0xFFF);
-        blocks[alt_addr>>12]->end = (alt_addr & ~UINT32_C(0xFFF)) + UINT32_C(0x1000);
-      }
-      init_block(blocks[alt_addr>>12]);
+      precomp_block *alt_block = get_or_alloc_block(alt_addr);
+      if (alt_block != NULL)
+        init_block(alt_block);
     }
   }
   timed_section_end(TIMED_SECTION_COMPILER);
+  return 1;
 }
 
 void free_block(precomp_block *block)
 {
-    size_t memsize = get_block_memsize(block);
-
     if (block->block) {
-        if (r4300emu == CORE_DYNAREC)
-            free_exec(block->block, memsize);
-        else
-            free(block->block);
+        free(block->block);
         block->block = NULL;
     }
-    if (block->code) { free_exec(block->code, block->max_code_length); block->code = NULL; }
+    if (block->info) {
+        free_exec(block->info, get_block_entries(block) * sizeof(precomp_info));
+        block->info = NULL;
+    }
+    code_cache_forget(block);
+    dyna_unlink_block(block);
+    if (block->code) { code_cache_free(block->code, block->max_code_length); block->code = NULL; }
     if (block->jumps_table) { free(block->jumps_table); block->jumps_table = NULL; }
     if (block->riprel_table) { free(block->riprel_table); block->riprel_table = NULL; }
 }
@@ -2363,7 +2450,9 @@ void recompile_block(const uint32_t *source, precomp_block *block, uint32_t func
 {
    uint32_t i;
    int length, finished=0;
+   long long int start_time = profile_time_nsec();
    timed_section_start(TIMED_SECTION_COMPILER);
+   profile_counter_inc(PROFILE_COUNTER_BLOCKS_COMPILED);
    length = (block->end-block->start)/4;
    dst_block = block;
    
@@ -2389,8 +2478,9 @@ void recompile_block(const uint32_t *source, precomp_block *block, uint32_t func
       {
           uint32_t address2 =
            virtual_to_physical_address(block->start + i*4, 0);
-         if(blocks[address2>>12]->block[(address2&UINT32_C(0xFFF))/4].ops == current_instruction_table.NOTCOMPILED)
-           blocks[address2>>12]->block[(address2&UINT32_C(0xFFF))/4].ops = current_instruction_table.NOTCOMPILED2;
+         precomp_instr *instr2 = &get_block(address2>>12)->block[(address2&UINT32_C(0xFFF))/4];
+         if(instr2->ops == current_instruction_table.NOTCOMPILED)
+           instr2->ops = current_instruction_table.NOTCOMPILED2;
       }
     
     SRC = source + i;
@@ -2398,13 +2488,12 @@ void recompile_block(const uint32_t *source, precomp_block *block, uint32_t func
     check_nop = source[i+1] == 0;
     dst = block->block + i;
     dst->addr = block->start + i*4;
-    dst->reg_cache_infos.need_map = 0;
-    dst->local_addr = code_length;
+    reset_precomp_info(block, dst, code_length);
 #ifdef COMPARE_CORE
     if (r4300emu == CORE_DYNAREC) gendebug();
 #endif
 #if defined(PROFILE_R4300)
-    long x86addr = (long) (block->code + block->block[i].local_addr);
+    long x86addr = (long) (block->code + block->info[i].local_addr);
     if (fwrite(source + i, 1, 4, pfProfile) != 4 || // write 4-byte MIPS opcode
         fwrite(&x86addr, 1, sizeof(char *), pfProfile) != sizeof(char *)) // write pointer to dynamically generated x86 code for this MIPS instruction
         DebugMessage(M64MSG_ERROR, "Error writing R4300 instruction address profiling data");
@@ -2452,8 +2541,7 @@ void recompile_block(const uint32_t *source, precomp_block *block, uint32_t func
      {
     dst = block->block + i;
     dst->addr = block->start + i*4;
-    dst->reg_cache_infos.need_map = 0;
-    dst->local_addr = code_length;
+    reset_precomp_info(block, dst, code_length);
 #ifdef COMPARE_CORE
     if (r4300emu == CORE_DYNAREC) gendebug();
 #endif
@@ -2464,8 +2552,7 @@ void recompile_block(const uint32_t *source, precomp_block *block, uint32_t func
       {
          dst = block->block + i;
          dst->addr = block->start + i*4;
-         dst->reg_cache_infos.need_map = 0;
-         dst->local_addr = code_length;
+         reset_precomp_info(block, dst, code_length);
 #ifdef COMPARE_CORE
          if (r4300emu == CORE_DYNAREC) gendebug();
 #endif
@@ -2491,6 +2578,7 @@ void recompile_block(const uint32_t *source, precomp_block *block, uint32_t func
    fclose(pfProfile);
    pfProfile = NULL;
 #endif
+   code_cache_count_compile(profile_time_nsec() - start_time);
    timed_section_end(TIMED_SECTION_COMPILER);
 }
 
@@ -2577,7 +2665,8 @@ void recompile_opcode(void)
    src = *SRC;
    dst++;
    dst->addr = (dst-1)->addr + 4;
-   dst->reg_cache_infos.need_map = 0;
+   if (dst_block->info)
+      get_precomp_info(dst_block, dst)->reg_cache_infos.need_map = 0;
    if(!is_jump())
    {
 #if defined(PROFILE_R4300)
@@ -2598,60 +2687,12 @@ void recompile_opcode(void)
    delay_slot_compiled = 2;
 }
 
-/**********************************************************************
- ************** allocate memory with executable bit set ***************
- **********************************************************************/
-static void *malloc_exec(size_t size)
-{
-#if defined(WIN32)
-   return VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
-#elif defined(__GNUC__)
-
-   #ifndef  MAP_ANONYMOUS
-      #ifdef MAP_ANON
-         #define MAP_ANONYMOUS MAP_ANON
-      #endif
-   #endif
-
-   void *block = mmap(NULL, size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-   if (block == MAP_FAILED)
-       { DebugMessage(M64MSG_ERROR, "Memory error: couldn't allocate %zi byte block of aligned RWX memory.", size); return NULL; }
-
-   return block;
-#else
-   return malloc(size);
-#endif
-}
-
 /**********************************************************************
  ************* reallocate memory with executable bit set **************
  **********************************************************************/
 void *realloc_exec(void *ptr, size_t oldsize, size_t newsize)
 {
-   void* block = malloc_exec(newsize);
-   if (block != NULL)
-   {
-      size_t copysize;
-      if (oldsize < newsize)
-         copysize = oldsize;
-      else
-         copysize = newsize;
-      memcpy(block, ptr, copysize);
-   }
-   free_exec(ptr, oldsize);
-   return block;
-}
-
-/**********************************************************************
- **************** frees memory with executable bit set ****************
- **********************************************************************/
-static void free_exec(void *ptr, size_t length)
-{
-#if defined(WIN32)
-   VirtualFree(ptr, 0, MEM_RELEASE);
-#elif defined(__GNUC__)
-   munmap(ptr, length);
-#else
-   free(ptr);
-#endif
+   /* links into the block would point to the old buffer */
+   dyna_unlink_block(dst_block);
+   return code_cache_realloc(ptr, oldsize, newsize);
 }
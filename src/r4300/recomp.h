@@ -24,12 +24,18 @@
 
 #include <stddef.h>
 #include <stdint.h>
+
+#include "osal/preproc.h"
+
 #if defined(__x86_64__)
   #include "x86_64/assemble_struct.h"
 #else
   #include "x86/assemble_struct.h"
 #endif
 
+/* Instructions are decoded into precomp_instr by the cached interpreter and
+ * the dynamic recompiler. Register operands are stored as indexes in reg[]
+ * to keep the array dense. */
 typedef struct _precomp_instr
 {
    void (*ops)(void);
@@ -37,8 +43,8 @@ typedef struct _precomp_instr
      {
     struct
       {
-         int64_t *rs;
-         int64_t *rt;
+         unsigned char rs;
+         unsigned char rt;
          int16_t immediate;
       } i;
     struct
@@ -47,9 +53,9 @@ typedef struct _precomp_instr
       } j;
     struct
       {
-         int64_t *rs;
-         int64_t *rt;
-         int64_t *rd;
+         unsigned char rs;
+         unsigned char rt;
+         unsigned char rd;
          unsigned char sa;
          unsigned char nrd;
       } r;
@@ -67,13 +73,23 @@ typedef struct _precomp_instr
       } cf;
      } f;
    uint32_t addr; /* word-aligned instruction address in r4300 address space */
+} precomp_instr;
+
+/* Recompiler information about an instruction, only allocated by the
+ * dynamic recompiler. It is held in precomp_block::info, at the same index
+ * as the instruction in precomp_block::block. */
+typedef struct _precomp_info
+{
    unsigned int local_addr; /* byte offset to start of corresponding x86_64 instructions, from start of code block */
    reg_cache_struct reg_cache_infos;
-} precomp_instr;
+} precomp_info;
+
+struct block_link;
 
 typedef struct _precomp_block
 {
    precomp_instr *block;
+   precomp_info *info;
    uint32_t start;
    uint32_t end;
    unsigned char *code;
@@ -85,20 +101,32 @@ typedef struct _precomp_block
    int riprel_number;
    //unsigned char md5[16];
    unsigned int adler32;
+   struct _precomp_block *lru_prev; /* code cache LRU list, see code_cache.h */
+   struct _precomp_block *lru_next;
+   unsigned char lru_referenced; /* set by linked jumps into this block */
+   struct block_link *links_in;  /* link sites jumping into this block */
+   struct block_link *links_out; /* link sites of this block */
 } precomp_block;
 
+static osal_inline precomp_info *get_precomp_info(const precomp_block *block, const precomp_instr *instr)
+{
+   return &block->info[instr - block->block];
+}
+
 void recompile_block(const uint32_t *source, precomp_block *block, uint32_t func);
-void init_block(precomp_block *block);
+int init_block(precomp_block *block);
 void free_block(precomp_block *block);
 void recompile_opcode(void);
 void dyna_jump(void);
 void dyna_start(void *code);
 void dyna_stop(void);
+void dyna_unlink_block(precomp_block *block);
 void *realloc_exec(void *ptr, size_t oldsize, size_t newsize);
 
 extern precomp_instr *dst; /* precomp_instr structure for instruction being recompiled */
 
 extern int no_compiled_jump;
+extern int use_fastmem;
 
 #if defined(__x86_64__)
   #include "x86_64/assemble.h"
@@ -294,6 +294,10 @@ void gentestl_out(void);
 void gencheck_cop1_unusable(void);
 void genll(void);
 
+#if defined(__x86_64__)
+int dynarec_fastmem_fixup(unsigned char *pc);
+#endif
+
 #ifdef COMPARE_CORE
 void gendebug(void);
 #endif
@@ -25,19 +25,22 @@
 #include <stdint.h>
 
 #include "cached_interp.h"
+#include "device/device.h"
 #include "interupt.h"
 #include "memory/memory.h"
 #include "r4300.h"
 #include "r4300_core.h"
 #include "reset.h"
+#include "rsp/rsp_core.h"
 
 int reset_hard_job = 0;
 
 void reset_hard(void)
 {
+    rsp_wait_task(&g_dev.sp);
     init_memory();
     r4300_reset_hard();
-    r4300_reset_soft();
+    r4300_reset_soft(&g_dev);
     last_addr = UINT32_C(0xa4000040);
     next_interupt = 624999;
     init_interupt();
@@ -79,20 +79,21 @@ void passe2(precomp_instr *dest, int start, int end, precomp_block *block)
 {
    unsigned int real_code_length, addr_dest;
    int i;
-   build_wrappers(dest, start, end, block);
+   build_wrappers(block->info, start, end, block);
    real_code_length = code_length;
    
    for (i=0; i < jumps_number; i++)
    {
+     precomp_info *jump_info = get_precomp_info(block, &dest[(jumps_table[i].mi_addr - dest[0].addr)/4]);
      code_length = jumps_table[i].pc_addr;
-     if (dest[(jumps_table[i].mi_addr - dest[0].addr)/4].reg_cache_infos.need_map)
+     if (jump_info->reg_cache_infos.need_map)
      {
-       addr_dest = (unsigned int)dest[(jumps_table[i].mi_addr - dest[0].addr)/4].reg_cache_infos.jump_wrapper;
+       addr_dest = (unsigned int)jump_info->reg_cache_infos.jump_wrapper;
        put32(addr_dest-((unsigned int)block->code+code_length)-4);
      }
      else
      {
-       addr_dest = dest[(jumps_table[i].mi_addr - dest[0].addr)/4].local_addr;
+       addr_dest = jump_info->local_addr;
        put32(addr_dest-code_length-4);
      }
    }
@@ -47,9 +47,9 @@ void genmfc1(void)
    gencheck_cop1_unusable();
    mov_eax_memoffs32((unsigned int*)(&reg_cop1_simple[dst->f.r.nrd]));
    mov_reg32_preg32(EBX, EAX);
-   mov_m32_reg32((unsigned int*)dst->f.r.rt, EBX);
+   mov_m32_reg32((unsigned int*)&reg[dst->f.r.rt], EBX);
    sar_reg32_imm8(EBX, 31);
-   mov_m32_reg32(((unsigned int*)dst->f.r.rt)+1, EBX);
+   mov_m32_reg32(((unsigned int*)&reg[dst->f.r.rt])+1, EBX);
 #endif
 }
 
@@ -62,8 +62,8 @@ void gendmfc1(void)
    mov_eax_memoffs32((unsigned int*)(&reg_cop1_double[dst->f.r.nrd]));
    mov_reg32_preg32(EBX, EAX);
    mov_reg32_preg32pimm32(ECX, EAX, 4);
-   mov_m32_reg32((unsigned int*)dst->f.r.rt, EBX);
-   mov_m32_reg32(((unsigned int*)dst->f.r.rt)+1, ECX);
+   mov_m32_reg32((unsigned int*)&reg[dst->f.r.rt], EBX);
+   mov_m32_reg32(((unsigned int*)&reg[dst->f.r.rt])+1, ECX);
 #endif
 }
 
@@ -75,9 +75,9 @@ void gencfc1(void)
    gencheck_cop1_unusable();
    if(dst->f.r.nrd == 31) mov_eax_memoffs32((unsigned int*)&FCR31);
    else mov_eax_memoffs32((unsigned int*)&FCR0);
-   mov_memoffs32_eax((unsigned int*)dst->f.r.rt);
+   mov_memoffs32_eax((unsigned int*)&reg[dst->f.r.rt]);
    sar_reg32_imm8(EAX, 31);
-   mov_memoffs32_eax(((unsigned int*)dst->f.r.rt)+1);
+   mov_memoffs32_eax(((unsigned int*)&reg[dst->f.r.rt])+1);
 #endif
 }
 
@@ -87,7 +87,7 @@ void genmtc1(void)
    gencallinterp((unsigned int)cached_interpreter_table.MTC1, 0);
 #else
    gencheck_cop1_unusable();
-   mov_eax_memoffs32((unsigned int*)dst->f.r.rt);
+   mov_eax_memoffs32((unsigned int*)&reg[dst->f.r.rt]);
    mov_reg32_m32(EBX, (unsigned int*)(&reg_cop1_simple[dst->f.r.nrd]));
    mov_preg32_reg32(EBX, EAX);
 #endif
@@ -99,8 +99,8 @@ void gendmtc1(void)
    gencallinterp((unsigned int)cached_interpreter_table.DMTC1, 0);
 #else
    gencheck_cop1_unusable();
-   mov_eax_memoffs32((unsigned int*)dst->f.r.rt);
-   mov_reg32_m32(EBX, ((unsigned int*)dst->f.r.rt)+1);
+   mov_eax_memoffs32((unsigned int*)&reg[dst->f.r.rt]);
+   mov_reg32_m32(EBX, ((unsigned int*)&reg[dst->f.r.rt])+1);
    mov_reg32_m32(EDX, (unsigned int*)(&reg_cop1_double[dst->f.r.nrd]));
    mov_preg32_reg32(EDX, EAX);
    mov_preg32pimm32_reg32(EDX, 4, EBX);
@@ -115,7 +115,7 @@ void genctc1(void)
    gencheck_cop1_unusable();
    
    if (dst->f.r.nrd != 31) return;
-   mov_eax_memoffs32((unsigned int*)dst->f.r.rt);
+   mov_eax_memoffs32((unsigned int*)&reg[dst->f.r.rt]);
    mov_memoffs32_eax((unsigned int*)&FCR31);
    and_eax_imm32(3);
    
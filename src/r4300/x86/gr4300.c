@@ -82,13 +82,13 @@ static void gencheck_interupt_out(unsigned int addr)
 
 static void genbeq_test(void)
 {
-   int rs_64bit = is64((unsigned int *)dst->f.i.rs);
-   int rt_64bit = is64((unsigned int *)dst->f.i.rt);
+   int rs_64bit = is64((unsigned int *)&reg[dst->f.i.rs]);
+   int rt_64bit = is64((unsigned int *)&reg[dst->f.i.rt]);
    
    if (!rs_64bit && !rt_64bit)
      {
-    int rs = allocate_register((unsigned int *)dst->f.i.rs);
-    int rt = allocate_register((unsigned int *)dst->f.i.rt);
+    int rs = allocate_register((unsigned int *)&reg[dst->f.i.rs]);
+    int rt = allocate_register((unsigned int *)&reg[dst->f.i.rt]);
     
     cmp_reg32_reg32(rs, rt);
     jne_rj(12);
@@ -98,12 +98,12 @@ static void genbeq_test(void)
      }
    else if (rs_64bit == -1)
      {
-    int rt1 = allocate_64_register1((unsigned int *)dst->f.i.rt);
-    int rt2 = allocate_64_register2((unsigned int *)dst->f.i.rt);
+    int rt1 = allocate_64_register1((unsigned int *)&reg[dst->f.i.rt]);
+    int rt2 = allocate_64_register2((unsigned int *)&reg[dst->f.i.rt]);
     
-    cmp_reg32_m32(rt1, (unsigned int *)dst->f.i.rs);
+    cmp_reg32_m32(rt1, (unsigned int *)&reg[dst->f.i.rs]);
     jne_rj(20);
-    cmp_reg32_m32(rt2, ((unsigned int *)dst->f.i.rs)+1); // 6
+    cmp_reg32_m32(rt2, ((unsigned int *)&reg[dst->f.i.rs])+1); // 6
     jne_rj(12); // 2
     mov_m32_imm32((unsigned int *)(&branch_taken), 1); // 10
     jmp_imm_short(10); // 2
@@ -111,12 +111,12 @@ static void genbeq_test(void)
      }
    else if (rt_64bit == -1)
      {
-    int rs1 = allocate_64_register1((unsigned int *)dst->f.i.rs);
-    int rs2 = allocate_64_register2((unsigned int *)dst->f.i.rs);
+    int rs1 = allocate_64_register1((unsigned int *)&reg[dst->f.i.rs]);
+    int rs2 = allocate_64_register2((unsigned int *)&reg[dst->f.i.rs]);
     
-    cmp_reg32_m32(rs1, (unsigned int *)dst->f.i.rt);
+    cmp_reg32_m32(rs1, (unsigned int *)&reg[dst->f.i.rt]);
     jne_rj(20);
-    cmp_reg32_m32(rs2, ((unsigned int *)dst->f.i.rt)+1); // 6
+    cmp_reg32_m32(rs2, ((unsigned int *)&reg[dst->f.i.rt])+1); // 6
     jne_rj(12); // 2
     mov_m32_imm32((unsigned int *)(&branch_taken), 1); // 10
     jmp_imm_short(10); // 2
@@ -127,17 +127,17 @@ static void genbeq_test(void)
     int rs1, rs2, rt1, rt2;
     if (!rs_64bit)
       {
-         rt1 = allocate_64_register1((unsigned int *)dst->f.i.rt);
-         rt2 = allocate_64_register2((unsigned int *)dst->f.i.rt);
-         rs1 = allocate_64_register1((unsigned int *)dst->f.i.rs);
-         rs2 = allocate_64_register2((unsigned int *)dst->f.i.rs);
+         rt1 = allocate_64_register1((unsigned int *)&reg[dst->f.i.rt]);
+         rt2 = allocate_64_register2((unsigned int *)&reg[dst->f.i.rt]);
+         rs1 = allocate_64_register1((unsigned int *)&reg[dst->f.i.rs]);
+         rs2 = allocate_64_register2((unsigned int *)&reg[dst->f.i.rs]);
       }
     else
       {
-         rs1 = allocate_64_register1((unsigned int *)dst->f.i.rs);
-         rs2 = allocate_64_register2((unsigned int *)dst->f.i.rs);
-         rt1 = allocate_64_register1((unsigned int *)dst->f.i.rt);
-         rt2 = allocate_64_register2((unsigned int *)dst->f.i.rt);
+         rs1 = allocate_64_register1((unsigned int *)&reg[dst->f.i.rs]);
+         rs2 = allocate_64_register2((unsigned int *)&reg[dst->f.i.rs]);
+         rt1 = allocate_64_register1((unsigned int *)&reg[dst->f.i.rt]);
+         rt2 = allocate_64_register2((unsigned int *)&reg[dst->f.i.rt]);
       }
     cmp_reg32_reg32(rs1, rt1);
     jne_rj(16);
@@ -151,13 +151,13 @@ static void genbeq_test(void)
 
 static void genbne_test(void)
 {
-   int rs_64bit = is64((unsigned int *)dst->f.i.rs);
-   int rt_64bit = is64((unsigned int *)dst->f.i.rt);
+   int rs_64bit = is64((unsigned int *)&reg[dst->f.i.rs]);
+   int rt_64bit = is64((unsigned int *)&reg[dst->f.i.rt]);
    
    if (!rs_64bit && !rt_64bit)
      {
-    int rs = allocate_register((unsigned int *)dst->f.i.rs);
-    int rt = allocate_register((unsigned int *)dst->f.i.rt);
+    int rs = allocate_register((unsigned int *)&reg[dst->f.i.rs]);
+    int rt = allocate_register((unsigned int *)&reg[dst->f.i.rt]);
     
     cmp_reg32_reg32(rs, rt);
     je_rj(12);
@@ -167,12 +167,12 @@ static void genbne_test(void)
      }
    else if (rs_64bit == -1)
      {
-    int rt1 = allocate_64_register1((unsigned int *)dst->f.i.rt);
-    int rt2 = allocate_64_register2((unsigned int *)dst->f.i.rt);
+    int rt1 = allocate_64_register1((unsigned int *)&reg[dst->f.i.rt]);
+    int rt2 = allocate_64_register2((unsigned int *)&reg[dst->f.i.rt]);
     
-    cmp_reg32_m32(rt1, (unsigned int *)dst->f.i.rs);
+    cmp_reg32_m32(rt1, (unsigned int *)&reg[dst->f.i.rs]);
     jne_rj(20);
-    cmp_reg32_m32(rt2, ((unsigned int *)dst->f.i.rs)+1); // 6
+    cmp_reg32_m32(rt2, ((unsigned int *)&reg[dst->f.i.rs])+1); // 6
     jne_rj(12); // 2
     mov_m32_imm32((unsigned int *)(&branch_taken), 0); // 10
     jmp_imm_short(10); // 2
@@ -180,12 +180,12 @@ static void genbne_test(void)
      }
    else if (rt_64bit == -1)
      {
-    int rs1 = allocate_64_register1((unsigned int *)dst->f.i.rs);
-    int rs2 = allocate_64_register2((unsigned int *)dst->f.i.rs);
+    int rs1 = allocate_64_register1((unsigned int *)&reg[dst->f.i.rs]);
+    int rs2 = allocate_64_register2((unsigned int *)&reg[dst->f.i.rs]);
     
-    cmp_reg32_m32(rs1, (unsigned int *)dst->f.i.rt);
+    cmp_reg32_m32(rs1, (unsigned int *)&reg[dst->f.i.rt]);
     jne_rj(20);
-    cmp_reg32_m32(rs2, ((unsigned int *)dst->f.i.rt)+1); // 6
+    cmp_reg32_m32(rs2, ((unsigned int *)&reg[dst->f.i.rt])+1); // 6
     jne_rj(12); // 2
     mov_m32_imm32((unsigned int *)(&branch_taken), 0); // 10
     jmp_imm_short(10); // 2
@@ -196,17 +196,17 @@ static void genbne_test(void)
     int rs1, rs2, rt1, rt2;
     if (!rs_64bit)
       {
-         rt1 = allocate_64_register1((unsigned int *)dst->f.i.rt);
-         rt2 = allocate_64_register2((unsigned int *)dst->f.i.rt);
-         rs1 = allocate_64_register1((unsigned int *)dst->f.i.rs);
-         rs2 = allocate_64_register2((unsigned int *)dst->f.i.rs);
+         rt1 = allocate_64_register1((unsigned int *)&reg[dst->f.i.rt]);
+         rt2 = allocate_64_register2((unsigned int *)&reg[dst->f.i.rt]);
+         rs1 = allocate_64_register1((unsigned int *)&reg[dst->f.i.rs]);
+         rs2 = allocate_64_register2((unsigned int *)&reg[dst->f.i.rs]);
       }
     else
       {
-         rs1 = allocate_64_register1((unsigned int *)dst->f.i.rs);
-         rs2 = allocate_64_register2((unsigned int *)dst->f.i.rs);
-         rt1 = allocate_64_register1((unsigned int *)dst->f.i.rt);
-         rt2 = allocate_64_register2((unsigned int *)dst->f.i.rt);
+         rs1 = allocate_64_register1((unsigned int *)&reg[dst->f.i.rs]);
+         rs2 = allocate_64_register2((unsigned int *)&reg[dst->f.i.rs]);
+         rt1 = allocate_64_register1((unsigned int *)&reg[dst->f.i.rt]);
+         rt2 = allocate_64_register2((unsigned int *)&reg[dst->f.i.rt]);
       }
     cmp_reg32_reg32(rs1, rt1);
     jne_rj(16);
@@ -220,11 +220,11 @@ static void genbne_test(void)
 
 static void genblez_test(void)
 {
-   int rs_64bit = is64((unsigned int *)dst->f.i.rs);
+   int rs_64bit = is64((unsigned int *)&reg[dst->f.i.rs]);
    
    if (!rs_64bit)
      {
-    int rs = allocate_register((unsigned int *)dst->f.i.rs);
+    int rs = allocate_register((unsigned int *)&reg[dst->f.i.rs]);
     
     cmp_reg32_imm32(rs, 0);
     jg_rj(12);
@@ -234,10 +234,10 @@ static void genblez_test(void)
      }
    else if (rs_64bit == -1)
      {
-    cmp_m32_imm32(((unsigned int *)dst->f.i.rs)+1, 0);
+    cmp_m32_imm32(((unsigned int *)&reg[dst->f.i.rs])+1, 0);
     jg_rj(14);
     jne_rj(24); // 2
-    cmp_m32_imm32((unsigned int *)dst->f.i.rs, 0); // 10
+    cmp_m32_imm32((unsigned int *)&reg[dst->f.i.rs], 0); // 10
     je_rj(12); // 2
     mov_m32_imm32((unsigned int *)(&branch_taken), 0); // 10
     jmp_imm_short(10); // 2
@@ -245,8 +245,8 @@ static void genblez_test(void)
      }
    else
      {
-    int rs1 = allocate_64_register1((unsigned int *)dst->f.i.rs);
-    int rs2 = allocate_64_register2((unsigned int *)dst->f.i.rs);
+    int rs1 = allocate_64_register1((unsigned int *)&reg[dst->f.i.rs]);
+    int rs2 = allocate_64_register2((unsigned int *)&reg[dst->f.i.rs]);
     
     cmp_reg32_imm32(rs2, 0);
     jg_rj(10);
@@ -261,11 +261,11 @@ static void genblez_test(void)
 
 static void genbgtz_test(void)
 {
-   int rs_64bit = is64((unsigned int *)dst->f.i.rs);
+   int rs_64bit = is64((unsigned int *)&reg[dst->f.i.rs]);
    
    if (!rs_64bit)
      {
-    int rs = allocate_register((unsigned int *)dst->f.i.rs);
+    int rs = allocate_register((unsigned int *)&reg[dst->f.i.rs]);
     
     cmp_reg32_imm32(rs, 0);
     jle_rj(12);
@@ -275,10 +275,10 @@ static void genbgtz_test(void)
      }
    else if (rs_64bit == -1)
      {
-    cmp_m32_imm32(((unsigned int *)dst->f.i.rs)+1, 0);
+    cmp_m32_imm32(((unsigned int *)&reg[dst->f.i.rs])+1, 0);
     jl_rj(14);
     jne_rj(24); // 2
-    cmp_m32_imm32((unsigned int *)dst->f.i.rs, 0); // 10
+    cmp_m32_imm32((unsigned int *)&reg[dst->f.i.rs], 0); // 10
     jne_rj(12); // 2
     mov_m32_imm32((unsigned int *)(&branch_taken), 0); // 10
     jmp_imm_short(10); // 2
@@ -286,8 +286,8 @@ static void genbgtz_test(void)
      }
    else
      {
-    int rs1 = allocate_64_register1((unsigned int *)dst->f.i.rs);
-    int rs2 = allocate_64_register2((unsigned int *)dst->f.i.rs);
+    int rs1 = allocate_64_register1((unsigned int *)&reg[dst->f.i.rs]);
+    int rs2 = allocate_64_register2((unsigned int *)&reg[dst->f.i.rs]);
     
     cmp_reg32_imm32(rs2, 0);
     jl_rj(10);
@@ -301,6 +301,38 @@ static void genbgtz_test(void)
 }
 
 
+/* invalidate the page written by a store if it holds compiled code
+ * for the stored address, which is expected in EAX */
+static void st_invalidate_code(void)
+{
+   mov_reg32_reg32(EBX, EAX);
+   shr_reg32_imm8(EBX, 12 + BLOCK_PAGE_BITS);
+   mov_reg32_preg32x4pimm32(EDX, EBX, (unsigned int)block_dir);
+   mov_reg32_reg32(EBX, EAX);
+   shr_reg32_imm8(EBX, 12);
+   and_reg32_imm32(EBX, BLOCK_PAGE_SIZE - 1);
+   mov_reg32_reg32(ECX, EBX);
+   add_reg32_reg32(ECX, EDX);
+   cmp_preg32pimm32_imm8(ECX, 0, 0);
+   jne_rj(0);
+   jump_start_rel8();
+
+   shl_reg32_imm8(EBX, 2);
+   add_reg32_reg32(EBX, EDX);
+   mov_reg32_preg32pimm32(EBX, EBX, (unsigned int)offsetof(struct block_page, blocks));
+   mov_reg32_preg32pimm32(EBX, EBX, (int)&actual->block - (int)actual);
+   and_eax_imm32(0xFFF);
+   shr_reg32_imm8(EAX, 2);
+   mov_reg32_imm32(EDX, sizeof(precomp_instr));
+   mul_reg32(EDX);
+   mov_reg32_preg32preg32pimm32(EAX, EAX, EBX, (int)&dst->ops - (int)dst);
+   cmp_reg32_imm32(EAX, (unsigned int)cached_interpreter_table.NOTCOMPILED);
+   je_rj(7); // 2
+   mov_preg32pimm32_imm8(ECX, 0, 1); // 7
+
+   jump_end_rel8();
+}
+
 /* global functions */
 
 void gennotcompiled(void)
@@ -852,8 +884,8 @@ void genaddi(void)
 #ifdef INTERPRET_ADDI
    gencallinterp((unsigned int)cached_interpreter_table.ADDI, 0);
 #else
-   int rs = allocate_register((unsigned int *)dst->f.i.rs);
-   int rt = allocate_register_w((unsigned int *)dst->f.i.rt);
+   int rs = allocate_register((unsigned int *)&reg[dst->f.i.rs]);
+   int rt = allocate_register_w((unsigned int *)&reg[dst->f.i.rt]);
    
    mov_reg32_reg32(rt, rs);
    add_reg32_imm32(rt,(int)dst->f.i.immediate);
@@ -865,8 +897,8 @@ void genaddiu(void)
 #ifdef INTERPRET_ADDIU
    gencallinterp((unsigned int)cached_interpreter_table.ADDIU, 0);
 #else
-   int rs = allocate_register((unsigned int *)dst->f.i.rs);
-   int rt = allocate_register_w((unsigned int *)dst->f.i.rt);
+   int rs = allocate_register((unsigned int *)&reg[dst->f.i.rs]);
+   int rt = allocate_register_w((unsigned int *)&reg[dst->f.i.rt]);
    
    mov_reg32_reg32(rt, rs);
    add_reg32_imm32(rt,(int)dst->f.i.immediate);
@@ -878,9 +910,9 @@ void genslti(void)
 #ifdef INTERPRET_SLTI
    gencallinterp((unsigned int)cached_interpreter_table.SLTI, 0);
 #else
-   int rs1 = allocate_64_register1((unsigned int *)dst->f.i.rs);
-   int rs2 = allocate_64_register2((unsigned int *)dst->f.i.rs);
-   int rt = allocate_register_w((unsigned int *)dst->f.i.rt);
+   int rs1 = allocate_64_register1((unsigned int *)&reg[dst->f.i.rs]);
+   int rs2 = allocate_64_register2((unsigned int *)&reg[dst->f.i.rs]);
+   int rt = allocate_register_w((unsigned int *)&reg[dst->f.i.rt]);
    long long imm = (long long)dst->f.i.immediate;
    
    cmp_reg32_imm32(rs2, (unsigned int)(imm >> 32));
@@ -899,9 +931,9 @@ void gensltiu(void)
 #ifdef INTERPRET_SLTIU
    gencallinterp((unsigned int)cached_interpreter_table.SLTIU, 0);
 #else
-   int rs1 = allocate_64_register1((unsigned int *)dst->f.i.rs);
-   int rs2 = allocate_64_register2((unsigned int *)dst->f.i.rs);
-   int rt = allocate_register_w((unsigned int *)dst->f.i.rt);
+   int rs1 = allocate_64_register1((unsigned int *)&reg[dst->f.i.rs]);
+   int rs2 = allocate_64_register2((unsigned int *)&reg[dst->f.i.rs]);
+   int rt = allocate_register_w((unsigned int *)&reg[dst->f.i.rt]);
    long long imm = (long long)dst->f.i.immediate;
    
    cmp_reg32_imm32(rs2, (unsigned int)(imm >> 32));
@@ -920,8 +952,8 @@ void genandi(void)
 #ifdef INTERPRET_ANDI
    gencallinterp((unsigned int)cached_interpreter_table.ANDI, 0);
 #else
-   int rs = allocate_register((unsigned int *)dst->f.i.rs);
-   int rt = allocate_register_w((unsigned int *)dst->f.i.rt);
+   int rs = allocate_register((unsigned int *)&reg[dst->f.i.rs]);
+   int rt = allocate_register_w((unsigned int *)&reg[dst->f.i.rt]);
    
    mov_reg32_reg32(rt, rs);
    and_reg32_imm32(rt, (unsigned short)dst->f.i.immediate);
@@ -933,10 +965,10 @@ void genori(void)
 #ifdef INTERPRET_ORI
    gencallinterp((unsigned int)cached_interpreter_table.ORI, 0);
 #else
-   int rs1 = allocate_64_register1((unsigned int *)dst->f.i.rs);
-   int rs2 = allocate_64_register2((unsigned int *)dst->f.i.rs);
-   int rt1 = allocate_64_register1_w((unsigned int *)dst->f.i.rt);
-   int rt2 = allocate_64_register2_w((unsigned int *)dst->f.i.rt);
+   int rs1 = allocate_64_register1((unsigned int *)&reg[dst->f.i.rs]);
+   int rs2 = allocate_64_register2((unsigned int *)&reg[dst->f.i.rs]);
+   int rt1 = allocate_64_register1_w((unsigned int *)&reg[dst->f.i.rt]);
+   int rt2 = allocate_64_register2_w((unsigned int *)&reg[dst->f.i.rt]);
    
    mov_reg32_reg32(rt1, rs1);
    mov_reg32_reg32(rt2, rs2);
@@ -949,10 +981,10 @@ void genxori(void)
 #ifdef INTERPRET_XORI
    gencallinterp((unsigned int)cached_interpreter_table.XORI, 0);
 #else
-   int rs1 = allocate_64_register1((unsigned int *)dst->f.i.rs);
-   int rs2 = allocate_64_register2((unsigned int *)dst->f.i.rs);
-   int rt1 = allocate_64_register1_w((unsigned int *)dst->f.i.rt);
-   int rt2 = allocate_64_register2_w((unsigned int *)dst->f.i.rt);
+   int rs1 = allocate_64_register1((unsigned int *)&reg[dst->f.i.rs]);
+   int rs2 = allocate_64_register2((unsigned int *)&reg[dst->f.i.rs]);
+   int rt1 = allocate_64_register1_w((unsigned int *)&reg[dst->f.i.rt]);
+   int rt2 = allocate_64_register2_w((unsigned int *)&reg[dst->f.i.rt]);
    
    mov_reg32_reg32(rt1, rs1);
    mov_reg32_reg32(rt2, rs2);
@@ -965,7 +997,7 @@ void genlui(void)
 #ifdef INTERPRET_LUI
    gencallinterp((unsigned int)cached_interpreter_table.LUI, 0);
 #else
-   int rt = allocate_register_w((unsigned int *)dst->f.i.rt);
+   int rt = allocate_register_w((unsigned int *)&reg[dst->f.i.rt]);
    
    mov_reg32_imm32(rt, (unsigned int)dst->f.i.immediate << 16);
 #endif
@@ -1235,10 +1267,10 @@ void gendaddi(void)
 #ifdef INTERPRET_DADDI
    gencallinterp((unsigned int)cached_interpreter_table.DADDI, 0);
 #else
-   int rs1 = allocate_64_register1((unsigned int *)dst->f.i.rs);
-   int rs2 = allocate_64_register2((unsigned int *)dst->f.i.rs);
-   int rt1 = allocate_64_register1_w((unsigned int *)dst->f.i.rt);
-   int rt2 = allocate_64_register2_w((unsigned int *)dst->f.i.rt);
+   int rs1 = allocate_64_register1((unsigned int *)&reg[dst->f.i.rs]);
+   int rs2 = allocate_64_register2((unsigned int *)&reg[dst->f.i.rs]);
+   int rt1 = allocate_64_register1_w((unsigned int *)&reg[dst->f.i.rt]);
+   int rt2 = allocate_64_register2_w((unsigned int *)&reg[dst->f.i.rt]);
    
    mov_reg32_reg32(rt1, rs1);
    mov_reg32_reg32(rt2, rs2);
@@ -1252,10 +1284,10 @@ void gendaddiu(void)
 #ifdef INTERPRET_DADDIU
    gencallinterp((unsigned int)cached_interpreter_table.DADDIU, 0);
 #else
-   int rs1 = allocate_64_register1((unsigned int *)dst->f.i.rs);
-   int rs2 = allocate_64_register2((unsigned int *)dst->f.i.rs);
-   int rt1 = allocate_64_register1_w((unsigned int *)dst->f.i.rt);
-   int rt2 = allocate_64_register2_w((unsigned int *)dst->f.i.rt);
+   int rs1 = allocate_64_register1((unsigned int *)&reg[dst->f.i.rs]);
+   int rs2 = allocate_64_register2((unsigned int *)&reg[dst->f.i.rs]);
+   int rt1 = allocate_64_register1_w((unsigned int *)&reg[dst->f.i.rt]);
+   int rt2 = allocate_64_register2_w((unsigned int *)&reg[dst->f.i.rt]);
    
    mov_reg32_reg32(rt1, rs1);
    mov_reg32_reg32(rt2, rs2);
@@ -1281,7 +1313,7 @@ void genlb(void)
 #else
    free_all_registers();
    simplify_access();
-   mov_eax_memoffs32((unsigned int *)dst->f.i.rs);
+   mov_eax_memoffs32((unsigned int *)&reg[dst->f.i.rs]);
    add_eax_imm32((int)dst->f.i.immediate);
    mov_reg32_reg32(EBX, EAX);
    if(fast_memory)
@@ -1299,18 +1331,18 @@ void genlb(void)
    
    mov_m32_imm32((unsigned int *)&PC, (unsigned int)(dst+1)); // 10
    mov_m32_reg32((unsigned int *)(&address), EBX); // 6
-   mov_m32_imm32((unsigned int *)(&rdword), (unsigned int)dst->f.i.rt); // 10
+   mov_m32_imm32((unsigned int *)(&rdword), (unsigned int)&reg[dst->f.i.rt]); // 10
    shr_reg32_imm8(EBX, 16); // 3
    mov_reg32_preg32x4pimm32(EBX, EBX, (unsigned int)readmemb); // 7
    call_reg32(EBX); // 2
-   movsx_reg32_m8(EAX, (unsigned char *)dst->f.i.rt); // 7
+   movsx_reg32_m8(EAX, (unsigned char *)&reg[dst->f.i.rt]); // 7
    jmp_imm_short(16); // 2
    
    and_reg32_imm32(EBX, 0x7FFFFF); // 6
    xor_reg8_imm8(BL, 3); // 3
    movsx_reg32_8preg32pimm32(EAX, EBX, (unsigned int)g_rdram); // 7
    
-   set_register_state(EAX, (unsigned int*)dst->f.i.rt, 1);
+   set_register_state(EAX, (unsigned int*)&reg[dst->f.i.rt], 1);
 #endif
 }
 
@@ -1321,7 +1353,7 @@ void genlh(void)
 #else
    free_all_registers();
    simplify_access();
-   mov_eax_memoffs32((unsigned int *)dst->f.i.rs);
+   mov_eax_memoffs32((unsigned int *)&reg[dst->f.i.rs]);
    add_eax_imm32((int)dst->f.i.immediate);
    mov_reg32_reg32(EBX, EAX);
    if(fast_memory)
@@ -1339,18 +1371,18 @@ void genlh(void)
    
    mov_m32_imm32((unsigned int *)&PC, (unsigned int)(dst+1)); // 10
    mov_m32_reg32((unsigned int *)(&address), EBX); // 6
-   mov_m32_imm32((unsigned int *)(&rdword), (unsigned int)dst->f.i.rt); // 10
+   mov_m32_imm32((unsigned int *)(&rdword), (unsigned int)&reg[dst->f.i.rt]); // 10
    shr_reg32_imm8(EBX, 16); // 3
    mov_reg32_preg32x4pimm32(EBX, EBX, (unsigned int)readmemh); // 7
    call_reg32(EBX); // 2
-   movsx_reg32_m16(EAX, (unsigned short *)dst->f.i.rt); // 7
+   movsx_reg32_m16(EAX, (unsigned short *)&reg[dst->f.i.rt]); // 7
    jmp_imm_short(16); // 2
    
    and_reg32_imm32(EBX, 0x7FFFFF); // 6
    xor_reg8_imm8(BL, 2); // 3
    movsx_reg32_16preg32pimm32(EAX, EBX, (unsigned int)g_rdram); // 7
    
-   set_register_state(EAX, (unsigned int*)dst->f.i.rt, 1);
+   set_register_state(EAX, (unsigned int*)&reg[dst->f.i.rt], 1);
 #endif
 }
 
@@ -1366,7 +1398,7 @@ void genlw(void)
 #else
    free_all_registers();
    simplify_access();
-   mov_eax_memoffs32((unsigned int *)dst->f.i.rs);
+   mov_eax_memoffs32((unsigned int *)&reg[dst->f.i.rs]);
    add_eax_imm32((int)dst->f.i.immediate);
    mov_reg32_reg32(EBX, EAX);
    if(fast_memory)
@@ -1384,17 +1416,17 @@ void genlw(void)
    
    mov_m32_imm32((unsigned int *)&PC, (unsigned int)(dst+1)); // 10
    mov_m32_reg32((unsigned int *)(&address), EBX); // 6
-   mov_m32_imm32((unsigned int *)(&rdword), (unsigned int)dst->f.i.rt); // 10
+   mov_m32_imm32((unsigned int *)(&rdword), (unsigned int)&reg[dst->f.i.rt]); // 10
    shr_reg32_imm8(EBX, 16); // 3
    mov_reg32_preg32x4pimm32(EBX, EBX, (unsigned int)readmem); // 7
    call_reg32(EBX); // 2
-   mov_eax_memoffs32((unsigned int *)(dst->f.i.rt)); // 5
+   mov_eax_memoffs32((unsigned int *)(&reg[dst->f.i.rt])); // 5
    jmp_imm_short(12); // 2
    
    and_reg32_imm32(EBX, 0x7FFFFF); // 6
    mov_reg32_preg32pimm32(EAX, EBX, (unsigned int)g_rdram); // 6
    
-   set_register_state(EAX, (unsigned int*)dst->f.i.rt, 1);
+   set_register_state(EAX, (unsigned int*)&reg[dst->f.i.rt], 1);
 #endif
 }
 
@@ -1405,7 +1437,7 @@ void genlbu(void)
 #else
    free_all_registers();
    simplify_access();
-   mov_eax_memoffs32((unsigned int *)dst->f.i.rs);
+   mov_eax_memoffs32((unsigned int *)&reg[dst->f.i.rs]);
    add_eax_imm32((int)dst->f.i.immediate);
    mov_reg32_reg32(EBX, EAX);
    if(fast_memory)
@@ -1423,11 +1455,11 @@ void genlbu(void)
    
    mov_m32_imm32((unsigned int *)&PC, (unsigned int)(dst+1)); // 10
    mov_m32_reg32((unsigned int *)(&address), EBX); // 6
-   mov_m32_imm32((unsigned int *)(&rdword), (unsigned int)dst->f.i.rt); // 10
+   mov_m32_imm32((unsigned int *)(&rdword), (unsigned int)&reg[dst->f.i.rt]); // 10
    shr_reg32_imm8(EBX, 16); // 3
    mov_reg32_preg32x4pimm32(EBX, EBX, (unsigned int)readmemb); // 7
    call_reg32(EBX); // 2
-   mov_reg32_m32(EAX, (unsigned int *)dst->f.i.rt); // 6
+   mov_reg32_m32(EAX, (unsigned int *)&reg[dst->f.i.rt]); // 6
    jmp_imm_short(15); // 2
    
    and_reg32_imm32(EBX, 0x7FFFFF); // 6
@@ -1436,7 +1468,7 @@ void genlbu(void)
    
    and_eax_imm32(0xFF);
    
-   set_register_state(EAX, (unsigned int*)dst->f.i.rt, 1);
+   set_register_state(EAX, (unsigned int*)&reg[dst->f.i.rt], 1);
 #endif
 }
 
@@ -1447,7 +1479,7 @@ void genlhu(void)
 #else
    free_all_registers();
    simplify_access();
-   mov_eax_memoffs32((unsigned int *)dst->f.i.rs);
+   mov_eax_memoffs32((unsigned int *)&reg[dst->f.i.rs]);
    add_eax_imm32((int)dst->f.i.immediate);
    mov_reg32_reg32(EBX, EAX);
    if(fast_memory)
@@ -1465,11 +1497,11 @@ void genlhu(void)
    
    mov_m32_imm32((unsigned int *)&PC, (unsigned int)(dst+1)); // 10
    mov_m32_reg32((unsigned int *)(&address), EBX); // 6
-   mov_m32_imm32((unsigned int *)(&rdword), (unsigned int)dst->f.i.rt); // 10
+   mov_m32_imm32((unsigned int *)(&rdword), (unsigned int)&reg[dst->f.i.rt]); // 10
    shr_reg32_imm8(EBX, 16); // 3
    mov_reg32_preg32x4pimm32(EBX, EBX, (unsigned int)readmemh); // 7
    call_reg32(EBX); // 2
-   mov_reg32_m32(EAX, (unsigned int *)dst->f.i.rt); // 6
+   mov_reg32_m32(EAX, (unsigned int *)&reg[dst->f.i.rt]); // 6
    jmp_imm_short(15); // 2
    
    and_reg32_imm32(EBX, 0x7FFFFF); // 6
@@ -1478,7 +1510,7 @@ void genlhu(void)
    
    and_eax_imm32(0xFFFF);
    
-   set_register_state(EAX, (unsigned int*)dst->f.i.rt, 1);
+   set_register_state(EAX, (unsigned int*)&reg[dst->f.i.rt], 1);
 #endif
 }
 
@@ -1494,7 +1526,7 @@ void genlwu(void)
 #else
    free_all_registers();
    simplify_access();
-   mov_eax_memoffs32((unsigned int *)dst->f.i.rs);
+   mov_eax_memoffs32((unsigned int *)&reg[dst->f.i.rs]);
    add_eax_imm32((int)dst->f.i.immediate);
    mov_reg32_reg32(EBX, EAX);
    if(fast_memory)
@@ -1512,11 +1544,11 @@ void genlwu(void)
    
    mov_m32_imm32((unsigned int *)(&PC), (unsigned int)(dst+1)); // 10
    mov_m32_reg32((unsigned int *)(&address), EBX); // 6
-   mov_m32_imm32((unsigned int *)(&rdword), (unsigned int)dst->f.i.rt); // 10
+   mov_m32_imm32((unsigned int *)(&rdword), (unsigned int)&reg[dst->f.i.rt]); // 10
    shr_reg32_imm8(EBX, 16); // 3
    mov_reg32_preg32x4pimm32(EBX, EBX, (unsigned int)readmem); // 7
    call_reg32(EBX); // 2
-   mov_eax_memoffs32((unsigned int *)(dst->f.i.rt)); // 5
+   mov_eax_memoffs32((unsigned int *)(&reg[dst->f.i.rt])); // 5
    jmp_imm_short(12); // 2
    
    and_reg32_imm32(EBX, 0x7FFFFF); // 6
@@ -1524,7 +1556,7 @@ void genlwu(void)
    
    xor_reg32_reg32(EBX, EBX);
    
-   set_64_register_state(EAX, EBX, (unsigned int*)dst->f.i.rt, 1);
+   set_64_register_state(EAX, EBX, (unsigned int*)&reg[dst->f.i.rt], 1);
 #endif
 }
 
@@ -1535,8 +1567,8 @@ void gensb(void)
 #else
    free_all_registers();
    simplify_access();
-   mov_reg8_m8(CL, (unsigned char *)dst->f.i.rt);
-   mov_eax_memoffs32((unsigned int *)dst->f.i.rs);
+   mov_reg8_m8(CL, (unsigned char *)&reg[dst->f.i.rt]);
+   mov_eax_memoffs32((unsigned int *)&reg[dst->f.i.rs]);
    add_eax_imm32((int)dst->f.i.immediate);
    mov_reg32_reg32(EBX, EAX);
    if(fast_memory)
@@ -1566,22 +1598,7 @@ void gensb(void)
    xor_reg8_imm8(BL, 3); // 3
    mov_preg32pimm32_reg8(EBX, (unsigned int)g_rdram, CL); // 6
    
-   mov_reg32_reg32(EBX, EAX);
-   shr_reg32_imm8(EBX, 12);
-   cmp_preg32pimm32_imm8(EBX, (unsigned int)invalid_code, 0);
-   jne_rj(54);
-   mov_reg32_reg32(ECX, EBX); // 2
-   shl_reg32_imm8(EBX, 2); // 3
-   mov_reg32_preg32pimm32(EBX, EBX, (unsigned int)blocks); // 6
-   mov_reg32_preg32pimm32(EBX, EBX, (int)&actual->block - (int)actual); // 6
-   and_eax_imm32(0xFFF); // 5
-   shr_reg32_imm8(EAX, 2); // 3
-   mov_reg32_imm32(EDX, sizeof(precomp_instr)); // 5
-   mul_reg32(EDX); // 2
-   mov_reg32_preg32preg32pimm32(EAX, EAX, EBX, (int)&dst->ops - (int)dst); // 7
-   cmp_reg32_imm32(EAX, (unsigned int)cached_interpreter_table.NOTCOMPILED); // 6
-   je_rj(7); // 2
-   mov_preg32pimm32_imm8(ECX, (unsigned int)invalid_code, 1); // 7
+   st_invalidate_code();
 #endif
 }
 
@@ -1592,8 +1609,8 @@ void gensh(void)
 #else
    free_all_registers();
    simplify_access();
-   mov_reg16_m16(CX, (unsigned short *)dst->f.i.rt);
-   mov_eax_memoffs32((unsigned int *)dst->f.i.rs);
+   mov_reg16_m16(CX, (unsigned short *)&reg[dst->f.i.rt]);
+   mov_eax_memoffs32((unsigned int *)&reg[dst->f.i.rs]);
    add_eax_imm32((int)dst->f.i.immediate);
    mov_reg32_reg32(EBX, EAX);
    if(fast_memory)
@@ -1623,22 +1640,7 @@ void gensh(void)
    xor_reg8_imm8(BL, 2); // 3
    mov_preg32pimm32_reg16(EBX, (unsigned int)g_rdram, CX); // 7
    
-   mov_reg32_reg32(EBX, EAX);
-   shr_reg32_imm8(EBX, 12);
-   cmp_preg32pimm32_imm8(EBX, (unsigned int)invalid_code, 0);
-   jne_rj(54);
-   mov_reg32_reg32(ECX, EBX); // 2
-   shl_reg32_imm8(EBX, 2); // 3
-   mov_reg32_preg32pimm32(EBX, EBX, (unsigned int)blocks); // 6
-   mov_reg32_preg32pimm32(EBX, EBX, (int)&actual->block - (int)actual); // 6
-   and_eax_imm32(0xFFF); // 5
-   shr_reg32_imm8(EAX, 2); // 3
-   mov_reg32_imm32(EDX, sizeof(precomp_instr)); // 5
-   mul_reg32(EDX); // 2
-   mov_reg32_preg32preg32pimm32(EAX, EAX, EBX, (int)&dst->ops - (int)dst); // 7
-   cmp_reg32_imm32(EAX, (unsigned int)cached_interpreter_table.NOTCOMPILED); // 6
-   je_rj(7); // 2
-   mov_preg32pimm32_imm8(ECX, (unsigned int)invalid_code, 1); // 7
+   st_invalidate_code();
 #endif
 }
 
@@ -1654,8 +1656,8 @@ void gensw(void)
 #else
    free_all_registers();
    simplify_access();
-   mov_reg32_m32(ECX, (unsigned int *)dst->f.i.rt);
-   mov_eax_memoffs32((unsigned int *)dst->f.i.rs);
+   mov_reg32_m32(ECX, (unsigned int *)&reg[dst->f.i.rt]);
+   mov_eax_memoffs32((unsigned int *)&reg[dst->f.i.rs]);
    add_eax_imm32((int)dst->f.i.immediate);
    mov_reg32_reg32(EBX, EAX);
    if(fast_memory)
@@ -1684,22 +1686,7 @@ void gensw(void)
    and_reg32_imm32(EBX, 0x7FFFFF); // 6
    mov_preg32pimm32_reg32(EBX, (unsigned int)g_rdram, ECX); // 6
    
-   mov_reg32_reg32(EBX, EAX);
-   shr_reg32_imm8(EBX, 12);
-   cmp_preg32pimm32_imm8(EBX, (unsigned int)invalid_code, 0);
-   jne_rj(54);
-   mov_reg32_reg32(ECX, EBX); // 2
-   shl_reg32_imm8(EBX, 2); // 3
-   mov_reg32_preg32pimm32(EBX, EBX, (unsigned int)blocks); // 6
-   mov_reg32_preg32pimm32(EBX, EBX, (int)&actual->block - (int)actual); // 6
-   and_eax_imm32(0xFFF); // 5
-   shr_reg32_imm8(EAX, 2); // 3
-   mov_reg32_imm32(EDX, sizeof(precomp_instr)); // 5
-   mul_reg32(EDX); // 2
-   mov_reg32_preg32preg32pimm32(EAX, EAX, EBX, (int)&dst->ops - (int)dst); // 7
-   cmp_reg32_imm32(EAX, (unsigned int)cached_interpreter_table.NOTCOMPILED); // 6
-   je_rj(7); // 2
-   mov_preg32pimm32_imm8(ECX, (unsigned int)invalid_code, 1); // 7
+   st_invalidate_code();
 #endif
 }
 
@@ -1823,7 +1810,7 @@ void genld(void)
 #else
    free_all_registers();
    simplify_access();
-   mov_eax_memoffs32((unsigned int *)dst->f.i.rs);
+   mov_eax_memoffs32((unsigned int *)&reg[dst->f.i.rs]);
    add_eax_imm32((int)dst->f.i.immediate);
    mov_reg32_reg32(EBX, EAX);
    if(fast_memory)
@@ -1841,19 +1828,19 @@ void genld(void)
    
    mov_m32_imm32((unsigned int *)(&PC), (unsigned int)(dst+1)); // 10
    mov_m32_reg32((unsigned int *)(&address), EBX); // 6
-   mov_m32_imm32((unsigned int *)(&rdword), (unsigned int)dst->f.i.rt); // 10
+   mov_m32_imm32((unsigned int *)(&rdword), (unsigned int)&reg[dst->f.i.rt]); // 10
    shr_reg32_imm8(EBX, 16); // 3
    mov_reg32_preg32x4pimm32(EBX, EBX, (unsigned int)readmemd); // 7
    call_reg32(EBX); // 2
-   mov_eax_memoffs32((unsigned int *)(dst->f.i.rt)); // 5
-   mov_reg32_m32(ECX, (unsigned int *)(dst->f.i.rt)+1); // 6
+   mov_eax_memoffs32((unsigned int *)(&reg[dst->f.i.rt])); // 5
+   mov_reg32_m32(ECX, (unsigned int *)(&reg[dst->f.i.rt])+1); // 6
    jmp_imm_short(18); // 2
    
    and_reg32_imm32(EBX, 0x7FFFFF); // 6
    mov_reg32_preg32pimm32(EAX, EBX, ((unsigned int)g_rdram)+4); // 6
    mov_reg32_preg32pimm32(ECX, EBX, ((unsigned int)g_rdram)); // 6
    
-   set_64_register_state(EAX, ECX, (unsigned int*)dst->f.i.rt, 1);
+   set_64_register_state(EAX, ECX, (unsigned int*)&reg[dst->f.i.rt], 1);
 #endif
 }
 
@@ -1895,22 +1882,7 @@ void genswc1(void)
    and_reg32_imm32(EBX, 0x7FFFFF); // 6
    mov_preg32pimm32_reg32(EBX, (unsigned int)g_rdram, ECX); // 6
    
-   mov_reg32_reg32(EBX, EAX);
-   shr_reg32_imm8(EBX, 12);
-   cmp_preg32pimm32_imm8(EBX, (unsigned int)invalid_code, 0);
-   jne_rj(54);
-   mov_reg32_reg32(ECX, EBX); // 2
-   shl_reg32_imm8(EBX, 2); // 3
-   mov_reg32_preg32pimm32(EBX, EBX, (unsigned int)blocks); // 6
-   mov_reg32_preg32pimm32(EBX, EBX, (int)&actual->block - (int)actual); // 6
-   and_eax_imm32(0xFFF); // 5
-   shr_reg32_imm8(EAX, 2); // 3
-   mov_reg32_imm32(EDX, sizeof(precomp_instr)); // 5
-   mul_reg32(EDX); // 2
-   mov_reg32_preg32preg32pimm32(EAX, EAX, EBX, (int)&dst->ops - (int)dst); // 7
-   cmp_reg32_imm32(EAX, (unsigned int)cached_interpreter_table.NOTCOMPILED); // 6
-   je_rj(7); // 2
-   mov_preg32pimm32_imm8(ECX, (unsigned int)invalid_code, 1); // 7
+   st_invalidate_code();
 #endif
 }
 
@@ -1955,22 +1927,7 @@ void gensdc1(void)
    mov_preg32pimm32_reg32(EBX, ((unsigned int)g_rdram)+4, ECX); // 6
    mov_preg32pimm32_reg32(EBX, ((unsigned int)g_rdram)+0, EDX); // 6
    
-   mov_reg32_reg32(EBX, EAX);
-   shr_reg32_imm8(EBX, 12);
-   cmp_preg32pimm32_imm8(EBX, (unsigned int)invalid_code, 0);
-   jne_rj(54);
-   mov_reg32_reg32(ECX, EBX); // 2
-   shl_reg32_imm8(EBX, 2); // 3
-   mov_reg32_preg32pimm32(EBX, EBX, (unsigned int)blocks); // 6
-   mov_reg32_preg32pimm32(EBX, EBX, (int)&actual->block - (int)actual); // 6
-   and_eax_imm32(0xFFF); // 5
-   shr_reg32_imm8(EAX, 2); // 3
-   mov_reg32_imm32(EDX, sizeof(precomp_instr)); // 5
-   mul_reg32(EDX); // 2
-   mov_reg32_preg32preg32pimm32(EAX, EAX, EBX, (int)&dst->ops - (int)dst); // 7
-   cmp_reg32_imm32(EAX, (unsigned int)cached_interpreter_table.NOTCOMPILED); // 6
-   je_rj(7); // 2
-   mov_preg32pimm32_imm8(ECX, (unsigned int)invalid_code, 1); // 7
+   st_invalidate_code();
 #endif
 }
 
@@ -1982,9 +1939,9 @@ void gensd(void)
    free_all_registers();
    simplify_access();
    
-   mov_reg32_m32(ECX, (unsigned int *)dst->f.i.rt);
-   mov_reg32_m32(EDX, ((unsigned int *)dst->f.i.rt)+1);
-   mov_eax_memoffs32((unsigned int *)dst->f.i.rs);
+   mov_reg32_m32(ECX, (unsigned int *)&reg[dst->f.i.rt]);
+   mov_reg32_m32(EDX, ((unsigned int *)&reg[dst->f.i.rt])+1);
+   mov_eax_memoffs32((unsigned int *)&reg[dst->f.i.rs]);
    add_eax_imm32((int)dst->f.i.immediate);
    mov_reg32_reg32(EBX, EAX);
    if(fast_memory)
@@ -2015,22 +1972,7 @@ void gensd(void)
    mov_preg32pimm32_reg32(EBX, ((unsigned int)g_rdram)+4, ECX); // 6
    mov_preg32pimm32_reg32(EBX, ((unsigned int)g_rdram)+0, EDX); // 6
    
-   mov_reg32_reg32(EBX, EAX);
-   shr_reg32_imm8(EBX, 12);
-   cmp_preg32pimm32_imm8(EBX, (unsigned int)invalid_code, 0);
-   jne_rj(54);
-   mov_reg32_reg32(ECX, EBX); // 2
-   shl_reg32_imm8(EBX, 2); // 3
-   mov_reg32_preg32pimm32(EBX, EBX, (unsigned int)blocks); // 6
-   mov_reg32_preg32pimm32(EBX, EBX, (int)&actual->block - (int)actual); // 6
-   and_eax_imm32(0xFFF); // 5
-   shr_reg32_imm8(EAX, 2); // 3
-   mov_reg32_imm32(EDX, sizeof(precomp_instr)); // 5
-   mul_reg32(EDX); // 2
-   mov_reg32_preg32preg32pimm32(EAX, EAX, EBX, (int)&dst->ops - (int)dst); // 7
-   cmp_reg32_imm32(EAX, (unsigned int)cached_interpreter_table.NOTCOMPILED); // 6
-   je_rj(7); // 2
-   mov_preg32pimm32_imm8(ECX, (unsigned int)invalid_code, 1); // 7
+   st_invalidate_code();
 #endif
 }
 
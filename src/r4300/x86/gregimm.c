@@ -33,11 +33,11 @@
 
 static void genbltz_test(void)
 {
-   int rs_64bit = is64((unsigned int *)dst->f.i.rs);
+   int rs_64bit = is64((unsigned int *)&reg[dst->f.i.rs]);
    
    if (!rs_64bit)
      {
-    int rs = allocate_register((unsigned int *)dst->f.i.rs);
+    int rs = allocate_register((unsigned int *)&reg[dst->f.i.rs]);
     
     cmp_reg32_imm32(rs, 0);
     jge_rj(12);
@@ -47,7 +47,7 @@ static void genbltz_test(void)
      }
    else if (rs_64bit == -1)
      {
-    cmp_m32_imm32(((unsigned int *)dst->f.i.rs)+1, 0);
+    cmp_m32_imm32(((unsigned int *)&reg[dst->f.i.rs])+1, 0);
     jge_rj(12);
     mov_m32_imm32((unsigned int *)(&branch_taken), 1); // 10
     jmp_imm_short(10); // 2
@@ -55,7 +55,7 @@ static void genbltz_test(void)
      }
    else
      {
-    int rs2 = allocate_64_register2((unsigned int *)dst->f.i.rs);
+    int rs2 = allocate_64_register2((unsigned int *)&reg[dst->f.i.rs]);
     
     cmp_reg32_imm32(rs2, 0);
     jge_rj(12);
@@ -121,11 +121,11 @@ void genbltz_idle(void)
 
 static void genbgez_test(void)
 {
-   int rs_64bit = is64((unsigned int *)dst->f.i.rs);
+   int rs_64bit = is64((unsigned int *)&reg[dst->f.i.rs]);
    
    if (!rs_64bit)
      {
-    int rs = allocate_register((unsigned int *)dst->f.i.rs);
+    int rs = allocate_register((unsigned int *)&reg[dst->f.i.rs]);
     
     cmp_reg32_imm32(rs, 0);
     jl_rj(12);
@@ -135,7 +135,7 @@ static void genbgez_test(void)
      }
    else if (rs_64bit == -1)
      {
-    cmp_m32_imm32(((unsigned int *)dst->f.i.rs)+1, 0);
+    cmp_m32_imm32(((unsigned int *)&reg[dst->f.i.rs])+1, 0);
     jl_rj(12);
     mov_m32_imm32((unsigned int *)(&branch_taken), 1); // 10
     jmp_imm_short(10); // 2
@@ -143,7 +143,7 @@ static void genbgez_test(void)
      }
    else
      {
-    int rs2 = allocate_64_register2((unsigned int *)dst->f.i.rs);
+    int rs2 = allocate_64_register2((unsigned int *)&reg[dst->f.i.rs]);
     
     cmp_reg32_imm32(rs2, 0);
     jl_rj(12);
@@ -19,6 +19,7 @@
  *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
+#include <stddef.h>
 #include <stdio.h>
 
 #include "assemble.h"
@@ -36,8 +37,8 @@ void gensll(void)
 #ifdef INTERPRET_SLL
    gencallinterp((unsigned int)cached_interpreter_table.SLL, 0);
 #else
-   int rt = allocate_register((unsigned int *)dst->f.r.rt);
-   int rd = allocate_register_w((unsigned int *)dst->f.r.rd);
+   int rt = allocate_register((unsigned int *)&reg[dst->f.r.rt]);
+   int rd = allocate_register_w((unsigned int *)&reg[dst->f.r.rd]);
    
    mov_reg32_reg32(rd, rt);
    shl_reg32_imm8(rd, dst->f.r.sa);
@@ -49,8 +50,8 @@ void gensrl(void)
 #ifdef INTERPRET_SRL
    gencallinterp((unsigned int)cached_interpreter_table.SRL, 0);
 #else
-   int rt = allocate_register((unsigned int *)dst->f.r.rt);
-   int rd = allocate_register_w((unsigned int *)dst->f.r.rd);
+   int rt = allocate_register((unsigned int *)&reg[dst->f.r.rt]);
+   int rd = allocate_register_w((unsigned int *)&reg[dst->f.r.rd]);
    
    mov_reg32_reg32(rd, rt);
    shr_reg32_imm8(rd, dst->f.r.sa);
@@ -62,8 +63,8 @@ void gensra(void)
 #ifdef INTERPRET_SRA
    gencallinterp((unsigned int)cached_interpreter_table.SRA, 0);
 #else
-   int rt = allocate_register((unsigned int *)dst->f.r.rt);
-   int rd = allocate_register_w((unsigned int *)dst->f.r.rd);
+   int rt = allocate_register((unsigned int *)&reg[dst->f.r.rt]);
+   int rd = allocate_register_w((unsigned int *)&reg[dst->f.r.rd]);
    
    mov_reg32_reg32(rd, rt);
    sar_reg32_imm8(rd, dst->f.r.sa);
@@ -76,10 +77,10 @@ void gensllv(void)
    gencallinterp((unsigned int)cached_interpreter_table.SLLV, 0);
 #else
    int rt, rd;
-   allocate_register_manually(ECX, (unsigned int *)dst->f.r.rs);
+   allocate_register_manually(ECX, (unsigned int *)&reg[dst->f.r.rs]);
    
-   rt = allocate_register((unsigned int *)dst->f.r.rt);
-   rd = allocate_register_w((unsigned int *)dst->f.r.rd);
+   rt = allocate_register((unsigned int *)&reg[dst->f.r.rt]);
+   rd = allocate_register_w((unsigned int *)&reg[dst->f.r.rd]);
    
    if (rd != ECX)
      {
@@ -103,10 +104,10 @@ void gensrlv(void)
    gencallinterp((unsigned int)cached_interpreter_table.SRLV, 0);
 #else
    int rt, rd;
-   allocate_register_manually(ECX, (unsigned int *)dst->f.r.rs);
+   allocate_register_manually(ECX, (unsigned int *)&reg[dst->f.r.rs]);
    
-   rt = allocate_register((unsigned int *)dst->f.r.rt);
-   rd = allocate_register_w((unsigned int *)dst->f.r.rd);
+   rt = allocate_register((unsigned int *)&reg[dst->f.r.rt]);
+   rd = allocate_register_w((unsigned int *)&reg[dst->f.r.rd]);
    
    if (rd != ECX)
      {
@@ -130,10 +131,10 @@ void gensrav(void)
    gencallinterp((unsigned int)cached_interpreter_table.SRAV, 0);
 #else
    int rt, rd;
-   allocate_register_manually(ECX, (unsigned int *)dst->f.r.rs);
+   allocate_register_manually(ECX, (unsigned int *)&reg[dst->f.r.rs]);
    
-   rt = allocate_register((unsigned int *)dst->f.r.rt);
-   rd = allocate_register_w((unsigned int *)dst->f.r.rd);
+   rt = allocate_register((unsigned int *)&reg[dst->f.r.rt]);
+   rd = allocate_register_w((unsigned int *)&reg[dst->f.r.rd]);
    
    if (rd != ECX)
      {
@@ -156,13 +157,10 @@ void genjr(void)
 #ifdef INTERPRET_JR
    gencallinterp((unsigned int)cached_interpreter_table.JR, 1);
 #else
-   static unsigned int precomp_instr_size = sizeof(precomp_instr);
-   unsigned int diff =
-     (unsigned int)(&dst->local_addr) - (unsigned int)(dst);
-   unsigned int diff_need =
-     (unsigned int)(&dst->reg_cache_infos.need_map) - (unsigned int)(dst);
-   unsigned int diff_wrap =
-     (unsigned int)(&dst->reg_cache_infos.jump_wrapper) - (unsigned int)(dst);
+   static unsigned int precomp_info_size = sizeof(precomp_info);
+   unsigned int diff = (unsigned int) offsetof(precomp_info, local_addr);
+   unsigned int diff_need = (unsigned int) offsetof(precomp_info, reg_cache_infos.need_map);
+   unsigned int diff_wrap = (unsigned int) offsetof(precomp_info, reg_cache_infos.jump_wrapper);
    
    if (((dst->addr & 0xFFF) == 0xFFC && 
        (dst->addr < 0x80000000 || dst->addr >= 0xC0000000))||no_compiled_jump)
@@ -173,7 +171,7 @@ void genjr(void)
    
    free_all_registers();
    simplify_access();
-   mov_eax_memoffs32((unsigned int *)dst->f.i.rs);
+   mov_eax_memoffs32((unsigned int *)&reg[dst->f.i.rs]);
    mov_memoffs32_eax((unsigned int *)&local_rs);
    
    gendelayslot();
@@ -201,16 +199,16 @@ void genjr(void)
    mov_reg32_reg32(EAX, EBX);
    sub_eax_imm32(dst_block->start);
    shr_reg32_imm8(EAX, 2);
-   mul_m32((unsigned int *)(&precomp_instr_size));
+   mul_m32((unsigned int *)(&precomp_info_size));
    
-   mov_reg32_preg32pimm32(EBX, EAX, (unsigned int)(dst_block->block)+diff_need);
+   mov_reg32_preg32pimm32(EBX, EAX, (unsigned int)(dst_block->info)+diff_need);
    cmp_reg32_imm32(EBX, 1);
    jne_rj(7);
    
-   add_eax_imm32((unsigned int)(dst_block->block)+diff_wrap); // 5
+   add_eax_imm32((unsigned int)(dst_block->info)+diff_wrap); // 5
    jmp_reg32(EAX); // 2
    
-   mov_reg32_preg32pimm32(EAX, EAX, (unsigned int)(dst_block->block)+diff);
+   mov_reg32_preg32pimm32(EAX, EAX, (unsigned int)(dst_block->info)+diff);
    add_reg32_m32(EAX, (unsigned int *)(&dst_block->code));
    
    jmp_reg32(EAX);
@@ -222,13 +220,10 @@ void genjalr(void)
 #ifdef INTERPRET_JALR
    gencallinterp((unsigned int)cached_interpreter_table.JALR, 0);
 #else
-   static unsigned int precomp_instr_size = sizeof(precomp_instr);
-   unsigned int diff =
-     (unsigned int)(&dst->local_addr) - (unsigned int)(dst);
-   unsigned int diff_need =
-     (unsigned int)(&dst->reg_cache_infos.need_map) - (unsigned int)(dst);
-   unsigned int diff_wrap =
-     (unsigned int)(&dst->reg_cache_infos.jump_wrapper) - (unsigned int)(dst);
+   static unsigned int precomp_info_size = sizeof(precomp_info);
+   unsigned int diff = (unsigned int) offsetof(precomp_info, local_addr);
+   unsigned int diff_need = (unsigned int) offsetof(precomp_info, reg_cache_infos.need_map);
+   unsigned int diff_wrap = (unsigned int) offsetof(precomp_info, reg_cache_infos.jump_wrapper);
    
    if (((dst->addr & 0xFFF) == 0xFFC && 
        (dst->addr < 0x80000000 || dst->addr >= 0xC0000000))||no_compiled_jump)
@@ -239,16 +234,16 @@ void genjalr(void)
    
    free_all_registers();
    simplify_access();
-   mov_eax_memoffs32((unsigned int *)dst->f.r.rs);
+   mov_eax_memoffs32((unsigned int *)&reg[dst->f.r.rs]);
    mov_memoffs32_eax((unsigned int *)&local_rs);
    
    gendelayslot();
    
-   mov_m32_imm32((unsigned int *)(dst-1)->f.r.rd, dst->addr+4);
+   mov_m32_imm32((unsigned int *)&reg[(dst-1)->f.r.rd], dst->addr+4);
    if ((dst->addr+4) & 0x80000000)
-     mov_m32_imm32(((unsigned int *)(dst-1)->f.r.rd)+1, 0xFFFFFFFF);
+     mov_m32_imm32(((unsigned int *)&reg[(dst-1)->f.r.rd])+1, 0xFFFFFFFF);
    else
-     mov_m32_imm32(((unsigned int *)(dst-1)->f.r.rd)+1, 0);
+     mov_m32_imm32(((unsigned int *)&reg[(dst-1)->f.r.rd])+1, 0);
    
    mov_eax_memoffs32((unsigned int *)&local_rs);
    mov_memoffs32_eax((unsigned int *)&last_addr);
@@ -273,16 +268,16 @@ void genjalr(void)
    mov_reg32_reg32(EAX, EBX);
    sub_eax_imm32(dst_block->start);
    shr_reg32_imm8(EAX, 2);
-   mul_m32((unsigned int *)(&precomp_instr_size));
+   mul_m32((unsigned int *)(&precomp_info_size));
    
-   mov_reg32_preg32pimm32(EBX, EAX, (unsigned int)(dst_block->block)+diff_need);
+   mov_reg32_preg32pimm32(EBX, EAX, (unsigned int)(dst_block->info)+diff_need);
    cmp_reg32_imm32(EBX, 1);
    jne_rj(7);
    
-   add_eax_imm32((unsigned int)(dst_block->block)+diff_wrap); // 5
+   add_eax_imm32((unsigned int)(dst_block->info)+diff_wrap); // 5
    jmp_reg32(EAX); // 2
    
-   mov_reg32_preg32pimm32(EAX, EAX, (unsigned int)(dst_block->block)+diff);
+   mov_reg32_preg32pimm32(EAX, EAX, (unsigned int)(dst_block->info)+diff);
    add_reg32_m32(EAX, (unsigned int *)(&dst_block->code));
    
    jmp_reg32(EAX);
@@ -310,8 +305,8 @@ void genmfhi(void)
 #ifdef INTERPRET_MFHI
    gencallinterp((unsigned int)cached_interpreter_table.MFHI, 0);
 #else
-   int rd1 = allocate_64_register1_w((unsigned int*)dst->f.r.rd);
-   int rd2 = allocate_64_register2_w((unsigned int*)dst->f.r.rd);
+   int rd1 = allocate_64_register1_w((unsigned int*)&reg[dst->f.r.rd]);
+   int rd2 = allocate_64_register2_w((unsigned int*)&reg[dst->f.r.rd]);
    int hi1 = allocate_64_register1((unsigned int*)&hi);
    int hi2 = allocate_64_register2((unsigned int*)&hi);
    
@@ -327,8 +322,8 @@ void genmthi(void)
 #else
    int hi1 = allocate_64_register1_w((unsigned int*)&hi);
    int hi2 = allocate_64_register2_w((unsigned int*)&hi);
-   int rs1 = allocate_64_register1((unsigned int*)dst->f.r.rs);
-   int rs2 = allocate_64_register2((unsigned int*)dst->f.r.rs);
+   int rs1 = allocate_64_register1((unsigned int*)&reg[dst->f.r.rs]);
+   int rs2 = allocate_64_register2((unsigned int*)&reg[dst->f.r.rs]);
    
    mov_reg32_reg32(hi1, rs1);
    mov_reg32_reg32(hi2, rs2);
@@ -340,8 +335,8 @@ void genmflo(void)
 #ifdef INTERPRET_MFLO
    gencallinterp((unsigned int)cached_interpreter_table.MFLO, 0);
 #else
-   int rd1 = allocate_64_register1_w((unsigned int*)dst->f.r.rd);
-   int rd2 = allocate_64_register2_w((unsigned int*)dst->f.r.rd);
+   int rd1 = allocate_64_register1_w((unsigned int*)&reg[dst->f.r.rd]);
+   int rd2 = allocate_64_register2_w((unsigned int*)&reg[dst->f.r.rd]);
    int lo1 = allocate_64_register1((unsigned int*)&lo);
    int lo2 = allocate_64_register2((unsigned int*)&lo);
    
@@ -357,8 +352,8 @@ void genmtlo(void)
 #else
    int lo1 = allocate_64_register1_w((unsigned int*)&lo);
    int lo2 = allocate_64_register2_w((unsigned int*)&lo);
-   int rs1 = allocate_64_register1((unsigned int*)dst->f.r.rs);
-   int rs2 = allocate_64_register2((unsigned int*)dst->f.r.rs);
+   int rs1 = allocate_64_register1((unsigned int*)&reg[dst->f.r.rs]);
+   int rs2 = allocate_64_register2((unsigned int*)&reg[dst->f.r.rs]);
    
    mov_reg32_reg32(lo1, rs1);
    mov_reg32_reg32(lo2, rs2);
@@ -371,12 +366,12 @@ void gendsllv(void)
    gencallinterp((unsigned int)cached_interpreter_table.DSLLV, 0);
 #else
    int rt1, rt2, rd1, rd2;
-   allocate_register_manually(ECX, (unsigned int *)dst->f.r.rs);
+   allocate_register_manually(ECX, (unsigned int *)&reg[dst->f.r.rs]);
    
-   rt1 = allocate_64_register1((unsigned int *)dst->f.r.rt);
-   rt2 = allocate_64_register2((unsigned int *)dst->f.r.rt);
-   rd1 = allocate_64_register1_w((unsigned int *)dst->f.r.rd);
-   rd2 = allocate_64_register2_w((unsigned int *)dst->f.r.rd);
+   rt1 = allocate_64_register1((unsigned int *)&reg[dst->f.r.rt]);
+   rt2 = allocate_64_register2((unsigned int *)&reg[dst->f.r.rt]);
+   rd1 = allocate_64_register1_w((unsigned int *)&reg[dst->f.r.rd]);
+   rd2 = allocate_64_register2_w((unsigned int *)&reg[dst->f.r.rd]);
    
    if (rd1 != ECX && rd2 != ECX)
      {
@@ -419,12 +414,12 @@ void gendsrlv(void)
    gencallinterp((unsigned int)cached_interpreter_table.DSRLV, 0);
 #else
    int rt1, rt2, rd1, rd2;
-   allocate_register_manually(ECX, (unsigned int *)dst->f.r.rs);
+   allocate_register_manually(ECX, (unsigned int *)&reg[dst->f.r.rs]);
    
-   rt1 = allocate_64_register1((unsigned int *)dst->f.r.rt);
-   rt2 = allocate_64_register2((unsigned int *)dst->f.r.rt);
-   rd1 = allocate_64_register1_w((unsigned int *)dst->f.r.rd);
-   rd2 = allocate_64_register2_w((unsigned int *)dst->f.r.rd);
+   rt1 = allocate_64_register1((unsigned int *)&reg[dst->f.r.rt]);
+   rt2 = allocate_64_register2((unsigned int *)&reg[dst->f.r.rt]);
+   rd1 = allocate_64_register1_w((unsigned int *)&reg[dst->f.r.rd]);
+   rd2 = allocate_64_register2_w((unsigned int *)&reg[dst->f.r.rd]);
    
    if (rd1 != ECX && rd2 != ECX)
      {
@@ -467,12 +462,12 @@ void gendsrav(void)
    gencallinterp((unsigned int)cached_interpreter_table.DSRAV, 0);
 #else
    int rt1, rt2, rd1, rd2;
-   allocate_register_manually(ECX, (unsigned int *)dst->f.r.rs);
+   allocate_register_manually(ECX, (unsigned int *)&reg[dst->f.r.rs]);
    
-   rt1 = allocate_64_register1((unsigned int *)dst->f.r.rt);
-   rt2 = allocate_64_register2((unsigned int *)dst->f.r.rt);
-   rd1 = allocate_64_register1_w((unsigned int *)dst->f.r.rd);
-   rd2 = allocate_64_register2_w((unsigned int *)dst->f.r.rd);
+   rt1 = allocate_64_register1((unsigned int *)&reg[dst->f.r.rt]);
+   rt2 = allocate_64_register2((unsigned int *)&reg[dst->f.r.rt]);
+   rd1 = allocate_64_register1_w((unsigned int *)&reg[dst->f.r.rd]);
+   rd2 = allocate_64_register2_w((unsigned int *)&reg[dst->f.r.rd]);
    
    if (rd1 != ECX && rd2 != ECX)
      {
@@ -517,8 +512,8 @@ void genmult(void)
    int rs, rt;
    allocate_register_manually_w(EAX, (unsigned int *)&lo, 0);
    allocate_register_manually_w(EDX, (unsigned int *)&hi, 0);
-   rs = allocate_register((unsigned int*)dst->f.r.rs);
-   rt = allocate_register((unsigned int*)dst->f.r.rt);
+   rs = allocate_register((unsigned int*)&reg[dst->f.r.rs]);
+   rt = allocate_register((unsigned int*)&reg[dst->f.r.rt]);
    mov_reg32_reg32(EAX, rs);
    imul_reg32(rt);
 #endif
@@ -532,8 +527,8 @@ void genmultu(void)
    int rs, rt;
    allocate_register_manually_w(EAX, (unsigned int *)&lo, 0);
    allocate_register_manually_w(EDX, (unsigned int *)&hi, 0);
-   rs = allocate_register((unsigned int*)dst->f.r.rs);
-   rt = allocate_register((unsigned int*)dst->f.r.rt);
+   rs = allocate_register((unsigned int*)&reg[dst->f.r.rs]);
+   rt = allocate_register((unsigned int*)&reg[dst->f.r.rt]);
    mov_reg32_reg32(EAX, rs);
    mul_reg32(rt);
 #endif
@@ -547,8 +542,8 @@ void gendiv(void)
    int rs, rt;
    allocate_register_manually_w(EAX, (unsigned int *)&lo, 0);
    allocate_register_manually_w(EDX, (unsigned int *)&hi, 0);
-   rs = allocate_register((unsigned int*)dst->f.r.rs);
-   rt = allocate_register((unsigned int*)dst->f.r.rt);
+   rs = allocate_register((unsigned int*)&reg[dst->f.r.rs]);
+   rt = allocate_register((unsigned int*)&reg[dst->f.r.rt]);
    cmp_reg32_imm32(rt, 0);
    je_rj((rs == EAX ? 0 : 2) + 1 + 2);
    mov_reg32_reg32(EAX, rs); // 0 or 2
@@ -565,8 +560,8 @@ void gendivu(void)
    int rs, rt;
    allocate_register_manually_w(EAX, (unsigned int *)&lo, 0);
    allocate_register_manually_w(EDX, (unsigned int *)&hi, 0);
-   rs = allocate_register((unsigned int*)dst->f.r.rs);
-   rt = allocate_register((unsigned int*)dst->f.r.rt);
+   rs = allocate_register((unsigned int*)&reg[dst->f.r.rs]);
+   rt = allocate_register((unsigned int*)&reg[dst->f.r.rt]);
    cmp_reg32_imm32(rt, 0);
    je_rj((rs == EAX ? 0 : 2) + 2 + 2);
    mov_reg32_reg32(EAX, rs); // 0 or 2
@@ -588,27 +583,27 @@ void gendmultu(void)
    free_all_registers();
    simplify_access();
    
-   mov_eax_memoffs32((unsigned int *)dst->f.r.rs);
-   mul_m32((unsigned int *)dst->f.r.rt); // EDX:EAX = temp1
+   mov_eax_memoffs32((unsigned int *)&reg[dst->f.r.rs]);
+   mul_m32((unsigned int *)&reg[dst->f.r.rt]); // EDX:EAX = temp1
    mov_memoffs32_eax((unsigned int *)(&lo));
    
    mov_reg32_reg32(EBX, EDX); // EBX = temp1>>32
-   mov_eax_memoffs32((unsigned int *)dst->f.r.rs);
-   mul_m32((unsigned int *)(dst->f.r.rt)+1);
+   mov_eax_memoffs32((unsigned int *)&reg[dst->f.r.rs]);
+   mul_m32((unsigned int *)(&reg[dst->f.r.rt])+1);
    add_reg32_reg32(EBX, EAX);
    adc_reg32_imm32(EDX, 0);
    mov_reg32_reg32(ECX, EDX); // ECX:EBX = temp2
    
-   mov_eax_memoffs32((unsigned int *)(dst->f.r.rs)+1);
-   mul_m32((unsigned int *)dst->f.r.rt); // EDX:EAX = temp3
+   mov_eax_memoffs32((unsigned int *)(&reg[dst->f.r.rs])+1);
+   mul_m32((unsigned int *)&reg[dst->f.r.rt]); // EDX:EAX = temp3
    
    add_reg32_reg32(EBX, EAX);
    adc_reg32_imm32(ECX, 0); // ECX:EBX = result2
    mov_m32_reg32((unsigned int*)(&lo)+1, EBX);
    
    mov_reg32_reg32(ESI, EDX); // ESI = temp3>>32
-   mov_eax_memoffs32((unsigned int *)(dst->f.r.rs)+1);
-   mul_m32((unsigned int *)(dst->f.r.rt)+1);
+   mov_eax_memoffs32((unsigned int *)(&reg[dst->f.r.rs])+1);
+   mul_m32((unsigned int *)(&reg[dst->f.r.rt])+1);
    add_reg32_reg32(EAX, ESI);
    adc_reg32_imm32(EDX, 0); // EDX:EAX = temp4
    
@@ -634,9 +629,9 @@ void genadd(void)
 #ifdef INTERPRET_ADD
    gencallinterp((unsigned int)cached_interpreter_table.ADD, 0);
 #else
-   int rs = allocate_register((unsigned int *)dst->f.r.rs);
-   int rt = allocate_register((unsigned int *)dst->f.r.rt);
-   int rd = allocate_register_w((unsigned int *)dst->f.r.rd);
+   int rs = allocate_register((unsigned int *)&reg[dst->f.r.rs]);
+   int rt = allocate_register((unsigned int *)&reg[dst->f.r.rt]);
+   int rd = allocate_register_w((unsigned int *)&reg[dst->f.r.rd]);
    
    if (rt != rd && rs != rd)
      {
@@ -659,9 +654,9 @@ void genaddu(void)
 #ifdef INTERPRET_ADDU
    gencallinterp((unsigned int)cached_interpreter_table.ADDU, 0);
 #else
-   int rs = allocate_register((unsigned int *)dst->f.r.rs);
-   int rt = allocate_register((unsigned int *)dst->f.r.rt);
-   int rd = allocate_register_w((unsigned int *)dst->f.r.rd);
+   int rs = allocate_register((unsigned int *)&reg[dst->f.r.rs]);
+   int rt = allocate_register((unsigned int *)&reg[dst->f.r.rt]);
+   int rd = allocate_register_w((unsigned int *)&reg[dst->f.r.rd]);
    
    if (rt != rd && rs != rd)
      {
@@ -684,9 +679,9 @@ void gensub(void)
 #ifdef INTERPRET_SUB
    gencallinterp((unsigned int)cached_interpreter_table.SUB, 0);
 #else
-   int rs = allocate_register((unsigned int *)dst->f.r.rs);
-   int rt = allocate_register((unsigned int *)dst->f.r.rt);
-   int rd = allocate_register_w((unsigned int *)dst->f.r.rd);
+   int rs = allocate_register((unsigned int *)&reg[dst->f.r.rs]);
+   int rt = allocate_register((unsigned int *)&reg[dst->f.r.rt]);
+   int rd = allocate_register_w((unsigned int *)&reg[dst->f.r.rd]);
    
    if (rt != rd && rs != rd)
      {
@@ -709,9 +704,9 @@ void gensubu(void)
 #ifdef INTERPRET_SUBU
    gencallinterp((unsigned int)cached_interpreter_table.SUBU, 0);
 #else
-   int rs = allocate_register((unsigned int *)dst->f.r.rs);
-   int rt = allocate_register((unsigned int *)dst->f.r.rt);
-   int rd = allocate_register_w((unsigned int *)dst->f.r.rd);
+   int rs = allocate_register((unsigned int *)&reg[dst->f.r.rs]);
+   int rt = allocate_register((unsigned int *)&reg[dst->f.r.rt]);
+   int rd = allocate_register_w((unsigned int *)&reg[dst->f.r.rd]);
    
    if (rt != rd && rs != rd)
      {
@@ -734,12 +729,12 @@ void genand(void)
 #ifdef INTERPRET_AND
    gencallinterp((unsigned int)cached_interpreter_table.AND, 0);
 #else
-   int rs1 = allocate_64_register1((unsigned int *)dst->f.r.rs);
-   int rs2 = allocate_64_register2((unsigned int *)dst->f.r.rs);
-   int rt1 = allocate_64_register1((unsigned int *)dst->f.r.rt);
-   int rt2 = allocate_64_register2((unsigned int *)dst->f.r.rt);
-   int rd1 = allocate_64_register1_w((unsigned int *)dst->f.r.rd);
-   int rd2 = allocate_64_register2_w((unsigned int *)dst->f.r.rd);
+   int rs1 = allocate_64_register1((unsigned int *)&reg[dst->f.r.rs]);
+   int rs2 = allocate_64_register2((unsigned int *)&reg[dst->f.r.rs]);
+   int rt1 = allocate_64_register1((unsigned int *)&reg[dst->f.r.rt]);
+   int rt2 = allocate_64_register2((unsigned int *)&reg[dst->f.r.rt]);
+   int rd1 = allocate_64_register1_w((unsigned int *)&reg[dst->f.r.rd]);
+   int rd2 = allocate_64_register2_w((unsigned int *)&reg[dst->f.r.rd]);
    
    if (rt1 != rd1 && rs1 != rd1)
      {
@@ -767,12 +762,12 @@ void genor(void)
 #ifdef INTERPRET_OR
    gencallinterp((unsigned int)cached_interpreter_table.OR, 0);
 #else
-   int rs1 = allocate_64_register1((unsigned int *)dst->f.r.rs);
-   int rs2 = allocate_64_register2((unsigned int *)dst->f.r.rs);
-   int rt1 = allocate_64_register1((unsigned int *)dst->f.r.rt);
-   int rt2 = allocate_64_register2((unsigned int *)dst->f.r.rt);
-   int rd1 = allocate_64_register1_w((unsigned int *)dst->f.r.rd);
-   int rd2 = allocate_64_register2_w((unsigned int *)dst->f.r.rd);
+   int rs1 = allocate_64_register1((unsigned int *)&reg[dst->f.r.rs]);
+   int rs2 = allocate_64_register2((unsigned int *)&reg[dst->f.r.rs]);
+   int rt1 = allocate_64_register1((unsigned int *)&reg[dst->f.r.rt]);
+   int rt2 = allocate_64_register2((unsigned int *)&reg[dst->f.r.rt]);
+   int rd1 = allocate_64_register1_w((unsigned int *)&reg[dst->f.r.rd]);
+   int rd2 = allocate_64_register2_w((unsigned int *)&reg[dst->f.r.rd]);
    
    if (rt1 != rd1 && rs1 != rd1)
      {
@@ -800,12 +795,12 @@ void genxor(void)
 #ifdef INTERPRET_XOR
    gencallinterp((unsigned int)cached_interpreter_table.XOR, 0);
 #else
-   int rs1 = allocate_64_register1((unsigned int *)dst->f.r.rs);
-   int rs2 = allocate_64_register2((unsigned int *)dst->f.r.rs);
-   int rt1 = allocate_64_register1((unsigned int *)dst->f.r.rt);
-   int rt2 = allocate_64_register2((unsigned int *)dst->f.r.rt);
-   int rd1 = allocate_64_register1_w((unsigned int *)dst->f.r.rd);
-   int rd2 = allocate_64_register2_w((unsigned int *)dst->f.r.rd);
+   int rs1 = allocate_64_register1((unsigned int *)&reg[dst->f.r.rs]);
+   int rs2 = allocate_64_register2((unsigned int *)&reg[dst->f.r.rs]);
+   int rt1 = allocate_64_register1((unsigned int *)&reg[dst->f.r.rt]);
+   int rt2 = allocate_64_register2((unsigned int *)&reg[dst->f.r.rt]);
+   int rd1 = allocate_64_register1_w((unsigned int *)&reg[dst->f.r.rd]);
+   int rd2 = allocate_64_register2_w((unsigned int *)&reg[dst->f.r.rd]);
    
    if (rt1 != rd1 && rs1 != rd1)
      {
@@ -833,12 +828,12 @@ void gennor(void)
 #ifdef INTERPRET_NOR
    gencallinterp((unsigned int)cached_interpreter_table.NOR, 0);
 #else
-   int rs1 = allocate_64_register1((unsigned int *)dst->f.r.rs);
-   int rs2 = allocate_64_register2((unsigned int *)dst->f.r.rs);
-   int rt1 = allocate_64_register1((unsigned int *)dst->f.r.rt);
-   int rt2 = allocate_64_register2((unsigned int *)dst->f.r.rt);
-   int rd1 = allocate_64_register1_w((unsigned int *)dst->f.r.rd);
-   int rd2 = allocate_64_register2_w((unsigned int *)dst->f.r.rd);
+   int rs1 = allocate_64_register1((unsigned int *)&reg[dst->f.r.rs]);
+   int rs2 = allocate_64_register2((unsigned int *)&reg[dst->f.r.rs]);
+   int rt1 = allocate_64_register1((unsigned int *)&reg[dst->f.r.rt]);
+   int rt2 = allocate_64_register2((unsigned int *)&reg[dst->f.r.rt]);
+   int rd1 = allocate_64_register1_w((unsigned int *)&reg[dst->f.r.rd]);
+   int rd2 = allocate_64_register2_w((unsigned int *)&reg[dst->f.r.rd]);
    
    if (rt1 != rd1 && rs1 != rd1)
      {
@@ -870,11 +865,11 @@ void genslt(void)
 #ifdef INTERPRET_SLT
    gencallinterp((unsigned int)cached_interpreter_table.SLT, 0);
 #else
-   int rs1 = allocate_64_register1((unsigned int *)dst->f.r.rs);
-   int rs2 = allocate_64_register2((unsigned int *)dst->f.r.rs);
-   int rt1 = allocate_64_register1((unsigned int *)dst->f.r.rt);
-   int rt2 = allocate_64_register2((unsigned int *)dst->f.r.rt);
-   int rd = allocate_register_w((unsigned int *)dst->f.r.rd);
+   int rs1 = allocate_64_register1((unsigned int *)&reg[dst->f.r.rs]);
+   int rs2 = allocate_64_register2((unsigned int *)&reg[dst->f.r.rs]);
+   int rt1 = allocate_64_register1((unsigned int *)&reg[dst->f.r.rt]);
+   int rt2 = allocate_64_register2((unsigned int *)&reg[dst->f.r.rt]);
+   int rd = allocate_register_w((unsigned int *)&reg[dst->f.r.rd]);
    
    cmp_reg32_reg32(rs2, rt2);
    jl_rj(13);
@@ -892,11 +887,11 @@ void gensltu(void)
 #ifdef INTERPRET_SLTU
    gencallinterp((unsigned int)cached_interpreter_table.SLTU, 0);
 #else
-   int rs1 = allocate_64_register1((unsigned int *)dst->f.r.rs);
-   int rs2 = allocate_64_register2((unsigned int *)dst->f.r.rs);
-   int rt1 = allocate_64_register1((unsigned int *)dst->f.r.rt);
-   int rt2 = allocate_64_register2((unsigned int *)dst->f.r.rt);
-   int rd = allocate_register_w((unsigned int *)dst->f.r.rd);
+   int rs1 = allocate_64_register1((unsigned int *)&reg[dst->f.r.rs]);
+   int rs2 = allocate_64_register2((unsigned int *)&reg[dst->f.r.rs]);
+   int rt1 = allocate_64_register1((unsigned int *)&reg[dst->f.r.rt]);
+   int rt2 = allocate_64_register2((unsigned int *)&reg[dst->f.r.rt]);
+   int rd = allocate_register_w((unsigned int *)&reg[dst->f.r.rd]);
    
    cmp_reg32_reg32(rs2, rt2);
    jb_rj(13);
@@ -914,12 +909,12 @@ void gendadd(void)
 #ifdef INTERPRET_DADD
    gencallinterp((unsigned int)cached_interpreter_table.DADD, 0);
 #else
-   int rs1 = allocate_64_register1((unsigned int *)dst->f.r.rs);
-   int rs2 = allocate_64_register2((unsigned int *)dst->f.r.rs);
-   int rt1 = allocate_64_register1((unsigned int *)dst->f.r.rt);
-   int rt2 = allocate_64_register2((unsigned int *)dst->f.r.rt);
-   int rd1 = allocate_64_register1_w((unsigned int *)dst->f.r.rd);
-   int rd2 = allocate_64_register2_w((unsigned int *)dst->f.r.rd);
+   int rs1 = allocate_64_register1((unsigned int *)&reg[dst->f.r.rs]);
+   int rs2 = allocate_64_register2((unsigned int *)&reg[dst->f.r.rs]);
+   int rt1 = allocate_64_register1((unsigned int *)&reg[dst->f.r.rt]);
+   int rt2 = allocate_64_register2((unsigned int *)&reg[dst->f.r.rt]);
+   int rd1 = allocate_64_register1_w((unsigned int *)&reg[dst->f.r.rd]);
+   int rd2 = allocate_64_register2_w((unsigned int *)&reg[dst->f.r.rd]);
    
    if (rt1 != rd1 && rs1 != rd1)
      {
@@ -947,12 +942,12 @@ void gendaddu(void)
 #ifdef INTERPRET_DADDU
    gencallinterp((unsigned int)cached_interpreter_table.DADDU, 0);
 #else
-   int rs1 = allocate_64_register1((unsigned int *)dst->f.r.rs);
-   int rs2 = allocate_64_register2((unsigned int *)dst->f.r.rs);
-   int rt1 = allocate_64_register1((unsigned int *)dst->f.r.rt);
-   int rt2 = allocate_64_register2((unsigned int *)dst->f.r.rt);
-   int rd1 = allocate_64_register1_w((unsigned int *)dst->f.r.rd);
-   int rd2 = allocate_64_register2_w((unsigned int *)dst->f.r.rd);
+   int rs1 = allocate_64_register1((unsigned int *)&reg[dst->f.r.rs]);
+   int rs2 = allocate_64_register2((unsigned int *)&reg[dst->f.r.rs]);
+   int rt1 = allocate_64_register1((unsigned int *)&reg[dst->f.r.rt]);
+   int rt2 = allocate_64_register2((unsigned int *)&reg[dst->f.r.rt]);
+   int rd1 = allocate_64_register1_w((unsigned int *)&reg[dst->f.r.rd]);
+   int rd2 = allocate_64_register2_w((unsigned int *)&reg[dst->f.r.rd]);
    
    if (rt1 != rd1 && rs1 != rd1)
      {
@@ -980,12 +975,12 @@ void gendsub(void)
 #ifdef INTERPRET_DSUB
    gencallinterp((unsigned int)cached_interpreter_table.DSUB, 0);
 #else
-   int rs1 = allocate_64_register1((unsigned int *)dst->f.r.rs);
-   int rs2 = allocate_64_register2((unsigned int *)dst->f.r.rs);
-   int rt1 = allocate_64_register1((unsigned int *)dst->f.r.rt);
-   int rt2 = allocate_64_register2((unsigned int *)dst->f.r.rt);
-   int rd1 = allocate_64_register1_w((unsigned int *)dst->f.r.rd);
-   int rd2 = allocate_64_register2_w((unsigned int *)dst->f.r.rd);
+   int rs1 = allocate_64_register1((unsigned int *)&reg[dst->f.r.rs]);
+   int rs2 = allocate_64_register2((unsigned int *)&reg[dst->f.r.rs]);
+   int rt1 = allocate_64_register1((unsigned int *)&reg[dst->f.r.rt]);
+   int rt2 = allocate_64_register2((unsigned int *)&reg[dst->f.r.rt]);
+   int rd1 = allocate_64_register1_w((unsigned int *)&reg[dst->f.r.rd]);
+   int rd2 = allocate_64_register2_w((unsigned int *)&reg[dst->f.r.rd]);
    
    if (rt1 != rd1 && rs1 != rd1)
      {
@@ -1013,12 +1008,12 @@ void gendsubu(void)
 #ifdef INTERPRET_DSUBU
    gencallinterp((unsigned int)cached_interpreter_table.DSUBU, 0);
 #else
-   int rs1 = allocate_64_register1((unsigned int *)dst->f.r.rs);
-   int rs2 = allocate_64_register2((unsigned int *)dst->f.r.rs);
-   int rt1 = allocate_64_register1((unsigned int *)dst->f.r.rt);
-   int rt2 = allocate_64_register2((unsigned int *)dst->f.r.rt);
-   int rd1 = allocate_64_register1_w((unsigned int *)dst->f.r.rd);
-   int rd2 = allocate_64_register2_w((unsigned int *)dst->f.r.rd);
+   int rs1 = allocate_64_register1((unsigned int *)&reg[dst->f.r.rs]);
+   int rs2 = allocate_64_register2((unsigned int *)&reg[dst->f.r.rs]);
+   int rt1 = allocate_64_register1((unsigned int *)&reg[dst->f.r.rt]);
+   int rt2 = allocate_64_register2((unsigned int *)&reg[dst->f.r.rt]);
+   int rd1 = allocate_64_register1_w((unsigned int *)&reg[dst->f.r.rd]);
+   int rd2 = allocate_64_register2_w((unsigned int *)&reg[dst->f.r.rd]);
    
    if (rt1 != rd1 && rs1 != rd1)
      {
@@ -1051,10 +1046,10 @@ void gendsll(void)
 #ifdef INTERPRET_DSLL
    gencallinterp((unsigned int)cached_interpreter_table.DSLL, 0);
 #else
-   int rt1 = allocate_64_register1((unsigned int *)dst->f.r.rt);
-   int rt2 = allocate_64_register2((unsigned int *)dst->f.r.rt);
-   int rd1 = allocate_64_register1_w((unsigned int *)dst->f.r.rd);
-   int rd2 = allocate_64_register2_w((unsigned int *)dst->f.r.rd);
+   int rt1 = allocate_64_register1((unsigned int *)&reg[dst->f.r.rt]);
+   int rt2 = allocate_64_register2((unsigned int *)&reg[dst->f.r.rt]);
+   int rd1 = allocate_64_register1_w((unsigned int *)&reg[dst->f.r.rd]);
+   int rd2 = allocate_64_register2_w((unsigned int *)&reg[dst->f.r.rd]);
    
    mov_reg32_reg32(rd1, rt1);
    mov_reg32_reg32(rd2, rt2);
@@ -1073,10 +1068,10 @@ void gendsrl(void)
 #ifdef INTERPRET_DSRL
    gencallinterp((unsigned int)cached_interpreter_table.DSRL, 0);
 #else
-   int rt1 = allocate_64_register1((unsigned int *)dst->f.r.rt);
-   int rt2 = allocate_64_register2((unsigned int *)dst->f.r.rt);
-   int rd1 = allocate_64_register1_w((unsigned int *)dst->f.r.rd);
-   int rd2 = allocate_64_register2_w((unsigned int *)dst->f.r.rd);
+   int rt1 = allocate_64_register1((unsigned int *)&reg[dst->f.r.rt]);
+   int rt2 = allocate_64_register2((unsigned int *)&reg[dst->f.r.rt]);
+   int rd1 = allocate_64_register1_w((unsigned int *)&reg[dst->f.r.rd]);
+   int rd2 = allocate_64_register2_w((unsigned int *)&reg[dst->f.r.rd]);
    
    mov_reg32_reg32(rd1, rt1);
    mov_reg32_reg32(rd2, rt2);
@@ -1095,10 +1090,10 @@ void gendsra(void)
 #ifdef INTERPRET_DSRA
    gencallinterp((unsigned int)cached_interpreter_table.DSRA, 0);
 #else
-   int rt1 = allocate_64_register1((unsigned int *)dst->f.r.rt);
-   int rt2 = allocate_64_register2((unsigned int *)dst->f.r.rt);
-   int rd1 = allocate_64_register1_w((unsigned int *)dst->f.r.rd);
-   int rd2 = allocate_64_register2_w((unsigned int *)dst->f.r.rd);
+   int rt1 = allocate_64_register1((unsigned int *)&reg[dst->f.r.rt]);
+   int rt2 = allocate_64_register2((unsigned int *)&reg[dst->f.r.rt]);
+   int rd1 = allocate_64_register1_w((unsigned int *)&reg[dst->f.r.rd]);
+   int rd2 = allocate_64_register2_w((unsigned int *)&reg[dst->f.r.rd]);
    
    mov_reg32_reg32(rd1, rt1);
    mov_reg32_reg32(rd2, rt2);
@@ -1117,9 +1112,9 @@ void gendsll32(void)
 #ifdef INTERPRET_DSLL32
    gencallinterp((unsigned int)cached_interpreter_table.DSLL32, 0);
 #else
-   int rt1 = allocate_64_register1((unsigned int *)dst->f.r.rt);
-   int rd1 = allocate_64_register1_w((unsigned int *)dst->f.r.rd);
-   int rd2 = allocate_64_register2_w((unsigned int *)dst->f.r.rd);
+   int rt1 = allocate_64_register1((unsigned int *)&reg[dst->f.r.rt]);
+   int rd1 = allocate_64_register1_w((unsigned int *)&reg[dst->f.r.rd]);
+   int rd2 = allocate_64_register2_w((unsigned int *)&reg[dst->f.r.rd]);
    
    mov_reg32_reg32(rd2, rt1);
    shl_reg32_imm8(rd2, dst->f.r.sa);
@@ -1132,9 +1127,9 @@ void gendsrl32(void)
 #ifdef INTERPRET_DSRL32
    gencallinterp((unsigned int)cached_interpreter_table.DSRL32, 0);
 #else
-   int rt2 = allocate_64_register2((unsigned int *)dst->f.r.rt);
-   int rd1 = allocate_64_register1_w((unsigned int *)dst->f.r.rd);
-   int rd2 = allocate_64_register2_w((unsigned int *)dst->f.r.rd);
+   int rt2 = allocate_64_register2((unsigned int *)&reg[dst->f.r.rt]);
+   int rd1 = allocate_64_register1_w((unsigned int *)&reg[dst->f.r.rd]);
+   int rd2 = allocate_64_register2_w((unsigned int *)&reg[dst->f.r.rd]);
    
    mov_reg32_reg32(rd1, rt2);
    shr_reg32_imm8(rd1, dst->f.r.sa);
@@ -1147,8 +1142,8 @@ void gendsra32(void)
 #ifdef INTERPRET_DSRA32
    gencallinterp((unsigned int)cached_interpreter_table.DSRA32, 0);
 #else
-   int rt2 = allocate_64_register2((unsigned int *)dst->f.r.rt);
-   int rd = allocate_register_w((unsigned int *)dst->f.r.rd);
+   int rt2 = allocate_64_register2((unsigned int *)&reg[dst->f.r.rt]);
+   int rd = allocate_register_w((unsigned int *)&reg[dst->f.r.rd]);
    
    mov_reg32_reg32(rd, rt2);
    sar_reg32_imm8(rd, dst->f.r.sa);
@@ -62,7 +62,7 @@ void free_all_registers(void)
       {
          while (free_since[i] <= dst)
            {
-          free_since[i]->reg_cache_infos.needed_registers[i] = NULL;
+          get_precomp_info(dst_block, free_since[i])->reg_cache_infos.needed_registers[i] = NULL;
           free_since[i]++;
            }
       }
@@ -100,16 +100,16 @@ void free_register(int reg)
    while (last <= dst)
      {
     if (last_access[reg] != NULL && dirty[reg])
-      last->reg_cache_infos.needed_registers[reg] = reg_content[reg];
+      get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[reg] = reg_content[reg];
     else
-      last->reg_cache_infos.needed_registers[reg] = NULL;
+      get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[reg] = NULL;
     
     if (last_access[reg] != NULL && r64[reg] != -1)
       {
          if (dirty[r64[reg]])
-           last->reg_cache_infos.needed_registers[r64[reg]] = reg_content[r64[reg]];
+           get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[r64[reg]] = reg_content[r64[reg]];
          else
-           last->reg_cache_infos.needed_registers[r64[reg]] = NULL;
+           get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[r64[reg]] = NULL;
       }
     
     last++;
@@ -189,7 +189,7 @@ int allocate_register(unsigned int *addr)
           
           while (last <= dst)
             {
-               last->reg_cache_infos.needed_registers[i] = reg_content[i];
+               get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[i] = reg_content[i];
                last++;
             }
           last_access[i] = dst;
@@ -199,7 +199,7 @@ int allocate_register(unsigned int *addr)
                
                while (last <= dst)
              {
-                last->reg_cache_infos.needed_registers[r64[i]] = reg_content[r64[i]];
+                get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[r64[i]] = reg_content[r64[i]];
                 last++;
              }
                last_access[r64[i]] = dst;
@@ -225,7 +225,7 @@ int allocate_register(unsigned int *addr)
      {
     while (free_since[reg] <= dst)
       {
-         free_since[reg]->reg_cache_infos.needed_registers[reg] = NULL;
+         get_precomp_info(dst_block, free_since[reg])->reg_cache_infos.needed_registers[reg] = NULL;
          free_since[reg]++;
       }
      }
@@ -356,7 +356,7 @@ int allocate_register_w(unsigned int *addr)
          
          while (last <= dst)
            {
-          last->reg_cache_infos.needed_registers[i] = NULL;
+          get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[i] = NULL;
           last++;
            }
          last_access[i] = dst;
@@ -366,7 +366,7 @@ int allocate_register_w(unsigned int *addr)
           last = last_access[r64[i]]+1;
           while (last <= dst)
             {
-               last->reg_cache_infos.needed_registers[r64[i]] = NULL;
+               get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[r64[i]] = NULL;
                last++;
             }
           free_since[r64[i]] = dst+1;
@@ -393,7 +393,7 @@ int allocate_register_w(unsigned int *addr)
      {
     while (free_since[reg] <= dst)
       {
-         free_since[reg]->reg_cache_infos.needed_registers[reg] = NULL;
+         get_precomp_info(dst_block, free_since[reg])->reg_cache_infos.needed_registers[reg] = NULL;
          free_since[reg]++;
       }
      }
@@ -424,7 +424,7 @@ int allocate_64_register1_w(unsigned int *addr)
           {
             while (free_since[reg2] <= dst)
             {
-              free_since[reg2]->reg_cache_infos.needed_registers[reg2] = NULL;
+              get_precomp_info(dst_block, free_since[reg2])->reg_cache_infos.needed_registers[reg2] = NULL;
               free_since[reg2]++;
             }
           }
@@ -456,7 +456,7 @@ int allocate_64_register1_w(unsigned int *addr)
      {
     while (free_since[reg2] <= dst)
       {
-         free_since[reg2]->reg_cache_infos.needed_registers[reg2] = NULL;
+         get_precomp_info(dst_block, free_since[reg2])->reg_cache_infos.needed_registers[reg2] = NULL;
          free_since[reg2]++;
       }
      }
@@ -487,7 +487,7 @@ int allocate_64_register2_w(unsigned int *addr)
           {
             while (free_since[reg2] <= dst)
             {
-              free_since[reg2]->reg_cache_infos.needed_registers[reg2] = NULL;
+              get_precomp_info(dst_block, free_since[reg2])->reg_cache_infos.needed_registers[reg2] = NULL;
               free_since[reg2]++;
             }
           }
@@ -519,7 +519,7 @@ int allocate_64_register2_w(unsigned int *addr)
      {
     while (free_since[reg2] <= dst)
       {
-         free_since[reg2]->reg_cache_infos.needed_registers[reg2] = NULL;
+         get_precomp_info(dst_block, free_since[reg2])->reg_cache_infos.needed_registers[reg2] = NULL;
          free_since[reg2]++;
       }
      }
@@ -561,14 +561,14 @@ void force_32(int reg)
     while (last <= dst)
       {
          if (dirty[reg])
-           last->reg_cache_infos.needed_registers[reg] = reg_content[reg];
+           get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[reg] = reg_content[reg];
          else
-           last->reg_cache_infos.needed_registers[reg] = NULL;
+           get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[reg] = NULL;
          
          if (dirty[r64[reg]])
-           last->reg_cache_infos.needed_registers[r64[reg]] = reg_content[r64[reg]];
+           get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[r64[reg]] = reg_content[r64[reg]];
          else
-           last->reg_cache_infos.needed_registers[r64[reg]] = NULL;
+           get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[r64[reg]] = NULL;
          
          last++;
       }
@@ -595,7 +595,7 @@ void allocate_register_manually(int reg, unsigned int *addr)
          
     while (last <= dst)
       {
-         last->reg_cache_infos.needed_registers[reg] = reg_content[reg];
+         get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[reg] = reg_content[reg];
          last++;
       }
     last_access[reg] = dst;
@@ -605,7 +605,7 @@ void allocate_register_manually(int reg, unsigned int *addr)
          
          while (last <= dst)
            {
-          last->reg_cache_infos.needed_registers[r64[reg]] = reg_content[r64[reg]];
+          get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[r64[reg]] = reg_content[r64[reg]];
           last++;
            }
          last_access[r64[reg]] = dst;
@@ -618,7 +618,7 @@ void allocate_register_manually(int reg, unsigned int *addr)
      {
     while (free_since[reg] <= dst)
       {
-         free_since[reg]->reg_cache_infos.needed_registers[reg] = NULL;
+         get_precomp_info(dst_block, free_since[reg])->reg_cache_infos.needed_registers[reg] = NULL;
          free_since[reg]++;
       }
      }
@@ -632,7 +632,7 @@ void allocate_register_manually(int reg, unsigned int *addr)
          
          while (last <= dst)
            {
-          last->reg_cache_infos.needed_registers[i] = reg_content[i];
+          get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[i] = reg_content[i];
           last++;
            }
          last_access[i] = dst;
@@ -642,7 +642,7 @@ void allocate_register_manually(int reg, unsigned int *addr)
           
           while (last <= dst)
             {
-               last->reg_cache_infos.needed_registers[r64[i]] = reg_content[r64[i]];
+               get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[r64[i]] = reg_content[r64[i]];
                last++;
             }
           last_access[r64[i]] = dst;
@@ -685,7 +685,7 @@ void allocate_register_manually_w(int reg, unsigned int *addr, int load)
          
     while (last <= dst)
       {
-         last->reg_cache_infos.needed_registers[reg] = reg_content[reg];
+         get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[reg] = reg_content[reg];
          last++;
       }
     last_access[reg] = dst;
@@ -696,7 +696,7 @@ void allocate_register_manually_w(int reg, unsigned int *addr, int load)
          
          while (last <= dst)
            {
-          last->reg_cache_infos.needed_registers[r64[reg]] = reg_content[r64[reg]];
+          get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[r64[reg]] = reg_content[r64[reg]];
           last++;
            }
          last_access[r64[reg]] = NULL;
@@ -712,7 +712,7 @@ void allocate_register_manually_w(int reg, unsigned int *addr, int load)
      {
     while (free_since[reg] <= dst)
       {
-         free_since[reg]->reg_cache_infos.needed_registers[reg] = NULL;
+         get_precomp_info(dst_block, free_since[reg])->reg_cache_infos.needed_registers[reg] = NULL;
          free_since[reg]++;
       }
      }
@@ -726,7 +726,7 @@ void allocate_register_manually_w(int reg, unsigned int *addr, int load)
          
          while (last <= dst)
            {
-          last->reg_cache_infos.needed_registers[i] = reg_content[i];
+          get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[i] = reg_content[i];
           last++;
            }
          last_access[i] = dst;
@@ -735,7 +735,7 @@ void allocate_register_manually_w(int reg, unsigned int *addr, int load)
           last = last_access[r64[i]]+1;
           while (last <= dst)
             {
-               last->reg_cache_infos.needed_registers[r64[i]] = NULL;
+               get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[r64[i]] = NULL;
                last++;
             }
           free_since[r64[i]] = dst+1;
@@ -783,7 +783,7 @@ void allocate_register_manually_w(int reg, unsigned int *addr, int load)
 // 0x8B (reg<<3)|5 0xXXXXXXXX mov edi, [XXXXXXXX]
 // 0xC3 ret
 // total : 62 bytes
-static void build_wrapper(precomp_instr *instr, unsigned char* code, precomp_block* block)
+static void build_wrapper(precomp_info *info, unsigned char* code, precomp_block* block)
 {
    int i;
    int j=0;
@@ -807,7 +807,7 @@ static void build_wrapper(precomp_instr *instr, unsigned char* code, precomp_blo
    j+=4;
    
    code[j++] = 0x05;
-   *((unsigned int*)&code[j]) = (unsigned int)instr->local_addr;
+   *((unsigned int*)&code[j]) = (unsigned int)info->local_addr;
    j+=4;
    
    code[j++] = 0x89;
@@ -816,12 +816,12 @@ static void build_wrapper(precomp_instr *instr, unsigned char* code, precomp_blo
    
    for (i=0; i<8; i++)
      {
-    if (instr->reg_cache_infos.needed_registers[i] != NULL)
+    if (info->reg_cache_infos.needed_registers[i] != NULL)
       {
          code[j++] = 0x8B;
          code[j++] = (i << 3) | 5;
          *((unsigned int*)&code[j]) =
-                 (unsigned int)instr->reg_cache_infos.needed_registers[i];
+                 (unsigned int)info->reg_cache_infos.needed_registers[i];
          j+=4;
       }
      }
@@ -829,18 +829,18 @@ static void build_wrapper(precomp_instr *instr, unsigned char* code, precomp_blo
    code[j++] = 0xC3;
 }
 
-void build_wrappers(precomp_instr *instr, int start, int end, precomp_block* block)
+void build_wrappers(precomp_info *info, int start, int end, precomp_block* block)
 {
    int i, reg;;
    for (i=start; i<end; i++)
      {
-    instr[i].reg_cache_infos.need_map = 0;
+    info[i].reg_cache_infos.need_map = 0;
     for (reg=0; reg<8; reg++)
       {
-         if (instr[i].reg_cache_infos.needed_registers[reg] != NULL)
+         if (info[i].reg_cache_infos.needed_registers[reg] != NULL)
            {
-          instr[i].reg_cache_infos.need_map = 1;
-          build_wrapper(&instr[i], instr[i].reg_cache_infos.jump_wrapper, block);
+          info[i].reg_cache_infos.need_map = 1;
+          build_wrapper(&info[i], info[i].reg_cache_infos.jump_wrapper, block);
           break;
            }
       }
@@ -850,7 +850,8 @@ void build_wrappers(precomp_instr *instr, int start, int end, precomp_block* blo
 void simplify_access(void)
 {
    int i;
-   dst->local_addr = code_length;
-   for(i=0; i<8; i++) dst->reg_cache_infos.needed_registers[i] = NULL;
+   precomp_info *info = get_precomp_info(dst_block, dst);
+   info->local_addr = code_length;
+   for(i=0; i<8; i++) info->reg_cache_infos.needed_registers[i] = NULL;
 }
 
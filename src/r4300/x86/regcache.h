@@ -31,7 +31,7 @@ int allocate_register(unsigned int *addr);
 int allocate_64_register1(unsigned int *addr);
 int allocate_64_register2(unsigned int *addr);
 int is64(unsigned int *addr);
-void build_wrappers(precomp_instr*, int, int, precomp_block*);
+void build_wrappers(precomp_info*, int, int, precomp_block*);
 int lru_register(void);
 int allocate_register_w(unsigned int *addr);
 int allocate_64_register1_w(unsigned int *addr);
@@ -54,10 +54,17 @@ void dyna_jump()
         return;
     }
 
-    if (PC->reg_cache_infos.need_map)
-        *return_address = (unsigned long) (PC->reg_cache_infos.jump_wrapper);
+    precomp_info *info = get_precomp_info(actual, PC);
+
+    if (info->reg_cache_infos.need_map)
+        *return_address = (unsigned long) (info->reg_cache_infos.jump_wrapper);
     else
-        *return_address = (unsigned long) (actual->code + PC->local_addr);
+        *return_address = (unsigned long) (actual->code + info->local_addr);
+}
+
+/* this recompiler doesn't link blocks, they always jump through jump_to_func() */
+void dyna_unlink_block(precomp_block *block)
+{
 }
 
 #if defined(WIN32) && !defined(__GNUC__) /* this warning disable only works if placed outside of the scope of a function */
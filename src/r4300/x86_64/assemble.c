@@ -122,7 +122,7 @@ void passe2(precomp_instr *dest, int start, int end, precomp_block *block)
 {
   unsigned int i;
 
-  build_wrappers(dest, start, end, block);
+  build_wrappers(block->info, start, end, block);
 
   /* First, fix up all the jumps.  This involves a table lookup to find the offset into the block of x86_64 code for
    * for start of a recompiled r4300i instruction corresponding to the given jump destination address in the N64
@@ -131,7 +131,7 @@ void passe2(precomp_instr *dest, int start, int end, precomp_block *block)
    */
   for (i = 0; i < jumps_number; i++)
   {
-    precomp_instr *jump_instr = dest + ((jumps_table[i].mi_addr - dest[0].addr) / 4);
+    precomp_info  *jump_instr = get_precomp_info(block, dest + ((jumps_table[i].mi_addr - dest[0].addr) / 4));
     unsigned int   jmp_offset_loc = jumps_table[i].pc_addr;
     unsigned char *addr_dest = NULL;
     /* calculate the destination address to jump to */
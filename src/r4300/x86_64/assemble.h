@@ -72,6 +72,16 @@ extern int64_t reg[32];
 
 extern int branch_taken;
 
+/* Static jumps to another block start with a link site of LINK_SITE_SIZE
+ * bytes, which only skips itself until dyna_link_jump() patches it to
+ * jump to the target block directly. */
+#define LINK_SITE_SIZE 80
+
+extern precomp_block *link_site_block;
+extern unsigned int link_site_offset;
+
+void dyna_link_jump(void);
+
 extern const uint16_t trunc_mode, round_mode, ceil_mode, floor_mode;
 
 void jump_start_rel8(void);
@@ -242,6 +252,20 @@ static osal_inline void cmp_reg64_imm32(int reg64, unsigned int imm32)
    put32(imm32);
 }
 
+static osal_inline void cmp_preg64_imm8(int reg64, unsigned char imm8)
+{
+   put8(0x80);
+   put8(0x38 | reg64);
+   put8(imm8);
+}
+
+static osal_inline void mov_preg64_imm8(int reg64, unsigned char imm8)
+{
+   put8(0xC6);
+   put8(reg64);
+   put8(imm8);
+}
+
 static osal_inline void cmp_preg64preg64_imm8(int reg1, int reg2, unsigned char imm8)
 {
    put8(0x80);
@@ -55,9 +55,9 @@ void genmfc1(void)
    gencheck_cop1_unusable();
    mov_xreg64_m64rel(RAX, (unsigned long long *)(&reg_cop1_simple[dst->f.r.nrd]));
    mov_reg32_preg64(EBX, RAX);
-   mov_m32rel_xreg32((unsigned int*)dst->f.r.rt, EBX);
+   mov_m32rel_xreg32((unsigned int*)&reg[dst->f.r.rt], EBX);
    sar_reg32_imm8(EBX, 31);
-   mov_m32rel_xreg32(((unsigned int*)dst->f.r.rt)+1, EBX);
+   mov_m32rel_xreg32(((unsigned int*)&reg[dst->f.r.rt])+1, EBX);
 #endif
 }
 
@@ -73,8 +73,8 @@ void gendmfc1(void)
    mov_xreg64_m64rel(RAX, (unsigned long long *) (&reg_cop1_double[dst->f.r.nrd]));
    mov_reg32_preg64(EBX, RAX);
    mov_reg32_preg64pimm32(ECX, RAX, 4);
-   mov_m32rel_xreg32((unsigned int*)dst->f.r.rt, EBX);
-   mov_m32rel_xreg32(((unsigned int*)dst->f.r.rt)+1, ECX);
+   mov_m32rel_xreg32((unsigned int*)&reg[dst->f.r.rt], EBX);
+   mov_m32rel_xreg32(((unsigned int*)&reg[dst->f.r.rt])+1, ECX);
 #endif
 }
 
@@ -89,9 +89,9 @@ void gencfc1(void)
    gencheck_cop1_unusable();
    if(dst->f.r.nrd == 31) mov_xreg32_m32rel(EAX, (unsigned int*)&FCR31);
    else mov_xreg32_m32rel(EAX, (unsigned int*)&FCR0);
-   mov_m32rel_xreg32((unsigned int*)dst->f.r.rt, EAX);
+   mov_m32rel_xreg32((unsigned int*)&reg[dst->f.r.rt], EAX);
    sar_reg32_imm8(EAX, 31);
-   mov_m32rel_xreg32(((unsigned int*)dst->f.r.rt)+1, EAX);
+   mov_m32rel_xreg32(((unsigned int*)&reg[dst->f.r.rt])+1, EAX);
 #endif
 }
 
@@ -104,7 +104,7 @@ void genmtc1(void)
    gencallinterp((unsigned long long)cached_interpreter_table.MTC1, 0);
 #else
    gencheck_cop1_unusable();
-   mov_xreg32_m32rel(EAX, (unsigned int*)dst->f.r.rt);
+   mov_xreg32_m32rel(EAX, (unsigned int*)&reg[dst->f.r.rt]);
    mov_xreg64_m64rel(RBX, (unsigned long long *)(&reg_cop1_simple[dst->f.r.nrd]));
    mov_preg64_reg32(RBX, EAX);
 #endif
@@ -119,8 +119,8 @@ void gendmtc1(void)
    gencallinterp((unsigned long long)cached_interpreter_table.DMTC1, 0);
 #else
    gencheck_cop1_unusable();
-   mov_xreg32_m32rel(EAX, (unsigned int*)dst->f.r.rt);
-   mov_xreg32_m32rel(EBX, ((unsigned int*)dst->f.r.rt)+1);
+   mov_xreg32_m32rel(EAX, (unsigned int*)&reg[dst->f.r.rt]);
+   mov_xreg32_m32rel(EBX, ((unsigned int*)&reg[dst->f.r.rt])+1);
    mov_xreg64_m64rel(RDX, (unsigned long long *)(&reg_cop1_double[dst->f.r.nrd]));
    mov_preg64_reg32(RDX, EAX);
    mov_preg64pimm32_reg32(RDX, 4, EBX);
@@ -138,7 +138,7 @@ void genctc1(void)
    gencheck_cop1_unusable();
    
    if (dst->f.r.nrd != 31) return;
-   mov_xreg32_m32rel(EAX, (unsigned int*)dst->f.r.rt);
+   mov_xreg32_m32rel(EAX, (unsigned int*)&reg[dst->f.r.rt]);
    mov_m32rel_xreg32((unsigned int*)&FCR31, EAX);
    and_eax_imm32(3);
    
@@ -27,8 +27,10 @@
 #include "assemble.h"
 #include "interpret.h"
 #include "main/main.h"
+#include "memory/fastmem.h"
 #include "memory/memory.h"
 #include "r4300/cached_interp.h"
+#include "r4300/code_cache.h"
 #include "r4300/cp0_private.h"
 #include "r4300/cp1_private.h"
 #include "r4300/exception.h"
@@ -104,37 +106,67 @@ static void gencheck_interupt_out(unsigned int addr)
    jump_end_rel8();
 }
 
+/* Jumps to naddr, in another block. KSEG0 and KSEG1 can't be remapped,
+ * so jumps there go through a link site (see LINK_SITE_SIZE). */
+static void genjump_out(unsigned int naddr)
+{
+   unsigned int site = code_length;
+   int linkable = (naddr & 0xC0000000) == 0x80000000;
+   int i;
+
+   if (linkable)
+     {
+    jmp_imm_short(LINK_SITE_SIZE - 2);
+    for (i = 2; i < LINK_SITE_SIZE; i++)
+      put8(0xCC); /* int3, never executed */
+     }
+
+   mov_m32rel_imm32(&jump_to_address, naddr);
+   mov_reg64_imm64(RAX, (unsigned long long) (dst+1));
+   mov_m64rel_xreg64((unsigned long long *)(&PC), RAX);
+   if (linkable)
+     {
+    mov_m32rel_imm32(&link_site_offset, site);
+    mov_reg64_imm64(RAX, (unsigned long long) dst_block);
+    mov_m64rel_xreg64((unsigned long long *)(&link_site_block), RAX);
+    mov_reg64_imm64(RAX, (unsigned long long) dyna_link_jump);
+     }
+   else
+     mov_reg64_imm64(RAX, (unsigned long long) jump_to_func);
+   call_reg64(RAX);
+}
+
 static void genbeq_test(void)
 {
-   int rs_64bit = is64((unsigned int *)dst->f.i.rs);
-   int rt_64bit = is64((unsigned int *)dst->f.i.rt);
+   int rs_64bit = is64((unsigned int *)&reg[dst->f.i.rs]);
+   int rt_64bit = is64((unsigned int *)&reg[dst->f.i.rt]);
    
    if (rs_64bit == 0 && rt_64bit == 0)
      {
-    int rs = allocate_register_32((unsigned int *)dst->f.i.rs);
-    int rt = allocate_register_32((unsigned int *)dst->f.i.rt);
+    int rs = allocate_register_32((unsigned int *)&reg[dst->f.i.rs]);
+    int rt = allocate_register_32((unsigned int *)&reg[dst->f.i.rt]);
     
     cmp_reg32_reg32(rs, rt);
     sete_m8rel((unsigned char *) &branch_taken);
      }
    else if (rs_64bit == -1)
      {
-    int rt = allocate_register_64((unsigned long long *)dst->f.i.rt);
+    int rt = allocate_register_64((unsigned long long *)&reg[dst->f.i.rt]);
     
-    cmp_xreg64_m64rel(rt, (unsigned long long *) dst->f.i.rs);
+    cmp_xreg64_m64rel(rt, (unsigned long long *) &reg[dst->f.i.rs]);
     sete_m8rel((unsigned char *) &branch_taken);
      }
    else if (rt_64bit == -1)
      {
-    int rs = allocate_register_64((unsigned long long *)dst->f.i.rs);
+    int rs = allocate_register_64((unsigned long long *)&reg[dst->f.i.rs]);
     
-    cmp_xreg64_m64rel(rs, (unsigned long long *)dst->f.i.rt);
+    cmp_xreg64_m64rel(rs, (unsigned long long *)&reg[dst->f.i.rt]);
     sete_m8rel((unsigned char *) &branch_taken);
      }
    else
      {
-    int rs = allocate_register_64((unsigned long long *)dst->f.i.rs);
-    int rt = allocate_register_64((unsigned long long *)dst->f.i.rt);
+    int rs = allocate_register_64((unsigned long long *)&reg[dst->f.i.rs]);
+    int rt = allocate_register_64((unsigned long long *)&reg[dst->f.i.rt]);
     cmp_reg64_reg64(rs, rt);
     sete_m8rel((unsigned char *) &branch_taken);
      }
@@ -142,35 +174,35 @@ static void genbeq_test(void)
 
 static void genbne_test(void)
 {
-   int rs_64bit = is64((unsigned int *)dst->f.i.rs);
-   int rt_64bit = is64((unsigned int *)dst->f.i.rt);
+   int rs_64bit = is64((unsigned int *)&reg[dst->f.i.rs]);
+   int rt_64bit = is64((unsigned int *)&reg[dst->f.i.rt]);
    
    if (rs_64bit == 0 && rt_64bit == 0)
      {
-    int rs = allocate_register_32((unsigned int *)dst->f.i.rs);
-    int rt = allocate_register_32((unsigned int *)dst->f.i.rt);
+    int rs = allocate_register_32((unsigned int *)&reg[dst->f.i.rs]);
+    int rt = allocate_register_32((unsigned int *)&reg[dst->f.i.rt]);
     
     cmp_reg32_reg32(rs, rt);
     setne_m8rel((unsigned char *) &branch_taken);
      }
    else if (rs_64bit == -1)
      {
-    int rt = allocate_register_64((unsigned long long *) dst->f.i.rt);
+    int rt = allocate_register_64((unsigned long long *) &reg[dst->f.i.rt]);
 
-    cmp_xreg64_m64rel(rt, (unsigned long long *)dst->f.i.rs);
+    cmp_xreg64_m64rel(rt, (unsigned long long *)&reg[dst->f.i.rs]);
     setne_m8rel((unsigned char *) &branch_taken);
      }
    else if (rt_64bit == -1)
      {
-    int rs = allocate_register_64((unsigned long long *) dst->f.i.rs);
+    int rs = allocate_register_64((unsigned long long *) &reg[dst->f.i.rs]);
     
-    cmp_xreg64_m64rel(rs, (unsigned long long *)dst->f.i.rt);
+    cmp_xreg64_m64rel(rs, (unsigned long long *)&reg[dst->f.i.rt]);
     setne_m8rel((unsigned char *) &branch_taken);
      }
    else
      {
-    int rs = allocate_register_64((unsigned long long *)dst->f.i.rs);
-    int rt = allocate_register_64((unsigned long long *)dst->f.i.rt);
+    int rs = allocate_register_64((unsigned long long *)&reg[dst->f.i.rs]);
+    int rt = allocate_register_64((unsigned long long *)&reg[dst->f.i.rt]);
 
     cmp_reg64_reg64(rs, rt);
     setne_m8rel((unsigned char *) &branch_taken);
@@ -179,18 +211,18 @@ static void genbne_test(void)
 
 static void genblez_test(void)
 {
-   int rs_64bit = is64((unsigned int *)dst->f.i.rs);
+   int rs_64bit = is64((unsigned int *)&reg[dst->f.i.rs]);
    
    if (rs_64bit == 0)
      {
-    int rs = allocate_register_32((unsigned int *)dst->f.i.rs);
+    int rs = allocate_register_32((unsigned int *)&reg[dst->f.i.rs]);
     
     cmp_reg32_imm32(rs, 0);
     setle_m8rel((unsigned char *) &branch_taken);
      }
    else
      {
-    int rs = allocate_register_64((unsigned long long *)dst->f.i.rs);
+    int rs = allocate_register_64((unsigned long long *)&reg[dst->f.i.rs]);
     
     cmp_reg64_imm8(rs, 0);
     setle_m8rel((unsigned char *) &branch_taken);
@@ -199,18 +231,18 @@ static void genblez_test(void)
 
 static void genbgtz_test(void)
 {
-   int rs_64bit = is64((unsigned int *)dst->f.i.rs);
+   int rs_64bit = is64((unsigned int *)&reg[dst->f.i.rs]);
    
    if (rs_64bit == 0)
      {
-    int rs = allocate_register_32((unsigned int *)dst->f.i.rs);
+    int rs = allocate_register_32((unsigned int *)&reg[dst->f.i.rs]);
     
     cmp_reg32_imm32(rs, 0);
     setg_m8rel((unsigned char *) &branch_taken);
      }
    else
      {
-    int rs = allocate_register_64((unsigned long long *)dst->f.i.rs);
+    int rs = allocate_register_64((unsigned long long *)&reg[dst->f.i.rs]);
 
     cmp_reg64_imm8(rs, 0);
     setg_m8rel((unsigned char *) &branch_taken);
@@ -227,16 +259,16 @@ static void ld_register_alloc(int *pGpr1, int *pGpr2, int *pBase1, int *pBase2)
 
    if (dst->f.i.rs == dst->f.i.rt)
    {
-     allocate_register_32((unsigned int*)dst->f.r.rs);          // tell regcache we need to read RS register here
-     gpr1 = allocate_register_32_w((unsigned int*)dst->f.r.rt); // tell regcache we will modify RT register during this instruction
+     allocate_register_32((unsigned int*)&reg[dst->f.r.rs]);          // tell regcache we need to read RS register here
+     gpr1 = allocate_register_32_w((unsigned int*)&reg[dst->f.r.rt]); // tell regcache we will modify RT register during this instruction
      gpr2 = lock_register(lru_register());                      // free and lock least recently used register for usage here
      add_reg32_imm32(gpr1, (int)dst->f.i.immediate);
      mov_reg32_reg32(gpr2, gpr1);
    }
    else
    {
-     gpr2 = allocate_register_32((unsigned int*)dst->f.r.rs);   // tell regcache we need to read RS register here
-     gpr1 = allocate_register_32_w((unsigned int*)dst->f.r.rt); // tell regcache we will modify RT register during this instruction
+     gpr2 = allocate_register_32((unsigned int*)&reg[dst->f.r.rs]);   // tell regcache we need to read RS register here
+     gpr1 = allocate_register_32_w((unsigned int*)&reg[dst->f.r.rt]); // tell regcache we will modify RT register during this instruction
      free_register(gpr2);                                       // write out gpr2 if dirty because I'm going to trash it right now
      add_reg32_imm32(gpr2, (int)dst->f.i.immediate);
      mov_reg32_reg32(gpr1, gpr2);
@@ -259,6 +291,86 @@ static void ld_register_alloc(int *pGpr1, int *pGpr2, int *pBase1, int *pBase2)
 }
 
 
+/* Fastmem accesses are padded to FASTMEM_SITE_SIZE bytes and followed by a
+ * short jump over their slow path. When the access faults, the site is
+ * rewritten into a short jump to the slow path, which starts right after. */
+#define FASTMEM_SITE_SIZE 4
+
+static unsigned int fastmem_site;
+
+static void fastmem_site_start(void)
+{
+   fastmem_site = code_length;
+}
+
+static void fastmem_site_end(void)
+{
+   while (code_length - fastmem_site < FASTMEM_SITE_SIZE)
+     put8(0x90); // nop
+   jmp_imm_short(0);
+   jump_start_rel8();
+}
+
+/* slow path of a load: calls one of the r4300_read_* accessors with the
+ * address in addr_reg and the RT register as destination */
+static void ld_call_accessor(int addr_reg, unsigned long long accessor)
+{
+   mov_reg32_reg32(EDI, addr_reg);
+   mov_reg64_imm64(RAX, (unsigned long long) (dst+1));
+   mov_m64rel_xreg64((unsigned long long *)(&PC), RAX);
+   mov_reg64_imm64(RSI, (unsigned long long) &reg[dst->f.i.rt]);
+   mov_reg64_imm64(RAX, accessor);
+   call_reg64(RAX);
+}
+
+/* slow path of a store: calls one of the r4300_write_* accessors with the
+ * address in EBX and the value in ECX. EBX is preserved across the call,
+ * so the address is left in EAX for st_invalidate_code() */
+static void st_call_accessor(unsigned long long accessor, unsigned int value_mask)
+{
+   mov_reg32_reg32(EDI, EBX);
+   mov_reg32_reg32(ESI, ECX);
+   if (value_mask != 0xFFFFFFFF)
+     and_reg32_imm32(ESI, value_mask);
+   mov_reg64_imm64(RAX, (unsigned long long) (dst+1));
+   mov_m64rel_xreg64((unsigned long long *)(&PC), RAX);
+   mov_reg64_imm64(RAX, accessor);
+   call_reg64(RAX);
+   mov_reg32_reg32(EAX, EBX);
+}
+
+/* invalidate the page written by a store if it holds compiled code
+ * for the stored address, which is expected in EAX */
+static void st_invalidate_code(void)
+{
+   mov_reg64_imm64(RSI, (unsigned long long) block_dir);
+   mov_reg32_reg32(EBX, EAX);
+   shr_reg32_imm8(EBX, 12 + BLOCK_PAGE_BITS);
+   mov_reg64_preg64x8preg64(RSI, RBX, RSI);
+   mov_reg32_reg32(EBX, EAX);
+   shr_reg32_imm8(EBX, 12);
+   and_reg32_imm32(EBX, BLOCK_PAGE_SIZE - 1);
+   cmp_preg64preg64_imm8(RBX, RSI, 0);
+   jne_rj(0);
+   jump_start_rel8();
+
+   mov_reg64_reg64(RDI, RSI);
+   add_reg64_imm32(RDI, (unsigned int) offsetof(struct block_page, blocks));
+   mov_reg64_preg64x8preg64(RDI, RBX, RDI);
+   mov_reg64_preg64pimm32(RDI, RDI, (int) offsetof(precomp_block, block));
+   and_eax_imm32(0xFFF);
+   shr_reg32_imm8(EAX, 2);
+   mov_reg32_imm32(EDX, sizeof(precomp_instr));
+   mul_reg32(EDX);
+   mov_reg64_preg64preg64pimm32(RAX, RAX, RDI, (int) offsetof(precomp_instr, ops));
+   mov_reg64_imm64(RDI, (unsigned long long) cached_interpreter_table.NOTCOMPILED);
+   cmp_reg64_reg64(RAX, RDI);
+   je_rj(4); // 2
+   mov_preg64preg64_imm8(RBX, RSI, 1); // 4
+
+   jump_end_rel8();
+}
+
 /* global functions */
 
 void gennotcompiled(void)
@@ -433,11 +545,7 @@ void genj_out(void)
    
    mov_m32rel_imm32((void*)(&last_addr), naddr);
    gencheck_interupt_out(naddr);
-   mov_m32rel_imm32(&jump_to_address, naddr);
-   mov_reg64_imm64(RAX, (unsigned long long) (dst+1));
-   mov_m64rel_xreg64((unsigned long long *)(&PC), RAX);
-   mov_reg64_imm64(RAX, (unsigned long long)jump_to_func);
-   call_reg64(RAX);
+   genjump_out(naddr);
 #endif
 }
 
@@ -530,11 +638,7 @@ void genjal_out(void)
 
    mov_m32rel_imm32((void*)(&last_addr), naddr);
    gencheck_interupt_out(naddr);
-   mov_m32rel_imm32(&jump_to_address, naddr);
-   mov_reg64_imm64(RAX, (unsigned long long) (dst+1));
-   mov_m64rel_xreg64((unsigned long long *)(&PC), RAX);
-   mov_reg64_imm64(RAX, (unsigned long long) jump_to_func);
-   call_reg64(RAX);
+   genjump_out(naddr);
 #endif
 }
 
@@ -611,11 +715,7 @@ void gentest_out(void)
 
    mov_m32rel_imm32((void*)(&last_addr), dst->addr + (dst-1)->f.i.immediate*4);
    gencheck_interupt_out(dst->addr + (dst-1)->f.i.immediate*4);
-   mov_m32rel_imm32(&jump_to_address, dst->addr + (dst-1)->f.i.immediate*4);
-   mov_reg64_imm64(RAX, (unsigned long long) (dst+1));
-   mov_m64rel_xreg64((unsigned long long *)(&PC), RAX);
-   mov_reg64_imm64(RAX, (unsigned long long) jump_to_func);
-   call_reg64(RAX);
+   genjump_out(dst->addr + (dst-1)->f.i.immediate*4);
    jump_end_rel32();
 
    mov_m32rel_imm32((void*)(&last_addr), dst->addr + 4);
@@ -874,8 +974,8 @@ void genaddi(void)
 #ifdef INTERPRET_ADDI
    gencallinterp((unsigned long long)cached_interpreter_table.ADDI, 0);
 #else
-   int rs = allocate_register_32((unsigned int *)dst->f.i.rs);
-   int rt = allocate_register_32_w((unsigned int *)dst->f.i.rt);
+   int rs = allocate_register_32((unsigned int *)&reg[dst->f.i.rs]);
+   int rt = allocate_register_32_w((unsigned int *)&reg[dst->f.i.rt]);
 
    mov_reg32_reg32(rt, rs);
    add_reg32_imm32(rt,(int)dst->f.i.immediate);
@@ -890,8 +990,8 @@ void genaddiu(void)
 #ifdef INTERPRET_ADDIU
    gencallinterp((unsigned long long)cached_interpreter_table.ADDIU, 0);
 #else
-   int rs = allocate_register_32((unsigned int *)dst->f.i.rs);
-   int rt = allocate_register_32_w((unsigned int *)dst->f.i.rt);
+   int rs = allocate_register_32((unsigned int *)&reg[dst->f.i.rs]);
+   int rt = allocate_register_32_w((unsigned int *)&reg[dst->f.i.rt]);
 
    mov_reg32_reg32(rt, rs);
    add_reg32_imm32(rt,(int)dst->f.i.immediate);
@@ -906,8 +1006,8 @@ void genslti(void)
 #ifdef INTERPRET_SLTI
    gencallinterp((unsigned long long)cached_interpreter_table.SLTI, 0);
 #else
-   int rs = allocate_register_64((unsigned long long *) dst->f.i.rs);
-   int rt = allocate_register_64_w((unsigned long long *) dst->f.i.rt);
+   int rs = allocate_register_64((unsigned long long *) &reg[dst->f.i.rs]);
+   int rt = allocate_register_64_w((unsigned long long *) &reg[dst->f.i.rt]);
    int imm = (int) dst->f.i.immediate;
    
    cmp_reg64_imm32(rs, imm);
@@ -924,8 +1024,8 @@ void gensltiu(void)
 #ifdef INTERPRET_SLTIU
    gencallinterp((unsigned long long)cached_interpreter_table.SLTIU, 0);
 #else
-   int rs = allocate_register_64((unsigned long long *)dst->f.i.rs);
-   int rt = allocate_register_64_w((unsigned long long *)dst->f.i.rt);
+   int rs = allocate_register_64((unsigned long long *)&reg[dst->f.i.rs]);
+   int rt = allocate_register_64_w((unsigned long long *)&reg[dst->f.i.rt]);
    int imm = (int) dst->f.i.immediate;
    
    cmp_reg64_imm32(rs, imm);
@@ -942,8 +1042,8 @@ void genandi(void)
 #ifdef INTERPRET_ANDI
    gencallinterp((unsigned long long)cached_interpreter_table.ANDI, 0);
 #else
-   int rs = allocate_register_64((unsigned long long *)dst->f.i.rs);
-   int rt = allocate_register_64_w((unsigned long long *)dst->f.i.rt);
+   int rs = allocate_register_64((unsigned long long *)&reg[dst->f.i.rs]);
+   int rt = allocate_register_64_w((unsigned long long *)&reg[dst->f.i.rt]);
    
    mov_reg64_reg64(rt, rs);
    and_reg64_imm32(rt, (unsigned short)dst->f.i.immediate);
@@ -958,8 +1058,8 @@ void genori(void)
 #ifdef INTERPRET_ORI
    gencallinterp((unsigned long long)cached_interpreter_table.ORI, 0);
 #else
-   int rs = allocate_register_64((unsigned long long *) dst->f.i.rs);
-   int rt = allocate_register_64_w((unsigned long long *) dst->f.i.rt);
+   int rs = allocate_register_64((unsigned long long *) &reg[dst->f.i.rs]);
+   int rt = allocate_register_64_w((unsigned long long *) &reg[dst->f.i.rt]);
    
    mov_reg64_reg64(rt, rs);
    or_reg64_imm32(rt, (unsigned short)dst->f.i.immediate);
@@ -974,8 +1074,8 @@ void genxori(void)
 #ifdef INTERPRET_XORI
    gencallinterp((unsigned long long)cached_interpreter_table.XORI, 0);
 #else
-   int rs = allocate_register_64((unsigned long long *)dst->f.i.rs);
-   int rt = allocate_register_64_w((unsigned long long *)dst->f.i.rt);
+   int rs = allocate_register_64((unsigned long long *)&reg[dst->f.i.rs]);
+   int rt = allocate_register_64_w((unsigned long long *)&reg[dst->f.i.rt]);
    
    mov_reg64_reg64(rt, rs);
    xor_reg64_imm32(rt, (unsigned short)dst->f.i.immediate);
@@ -990,7 +1090,7 @@ void genlui(void)
 #ifdef INTERPRET_LUI
    gencallinterp((unsigned long long)cached_interpreter_table.LUI, 0);
 #else
-   int rt = allocate_register_32_w((unsigned int *)dst->f.i.rt);
+   int rt = allocate_register_32_w((unsigned int *)&reg[dst->f.i.rt]);
 
    mov_reg32_imm32(rt, (unsigned int)dst->f.i.immediate << 16);
 #endif
@@ -1045,12 +1145,7 @@ void gentestl_out(void)
    gendelayslot();
    mov_m32rel_imm32((void*)(&last_addr), dst->addr + (dst-1)->f.i.immediate*4);
    gencheck_interupt_out(dst->addr + (dst-1)->f.i.immediate*4);
-   mov_m32rel_imm32(&jump_to_address, dst->addr + (dst-1)->f.i.immediate*4);
-
-   mov_reg64_imm64(RAX, (unsigned long long) (dst+1));
-   mov_m64rel_xreg64((unsigned long long *)(&PC), RAX);
-   mov_reg64_imm64(RAX, (unsigned long long) jump_to_func);
-   call_reg64(RAX);
+   genjump_out(dst->addr + (dst-1)->f.i.immediate*4);
    
    jump_end_rel32();
 
@@ -1287,8 +1382,8 @@ void gendaddi(void)
 #ifdef INTERPRET_DADDI
    gencallinterp((unsigned long long)cached_interpreter_table.DADDI, 0);
 #else
-   int rs = allocate_register_64((unsigned long long *)dst->f.i.rs);
-   int rt = allocate_register_64_w((unsigned long long *)dst->f.i.rt);
+   int rs = allocate_register_64((unsigned long long *)&reg[dst->f.i.rs]);
+   int rt = allocate_register_64_w((unsigned long long *)&reg[dst->f.i.rt]);
 
    mov_reg64_reg64(rt, rs);
    add_reg64_imm32(rt, (int) dst->f.i.immediate);
@@ -1300,8 +1395,8 @@ void gendaddiu(void)
 #ifdef INTERPRET_DADDIU
    gencallinterp((unsigned long long)cached_interpreter_table.DADDIU, 0);
 #else
-   int rs = allocate_register_64((unsigned long long *)dst->f.i.rs);
-   int rt = allocate_register_64_w((unsigned long long *)dst->f.i.rt);
+   int rs = allocate_register_64((unsigned long long *)&reg[dst->f.i.rs]);
+   int rt = allocate_register_64_w((unsigned long long *)&reg[dst->f.i.rt]);
 
    mov_reg64_reg64(rt, rs);
    add_reg64_imm32(rt, (int) dst->f.i.immediate);
@@ -1337,7 +1432,23 @@ void genlb(void)
 
    ld_register_alloc(&gpr1, &gpr2, &base1, &base2);
 
-   mov_reg64_imm64(base1, (unsigned long long) readmemb);
+   if (fast_memory && g_fastmem_base != NULL)
+     {
+      mov_reg64_imm64(base1, (unsigned long long) g_fastmem_base);
+      xor_reg8_imm8(gpr2, 3);
+      fastmem_site_start();
+      movsx_reg32_8preg64preg64(gpr1, gpr2, base1);
+      fastmem_site_end();
+
+      xor_reg8_imm8(gpr2, 3);
+      ld_call_accessor(gpr2, (unsigned long long) r4300_read_byte);
+      movsx_xreg32_m8rel(gpr1, (unsigned char *)&reg[dst->f.i.rt]);
+      jump_end_rel8();
+
+      set_register_state(gpr1, (unsigned int*)&reg[dst->f.i.rt], 1, 0);
+      return;
+     }
+
    if(fast_memory)
      {
     and_reg32_imm32(gpr1, 0xDF800000);
@@ -1345,6 +1456,7 @@ void genlb(void)
      }
    else
      {
+    mov_reg64_imm64(base1, (unsigned long long) readmemb);
     mov_reg64_imm64(base2, (unsigned long long) read_rdramb);
     shr_reg32_imm8(gpr1, 16);
     mov_reg64_preg64x8preg64(gpr1, gpr1, base1);
@@ -1353,15 +1465,8 @@ void genlb(void)
    je_rj(0);
    jump_start_rel8();
 
-   mov_reg64_imm64(gpr1, (unsigned long long) (dst+1));
-   mov_m64rel_xreg64((unsigned long long *)(&PC), gpr1);
-   mov_m32rel_xreg32((unsigned int *)(&address), gpr2);
-   mov_reg64_imm64(gpr1, (unsigned long long) dst->f.i.rt);
-   mov_m64rel_xreg64((unsigned long long *)(&rdword), gpr1);
-   shr_reg32_imm8(gpr2, 16);
-   mov_reg64_preg64x8preg64(gpr2, gpr2, base1);
-   call_reg64(gpr2);
-   movsx_xreg32_m8rel(gpr1, (unsigned char *)dst->f.i.rt);
+   ld_call_accessor(gpr2, (unsigned long long) r4300_read_byte);
+   movsx_xreg32_m8rel(gpr1, (unsigned char *)&reg[dst->f.i.rt]);
    jmp_imm_short(24);
 
    jump_end_rel8();
@@ -1370,7 +1475,7 @@ void genlb(void)
    xor_reg8_imm8(gpr2, 3); // 4
    movsx_reg32_8preg64preg64(gpr1, gpr2, base1); // 4
 
-   set_register_state(gpr1, (unsigned int*)dst->f.i.rt, 1, 0);
+   set_register_state(gpr1, (unsigned int*)&reg[dst->f.i.rt], 1, 0);
 #endif
 }
 
@@ -1387,7 +1492,23 @@ void genlh(void)
 
    ld_register_alloc(&gpr1, &gpr2, &base1, &base2);
 
-   mov_reg64_imm64(base1, (unsigned long long) readmemh);
+   if (fast_memory && g_fastmem_base != NULL)
+     {
+      mov_reg64_imm64(base1, (unsigned long long) g_fastmem_base);
+      xor_reg8_imm8(gpr2, 2);
+      fastmem_site_start();
+      movsx_reg32_16preg64preg64(gpr1, gpr2, base1);
+      fastmem_site_end();
+
+      xor_reg8_imm8(gpr2, 2);
+      ld_call_accessor(gpr2, (unsigned long long) r4300_read_hword);
+      movsx_xreg32_m16rel(gpr1, (unsigned short *)&reg[dst->f.i.rt]);
+      jump_end_rel8();
+
+      set_register_state(gpr1, (unsigned int*)&reg[dst->f.i.rt], 1, 0);
+      return;
+     }
+
    if(fast_memory)
      {
     and_reg32_imm32(gpr1, 0xDF800000);
@@ -1395,6 +1516,7 @@ void genlh(void)
      }
    else
      {
+    mov_reg64_imm64(base1, (unsigned long long) readmemh);
     mov_reg64_imm64(base2, (unsigned long long) read_rdramh);
     shr_reg32_imm8(gpr1, 16);
     mov_reg64_preg64x8preg64(gpr1, gpr1, base1);
@@ -1403,15 +1525,8 @@ void genlh(void)
    je_rj(0);
    jump_start_rel8();
    
-   mov_reg64_imm64(gpr1, (unsigned long long) (dst+1));
-   mov_m64rel_xreg64((unsigned long long *)(&PC), gpr1);
-   mov_m32rel_xreg32((unsigned int *)(&address), gpr2);
-   mov_reg64_imm64(gpr1, (unsigned long long) dst->f.i.rt);
-   mov_m64rel_xreg64((unsigned long long *)(&rdword), gpr1);
-   shr_reg32_imm8(gpr2, 16);
-   mov_reg64_preg64x8preg64(gpr2, gpr2, base1);
-   call_reg64(gpr2);
-   movsx_xreg32_m16rel(gpr1, (unsigned short *)dst->f.i.rt);
+   ld_call_accessor(gpr2, (unsigned long long) r4300_read_hword);
+   movsx_xreg32_m16rel(gpr1, (unsigned short *)&reg[dst->f.i.rt]);
    jmp_imm_short(24);
 
    jump_end_rel8();   
@@ -1420,7 +1535,7 @@ void genlh(void)
    xor_reg8_imm8(gpr2, 2); // 4
    movsx_reg32_16preg64preg64(gpr1, gpr2, base1); // 4
 
-   set_register_state(gpr1, (unsigned int*)dst->f.i.rt, 1, 0);
+   set_register_state(gpr1, (unsigned int*)&reg[dst->f.i.rt], 1, 0);
 #endif
 }
 
@@ -1445,7 +1560,21 @@ void genlw(void)
 
    ld_register_alloc(&gpr1, &gpr2, &base1, &base2);
 
-   mov_reg64_imm64(base1, (unsigned long long) readmem);
+   if (fast_memory && g_fastmem_base != NULL)
+     {
+      mov_reg64_imm64(base1, (unsigned long long) g_fastmem_base);
+      fastmem_site_start();
+      mov_reg32_preg64preg64(gpr1, gpr2, base1);
+      fastmem_site_end();
+
+      ld_call_accessor(gpr2, (unsigned long long) r4300_read_word);
+      mov_xreg32_m32rel(gpr1, (unsigned int *)(&reg[dst->f.i.rt]));
+      jump_end_rel8();
+
+      set_register_state(gpr1, (unsigned int*)&reg[dst->f.i.rt], 1, 0);
+      return;
+     }
+
    if(fast_memory)
      {
     and_reg32_imm32(gpr1, 0xDF800000);
@@ -1453,6 +1582,7 @@ void genlw(void)
      }
    else
      {
+    mov_reg64_imm64(base1, (unsigned long long) readmem);
     mov_reg64_imm64(base2, (unsigned long long) read_rdram);
     shr_reg32_imm8(gpr1, 16);
     mov_reg64_preg64x8preg64(gpr1, gpr1, base1);
@@ -1466,19 +1596,12 @@ void genlw(void)
    jmp_imm_short(0); // 2
    jump_start_rel8();
 
-   mov_reg64_imm64(gpr1, (unsigned long long) (dst+1));
-   mov_m64rel_xreg64((unsigned long long *)(&PC), gpr1);
-   mov_m32rel_xreg32((unsigned int *)(&address), gpr2);
-   mov_reg64_imm64(gpr1, (unsigned long long) dst->f.i.rt);
-   mov_m64rel_xreg64((unsigned long long *)(&rdword), gpr1);
-   shr_reg32_imm8(gpr2, 16);
-   mov_reg64_preg64x8preg64(gpr1, gpr2, base1);
-   call_reg64(gpr1);
-   mov_xreg32_m32rel(gpr1, (unsigned int *)(dst->f.i.rt));
+   ld_call_accessor(gpr2, (unsigned long long) r4300_read_word);
+   mov_xreg32_m32rel(gpr1, (unsigned int *)(&reg[dst->f.i.rt]));
 
    jump_end_rel8();
 
-   set_register_state(gpr1, (unsigned int*)dst->f.i.rt, 1, 0);     // set gpr1 state as dirty, and bound to r4300 reg RT
+   set_register_state(gpr1, (unsigned int*)&reg[dst->f.i.rt], 1, 0);     // set gpr1 state as dirty, and bound to r4300 reg RT
 #endif
 }
 
@@ -1495,7 +1618,24 @@ void genlbu(void)
 
    ld_register_alloc(&gpr1, &gpr2, &base1, &base2);
 
-   mov_reg64_imm64(base1, (unsigned long long) readmemb);
+   if (fast_memory && g_fastmem_base != NULL)
+     {
+      mov_reg64_imm64(base1, (unsigned long long) g_fastmem_base);
+      xor_reg8_imm8(gpr2, 3);
+      fastmem_site_start();
+      mov_reg32_preg64preg64(gpr1, gpr2, base1);
+      fastmem_site_end();
+
+      xor_reg8_imm8(gpr2, 3);
+      ld_call_accessor(gpr2, (unsigned long long) r4300_read_byte);
+      mov_xreg32_m32rel(gpr1, (unsigned int *)&reg[dst->f.i.rt]);
+      jump_end_rel8();
+
+      and_reg32_imm32(gpr1, 0xFF);
+      set_register_state(gpr1, (unsigned int*)&reg[dst->f.i.rt], 1, 0);
+      return;
+     }
+
    if(fast_memory)
      {
     and_reg32_imm32(gpr1, 0xDF800000);
@@ -1503,6 +1643,7 @@ void genlbu(void)
      }
    else
      {
+    mov_reg64_imm64(base1, (unsigned long long) readmemb);
     mov_reg64_imm64(base2, (unsigned long long) read_rdramb);
     shr_reg32_imm8(gpr1, 16);
     mov_reg64_preg64x8preg64(gpr1, gpr1, base1);
@@ -1511,15 +1652,8 @@ void genlbu(void)
    je_rj(0);
    jump_start_rel8();
 
-   mov_reg64_imm64(gpr1, (unsigned long long) (dst+1));
-   mov_m64rel_xreg64((unsigned long long *)(&PC), gpr1);
-   mov_m32rel_xreg32((unsigned int *)(&address), gpr2);
-   mov_reg64_imm64(gpr1, (unsigned long long) dst->f.i.rt);
-   mov_m64rel_xreg64((unsigned long long *)(&rdword), gpr1);
-   shr_reg32_imm8(gpr2, 16);
-   mov_reg64_preg64x8preg64(gpr2, gpr2, base1);
-   call_reg64(gpr2);
-   mov_xreg32_m32rel(gpr1, (unsigned int *)dst->f.i.rt);
+   ld_call_accessor(gpr2, (unsigned long long) r4300_read_byte);
+   mov_xreg32_m32rel(gpr1, (unsigned int *)&reg[dst->f.i.rt]);
    jmp_imm_short(23);
 
    jump_end_rel8();
@@ -1529,7 +1663,7 @@ void genlbu(void)
    mov_reg32_preg64preg64(gpr1, gpr2, base1); // 3
    
    and_reg32_imm32(gpr1, 0xFF);
-   set_register_state(gpr1, (unsigned int*)dst->f.i.rt, 1, 0);
+   set_register_state(gpr1, (unsigned int*)&reg[dst->f.i.rt], 1, 0);
 #endif
 }
 
@@ -1546,7 +1680,24 @@ void genlhu(void)
 
    ld_register_alloc(&gpr1, &gpr2, &base1, &base2);
 
-   mov_reg64_imm64(base1, (unsigned long long) readmemh);
+   if (fast_memory && g_fastmem_base != NULL)
+     {
+      mov_reg64_imm64(base1, (unsigned long long) g_fastmem_base);
+      xor_reg8_imm8(gpr2, 2);
+      fastmem_site_start();
+      mov_reg32_preg64preg64(gpr1, gpr2, base1);
+      fastmem_site_end();
+
+      xor_reg8_imm8(gpr2, 2);
+      ld_call_accessor(gpr2, (unsigned long long) r4300_read_hword);
+      mov_xreg32_m32rel(gpr1, (unsigned int *)&reg[dst->f.i.rt]);
+      jump_end_rel8();
+
+      and_reg32_imm32(gpr1, 0xFFFF);
+      set_register_state(gpr1, (unsigned int*)&reg[dst->f.i.rt], 1, 0);
+      return;
+     }
+
    if(fast_memory)
      {
     and_reg32_imm32(gpr1, 0xDF800000);
@@ -1554,6 +1705,7 @@ void genlhu(void)
      }
    else
      {
+    mov_reg64_imm64(base1, (unsigned long long) readmemh);
     mov_reg64_imm64(base2, (unsigned long long) read_rdramh);
     shr_reg32_imm8(gpr1, 16);
     mov_reg64_preg64x8preg64(gpr1, gpr1, base1);
@@ -1562,15 +1714,8 @@ void genlhu(void)
    je_rj(0);
    jump_start_rel8();
 
-   mov_reg64_imm64(gpr1, (unsigned long long) (dst+1));
-   mov_m64rel_xreg64((unsigned long long *)(&PC), gpr1);
-   mov_m32rel_xreg32((unsigned int *)(&address), gpr2);
-   mov_reg64_imm64(gpr1, (unsigned long long) dst->f.i.rt);
-   mov_m64rel_xreg64((unsigned long long *)(&rdword), gpr1);
-   shr_reg32_imm8(gpr2, 16);
-   mov_reg64_preg64x8preg64(gpr2, gpr2, base1);
-   call_reg64(gpr2);
-   mov_xreg32_m32rel(gpr1, (unsigned int *)dst->f.i.rt);
+   ld_call_accessor(gpr2, (unsigned long long) r4300_read_hword);
+   mov_xreg32_m32rel(gpr1, (unsigned int *)&reg[dst->f.i.rt]);
    jmp_imm_short(23);
 
    jump_end_rel8();
@@ -1580,7 +1725,7 @@ void genlhu(void)
    mov_reg32_preg64preg64(gpr1, gpr2, base1); // 3
 
    and_reg32_imm32(gpr1, 0xFFFF);
-   set_register_state(gpr1, (unsigned int*)dst->f.i.rt, 1, 0);
+   set_register_state(gpr1, (unsigned int*)&reg[dst->f.i.rt], 1, 0);
 #endif
 }
 
@@ -1605,7 +1750,21 @@ void genlwu(void)
 
    ld_register_alloc(&gpr1, &gpr2, &base1, &base2);
 
-   mov_reg64_imm64(base1, (unsigned long long) readmem);
+   if (fast_memory && g_fastmem_base != NULL)
+     {
+      mov_reg64_imm64(base1, (unsigned long long) g_fastmem_base);
+      fastmem_site_start();
+      mov_reg32_preg64preg64(gpr1, gpr2, base1);
+      fastmem_site_end();
+
+      ld_call_accessor(gpr2, (unsigned long long) r4300_read_word);
+      mov_xreg32_m32rel(gpr1, (unsigned int *)&reg[dst->f.i.rt]);
+      jump_end_rel8();
+
+      set_register_state(gpr1, (unsigned int*)&reg[dst->f.i.rt], 1, 1);
+      return;
+     }
+
    if(fast_memory)
      {
     and_reg32_imm32(gpr1, 0xDF800000);
@@ -1613,6 +1772,7 @@ void genlwu(void)
      }
    else
      {
+    mov_reg64_imm64(base1, (unsigned long long) readmem);
     mov_reg64_imm64(base2, (unsigned long long) read_rdram);
     shr_reg32_imm8(gpr1, 16);
     mov_reg64_preg64x8preg64(gpr1, gpr1, base1);
@@ -1621,15 +1781,8 @@ void genlwu(void)
    je_rj(0);
    jump_start_rel8();
 
-   mov_reg64_imm64(gpr1, (unsigned long long) (dst+1));
-   mov_m64rel_xreg64((unsigned long long *)(&PC), gpr1);
-   mov_m32rel_xreg32((unsigned int *)(&address), gpr2);
-   mov_reg64_imm64(gpr1, (unsigned long long) dst->f.i.rt);
-   mov_m64rel_xreg64((unsigned long long *)(&rdword), gpr1);
-   shr_reg32_imm8(gpr2, 16);
-   mov_reg64_preg64x8preg64(gpr2, gpr2, base1);
-   call_reg64(gpr2);
-   mov_xreg32_m32rel(gpr1, (unsigned int *)dst->f.i.rt);
+   ld_call_accessor(gpr2, (unsigned long long) r4300_read_word);
+   mov_xreg32_m32rel(gpr1, (unsigned int *)&reg[dst->f.i.rt]);
    jmp_imm_short(19);
 
    jump_end_rel8();
@@ -1637,7 +1790,7 @@ void genlwu(void)
    and_reg32_imm32(gpr2, 0x7FFFFF); // 6
    mov_reg32_preg64preg64(gpr1, gpr2, base1); // 3
 
-   set_register_state(gpr1, (unsigned int*)dst->f.i.rt, 1, 1);
+   set_register_state(gpr1, (unsigned int*)&reg[dst->f.i.rt], 1, 1);
 #endif
 }
 
@@ -1651,11 +1804,26 @@ void gensb(void)
 #else
    free_registers_move_start();
 
-   mov_xreg8_m8rel(CL, (unsigned char *)dst->f.i.rt);
-   mov_xreg32_m32rel(EAX, (unsigned int *)dst->f.i.rs);
+   mov_xreg8_m8rel(CL, (unsigned char *)&reg[dst->f.i.rt]);
+   mov_xreg32_m32rel(EAX, (unsigned int *)&reg[dst->f.i.rs]);
    add_eax_imm32((int)dst->f.i.immediate);
    mov_reg32_reg32(EBX, EAX);
-   mov_reg64_imm64(RSI, (unsigned long long) writememb);
+   if (fast_memory && g_fastmem_base != NULL)
+     {
+      mov_reg64_imm64(RSI, (unsigned long long) g_fastmem_base);
+      xor_reg8_imm8(BL, 3);
+      fastmem_site_start();
+      mov_preg64preg64_reg8(RBX, RSI, CL);
+      fastmem_site_end();
+
+      xor_reg8_imm8(BL, 3);
+      st_call_accessor((unsigned long long) r4300_write_byte, 0xFF);
+      jump_end_rel8();
+
+      st_invalidate_code();
+      return;
+     }
+
    if(fast_memory)
      {
     and_eax_imm32(0xDF800000);
@@ -1663,48 +1831,26 @@ void gensb(void)
      }
    else
      {
+    mov_reg64_imm64(RSI, (unsigned long long) writememb);
     mov_reg64_imm64(RDI, (unsigned long long) write_rdramb);
     shr_reg32_imm8(EAX, 16);
     mov_reg64_preg64x8preg64(RAX, RAX, RSI);
     cmp_reg64_reg64(RAX, RDI);
      }
-   je_rj(49);
+   je_rj(0);
+   jump_start_rel8();
 
-   mov_reg64_imm64(RAX, (unsigned long long) (dst+1)); // 10
-   mov_m64rel_xreg64((unsigned long long *)(&PC), RAX); // 7
-   mov_m32rel_xreg32((unsigned int *)(&address), EBX); // 7
-   mov_m8rel_xreg8((unsigned char *)(&cpu_byte), CL); // 7
-   shr_reg32_imm8(EBX, 16); // 3
-   mov_reg64_preg64x8preg64(RBX, RBX, RSI);  // 4
-   call_reg64(RBX); // 2
-   mov_xreg32_m32rel(EAX, (unsigned int *)(&address)); // 7
+   st_call_accessor((unsigned long long) r4300_write_byte, 0xFF);
    jmp_imm_short(25); // 2
 
+   jump_end_rel8();
    mov_reg64_imm64(RSI, (unsigned long long) g_rdram); // 10
    mov_reg32_reg32(EAX, EBX); // 2
    and_reg32_imm32(EBX, 0x7FFFFF); // 6
    xor_reg8_imm8(BL, 3); // 4
    mov_preg64preg64_reg8(RBX, RSI, CL); // 3
    
-   mov_reg64_imm64(RSI, (unsigned long long) invalid_code);
-   mov_reg32_reg32(EBX, EAX);
-   shr_reg32_imm8(EBX, 12);
-   cmp_preg64preg64_imm8(RBX, RSI, 0);
-   jne_rj(65);
-
-   mov_reg64_imm64(RDI, (unsigned long long) blocks); // 10
-   mov_reg32_reg32(ECX, EBX); // 2
-   mov_reg64_preg64x8preg64(RBX, RBX, RDI);  // 4
-   mov_reg64_preg64pimm32(RBX, RBX, (int) offsetof(precomp_block, block)); // 7
-   mov_reg64_imm64(RDI, (unsigned long long) cached_interpreter_table.NOTCOMPILED); // 10
-   and_eax_imm32(0xFFF); // 5
-   shr_reg32_imm8(EAX, 2); // 3
-   mov_reg32_imm32(EDX, sizeof(precomp_instr)); // 5
-   mul_reg32(EDX); // 2
-   mov_reg64_preg64preg64pimm32(RAX, RAX, RBX, (int) offsetof(precomp_instr, ops)); // 8
-   cmp_reg64_reg64(RAX, RDI); // 3
-   je_rj(4); // 2
-   mov_preg64preg64_imm8(RCX, RSI, 1); // 4
+   st_invalidate_code();
 #endif
 }
 
@@ -1718,11 +1864,26 @@ void gensh(void)
 #else
    free_registers_move_start();
 
-   mov_xreg16_m16rel(CX, (unsigned short *)dst->f.i.rt);
-   mov_xreg32_m32rel(EAX, (unsigned int *)dst->f.i.rs);
+   mov_xreg16_m16rel(CX, (unsigned short *)&reg[dst->f.i.rt]);
+   mov_xreg32_m32rel(EAX, (unsigned int *)&reg[dst->f.i.rs]);
    add_eax_imm32((int)dst->f.i.immediate);
    mov_reg32_reg32(EBX, EAX);
-   mov_reg64_imm64(RSI, (unsigned long long) writememh);
+   if (fast_memory && g_fastmem_base != NULL)
+     {
+      mov_reg64_imm64(RSI, (unsigned long long) g_fastmem_base);
+      xor_reg8_imm8(BL, 2);
+      fastmem_site_start();
+      mov_preg64preg64_reg16(RBX, RSI, CX);
+      fastmem_site_end();
+
+      xor_reg8_imm8(BL, 2);
+      st_call_accessor((unsigned long long) r4300_write_hword, 0xFFFF);
+      jump_end_rel8();
+
+      st_invalidate_code();
+      return;
+     }
+
    if(fast_memory)
      {
     and_eax_imm32(0xDF800000);
@@ -1730,48 +1891,26 @@ void gensh(void)
      }
    else
      {
+    mov_reg64_imm64(RSI, (unsigned long long) writememh);
     mov_reg64_imm64(RDI, (unsigned long long) write_rdramh);
     shr_reg32_imm8(EAX, 16);
     mov_reg64_preg64x8preg64(RAX, RAX, RSI);
     cmp_reg64_reg64(RAX, RDI);
      }
-   je_rj(50);
+   je_rj(0);
+   jump_start_rel8();
 
-   mov_reg64_imm64(RAX, (unsigned long long) (dst+1)); // 10
-   mov_m64rel_xreg64((unsigned long long *)(&PC), RAX); // 7
-   mov_m32rel_xreg32((unsigned int *)(&address), EBX); // 7
-   mov_m16rel_xreg16((unsigned short *)(&cpu_hword), CX); // 8
-   shr_reg32_imm8(EBX, 16); // 3
-   mov_reg64_preg64x8preg64(RBX, RBX, RSI);  // 4
-   call_reg64(RBX); // 2
-   mov_xreg32_m32rel(EAX, (unsigned int *)(&address)); // 7
+   st_call_accessor((unsigned long long) r4300_write_hword, 0xFFFF);
    jmp_imm_short(26); // 2
 
+   jump_end_rel8();
    mov_reg64_imm64(RSI, (unsigned long long) g_rdram); // 10
    mov_reg32_reg32(EAX, EBX); // 2
    and_reg32_imm32(EBX, 0x7FFFFF); // 6
    xor_reg8_imm8(BL, 2); // 4
    mov_preg64preg64_reg16(RBX, RSI, CX); // 4
 
-   mov_reg64_imm64(RSI, (unsigned long long) invalid_code);
-   mov_reg32_reg32(EBX, EAX);
-   shr_reg32_imm8(EBX, 12);
-   cmp_preg64preg64_imm8(RBX, RSI, 0);
-   jne_rj(65);
-
-   mov_reg64_imm64(RDI, (unsigned long long) blocks); // 10
-   mov_reg32_reg32(ECX, EBX); // 2
-   mov_reg64_preg64x8preg64(RBX, RBX, RDI);  // 4
-   mov_reg64_preg64pimm32(RBX, RBX, (int) offsetof(precomp_block, block)); // 7
-   mov_reg64_imm64(RDI, (unsigned long long) cached_interpreter_table.NOTCOMPILED); // 10
-   and_eax_imm32(0xFFF); // 5
-   shr_reg32_imm8(EAX, 2); // 3
-   mov_reg32_imm32(EDX, sizeof(precomp_instr)); // 5
-   mul_reg32(EDX); // 2
-   mov_reg64_preg64preg64pimm32(RAX, RAX, RBX, (int) offsetof(precomp_instr, ops)); // 8
-   cmp_reg64_reg64(RAX, RDI); // 3
-   je_rj(4); // 2
-   mov_preg64preg64_imm8(RCX, RSI, 1); // 4
+   st_invalidate_code();
 #endif
 }
 
@@ -1793,11 +1932,24 @@ void gensw(void)
 #else
    free_registers_move_start();
 
-   mov_xreg32_m32rel(ECX, (unsigned int *)dst->f.i.rt);
-   mov_xreg32_m32rel(EAX, (unsigned int *)dst->f.i.rs);
+   mov_xreg32_m32rel(ECX, (unsigned int *)&reg[dst->f.i.rt]);
+   mov_xreg32_m32rel(EAX, (unsigned int *)&reg[dst->f.i.rs]);
    add_eax_imm32((int)dst->f.i.immediate);
    mov_reg32_reg32(EBX, EAX);
-   mov_reg64_imm64(RSI, (unsigned long long) writemem);
+   if (fast_memory && g_fastmem_base != NULL)
+     {
+      mov_reg64_imm64(RSI, (unsigned long long) g_fastmem_base);
+      fastmem_site_start();
+      mov_preg64preg64_reg32(RBX, RSI, ECX);
+      fastmem_site_end();
+
+      st_call_accessor((unsigned long long) r4300_write_word, 0xFFFFFFFF);
+      jump_end_rel8();
+
+      st_invalidate_code();
+      return;
+     }
+
    if(fast_memory)
      {
     and_eax_imm32(0xDF800000);
@@ -1805,47 +1957,25 @@ void gensw(void)
      }
    else
      {
+    mov_reg64_imm64(RSI, (unsigned long long) writemem);
     mov_reg64_imm64(RDI, (unsigned long long) write_rdram);
     shr_reg32_imm8(EAX, 16);
     mov_reg64_preg64x8preg64(RAX, RAX, RSI);
     cmp_reg64_reg64(RAX, RDI);
      }
-   je_rj(49);
+   je_rj(0);
+   jump_start_rel8();
 
-   mov_reg64_imm64(RAX, (unsigned long long) (dst+1)); // 10
-   mov_m64rel_xreg64((unsigned long long *)(&PC), RAX); // 7
-   mov_m32rel_xreg32((unsigned int *)(&address), EBX); // 7
-   mov_m32rel_xreg32((unsigned int *)(&cpu_word), ECX); // 7
-   shr_reg32_imm8(EBX, 16); // 3
-   mov_reg64_preg64x8preg64(RBX, RBX, RSI);  // 4
-   call_reg64(RBX); // 2
-   mov_xreg32_m32rel(EAX, (unsigned int *)(&address)); // 7
+   st_call_accessor((unsigned long long) r4300_write_word, 0xFFFFFFFF);
    jmp_imm_short(21); // 2
 
+   jump_end_rel8();
    mov_reg64_imm64(RSI, (unsigned long long) g_rdram); // 10
    mov_reg32_reg32(EAX, EBX); // 2
    and_reg32_imm32(EBX, 0x7FFFFF); // 6
    mov_preg64preg64_reg32(RBX, RSI, ECX); // 3
 
-   mov_reg64_imm64(RSI, (unsigned long long) invalid_code);
-   mov_reg32_reg32(EBX, EAX);
-   shr_reg32_imm8(EBX, 12);
-   cmp_preg64preg64_imm8(RBX, RSI, 0);
-   jne_rj(65);
-
-   mov_reg64_imm64(RDI, (unsigned long long) blocks); // 10
-   mov_reg32_reg32(ECX, EBX); // 2
-   mov_reg64_preg64x8preg64(RBX, RBX, RDI);  // 4
-   mov_reg64_preg64pimm32(RBX, RBX, (int) offsetof(precomp_block, block)); // 7
-   mov_reg64_imm64(RDI, (unsigned long long) cached_interpreter_table.NOTCOMPILED); // 10
-   and_eax_imm32(0xFFF); // 5
-   shr_reg32_imm8(EAX, 2); // 3
-   mov_reg32_imm32(EDX, sizeof(precomp_instr)); // 5
-   mul_reg32(EDX); // 2
-   mov_reg64_preg64preg64pimm32(RAX, RAX, RBX, (int) offsetof(precomp_instr, ops)); // 8
-   cmp_reg64_reg64(RAX, RDI); // 3
-   je_rj(4); // 2
-   mov_preg64preg64_imm8(RCX, RSI, 1); // 4
+   st_invalidate_code();
 #endif
 }
 
@@ -1994,7 +2124,7 @@ void genld(void)
 #else
    free_registers_move_start();
 
-   mov_xreg32_m32rel(EAX, (unsigned int *)dst->f.i.rs);
+   mov_xreg32_m32rel(EAX, (unsigned int *)&reg[dst->f.i.rs]);
    add_eax_imm32((int)dst->f.i.immediate);
    mov_reg32_reg32(EBX, EAX);
    mov_reg64_imm64(RSI, (unsigned long long) readmemd);
@@ -2015,12 +2145,12 @@ void genld(void)
    mov_reg64_imm64(RAX, (unsigned long long) (dst+1)); // 10
    mov_m64rel_xreg64((unsigned long long *)(&PC), RAX); // 7
    mov_m32rel_xreg32((unsigned int *)(&address), EBX); // 7
-   mov_reg64_imm64(RAX, (unsigned long long) dst->f.i.rt); // 10
+   mov_reg64_imm64(RAX, (unsigned long long) &reg[dst->f.i.rt]); // 10
    mov_m64rel_xreg64((unsigned long long *)(&rdword), RAX); // 7
    shr_reg32_imm8(EBX, 16); // 3
    mov_reg64_preg64x8preg64(RBX, RBX, RSI);  // 4
    call_reg64(RBX); // 2
-   mov_xreg64_m64rel(RAX, (unsigned long long *)(dst->f.i.rt)); // 7
+   mov_xreg64_m64rel(RAX, (unsigned long long *)(&reg[dst->f.i.rt])); // 7
    jmp_imm_short(33); // 2
 
    mov_reg64_imm64(RSI, (unsigned long long) g_rdram); // 10
@@ -2031,7 +2161,7 @@ void genld(void)
    shl_reg64_imm8(RAX, 32); // 4
    or_reg64_reg64(RAX, RBX); // 3
    
-   set_register_state(RAX, (unsigned int*)dst->f.i.rt, 1, 1);
+   set_register_state(RAX, (unsigned int*)&reg[dst->f.i.rt], 1, 1);
 #endif
 }
 
@@ -2080,25 +2210,7 @@ void genswc1(void)
    and_reg32_imm32(EBX, 0x7FFFFF); // 6
    mov_preg64preg64_reg32(RBX, RSI, ECX); // 3
    
-   mov_reg64_imm64(RSI, (unsigned long long) invalid_code);
-   mov_reg32_reg32(EBX, EAX);
-   shr_reg32_imm8(EBX, 12);
-   cmp_preg64preg64_imm8(RBX, RSI, 0);
-   jne_rj(65);
-
-   mov_reg64_imm64(RDI, (unsigned long long) blocks); // 10
-   mov_reg32_reg32(ECX, EBX); // 2
-   mov_reg64_preg64x8preg64(RBX, RBX, RDI);  // 4
-   mov_reg64_preg64pimm32(RBX, RBX, (int) offsetof(precomp_block, block)); // 7
-   mov_reg64_imm64(RDI, (unsigned long long) cached_interpreter_table.NOTCOMPILED); // 10
-   and_eax_imm32(0xFFF); // 5
-   shr_reg32_imm8(EAX, 2); // 3
-   mov_reg32_imm32(EDX, sizeof(precomp_instr)); // 5
-   mul_reg32(EDX); // 2
-   mov_reg64_preg64preg64pimm32(RAX, RAX, RBX, (int) offsetof(precomp_instr, ops)); // 8
-   cmp_reg64_reg64(RAX, RDI); // 3
-   je_rj(4); // 2
-   mov_preg64preg64_imm8(RCX, RSI, 1); // 4
+   st_invalidate_code();
 #endif
 }
 
@@ -2150,25 +2262,7 @@ void gensdc1(void)
    mov_preg64preg64pimm32_reg32(RBX, RSI, 4, ECX); // 7
    mov_preg64preg64_reg32(RBX, RSI, EDX); // 3
 
-   mov_reg64_imm64(RSI, (unsigned long long) invalid_code);
-   mov_reg32_reg32(EBX, EAX);
-   shr_reg32_imm8(EBX, 12);
-   cmp_preg64preg64_imm8(RBX, RSI, 0);
-   jne_rj(65);
-
-   mov_reg64_imm64(RDI, (unsigned long long) blocks); // 10
-   mov_reg32_reg32(ECX, EBX); // 2
-   mov_reg64_preg64x8preg64(RBX, RBX, RDI);  // 4
-   mov_reg64_preg64pimm32(RBX, RBX, (int) offsetof(precomp_block, block)); // 7
-   mov_reg64_imm64(RDI, (unsigned long long) cached_interpreter_table.NOTCOMPILED); // 10
-   and_eax_imm32(0xFFF); // 5
-   shr_reg32_imm8(EAX, 2); // 3
-   mov_reg32_imm32(EDX, sizeof(precomp_instr)); // 5
-   mul_reg32(EDX); // 2
-   mov_reg64_preg64preg64pimm32(RAX, RAX, RBX, (int) offsetof(precomp_instr, ops)); // 8
-   cmp_reg64_reg64(RAX, RDI); // 3
-   je_rj(4); // 2
-   mov_preg64preg64_imm8(RCX, RSI, 1); // 4
+   st_invalidate_code();
 #endif
 }
 
@@ -2182,9 +2276,9 @@ void gensd(void)
 #else
    free_registers_move_start();
 
-   mov_xreg32_m32rel(ECX, (unsigned int *)dst->f.i.rt);
-   mov_xreg32_m32rel(EDX, ((unsigned int *)dst->f.i.rt)+1);
-   mov_xreg32_m32rel(EAX, (unsigned int *)dst->f.i.rs);
+   mov_xreg32_m32rel(ECX, (unsigned int *)&reg[dst->f.i.rt]);
+   mov_xreg32_m32rel(EDX, ((unsigned int *)&reg[dst->f.i.rt])+1);
+   mov_xreg32_m32rel(EAX, (unsigned int *)&reg[dst->f.i.rs]);
    add_eax_imm32((int)dst->f.i.immediate);
    mov_reg32_reg32(EBX, EAX);
    mov_reg64_imm64(RSI, (unsigned long long) writememd);
@@ -2219,28 +2313,21 @@ void gensd(void)
    mov_preg64preg64pimm32_reg32(RBX, RSI, 4, ECX); // 7
    mov_preg64preg64_reg32(RBX, RSI, EDX); // 3
 
-   mov_reg64_imm64(RSI, (unsigned long long) invalid_code);
-   mov_reg32_reg32(EBX, EAX);
-   shr_reg32_imm8(EBX, 12);
-   cmp_preg64preg64_imm8(RBX, RSI, 0);
-   jne_rj(65);
-
-   mov_reg64_imm64(RDI, (unsigned long long) blocks); // 10
-   mov_reg32_reg32(ECX, EBX); // 2
-   mov_reg64_preg64x8preg64(RBX, RBX, RDI);  // 4
-   mov_reg64_preg64pimm32(RBX, RBX, (int) offsetof(precomp_block, block)); // 7
-   mov_reg64_imm64(RDI, (unsigned long long) cached_interpreter_table.NOTCOMPILED); // 10
-   and_eax_imm32(0xFFF); // 5
-   shr_reg32_imm8(EAX, 2); // 3
-   mov_reg32_imm32(EDX, sizeof(precomp_instr)); // 5
-   mul_reg32(EDX); // 2
-   mov_reg64_preg64preg64pimm32(RAX, RAX, RBX, (int) offsetof(precomp_instr, ops)); // 8
-   cmp_reg64_reg64(RAX, RDI); // 3
-   je_rj(4); // 2
-   mov_preg64preg64_imm8(RCX, RSI, 1); // 4
+   st_invalidate_code();
 #endif
 }
 
+int dynarec_fastmem_fixup(unsigned char *pc)
+{
+   /* only recompiled code has fastmem sites */
+   if (!code_cache_contains(pc, FASTMEM_SITE_SIZE + 1) || pc[FASTMEM_SITE_SIZE] != 0xEB)
+     return 0;
+
+   pc[0] = 0xEB; // jmp short to the slow path
+   pc[1] = FASTMEM_SITE_SIZE;
+   return 1;
+}
+
 void genll(void)
 {
 #if defined(COUNT_INSTR)
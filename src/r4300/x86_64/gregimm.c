@@ -40,23 +40,23 @@
 
 static void genbltz_test(void)
 {
-  int rs_64bit = is64((unsigned int *)dst->f.i.rs);
+  int rs_64bit = is64((unsigned int *)&reg[dst->f.i.rs]);
    
   if (rs_64bit == 0)
   {
-    int rs = allocate_register_32((unsigned int *)dst->f.i.rs);
+    int rs = allocate_register_32((unsigned int *)&reg[dst->f.i.rs]);
     
     cmp_reg32_imm32(rs, 0);
     setl_m8rel((unsigned char *) &branch_taken);
   }
   else if (rs_64bit == -1)
   {
-    cmp_m32rel_imm32(((unsigned int *)dst->f.i.rs)+1, 0);
+    cmp_m32rel_imm32(((unsigned int *)&reg[dst->f.i.rs])+1, 0);
     setl_m8rel((unsigned char *) &branch_taken);
   }
   else
   {
-    int rs = allocate_register_64((unsigned long long *)dst->f.i.rs);
+    int rs = allocate_register_64((unsigned long long *)&reg[dst->f.i.rs]);
 
     cmp_reg64_imm8(rs, 0);
     setl_m8rel((unsigned char *) &branch_taken);
@@ -125,22 +125,22 @@ void genbltz_idle(void)
 
 static void genbgez_test(void)
 {
-  int rs_64bit = is64((unsigned int *)dst->f.i.rs);
+  int rs_64bit = is64((unsigned int *)&reg[dst->f.i.rs]);
    
   if (rs_64bit == 0)
   {
-    int rs = allocate_register_32((unsigned int *)dst->f.i.rs);
+    int rs = allocate_register_32((unsigned int *)&reg[dst->f.i.rs]);
     cmp_reg32_imm32(rs, 0);
     setge_m8rel((unsigned char *) &branch_taken);
   }
   else if (rs_64bit == -1)
   {
-    cmp_m32rel_imm32(((unsigned int *)dst->f.i.rs)+1, 0);
+    cmp_m32rel_imm32(((unsigned int *)&reg[dst->f.i.rs])+1, 0);
     setge_m8rel((unsigned char *) &branch_taken);
   }
   else
   {
-    int rs = allocate_register_64((unsigned long long *)dst->f.i.rs);
+    int rs = allocate_register_64((unsigned long long *)&reg[dst->f.i.rs]);
     cmp_reg64_imm8(rs, 0);
     setge_m8rel((unsigned char *) &branch_taken);
   }
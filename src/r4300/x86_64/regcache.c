@@ -74,7 +74,7 @@ void free_all_registers(void)
     {
       while (free_since[i] <= dst)
       {
-        free_since[i]->reg_cache_infos.needed_registers[i] = NULL;
+        get_precomp_info(dst_block, free_since[i])->reg_cache_infos.needed_registers[i] = NULL;
         free_since[i]++;
       }
     }
@@ -99,8 +99,9 @@ void free_all_registers(void)
 static void simplify_access(void)
 {
    int i;
-   dst->local_addr = code_length;
-   for(i=0; i<8; i++) dst->reg_cache_infos.needed_registers[i] = NULL;
+   precomp_info *info = get_precomp_info(dst_block, dst);
+   info->local_addr = code_length;
+   for(i=0; i<8; i++) info->reg_cache_infos.needed_registers[i] = NULL;
 }
 
 void free_registers_move_start(void)
@@ -126,9 +127,9 @@ void free_register(int reg)
   while (last <= dst)
   {
     if (last_access[reg] != NULL && dirty[reg])
-      last->reg_cache_infos.needed_registers[reg] = reg_content[reg];
+      get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[reg] = reg_content[reg];
     else
-      last->reg_cache_infos.needed_registers[reg] = NULL;
+      get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[reg] = NULL;
     last++;
   }
   if (last_access[reg] == NULL) 
@@ -227,7 +228,7 @@ int allocate_register_32(unsigned int *addr)
 
         while (last <= dst)
         {
-          last->reg_cache_infos.needed_registers[i] = reg_content[i];
+          get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[i] = reg_content[i];
           last++;
         }
         last_access[i] = dst;
@@ -246,7 +247,7 @@ int allocate_register_32(unsigned int *addr)
   {
     while (free_since[reg] <= dst)
     {
-      free_since[reg]->reg_cache_infos.needed_registers[reg] = NULL;
+      get_precomp_info(dst_block, free_since[reg])->reg_cache_infos.needed_registers[reg] = NULL;
       free_since[reg]++;
     }
   }
@@ -284,7 +285,7 @@ int allocate_register_64(unsigned long long *addr)
 
         while (last <= dst)
         {
-          last->reg_cache_infos.needed_registers[i] = reg_content[i];
+          get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[i] = reg_content[i];
           last++;
         }
         last_access[i] = dst;
@@ -307,7 +308,7 @@ int allocate_register_64(unsigned long long *addr)
   {
     while (free_since[reg] <= dst)
     {
-      free_since[reg]->reg_cache_infos.needed_registers[reg] = NULL;
+      get_precomp_info(dst_block, free_since[reg])->reg_cache_infos.needed_registers[reg] = NULL;
       free_since[reg]++;
     }
   }
@@ -358,7 +359,7 @@ int allocate_register_32_w(unsigned int *addr)
          
       while (last <= dst)
       {
-        last->reg_cache_infos.needed_registers[i] = NULL;
+        get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[i] = NULL;
         last++;
       }
       last_access[i] = dst;
@@ -377,7 +378,7 @@ int allocate_register_32_w(unsigned int *addr)
   {
     while (free_since[reg] <= dst)
     {
-      free_since[reg]->reg_cache_infos.needed_registers[reg] = NULL;
+      get_precomp_info(dst_block, free_since[reg])->reg_cache_infos.needed_registers[reg] = NULL;
       free_since[reg]++;
     }
   }
@@ -403,7 +404,7 @@ int allocate_register_64_w(unsigned long long *addr)
 
       while (last <= dst)
       {
-        last->reg_cache_infos.needed_registers[i] = NULL;
+        get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[i] = NULL;
         last++;
       }
       last_access[i] = dst;
@@ -422,7 +423,7 @@ int allocate_register_64_w(unsigned long long *addr)
   {
     while (free_since[reg] <= dst)
     {
-      free_since[reg]->reg_cache_infos.needed_registers[reg] = NULL;
+      get_precomp_info(dst_block, free_since[reg])->reg_cache_infos.needed_registers[reg] = NULL;
       free_since[reg]++;
     }
   }
@@ -445,7 +446,7 @@ void allocate_register_32_manually(int reg, unsigned int *addr)
     precomp_instr *last = last_access[reg] + 1;
     while (last <= dst)
     {
-      last->reg_cache_infos.needed_registers[reg] = reg_content[reg];
+      get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[reg] = reg_content[reg];
       last++;
     }
     last_access[reg] = dst;
@@ -460,7 +461,7 @@ void allocate_register_32_manually(int reg, unsigned int *addr)
   {
     while (free_since[reg] <= dst)
     {
-      free_since[reg]->reg_cache_infos.needed_registers[reg] = NULL;
+      get_precomp_info(dst_block, free_since[reg])->reg_cache_infos.needed_registers[reg] = NULL;
       free_since[reg]++;
     }
   }
@@ -473,7 +474,7 @@ void allocate_register_32_manually(int reg, unsigned int *addr)
       precomp_instr *last = last_access[i]+1;
       while (last <= dst)
       {
-        last->reg_cache_infos.needed_registers[i] = reg_content[i];
+        get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[i] = reg_content[i];
         last++;
       }
       last_access[i] = dst;
@@ -514,7 +515,7 @@ void allocate_register_32_manually_w(int reg, unsigned int *addr)
     precomp_instr *last = last_access[reg]+1;
     while (last <= dst)
     {
-      last->reg_cache_infos.needed_registers[reg] = NULL;
+      get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[reg] = NULL;
       last++;
     }
     last_access[reg] = dst;
@@ -530,7 +531,7 @@ void allocate_register_32_manually_w(int reg, unsigned int *addr)
   {
     while (free_since[reg] <= dst)
     {
-      free_since[reg]->reg_cache_infos.needed_registers[reg] = NULL;
+      get_precomp_info(dst_block, free_since[reg])->reg_cache_infos.needed_registers[reg] = NULL;
       free_since[reg]++;
     }
   }
@@ -543,7 +544,7 @@ void allocate_register_32_manually_w(int reg, unsigned int *addr)
       precomp_instr *last = last_access[i] + 1;
       while (last <= dst)
       {
-        last->reg_cache_infos.needed_registers[i] = NULL;
+        get_precomp_info(dst_block, last)->reg_cache_infos.needed_registers[i] = NULL;
         last++;
       }
       last_access[reg] = dst;
@@ -580,7 +581,7 @@ void allocate_register_32_manually_w(int reg, unsigned int *addr)
 // 0xC3 ret
 // total : 84 bytes
 
-static void build_wrapper(precomp_instr *instr, unsigned char* pCode, precomp_block* block)
+static void build_wrapper(precomp_info *info, unsigned char* pCode, precomp_block* block)
 {
    int i;
 
@@ -604,7 +605,7 @@ static void build_wrapper(precomp_instr *instr, unsigned char* pCode, precomp_bl
    
    *pCode++ = 0x48;
    *pCode++ = 0x05;
-   *((unsigned int *) pCode) = (unsigned int) instr->local_addr;
+   *((unsigned int *) pCode) = (unsigned int) info->local_addr;
    pCode += 4;
    
    *pCode++ = 0x48;
@@ -620,18 +621,18 @@ static void build_wrapper(precomp_instr *instr, unsigned char* pCode, precomp_bl
    for (i=7; i>=0; i--)
    {
      long long riprel;
-     if (instr->reg_cache_infos.needed_registers[i] != NULL)
+     if (info->reg_cache_infos.needed_registers[i] != NULL)
      {
        *pCode++ = 0x48;
        *pCode++ = 0x8B;
        *pCode++ = 0x80 | (i << 3);
-       riprel = (long long) ((unsigned char *) instr->reg_cache_infos.needed_registers[i] - (unsigned char *) &reg[0]);
+       riprel = (long long) ((unsigned char *) info->reg_cache_infos.needed_registers[i] - (unsigned char *) &reg[0]);
        *((int *) pCode) = (int) riprel;
        pCode += 4;
        if (riprel >= 0x7fffffffLL || riprel < -0x80000000LL)
        {
          DebugMessage(M64MSG_ERROR, "build_wrapper error: reg[%i] offset too big for relative address from %p to %p",
-                i, (&reg[0]), instr->reg_cache_infos.needed_registers[i]);
+                i, (&reg[0]), info->reg_cache_infos.needed_registers[i]);
          OSAL_BREAKPOINT_INTERRUPT;
        }
      }
@@ -639,18 +640,18 @@ static void build_wrapper(precomp_instr *instr, unsigned char* pCode, precomp_bl
    *pCode++ = 0xC3;
 }
 
-void build_wrappers(precomp_instr *instr, int start, int end, precomp_block* block)
+void build_wrappers(precomp_info *info, int start, int end, precomp_block* block)
 {
    int i, reg;
    for (i=start; i<end; i++)
      {
-    instr[i].reg_cache_infos.need_map = 0;
+    info[i].reg_cache_infos.need_map = 0;
     for (reg=0; reg<8; reg++)
       {
-         if (instr[i].reg_cache_infos.needed_registers[reg] != NULL)
+         if (info[i].reg_cache_infos.needed_registers[reg] != NULL)
            {
-          instr[i].reg_cache_infos.need_map = 1;
-          build_wrapper(&instr[i], instr[i].reg_cache_infos.jump_wrapper, block);
+          info[i].reg_cache_infos.need_map = 1;
+          build_wrapper(&info[i], info[i].reg_cache_infos.jump_wrapper, block);
           break;
            }
       }
@@ -41,7 +41,7 @@ int allocate_register_32_w(unsigned int *addr);
 int allocate_register_64_w(unsigned long long *addr);
 void allocate_register_32_manually(int reg, unsigned int *addr);
 void allocate_register_32_manually_w(int reg, unsigned int *addr);
-void build_wrappers(precomp_instr*, int, int, precomp_block*);
+void build_wrappers(precomp_info*, int, int, precomp_block*);
 
 #endif /* M64P_R4300_REGCACHE_H */
 
@@ -43,10 +43,164 @@ void dyna_jump(void)
         return;
     }
 
-    if (PC->reg_cache_infos.need_map)
-        *return_address = (unsigned long long) (PC->reg_cache_infos.jump_wrapper);
+    precomp_info *info = get_precomp_info(actual, PC);
+
+    if (info->reg_cache_infos.need_map)
+        *return_address = (unsigned long long) (info->reg_cache_infos.jump_wrapper);
+    else
+        *return_address = (unsigned long long) (actual->code + info->local_addr);
+}
+
+/* A link from the link site at offset in the code of source to target.
+ * Each link is in the links_out list of its source and in the links_in
+ * list of its target, so that it is removed when either block changes. */
+struct block_link
+{
+    precomp_block *source;
+    unsigned int offset;
+    precomp_block *target;
+    struct block_link *next_in, **prev_in;
+    struct block_link *next_out, **prev_out;
+};
+
+/* source of the link site being taken, set by the recompiled code */
+precomp_block *link_site_block;
+unsigned int link_site_offset;
+
+/* cleared if the source block changes while we jump */
+static precomp_block *linking_block;
+
+static const char *invalid_code_ptr(uint32_t addr)
+{
+    uint32_t page = addr >> 12;
+    return &block_dir[page >> BLOCK_PAGE_BITS]->invalid_code[page & (BLOCK_PAGE_SIZE - 1)];
+}
+
+/* Writes a link site, which jumps to target_code after checking that
+ * target is still valid, or skips itself if target is NULL. */
+static void write_link_site(unsigned char *site, const precomp_block *target, const unsigned char *target_code)
+{
+    unsigned char **saved_inst_pointer = inst_pointer;
+    int saved_code_length = code_length;
+    int saved_max_code_length = max_code_length;
+
+    inst_pointer = &site;
+    code_length = 0;
+    max_code_length = LINK_SITE_SIZE;
+
+    if (target == NULL)
+    {
+        jmp_imm_short(LINK_SITE_SIZE - 2);
+    }
     else
-        *return_address = (unsigned long long) (actual->code + PC->local_addr);
+    {
+        /* a write through the other KSEG view only invalidates that view */
+        mov_reg64_imm64(RAX, (unsigned long long) invalid_code_ptr(target->start));
+        cmp_preg64_imm8(RAX, 0);
+        jne_rj(LINK_SITE_SIZE - (code_length + 2));
+        mov_reg64_imm64(RAX, (unsigned long long) invalid_code_ptr(target->start ^ UINT32_C(0x20000000)));
+        cmp_preg64_imm8(RAX, 0);
+        jne_rj(LINK_SITE_SIZE - (code_length + 2));
+
+        /* linked jumps bypass code_cache_touch(), see code_cache.h */
+        mov_reg64_imm64(RAX, (unsigned long long) &target->lru_referenced);
+        mov_preg64_imm8(RAX, 1);
+        mov_reg64_imm64(RAX, (unsigned long long) target);
+        mov_m64rel_xreg64((unsigned long long *) &actual, RAX);
+        mov_reg64_imm64(RAX, (unsigned long long) target_code);
+        jmp_reg64(RAX);
+    }
+
+    inst_pointer = saved_inst_pointer;
+    code_length = saved_code_length;
+    max_code_length = saved_max_code_length;
+}
+
+static void remove_link(struct block_link *link)
+{
+    write_link_site(link->source->code + link->offset, NULL, NULL);
+
+    *link->prev_in = link->next_in;
+    if (link->next_in != NULL)
+        link->next_in->prev_in = link->prev_in;
+    *link->prev_out = link->next_out;
+    if (link->next_out != NULL)
+        link->next_out->prev_out = link->prev_out;
+    free(link);
+}
+
+static void add_link(precomp_block *source, unsigned int offset, precomp_block *target, const unsigned char *target_code)
+{
+    struct block_link *link;
+
+    for (link = source->links_out; link != NULL; link = link->next_out)
+    {
+        if (link->offset == offset)
+        {
+            remove_link(link);
+            break;
+        }
+    }
+
+    link = (struct block_link *) malloc(sizeof(struct block_link));
+    if (link == NULL)
+        return;
+
+    link->source = source;
+    link->offset = offset;
+    link->target = target;
+    link->next_in = target->links_in;
+    link->prev_in = &target->links_in;
+    if (target->links_in != NULL)
+        target->links_in->prev_in = &link->next_in;
+    target->links_in = link;
+    link->next_out = source->links_out;
+    link->prev_out = &source->links_out;
+    if (source->links_out != NULL)
+        source->links_out->prev_out = &link->next_out;
+    source->links_out = link;
+
+    write_link_site(source->code + offset, target, target_code);
+}
+
+/* Called by a link site which isn't linked yet, or whose target has been
+ * invalidated: jumps like jump_to_func() and links the site to the target
+ * if it is compiled. */
+void dyna_link_jump(void)
+{
+    precomp_block *source = link_site_block;
+    unsigned int offset = link_site_offset;
+    int source_changed;
+
+    linking_block = source;
+    jump_to_func();
+    source_changed = (linking_block == NULL);
+    linking_block = NULL;
+
+    if (source_changed || stop || skip_jump)
+        return;
+
+    if (PC->ops == current_instruction_table.NOTCOMPILED ||
+        PC->ops == current_instruction_table.NOTCOMPILED2 ||
+        *invalid_code_ptr(actual->start) ||
+        *invalid_code_ptr(actual->start ^ UINT32_C(0x20000000)))
+        return;
+
+    /* dyna_jump() has set the return address to the target's code */
+    add_link(source, offset, actual, (const unsigned char *) *return_address);
+}
+
+/* Unlinks the link sites jumping into block, and forgets those of block.
+ * This must be done before its code is rewritten, moved or freed. */
+void dyna_unlink_block(precomp_block *block)
+{
+    if (block == linking_block)
+        linking_block = NULL;
+
+    while (block->links_in != NULL)
+        remove_link(block->links_in);
+    while (block->links_out != NULL)
+        remove_link(block->links_out);
 }
 
 long long save_rsp = 0;
@@ -22,11 +22,13 @@
 #include "fb.h"
 
 #include "api/m64p_types.h"
+#include "memory/fastmem.h"
 #include "memory/memory.h"
 #include "plugin/plugin.h"
 #include "r4300/r4300_core.h"
 #include "rdp_core.h"
 #include "ri/ri_controller.h"
+#include "rsp/rsp_core.h"
 
 extern int fast_memory;
 
@@ -39,49 +41,57 @@ void init_fb(struct fb* fb)
 }
 
 
-static void pre_framebuffer_read(struct fb* fb, uint32_t address)
+static int fb_page_used(const struct fb* fb, uint32_t page)
 {
-    size_t i;
+    return (fb->pages[page / 32] >> (page % 32)) & 1;
+}
+
+/* returns the framebuffer range holding RDRAM offset addr, or NULL */
+static const struct fb_range* find_fb_range(const struct fb* fb, uint32_t addr)
+{
+    size_t lo = 0;
+    size_t hi = fb->ranges_count;
 
-    for(i = 0; i < FB_INFOS_COUNT; ++i)
+    while (lo < hi)
     {
-        if (fb->infos[i].addr)
-        {
-            unsigned int start = fb->infos[i].addr & 0x7FFFFF;
-            unsigned int end = start + fb->infos[i].width*
-                               fb->infos[i].height*
-                               fb->infos[i].size - 1;
-            if ((address & 0x7FFFFF) >= start && (address & 0x7FFFFF) <= end &&
-                    fb->dirty_page[(address & 0x7FFFFF)>>12])
-            {
-                gfx.fBRead(address);
-                fb->dirty_page[(address & 0x7FFFFF)>>12] = 0;
-            }
-        }
+        size_t mid = (lo + hi) / 2;
+
+        if (addr < fb->ranges[mid].start)
+            hi = mid;
+        else if (addr > fb->ranges[mid].end)
+            lo = mid + 1;
+        else
+            return &fb->ranges[mid];
     }
+
+    return NULL;
 }
 
-static void pre_framebuffer_write(struct fb* fb, uint32_t address)
+static void pre_framebuffer_read(struct fb* fb, uint32_t address)
 {
-    size_t i;
+    uint32_t addr = address & 0x7FFFFF;
+    uint32_t page = addr >> 12;
 
-    for(i = 0; i < FB_INFOS_COUNT; ++i)
+    if (fb_page_used(fb, page) && fb->dirty_page[page]
+            && find_fb_range(fb, addr) != NULL)
     {
-        if (fb->infos[i].addr)
-        {
-            unsigned int start = fb->infos[i].addr & 0x7FFFFF;
-            unsigned int end = start + fb->infos[i].width*
-                               fb->infos[i].height*
-                               fb->infos[i].size - 1;
-            if ((address & 0x7FFFFF) >= start && (address & 0x7FFFFF) <= end)
-                gfx.fBWrite(address, 4);
-        }
+        gfx.fBRead(address);
+        fb->dirty_page[page] = 0;
     }
 }
 
+static void pre_framebuffer_write(struct fb* fb, uint32_t address)
+{
+    uint32_t addr = address & 0x7FFFFF;
+
+    if (fb_page_used(fb, addr >> 12) && find_fb_range(fb, addr) != NULL)
+        gfx.fBWrite(address, 4);
+}
+
 int read_rdram_fb(void* opaque, uint32_t address, uint32_t* value)
 {
     struct rdp_core* dp = (struct rdp_core*)opaque;
+    rsp_wait_task(dp->sp);
     pre_framebuffer_read(&dp->fb, address);
     return read_rdram_dram(dp->ri, address, value);
 }
@@ -89,6 +99,7 @@ int read_rdram_fb(void* opaque, uint32_t address, uint32_t* value)
 int write_rdram_fb(void* opaque, uint32_t address, uint32_t value, uint32_t mask)
 {
     struct rdp_core* dp = (struct rdp_core*)opaque;
+    rsp_wait_task(dp->sp);
     pre_framebuffer_write(&dp->fb, address);
     return write_rdram_dram(dp->ri, address, value, mask);
 }
@@ -98,39 +109,115 @@ int write_rdram_fb(void* opaque, uint32_t address, uint32_t value, uint32_t mask
 #define W(x) write_ ## x ## b, write_ ## x ## h, write_ ## x, write_ ## x ## d
 #define RW(x) R(x), W(x)
 
+/* only remap the 64KB regions whose protection changes */
+static void update_fb_regions(struct fb* fb, const uint32_t* regions)
+{
+    size_t i;
+
+    for (i = 0; i < FB_REGIONS_COUNT; ++i)
+    {
+        uint32_t bit = UINT32_C(1) << (i % 32);
+
+        if ((regions[i / 32] & bit) == (fb->mapped_regions[i / 32] & bit))
+            continue;
+
+        if (regions[i / 32] & bit)
+        {
+            map_region(0x8000+i, M64P_MEM_RDRAM, &rdramFB_handler, RW(rdramFB));
+            map_region(0xa000+i, M64P_MEM_RDRAM, &rdramFB_handler, RW(rdramFB));
+        }
+        else
+        {
+            map_rdram_region(i);
+        }
+
+        /* recompiled fastmem accesses bypass the handlers, make them fault */
+        fastmem_protect((uint32_t)i << 16, 0x10000, (regions[i / 32] & bit) != 0);
+    }
+
+    memcpy(fb->mapped_regions, regions, sizeof(fb->mapped_regions));
+}
+
+static void add_fb_range(struct fb* fb, uint32_t start, uint32_t end)
+{
+    size_t i = fb->ranges_count++;
+
+    /* keep ranges sorted by start */
+    while (i > 0 && fb->ranges[i-1].start > start)
+    {
+        fb->ranges[i] = fb->ranges[i-1];
+        --i;
+    }
+
+    fb->ranges[i].start = start;
+    fb->ranges[i].end = end;
+}
+
+static void merge_fb_ranges(struct fb* fb)
+{
+    size_t i;
+    size_t n = 0;
+
+    for (i = 1; i < fb->ranges_count; ++i)
+    {
+        if (fb->ranges[i].start <= fb->ranges[n].end + 1)
+        {
+            if (fb->ranges[i].end > fb->ranges[n].end)
+                fb->ranges[n].end = fb->ranges[i].end;
+        }
+        else
+        {
+            fb->ranges[++n] = fb->ranges[i];
+        }
+    }
+
+    if (fb->ranges_count != 0)
+        fb->ranges_count = n + 1;
+}
+
 void protect_framebuffers(struct rdp_core* dp)
 {
     struct fb* fb = &dp->fb;
+    uint32_t regions[FB_REGIONS_COUNT / 32];
 
-    if (gfx.fBGetFrameBufferInfo && gfx.fBRead && gfx.fBWrite)
-        gfx.fBGetFrameBufferInfo(fb->infos);
-    if (gfx.fBGetFrameBufferInfo && gfx.fBRead && gfx.fBWrite
-            && fb->infos[0].addr)
+    if (!(gfx.fBGetFrameBufferInfo && gfx.fBRead && gfx.fBWrite))
+        return;
+
+    gfx.fBGetFrameBufferInfo(fb->infos);
+
+    memset(regions, 0, sizeof(regions));
+    memset(fb->pages, 0, sizeof(fb->pages));
+    fb->ranges_count = 0;
+
+    if (fb->infos[0].addr)
     {
         size_t i;
         for(i = 0; i < FB_INFOS_COUNT; ++i)
         {
             if (fb->infos[i].addr)
             {
-                int j;
-                int start = fb->infos[i].addr & 0x7FFFFF;
-                int end = start + fb->infos[i].width*
-                          fb->infos[i].height*
-                          fb->infos[i].size - 1;
-                int start1 = start;
-                int end1 = end;
-                start >>= 16;
-                end >>= 16;
-                for (j=start; j<=end; j++)
-                {
-                    map_region(0x8000+j, M64P_MEM_RDRAM, RW(rdramFB));
-                    map_region(0xa000+j, M64P_MEM_RDRAM, RW(rdramFB));
-                }
-                start <<= 4;
-                end <<= 4;
-                for (j=start; j<=end; j++)
+                uint32_t j;
+                uint32_t start = fb->infos[i].addr & 0x7FFFFF;
+                uint32_t size = fb->infos[i].width*
+                                fb->infos[i].height*
+                                fb->infos[i].size;
+                uint32_t end;
+
+                if (size == 0)
+                    continue;
+
+                end = (size - 1 > 0x7FFFFF - start) ? 0x7FFFFF : start + size - 1;
+                add_fb_range(fb, start, end);
+
+                for (j = start >> 12; j <= end >> 12; j++)
+                    fb->pages[j / 32] |= UINT32_C(1) << (j % 32);
+
+                for (j = start >> 16; j <= end >> 16; j++)
+                    regions[j / 32] |= UINT32_C(1) << (j % 32);
+
+                for (j = (start >> 16) << 4; j <= (end >> 16) << 4; j++)
                 {
-                    if (j>=start1 && j<=end1) fb->dirty_page[j]=1;
+                    if (j>=start && j<=end) fb->dirty_page[j]=1;
                     else fb->dirty_page[j] = 0;
                 }
 
@@ -142,35 +229,21 @@ void protect_framebuffers(struct rdp_core* dp)
                 }
             }
         }
+
+        merge_fb_ranges(fb);
     }
+
+    update_fb_regions(fb, regions);
 }
 
 void unprotect_framebuffers(struct rdp_core* dp)
 {
     struct fb* fb = &dp->fb;
+    uint32_t regions[FB_REGIONS_COUNT / 32];
 
-    if (gfx.fBGetFrameBufferInfo && gfx.fBRead && gfx.fBWrite &&
-            fb->infos[0].addr)
-    {
-        size_t i;
-        for(i = 0; i < FB_INFOS_COUNT; ++i)
-        {
-            if (fb->infos[i].addr)
-            {
-                int j;
-                int start = fb->infos[i].addr & 0x7FFFFF;
-                int end = start + fb->infos[i].width*
-                          fb->infos[i].height*
-                          fb->infos[i].size - 1;
-                start = start >> 16;
-                end = end >> 16;
-
-                for (j=start; j<=end; j++)
-                {
-                    map_region(0x8000+j, M64P_MEM_RDRAM, RW(rdram));
-                    map_region(0xa000+j, M64P_MEM_RDRAM, RW(rdram));
-                }
-            }
-        }
-    }
+    memset(regions, 0, sizeof(regions));
+    memset(fb->pages, 0, sizeof(fb->pages));
+    fb->ranges_count = 0;
+
+    update_fb_regions(fb, regions);
 }
@@ -22,6 +22,7 @@
 #ifndef M64P_RDP_FB_H
 #define M64P_RDP_FB_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include "api/m64p_plugin.h"
@@ -30,12 +31,29 @@ struct rdp_core;
 
 enum { FB_INFOS_COUNT = 6 };
 enum { FB_DIRTY_PAGES_COUNT = 0x800 };
+enum { FB_REGIONS_COUNT = 0x80 };
+
+/* [start, end] offsets in RDRAM */
+struct fb_range
+{
+    uint32_t start;
+    uint32_t end;
+};
 
 struct fb
 {
     unsigned char dirty_page[FB_DIRTY_PAGES_COUNT];
     FrameBufferInfo infos[FB_INFOS_COUNT];
     unsigned int once;
+
+    /* framebuffers of the last protect_framebuffers call,
+     * sorted and merged, and the 4KB pages they cover */
+    struct fb_range ranges[FB_INFOS_COUNT];
+    size_t ranges_count;
+    uint32_t pages[FB_DIRTY_PAGES_COUNT / 32];
+
+    /* 64KB regions currently mapped to the framebuffer handlers */
+    uint32_t mapped_regions[FB_REGIONS_COUNT / 32];
 };
 
 void init_fb(struct fb* fb);
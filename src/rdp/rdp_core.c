@@ -79,6 +79,8 @@ int read_dpc_regs(void* opaque, uint32_t address, uint32_t* value)
     struct rdp_core* dp = (struct rdp_core*)opaque;
     uint32_t reg = dpc_reg(address);
 
+    rsp_wait_task(dp->sp);
+
     *value = dp->dpc_regs[reg];
 
     return 0;
@@ -89,6 +91,8 @@ int write_dpc_regs(void* opaque, uint32_t address, uint32_t value, uint32_t mask
     struct rdp_core* dp = (struct rdp_core*)opaque;
     uint32_t reg = dpc_reg(address);
 
+    rsp_wait_task(dp->sp);
+
     switch(reg)
     {
     case DPC_STATUS_REG:
@@ -124,6 +128,8 @@ int read_dps_regs(void* opaque, uint32_t address, uint32_t* value)
     struct rdp_core* dp = (struct rdp_core*)opaque;
     uint32_t reg = dps_reg(address);
 
+    rsp_wait_task(dp->sp);
+
     *value = dp->dps_regs[reg];
 
     return 0;
@@ -134,11 +140,23 @@ int write_dps_regs(void* opaque, uint32_t address, uint32_t value, uint32_t mask
     struct rdp_core* dp = (struct rdp_core*)opaque;
     uint32_t reg = dps_reg(address);
 
+    rsp_wait_task(dp->sp);
+
     masked_write(&dp->dps_regs[reg], value, mask);
 
     return 0;
 }
 
+void rdp_skip_commands(struct rdp_core* dp)
+{
+    dp->dpc_regs[DPC_START_REG] = dp->dpc_regs[DPC_END_REG];
+    dp->dpc_regs[DPC_CURRENT_REG] = dp->dpc_regs[DPC_END_REG];
+
+    /* not busy (dma, cmd, pipe, tmem), no pending start/end, buffer ready */
+    dp->dpc_regs[DPC_STATUS_REG] &= ~0x770;
+    dp->dpc_regs[DPC_STATUS_REG] |= 0x80;
+}
+
 void rdp_interrupt_event(struct rdp_core* dp)
 {
     dp->dpc_regs[DPC_STATUS_REG] &= ~2;
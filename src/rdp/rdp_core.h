@@ -88,6 +88,10 @@ int write_dpc_regs(void* opaque, uint32_t address, uint32_t value, uint32_t mask
 int read_dps_regs(void* opaque, uint32_t address, uint32_t* value);
 int write_dps_regs(void* opaque, uint32_t address, uint32_t value, uint32_t mask);
 
+/* Leave the DPC registers as if the RDP had processed every command
+ * up to DPC_END, for display lists which aren't rendered. */
+void rdp_skip_commands(struct rdp_core* dp);
+
 void rdp_interrupt_event(struct rdp_core* dp);
 
 #endif
@@ -23,6 +23,7 @@
 
 #include <stdint.h>
 
+#include "device/device.h"
 #include "main/main.h"
 #include "ri_controller.h"
 #include "si/si_controller.h"
@@ -34,10 +35,10 @@
  */
 void force_detected_rdram_size_hack(void)
 {
-    uint32_t address = (g_si.pif.cic.version != CIC_X105)
+    uint32_t address = (g_dev.si.pif.cic.version != CIC_X105)
         ? 0x318
         : 0x3f0;
 
-    g_ri.rdram.dram[address/4] = g_ri.rdram.dram_size;
+    g_dev.ri.rdram.dram[address/4] = g_dev.ri.rdram.dram_size;
 }
 
@@ -25,15 +25,17 @@
 
 #include "main/main.h"
 #include "main/profile.h"
+#include "memory/dma_copy.h"
 #include "memory/memory.h"
 #include "plugin/plugin.h"
+#include "r4300/r4300.h"
 #include "r4300/r4300_core.h"
 #include "rdp/rdp_core.h"
 #include "ri/ri_controller.h"
 
 static void dma_sp_write(struct rsp_core* sp)
 {
-    unsigned int i,j;
+    unsigned int j;
 
     unsigned int l = sp->regs[SP_RD_LEN_REG];
 
@@ -48,18 +50,15 @@ static void dma_sp_write(struct rsp_core* sp)
     unsigned char *dram = (unsigned char*)sp->ri->rdram.dram;
 
     for(j=0; j<count; j++) {
-        for(i=0; i<length; i++) {
-            spmem[memaddr^S8] = dram[dramaddr^S8];
-            memaddr++;
-            dramaddr++;
-        }
-        dramaddr+=skip;
+        dma_copy(spmem, memaddr, dram, dramaddr, length);
+        memaddr += length;
+        dramaddr += length + skip;
     }
 }
 
 static void dma_sp_read(struct rsp_core* sp)
 {
-    unsigned int i,j;
+    unsigned int j;
 
     unsigned int l = sp->regs[SP_WR_LEN_REG];
 
@@ -74,12 +73,10 @@ static void dma_sp_read(struct rsp_core* sp)
     unsigned char *dram = (unsigned char*)sp->ri->rdram.dram;
 
     for(j=0; j<count; j++) {
-        for(i=0; i<length; i++) {
-            dram[dramaddr^S8] = spmem[memaddr^S8];
-            memaddr++;
-            dramaddr++;
-        }
-        dramaddr+=skip;
+        invalidate_r4300_cached_dram(dramaddr, length);
+        dma_copy(dram, dramaddr, spmem, memaddr, length);
+        memaddr += length;
+        dramaddr += length + skip;
     }
 }
 
@@ -176,6 +173,8 @@ int read_rsp_mem(void* opaque, uint32_t address, uint32_t* value)
     struct rsp_core* sp = (struct rsp_core*)opaque;
     uint32_t addr = rsp_mem_address(address);
 
+    rsp_wait_task(sp);
+
     *value = sp->mem[addr];
 
     return 0;
@@ -186,6 +185,8 @@ int write_rsp_mem(void* opaque, uint32_t address, uint32_t value, uint32_t mask)
     struct rsp_core* sp = (struct rsp_core*)opaque;
     uint32_t addr = rsp_mem_address(address);
 
+    rsp_wait_task(sp);
+
     masked_write(&sp->mem[addr], value, mask);
 
     return 0;
@@ -197,6 +198,8 @@ int read_rsp_regs(void* opaque, uint32_t address, uint32_t* value)
     struct rsp_core* sp = (struct rsp_core*)opaque;
     uint32_t reg = rsp_reg(address);
 
+    rsp_wait_task(sp);
+
     *value = sp->regs[reg];
 
     if (reg == SP_SEMAPHORE_REG)
@@ -212,6 +215,8 @@ int write_rsp_regs(void* opaque, uint32_t address, uint32_t value, uint32_t mask
     struct rsp_core* sp = (struct rsp_core*)opaque;
     uint32_t reg = rsp_reg(address);
 
+    rsp_wait_task(sp);
+
     switch(reg)
     {
     case SP_STATUS_REG:
@@ -245,6 +250,8 @@ int read_rsp_regs2(void* opaque, uint32_t address, uint32_t* value)
     struct rsp_core* sp = (struct rsp_core*)opaque;
     uint32_t reg = rsp_reg2(address);
 
+    rsp_wait_task(sp);
+
     *value = sp->regs2[reg];
 
     return 0;
@@ -255,15 +262,64 @@ int write_rsp_regs2(void* opaque, uint32_t address, uint32_t value, uint32_t mas
     struct rsp_core* sp = (struct rsp_core*)opaque;
     uint32_t reg = rsp_reg2(address);
 
+    rsp_wait_task(sp);
+
     masked_write(&sp->regs2[reg], value, mask);
 
     return 0;
 }
 
+static void sp_task_work(struct work_struct* work)
+{
+    (void)work;
+    rsp.doRspCycles(0xffffffff);
+}
+
+/* what the RSP plugin does at the end of a task, without running it */
+static void skip_SP_Task(struct rsp_core* sp)
+{
+    sp->regs[SP_STATUS_REG] |= 0x203; /* task done, broke, halt */
+
+    if (sp->regs[SP_STATUS_REG] & 0x40) /* interrupt on break */
+        sp->mi_intr_reg |= MI_INTR_SP;
+}
+
+static void finish_SP_Task(struct rsp_core* sp, unsigned task, uint32_t save_pc, uint32_t mi_intr)
+{
+    /* apply the changes made by the RSP plugin to MI_INTR_REG */
+    uint32_t changed = sp->mi_intr_reg ^ mi_intr;
+    sp->r4300->mi.regs[MI_INTR_REG] = (sp->r4300->mi.regs[MI_INTR_REG] & ~changed)
+                                    | (sp->mi_intr_reg & changed);
+
+    sp->regs2[SP_PC_REG] |= save_pc;
+
+    if (task == 1 && (sp->r4300->mi.regs[MI_INTR_REG] & MI_INTR_DP))
+    {
+       add_interupt_event(DP_INT, 1000);
+       sp->r4300->mi.regs[MI_INTR_REG] &= ~(MI_INTR_DP);
+    }
+
+    if (((sp->regs[SP_STATUS_REG] & 0x00000001) == 0x00000000)
+        && (sp->regs[SP_STATUS_REG] & 0x00000002) == 0x00000000)
+    { /* needed for games like "Stunt Racer 64" with CPU-RSP timer sync fails */
+        /* printf(
+            "To do:  early RSP exit and task resume (SP_STATUS_REG = %08X)\n",
+            sp->regs[SP_STATUS_REG]
+        ); */
+        add_interupt_event(SP_INT, 0x200);
+        sp->regs[SP_STATUS_REG] &= ~0x00000003; /* Clear BROKE and HALT. */
+    }
+    else
+    {
+       sp->regs[SP_STATUS_REG] |= 0x00000003; /* Set BROKE and HALT. */
+    }
+}
+
 void do_SP_Task(struct rsp_core* sp)
 {
     uint32_t save_pc = sp->regs2[SP_PC_REG] & ~0xfff;
     unsigned task    = sp->mem[0xfc0/4];
+    uint32_t mi_intr;
 
     if (((sp->regs[SP_STATUS_REG] & 0x00000001) == 0x00000000)
         && (sp->regs[SP_STATUS_REG] & 0x00000002) == 0x00000000)
@@ -278,7 +334,6 @@ void do_SP_Task(struct rsp_core* sp)
              return;
           }
 
-          unprotect_framebuffers(sp->dp);
           new_frame();
 
           cp0_update_count();
@@ -287,7 +342,11 @@ void do_SP_Task(struct rsp_core* sp)
           sp->r4300->mi.regs[MI_INTR_REG] &= ~(MI_INTR_SP);
           sp->regs[SP_STATUS_REG] &= ~0x300; /* task done && yielded */
 
-          protect_framebuffers(sp->dp);
+          /* only the regions whose protection changes are remapped */
+          if (main_frame_rendered())
+             protect_framebuffers(sp->dp);
+          else
+             unprotect_framebuffers(sp->dp);
        }
        else if (task == 2)
        {
@@ -310,34 +369,91 @@ void do_SP_Task(struct rsp_core* sp)
     }
 
     sp->regs2[SP_PC_REG] &= 0xfff;
-    rsp.doRspCycles(0xffffffff);
-    sp->regs2[SP_PC_REG] |= save_pc;
+    mi_intr = sp->r4300->mi.regs[MI_INTR_REG];
+    sp->mi_intr_reg = mi_intr;
 
-    if (task == 1 && (sp->r4300->mi.regs[MI_INTR_REG] & MI_INTR_DP))
+    if (task == 1 && !main_frame_rendered())
     {
-       add_interupt_event(DP_INT, 1000);
-       sp->r4300->mi.regs[MI_INTR_REG] &= ~(MI_INTR_DP);
+        /* acknowledge the display list as if the RDP had processed it */
+        skip_SP_Task(sp);
+        rdp_skip_commands(sp->dp);
+        sp->r4300->mi.regs[MI_INTR_REG] |= MI_INTR_DP;
+        finish_SP_Task(sp, task, save_pc, mi_intr);
+        return;
     }
 
-    if (((sp->regs[SP_STATUS_REG] & 0x00000001) == 0x00000000)
-        && (sp->regs[SP_STATUS_REG] & 0x00000002) == 0x00000000)
-    { /* needed for games like "Stunt Racer 64" with CPU-RSP timer sync fails */
-        /* printf(
-            "To do:  early RSP exit and task resume (SP_STATUS_REG = %08X)\n",
-            sp->regs[SP_STATUS_REG]
-        ); */
-        add_interupt_event(SP_INT, 0x200);
-        sp->regs[SP_STATUS_REG] &= ~0x00000003; /* Clear BROKE and HALT. */
+    if (task == 2 && sp->skip_audio)
+    {
+        skip_SP_Task(sp);
+        finish_SP_Task(sp, task, save_pc, mi_intr);
+        return;
     }
-    else
+
+    if (task == 2 && sp->async_audio)
     {
-       sp->regs[SP_STATUS_REG] |= 0x00000003; /* Set BROKE and HALT. */
+        /* the task is completed by rsp_wait_task, at the latest when SP_INT fires */
+        sp->task = task;
+        sp->task_save_pc = save_pc;
+        sp->task_mi_intr = mi_intr;
+        sp->task_pending = 1;
+
+        if (!get_event(SP_INT))
+            add_interupt_event(SP_INT, 4000);
+
+        queue_work_fenced(&sp->task_work, &sp->task_fence);
+        return;
     }
 
+    rsp.doRspCycles(0xffffffff);
+    finish_SP_Task(sp, task, save_pc, mi_intr);
+}
+
+void rsp_wait_task(struct rsp_core* sp)
+{
+    if (!sp->task_pending)
+        return;
+
+    wait_work_fence(&sp->task_fence);
+    sp->task_pending = 0;
+
+    finish_SP_Task(sp, sp->task, sp->task_save_pc, sp->task_mi_intr);
+}
+
+int enable_async_rsp_audio(struct rsp_core* sp)
+{
+#ifdef M64P_PARALLEL
+#ifdef NEW_DYNAREC
+    /* its RDRAM accesses can't be routed through the handlers */
+    if (r4300emu >= CORE_DYNAREC)
+        return 0;
+#endif
+
+    if (init_work_fence(&sp->task_fence) != 0)
+        return 0;
+
+    init_work(&sp->task_work, sp_task_work);
+    sp->async_audio = 1;
+
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+void disable_async_rsp_audio(struct rsp_core* sp)
+{
+    if (!sp->async_audio)
+        return;
+
+    rsp_wait_task(sp);
+    destroy_work_fence(&sp->task_fence);
+    sp->async_audio = 0;
 }
 
 void rsp_interrupt_event(struct rsp_core* sp)
 {
+    rsp_wait_task(sp);
+
     sp->regs[SP_STATUS_REG] |= 0x203;
 
     if ((sp->regs[SP_STATUS_REG] & 0x40) != 0)
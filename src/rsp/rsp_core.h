@@ -24,6 +24,8 @@
 
 #include <stdint.h>
 
+#include "main/workqueue.h"
+
 struct r4300_core;
 struct rdp_core;
 struct ri_controller;
@@ -60,6 +62,23 @@ struct rsp_core
     struct r4300_core* r4300;
     struct rdp_core* dp;
     struct ri_controller* ri;
+
+    /* MI_INTR_REG as seen by the RSP plugin,
+     * its changes are applied to the MI once a task is done */
+    uint32_t mi_intr_reg;
+
+    /* audio tasks are only signalled as done when skip_audio is set */
+    int skip_audio;
+
+    /* audio tasks run on a worker thread when async_audio is set,
+     * see rsp_wait_task */
+    int async_audio;
+    int task_pending;
+    unsigned int task;
+    uint32_t task_save_pc;
+    uint32_t task_mi_intr;
+    struct work_struct task_work;
+    struct work_fence task_fence;
 };
 
 static uint32_t rsp_mem_address(uint32_t address)
@@ -95,6 +114,15 @@ int write_rsp_regs2(void* opaque, uint32_t address, uint32_t value, uint32_t mas
 
 void do_SP_Task(struct rsp_core* sp);
 
+int enable_async_rsp_audio(struct rsp_core* sp);
+void disable_async_rsp_audio(struct rsp_core* sp);
+
+/* Wait for the audio task running on a worker thread (if any) and complete it.
+ * Must be called before accessing the state shared with the RSP plugin:
+ * RDRAM, SP/DP registers, SP memory and the MI interrupt register,
+ * and before calling the audio plugin. */
+void rsp_wait_task(struct rsp_core* sp);
+
 void rsp_interrupt_event(struct rsp_core* sp);
 
 #endif
@@ -26,6 +26,7 @@
 #include "api/callbacks.h"
 #include "api/m64p_types.h"
 #include "main/main.h"
+#include "memory/dma_copy.h"
 #include "memory/memory.h"
 #include "r4300/r4300_core.h"
 #include "ri/ri_controller.h"
@@ -33,18 +34,13 @@
 
 static void dma_si_write(struct si_controller* si)
 {
-    int i;
-
     if (si->regs[SI_PIF_ADDR_WR64B_REG] != 0x1FC007C0)
     {
         DebugMessage(M64MSG_ERROR, "dma_si_write(): unknown SI use");
         return;
     }
 
-    for (i = 0; i < PIF_RAM_SIZE; i += 4)
-    {
-        *((uint32_t*)(&si->pif.ram[i])) = sl(si->ri->rdram.dram[(si->regs[SI_DRAM_ADDR_REG]+i)/4]);
-    }
+    dma_copy_be32(si->pif.ram, &si->ri->rdram.dram[si->regs[SI_DRAM_ADDR_REG]/4], PIF_RAM_SIZE/4);
 
     update_pif_write(si);
     cp0_update_count();
@@ -59,8 +55,6 @@ static void dma_si_write(struct si_controller* si)
 
 static void dma_si_read(struct si_controller* si)
 {
-    int i;
-
     if (si->regs[SI_PIF_ADDR_RD64B_REG] != 0x1FC007C0)
     {
         DebugMessage(M64MSG_ERROR, "dma_si_read(): unknown SI use");
@@ -69,10 +63,9 @@ static void dma_si_read(struct si_controller* si)
 
     update_pif_read(si);
 
-    for (i = 0; i < PIF_RAM_SIZE; i += 4)
-    {
-        si->ri->rdram.dram[(si->regs[SI_DRAM_ADDR_REG]+i)/4] = sl(*(uint32_t*)(&si->pif.ram[i]));
-    }
+    dma_copy_be32(&si->ri->rdram.dram[si->regs[SI_DRAM_ADDR_REG]/4], si->pif.ram, PIF_RAM_SIZE/4);
+
+    invalidate_r4300_cached_dram(si->regs[SI_DRAM_ADDR_REG], PIF_RAM_SIZE);
 
     cp0_update_count();
 
@@ -96,7 +96,8 @@ int write_vi_regs(void* opaque, uint32_t address, uint32_t value, uint32_t mask)
 
 void vi_vertical_interrupt_event(struct vi_controller* vi)
 {
-    gfx.updateScreen();
+    if (main_frame_rendered())
+        gfx.updateScreen();
 
     /* allow main module to do things on VI event */
     new_vi();
@@ -0,0 +1,312 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - m64p_bench.c                                            *
+ *   Mupen64Plus homepage: http://code.google.com/p/mupen64plus/           *
+ *   Copyright (C) 2015 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Headless benchmark driver. It is linked statically against the core objects
+ * (see the 'bench' target of projects/unix/Makefile) and runs without any
+ * plugin attached, so the built-in dummy plugins are used.
+ *
+ * For each requested R4300Emulator mode the ROM is opened, paused as soon as
+ * it starts, advanced by a warm-up batch and then by a timed batch of VIs.
+ * One JSON object per mode is printed on stdout, with the compiler time and
+ * block counts of the timed batch taken from M64CMD_CODE_CACHE_STATS. When
+ * the core objects are built with -DPROFILE (DBG_TIMING=1), the number of
+ * blocks initialized is reported too, but the timings then include the
+ * profiling overhead. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <SDL.h>
+#include <SDL_thread.h>
+
+#define M64P_CORE_PROTOTYPES 1
+#include "api/m64p_common.h"
+#include "api/m64p_config.h"
+#include "api/m64p_frontend.h"
+#include "api/m64p_types.h"
+#include "main/profile.h"
+#include "main/version.h"
+
+static const char *emulator_names[] = { "pure_interpreter", "cached_interpreter", "dynarec" };
+
+static int l_Verbose = 0;
+static int l_Started = 0;
+static SDL_sem *l_StartSem = NULL;
+
+struct bench_run
+{
+    int mode;
+    int warmup;
+    int vis;
+    m64p_error rval;
+    double seconds;
+    long long int compile_nsec;
+    long long int blocks_initialized;
+    long long int blocks_compiled;
+    long long int evictions;
+};
+
+static double get_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+static void debug_callback(void *context, int level, const char *message)
+{
+    if (level <= M64MSG_WARNING || l_Verbose)
+        fprintf(stderr, "core: %s\n", message);
+}
+
+static void state_callback(void *context, m64p_core_param param_type, int new_value)
+{
+    if (param_type == M64CORE_EMU_STATE && new_value == M64EMU_RUNNING && !l_Started)
+    {
+        l_Started = 1;
+        SDL_SemPost(l_StartSem);
+    }
+}
+
+static m64p_error get_cache_stats(m64p_code_cache_stats *stats)
+{
+    return CoreDoCommand(M64CMD_CODE_CACHE_STATS, sizeof(*stats), stats);
+}
+
+static int bench_thread(void *data)
+{
+    struct bench_run *run = (struct bench_run *) data;
+    m64p_code_cache_stats before, after;
+#ifdef PROFILE
+    long long int blocks_initialized;
+#endif
+    double start;
+
+    SDL_SemWait(l_StartSem);
+
+    run->rval = CoreDoCommand(M64CMD_PAUSE, 0, NULL);
+    if (run->rval == M64ERR_SUCCESS && run->warmup > 0)
+        run->rval = CoreDoCommand(M64CMD_ADVANCE_BATCH, M64BATCH_VIS, &run->warmup);
+
+    if (run->rval == M64ERR_SUCCESS)
+        run->rval = get_cache_stats(&before);
+
+    if (run->rval == M64ERR_SUCCESS)
+    {
+#ifdef PROFILE
+        blocks_initialized = profile_counter_get(PROFILE_COUNTER_BLOCKS_INITIALIZED);
+#endif
+        start = get_seconds();
+
+        run->rval = CoreDoCommand(M64CMD_ADVANCE_BATCH, M64BATCH_VIS, &run->vis);
+
+        run->seconds = get_seconds() - start;
+        if (run->rval == M64ERR_SUCCESS)
+            run->rval = get_cache_stats(&after);
+        run->compile_nsec = (long long int) (after.recompile_nsec - before.recompile_nsec);
+        run->blocks_compiled = (long long int) (after.blocks_compiled - before.blocks_compiled);
+        run->evictions = (long long int) (after.evictions - before.evictions);
+#ifdef PROFILE
+        run->blocks_initialized = profile_counter_get(PROFILE_COUNTER_BLOCKS_INITIALIZED) - blocks_initialized;
+#endif
+    }
+
+    CoreDoCommand(M64CMD_STOP, 0, NULL);
+    return 0;
+}
+
+static m64p_error bench_mode(unsigned char *rom, int rom_size, struct bench_run *run)
+{
+    m64p_handle core_config;
+    m64p_error rval;
+    SDL_Thread *thread;
+
+    rval = ConfigOpenSection("Core", &core_config);
+    if (rval != M64ERR_SUCCESS)
+        return rval;
+    rval = ConfigSetParameter(core_config, "R4300Emulator", M64TYPE_INT, &run->mode);
+    if (rval != M64ERR_SUCCESS)
+        return rval;
+
+    rval = CoreDoCommand(M64CMD_ROM_OPEN, rom_size, rom);
+    if (rval != M64ERR_SUCCESS)
+        return rval;
+
+    l_Started = 0;
+    run->rval = M64ERR_INVALID_STATE;
+#if SDL_VERSION_ATLEAST(2,0,0)
+    thread = SDL_CreateThread(bench_thread, "m64pbench", run);
+#else
+    thread = SDL_CreateThread(bench_thread, run);
+#endif
+    if (thread == NULL)
+    {
+        CoreDoCommand(M64CMD_ROM_CLOSE, 0, NULL);
+        return M64ERR_SYSTEM_FAIL;
+    }
+
+    rval = CoreDoCommand(M64CMD_EXECUTE, 0, NULL);
+    if (rval != M64ERR_SUCCESS && !l_Started)
+    {
+        /* emulation never started: release the bench thread so it can exit */
+        l_Started = 1;
+        SDL_SemPost(l_StartSem);
+    }
+    SDL_WaitThread(thread, NULL);
+
+    CoreDoCommand(M64CMD_ROM_CLOSE, 0, NULL);
+
+    return (rval != M64ERR_SUCCESS) ? rval : run->rval;
+}
+
+static unsigned char *load_file(const char *filename, int *size)
+{
+    FILE *f;
+    long length;
+    unsigned char *data;
+
+    f = fopen(filename, "rb");
+    if (f == NULL)
+        return NULL;
+
+    fseek(f, 0, SEEK_END);
+    length = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    data = (length > 0) ? (unsigned char *) malloc(length) : NULL;
+    if (data != NULL && fread(data, 1, length, f) != (size_t) length)
+    {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+
+    *size = (int) length;
+    return data;
+}
+
+static void print_usage(const char *progname)
+{
+    printf("Usage: %s [options] <rom>\n"
+           "    --vis N          number of timed VIs per emulator mode (default: 3000)\n"
+           "    --warmup N       number of VIs to run before timing (default: 60)\n"
+           "    --modes LIST     comma-separated R4300Emulator modes to run (default: 0,1,2)\n"
+           "    --configdir DIR  core configuration directory\n"
+           "    --datadir DIR    core data directory (mupen64plus.ini)\n"
+           "    --verbose        print all core messages on stderr\n", progname);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *configdir = NULL, *datadir = NULL, *romname = NULL;
+    const char *modes = "0,1,2";
+    const char *p;
+    unsigned char *rom;
+    int rom_size, vis = 3000, warmup = 60;
+    int i, failed = 0;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--vis") == 0 && i + 1 < argc)
+            vis = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+            warmup = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--modes") == 0 && i + 1 < argc)
+            modes = argv[++i];
+        else if (strcmp(argv[i], "--configdir") == 0 && i + 1 < argc)
+            configdir = argv[++i];
+        else if (strcmp(argv[i], "--datadir") == 0 && i + 1 < argc)
+            datadir = argv[++i];
+        else if (strcmp(argv[i], "--verbose") == 0)
+            l_Verbose = 1;
+        else if (argv[i][0] != '-' && romname == NULL)
+            romname = argv[i];
+        else
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (romname == NULL || vis <= 0 || warmup < 0)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    rom = load_file(romname, &rom_size);
+    if (rom == NULL)
+    {
+        fprintf(stderr, "couldn't read ROM file '%s'\n", romname);
+        return 1;
+    }
+
+    l_StartSem = SDL_CreateSemaphore(0);
+    if (l_StartSem == NULL ||
+        CoreStartup(FRONTEND_API_VERSION, configdir, datadir, NULL, debug_callback, NULL, state_callback) != M64ERR_SUCCESS)
+    {
+        fprintf(stderr, "couldn't start the core\n");
+        free(rom);
+        return 1;
+    }
+
+    for (p = modes; *p != '\0'; p++)
+    {
+        struct bench_run run;
+        m64p_error rval;
+
+        if (*p < '0' || *p > '2')
+            continue;
+
+        memset(&run, 0, sizeof(run));
+        run.mode = *p - '0';
+        run.warmup = warmup;
+        run.vis = vis;
+
+        rval = bench_mode(rom, rom_size, &run);
+        if (rval != M64ERR_SUCCESS)
+        {
+            printf("{\"mode\":%d,\"emulator\":\"%s\",\"error\":\"%s\"}\n",
+                   run.mode, emulator_names[run.mode], CoreErrorMessage(rval));
+            failed = 1;
+            continue;
+        }
+
+        printf("{\"mode\":%d,\"emulator\":\"%s\",\"vis\":%d,\"seconds\":%.6f,\"vis_per_sec\":%.3f",
+               run.mode, emulator_names[run.mode], run.vis, run.seconds,
+               (run.seconds > 0.0) ? run.vis / run.seconds : 0.0);
+        printf(",\"compile_seconds\":%.6f,\"blocks_compiled\":%lld,\"evictions\":%lld",
+               run.compile_nsec / 1e9, run.blocks_compiled, run.evictions);
+#ifdef PROFILE
+        printf(",\"blocks_initialized\":%lld", run.blocks_initialized);
+#endif
+        printf("}\n");
+        fflush(stdout);
+    }
+
+    CoreShutdown();
+    SDL_DestroySemaphore(l_StartSem);
+    free(rom);
+
+    return failed;
+}